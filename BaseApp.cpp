@@ -1,19 +1,42 @@
 #include "BaseApp.h"
 #include "Input.h"
 #include <iostream>
+#include <fstream>
 #include <cmath>
 
-const int gNumFrameResources = 3;
+int gNumFrameResources = DefaultFramesInFlight;
 
-BaseApp::BaseApp(HINSTANCE hInstance)
+BaseApp::BaseApp(HINSTANCE hInstance, uint32_t framesInFlight)
 	: D3DApp(hInstance)
 {
-
+	gNumFrameResources = (int)min(max(framesInFlight, 1u), MaxFramesInFlight);
 }
 
 BaseApp::~BaseApp()
 {
+	ofstream log(QueueTimelineLogPath);
+	if (log)
+	{
+		mQueueTimeline.Write(log);
+	}
+
+	ofstream summary(ProfileSummaryPath);
+	if (summary)
+	{
+		mProfiler.WriteSummary(summary);
+	}
+
+	ofstream trace(ProfileTracePath);
+	if (trace)
+	{
+		mProfiler.WriteTrace(trace);
+	}
 
+	ofstream culling(CullingStatsPath);
+	if (culling)
+	{
+		mCullingStats.Write(culling);
+	}
 }
 
 bool BaseApp::Initialize()
@@ -39,16 +62,42 @@ bool BaseApp::Initialize()
 
 	ThrowIfFailed(mComputeCommandList->Reset(mComputeCmdListAlloc.Get(), nullptr));
 
+	mUploadBatcher = make_unique<UploadBatcher>(md3dDevice.Get());
+	mPipelines = make_unique<PipelineStateLibrary>(md3dDevice.Get(), PipelineLibraryPath);
+	mFrameScheduler = make_unique<FrameScheduler>(mFrameFence.get(), gNumFrameResources);
+
+	mGpuProfiler = make_unique<D3D12GpuProfiler>(md3dDevice.Get(), mCommandQueue.Get(), mComputeCommandQueue.Get(), &mProfiler, gNumFrameResources);
+	mUpdateScope = mProfiler.RegisterScope("update", ProfileTrack::Cpu);
+	mWaitScope = mProfiler.RegisterScope("waitForFrame", ProfileTrack::Cpu);
+	mDrawScope = mProfiler.RegisterScope("draw", ProfileTrack::Cpu);
+	mPresentScope = mProfiler.RegisterScope("present", ProfileTrack::Cpu);
+	mCullScope = mGpuProfiler->AddScope("cullSceneObjects", PassQueue::Compute);
+	mExecuteIndirectScope = mGpuProfiler->AddScope("executeIndirect", PassQueue::Graphics);
+
 	Build();
+	BuildInstanceStorage();
 
 	// BuildWireFramePSOs();
 
+	mPipelines->CompileAll();
+	mPipelines->Save();
+
+	mRenderGraph = make_unique<D3D12RenderGraph>(md3dDevice.Get(), mCommandQueue.Get(), mComputeCommandQueue.Get());
+	mRenderGraph->Recorder().SetMode(mAsyncComputeMode);
+	mRenderGraph->Recorder().SetTimeline(&mQueueTimeline);
+	mRenderGraph->SetProfiler(mGpuProfiler.get());
+	BuildPasses();
+	mRenderGraph->Compile();
+
+	mUploadBatcher->Flush(mCommandList.Get());
+
 	ThrowIfFailed(mCommandList->Close());
 
 	ThrowIfFailed(mComputeCommandList->Close());
 
 	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
 	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+	mUploadBatcher->Signal(mCommandQueue.Get());
 
 	ID3D12CommandList* computeCmdsLists[] = { mComputeCommandList.Get() };
 	mCommandQueue->ExecuteCommandLists(_countof(computeCmdsLists), computeCmdsLists);
@@ -70,19 +119,40 @@ void BaseApp::Update(const Timer& gt)
 {
 	OnKeyboardInput(gt);
 
-	mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % gNumFrameResources;
+	mCurrFrameResourceIndex = (int)mFrameScheduler->BeginFrame();
 	mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
 	mCurrCuller = mCullers[mCurrFrameResourceIndex].get();
 
-	if (mCurrFrameResource->Fence != 0 && mFence->GetCompletedValue() < mCurrFrameResource->Fence)
+	mProfiler.BeginFrame(mFrameScheduler->CurrentFrame());
+	ProfileScope updateScope(mProfiler, mUpdateScope);
+
+	// CPU-only work, overlapping the GPU finishing this slot's previous frame.
+	AnimateMaterials(gt);
+	UpdateTransforms();
+	PackInstances();
+
+	if (mCaptureWriter != nullptr)
 	{
-		HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-		ThrowIfFailed(mFence->SetEventOnCompletion(mCurrFrameResource->Fence, eventHandle));
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
+		RecordCapture(gt);
 	}
 
-	AnimateMaterials(gt);
+	{
+		ProfileScope waitScope(mProfiler, mWaitScope);
+		mFrameScheduler->WaitForSlot();
+		mRenderGraph->Recorder().WaitForSignal(PassQueue::Compute, mCurrFrameResource->ComputeFence);
+	}
+
+	mGpuProfiler->BeginFrame(mCurrFrameResourceIndex, mFrameScheduler->CurrentFrame());
+
+	// The slot's previous frame is done, so its culling results are ready to read.
+	CullingCounters counters;
+	if (mCurrCuller->ReadStats(counters))
+	{
+		mCullingStats.AddFrame(mFrameScheduler->CurrentFrame() - mFrameScheduler->FramesInFlight(), counters);
+	}
+
+	mUploadBatcher->Recycle();
+
 	UpdateInstanceBuffer(gt);
 	UpdateMaterialBuffer(gt);
 	UpdateMainPassCB(gt);
@@ -90,81 +160,158 @@ void BaseApp::Update(const Timer& gt)
 
 void BaseApp::DoComputeWork(const Timer& gt)
 {
-	auto cmdListAlloc = mCurrCuller->CommandAllocator();
-
-	ThrowIfFailed(cmdListAlloc->Reset());
-
-	ThrowIfFailed(mComputeCommandList->Reset(cmdListAlloc.Get(), nullptr));
-
-	// Set compute root signature
-	CullRenderItems();
-
-	ThrowIfFailed(mComputeCommandList->Close());
-
-	ID3D12CommandList* cmdsLists[] = { mComputeCommandList.Get() };
-	mComputeCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
-
-	mCurrFrameResource->ComputeFence = ++mCurrentComputeFence;
-
-	mComputeCommandQueue->Signal(mComputeFence.Get(), mCurrentComputeFence);
+	// Culling is recorded as a compute pass of the frame in Draw.
 }
 
 void BaseApp::Draw(const Timer& gt)
 {
-	auto cmdListAlloc = mCurrFrameResource->CmdListAlloc;
-
-	ThrowIfFailed(cmdListAlloc->Reset());
-
-	ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));
-
-	ID3D12DescriptorHeap* descriptorheaps[] = { mSrvDescriptorHeap.Get() };
-	mCommandList->SetDescriptorHeaps(_countof(descriptorheaps), descriptorheaps);
+	ProfileScope drawScope(mProfiler, mDrawScope);
 
-	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
+	mRenderGraph->SetImportedResource(mBackBufferResource, CurrentBackBuffer());
+	mRenderGraph->SetImportedResource(mDepthBufferResource, mDepthStencilBuffer.Get());
+	mRenderGraph->SetImportedResource(mIndirectArgsResource, mCurrCuller->GetIndirectBuffer());
+	mRenderGraph->SetImportedResource(mVisibilityResource, mCurrCuller->GetVisibilityResource());
+	mRenderGraph->SetImportedResource(mCullingStatsResource, mCurrCuller->GetStatsResource());
 
-	auto matBuffer = mCurrFrameResource->MaterialBuffer->Resource();
-	mCommandList->SetGraphicsRootShaderResourceView(matBufferRootParameterIndex, matBuffer->GetGPUVirtualAddress());
+	mRenderGraph->Execute(mCurrFrameResource->PassCmdListAllocs);
+	mCurrFrameResource->ComputeFence = mRenderGraph->Recorder().LastSignal(PassQueue::Compute);
+	mUploadBatcher->Signal(mCommandQueue.Get());
 
-	mCommandList->SetGraphicsRootDescriptorTable(texRootParameterIndex, mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+	{
+		ProfileScope presentScope(mProfiler, mPresentScope);
+		ThrowIfFailed(mSwapChain->Present(0, 0));
+	}
+	mCurrBackBuffer = (mCurrBackBuffer + 1) % SwapChainBufferCount;
 
-	mCommandList->RSSetViewports(1, &mScreenViewport);
-	mCommandList->RSSetScissorRects(1, &mScissorRect);
+	mCommandQueue->Signal(mFence.Get(), ++mCurrentFence);
+	mFrameScheduler->EndFrame(mCurrentFence);
+}
 
-	auto toRenderTarget = CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+wstring BaseApp::FrameStatsText() const
+{
+	const auto& stats = mFrameScheduler->Stats();
+
+	wostringstream text;
+	text.precision(2);
+	text << fixed
+		<< L"  blocked: " << stats.AverageBlockedMs
+		<< L" ms (p95 " << stats.P95BlockedMs
+		<< L", max " << stats.MaxBlockedMs
+		<< L", " << stats.BlockedFrames << L"/" << stats.Frames << L" frames)"
+		<< L"  in flight: " << mFrameScheduler->FramesInFlight()
+		<< L"  compute overlapped: " << mQueueTimeline.Stats().OverlappedFrames << L"/" << mQueueTimeline.Stats().Frames
+		<< L"  gpu graphics: " << mProfiler.Stats(mGpuProfiler->Core().TotalScope(PassQueue::Graphics)).AverageMs
+		<< L" ms, compute: " << mProfiler.Stats(mGpuProfiler->Core().TotalScope(PassQueue::Compute)).AverageMs << L" ms"
+		<< L"  visible: " << mCullingStats.Last().Visible << L"/" << mCullingStats.Last().Tested;
+	return text.str();
+}
 
-	mCommandList->ResourceBarrier(1, &toRenderTarget);
+void BaseApp::SetCapturePath(const string& path)
+{
+	mCaptureFile = make_unique<ofstream>(path, ios::binary | ios::trunc);
+	mCaptureWriter = make_unique<FrameCaptureWriter>(*mCaptureFile);
+}
 
-	mCommandList->ClearRenderTargetView(CurrentBackBufferView(), Colors::LightSteelBlue, 0, nullptr);
-	mCommandList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+void BaseApp::RecordCapture(const Timer& gt)
+{
+	mCapture.Frame = mFrameScheduler->CurrentFrame();
+	mCapture.DeltaTime = gt.GetDeltaTime();
+	mCapture.TotalTime = gt.GetTotalTime();
+	mCapture.View = mCamera.GetView4x4f();
+	mCapture.Proj = mCamera.GetProj4x4f();
+
+	mCapture.Items.resize(mAllRitems.size());
+	for (size_t i = 0; i < mAllRitems.size(); ++i)
+	{
+		const RenderItem* ri = mAllRitems[i].get();
+		auto& item = mCapture.Items[i];
 
-	auto currentBackBufferView = CurrentBackBufferView();
-	auto depthStencilView = DepthStencilView();
-	mCommandList->OMSetRenderTargets(1, &currentBackBufferView, true, &depthStencilView);
+		item.ObjectIndex = ri->ObjCBIndex;
+		item.MaterialIndex = ri->Mat != nullptr ? ri->Mat->MatCBIndex : 0;
+		item.BoundsCenter = ri->Bounds.Center;
+		item.BoundsExtents = ri->Bounds.Extents;
 
-	auto passCB = mCurrFrameResource->PassCB->Resource();
-	mCommandList->SetGraphicsRootConstantBufferView(passCBRootParameterIndex, passCB->GetGPUVirtualAddress());
+		const auto& archetype = mInstanceStorage.Archetype(ri->Archetype);
+		item.Instances.resize(archetype.Size());
+		for (UINT j = 0; j < archetype.Size(); ++j)
+		{
+			item.Instances[j].World = archetype.World[j];
+			item.Instances[j].TexTransform = mInstanceStorage.TexTransform(ri->Archetype, j);
+			item.Instances[j].MaterialIndex = archetype.InstanceMaterial[j];
+		}
+	}
 
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+	mCapture.CullCommandCount = mCurrCuller->CountBuffer()->Count;
+	mCapture.CullObjects.resize(mSceneObjectData.size());
+	for (size_t i = 0; i < mSceneObjectData.size(); ++i)
+	{
+		mCapture.CullObjects[i].WorldPosition = mSceneObjectData[i].WorldPosition;
+		mCapture.CullObjects[i].Size = mSceneObjectData[i].Size;
+	}
 
-	auto toPresent = CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-	mCommandList->ResourceBarrier(1, &toPresent);
+	mCaptureWriter->Write(mCapture);
+}
 
-	ThrowIfFailed(mCommandList->Close());
+void BaseApp::BuildPasses()
+{
+	auto& graph = *mRenderGraph;
 
-	mCommandQueue->Wait(mComputeFence.Get(), mCurrentComputeFence);
+	mBackBufferResource = graph.ImportResource("backBuffer", D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+	mDepthBufferResource = graph.ImportResource("depthBuffer", D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	mIndirectArgsResource = graph.ImportResource("indirectArgs", D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+	mVisibilityResource = graph.ImportResource("visibility", D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	mCullingStatsResource = graph.ImportResource("cullingStats", D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
 
-	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
-	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+	// Compute passes go first so the frame's culling is submitted before its
+	// graphics work and can run alongside the previous frame's shading.
+	auto resetArgs = graph.AddPass("resetIndirectArgs", PassQueue::Compute, [this](ID3D12GraphicsCommandList* cmdList)
+		{
+			mCurrCuller->ResetIndirectCommands(cmdList);
+		});
+	graph.Write(resetArgs, mIndirectArgsResource, D3D12_RESOURCE_STATE_COPY_DEST);
+	graph.Write(resetArgs, mCullingStatsResource, D3D12_RESOURCE_STATE_COPY_DEST);
 
-	ThrowIfFailed(mSwapChain->Present(0, 0));
-	mCurrBackBuffer = (mCurrBackBuffer + 1) % SwapChainBufferCount;
+	auto culling = graph.AddPass("culling", PassQueue::Compute, [this](ID3D12GraphicsCommandList* cmdList)
+		{
+			CullRenderItems(cmdList);
+		});
+	graph.Write(culling, mIndirectArgsResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	graph.Write(culling, mVisibilityResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	graph.Write(culling, mCullingStatsResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	// Read on the CPU when this frame slot comes round again, see Update.
+	auto cullingReadback = graph.AddPass("cullingReadback", PassQueue::Graphics, [this](ID3D12GraphicsCommandList* cmdList)
+		{
+			mCurrCuller->CopyStatsToReadback(cmdList);
+		}, true);
+	graph.Read(cullingReadback, mIndirectArgsResource, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	graph.Read(cullingReadback, mCullingStatsResource, D3D12_RESOURCE_STATE_COPY_SOURCE);
 
-	mCurrFrameResource->Fence = ++mCurrentFence;
+	auto upload = graph.AddPass("upload", PassQueue::Graphics, [this](ID3D12GraphicsCommandList* cmdList)
+		{
+			mUploadBatcher->Flush(cmdList);
+		}, true);
 
-	mCommandQueue->Signal(mFence.Get(), mCurrentFence);
+	auto clear = graph.AddPass("clear", PassQueue::Graphics, [this](ID3D12GraphicsCommandList* cmdList)
+		{
+			cmdList->ClearRenderTargetView(CurrentBackBufferView(), Colors::LightSteelBlue, 0, nullptr);
+			cmdList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+		});
+	graph.Write(clear, mBackBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	graph.Write(clear, mDepthBufferResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
+	auto opaque = graph.AddPass("opaque", PassQueue::Graphics, [this](ID3D12GraphicsCommandList* cmdList)
+		{
+			cmdList->SetPipelineState(mPipelines->Get("opaque"));
+			BindMainPass(cmdList);
+			DrawRenderItems(cmdList, mRitemLayer[(int)RenderLayer::Opaque]);
+		});
+	graph.Read(opaque, mIndirectArgsResource, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+	graph.Read(opaque, mVisibilityResource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	graph.Write(opaque, mBackBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	graph.Write(opaque, mDepthBufferResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	// Textures the opaque pass samples are uploaded outside the graph's resources.
+	graph.DependsOn(opaque, upload);
 }
 
 void BaseApp::OnMouseDown(WPARAM btnState, int x, int y)
@@ -223,55 +370,124 @@ void BaseApp::OnKeyboardInput(const Timer& gt)
 	mCamera.UpdateViewMatrix();
 }
 
-void BaseApp::CullRenderItems()
+void BaseApp::BindInstance(TransformNode node, RenderItem* ritem, UINT instance)
 {
-	auto view = mCamera.GetView();
-	auto proj = mCamera.GetProj();
-	auto viewProj = XMMatrixMultiply(view, proj);
+	if (node >= mInstanceBindings.size())
+	{
+		mInstanceBindings.resize(node + 1);
+	}
+	mInstanceBindings[node] = { ritem, instance };
+}
 
-	vector<SceneObjectData> sceneObjectDatas;
+void BaseApp::UpdateTransforms()
+{
+	mTransforms.Update();
 
+	const auto& changed = mTransforms.Changed();
+	ThreadPool::Default().ParallelFor(0, (int)changed.size(), 1024, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			const TransformNode node = changed[i];
+			if (node < mInstanceBindings.size() && mInstanceBindings[node].Item != nullptr)
+			{
+				const auto& binding = mInstanceBindings[node];
+				mInstanceStorage.SetWorld(binding.Item->Archetype, binding.Instance, mTransforms.World(node));
+			}
+		}
+	});
+}
+
+void BaseApp::BuildInstanceStorage()
+{
 	for (auto& e : mAllRitems)
 	{
-		for (auto& instance : e->Instances)
+		RenderItem* ri = e.get();
+		const UINT archetype = mInstanceStorage.AddArchetype(
+			ri->ObjCBIndex,
+			ri->Bounds.Center,
+			ri->Bounds.Extents);
+
+		mInstanceStorage.Reserve(archetype, (UINT)ri->Instances.size());
+		for (UINT i = 0; i < (UINT)ri->Instances.size(); ++i)
 		{
-			SceneObjectData sceneObjectData;
-			XMMATRIX world = XMLoadFloat4x4(&instance.World);
-			sceneObjectData.WorldPosition = XMFLOAT4(instance.World._41, instance.World._42, instance.World._43, instance.World._44);
-			sceneObjectData.Size = e->Bounds.Extents;
-			sceneObjectDatas.push_back(sceneObjectData);
+			const auto& instance = ri->Instances[i];
+			mInstanceStorage.AddInstance(archetype, instance.World, instance.MaterialIndex);
+			mInstanceStorage.SetTexTransform(archetype, i, instance.TexTransform);
 		}
-	}
 
-	mCurrCuller->CullSceneObjects(
-		md3dDevice.Get(),
-		mComputeCommandList.Get(),
-		viewProj,
-		sceneObjectDatas);
+		ri->Archetype = archetype;
+		ri->InstanceCount = (UINT)ri->Instances.size();
+		vector<Instance>().swap(ri->Instances);
+	}
 }
 
-void BaseApp::UpdateInstanceBuffer(const Timer& gt)
+void BaseApp::PackInstances()
 {
-	auto currInstanceBuffer = mCurrFrameResource->ObjectCB.get();
+	mInstanceData.resize(mInstanceStorage.ObjectSlotCount());
+	mSceneObjectData.resize(mInstanceStorage.InstanceCount());
 
-	for (auto& e : mAllRitems)
+	UINT sceneObjectOffset = 0;
+
+	for (UINT a = 0; a < mInstanceStorage.ArchetypeCount(); ++a)
 	{
-		UINT objCount = (UINT)e->Instances.size();
+		const auto& archetype = mInstanceStorage.Archetype(a);
+		const UINT cullOffset = sceneObjectOffset;
 
-		for (int i = 0; i < objCount; ++i)
+		ThreadPool::Default().ParallelFor(0, (int)archetype.Size(), 1024, [&](int begin, int end)
 		{
-			XMMATRIX world = XMLoadFloat4x4(&e->Instances[i].World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&e->Instances[i].TexTransform);
+			// Each loop streams only the components it needs.
+			for (int i = begin; i < end; ++i)
+			{
+				ObjectData& objData = mInstanceData[archetype.ObjectOffset + i];
+				XMStoreFloat4x4(&objData.World, XMMatrixTranspose(XMLoadFloat4x4(&archetype.World[i])));
+				if (archetype.HasTexTransforms())
+				{
+					XMStoreFloat4x4(&objData.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&archetype.TexTransform[i])));
+				}
+				else
+				{
+					objData.TexTransform = InstanceStorage::Identity();
+				}
+				objData.MaterialIndex = archetype.InstanceMaterial[i];
+			}
+
+			for (int i = begin; i < end; ++i)
+			{
+				SceneObjectData& sceneObjectData = mSceneObjectData[cullOffset + i];
+				sceneObjectData.WorldPosition = archetype.Position[i];
+				sceneObjectData.Size = archetype.BoundsExtents;
+			}
+		});
+
+		sceneObjectOffset += archetype.Size();
+	}
 
-			ObjectData objData;
-			XMStoreFloat4x4(&objData.World, XMMatrixTranspose(world));
-			XMStoreFloat4x4(&objData.TexTransform, XMMatrixTranspose(texTransform));
-			objData.MaterialIndex = e->Mat->MatCBIndex;
+	for (auto& e : mAllRitems)
+	{
+		e->InstanceCount = mInstanceStorage.Archetype(e->Archetype).Size();
+	}
+}
 
-			currInstanceBuffer->CopyData(e->ObjCBIndex + i, objData);
-		}
+void BaseApp::CullRenderItems(ID3D12GraphicsCommandList* cmdList)
+{
+	auto view = mCamera.GetView();
+	auto proj = mCamera.GetProj();
+	auto viewProj = XMMatrixMultiply(view, proj);
+
+	GpuProfileScope scope(mGpuProfiler.get(), cmdList, mCullScope);
+	mCurrCuller->CullSceneObjects(
+		md3dDevice.Get(),
+		cmdList,
+		viewProj,
+		mSceneObjectData);
+}
 
-		e->InstanceCount = objCount;
+void BaseApp::UpdateInstanceBuffer(const Timer& gt)
+{
+	if (!mInstanceData.empty())
+	{
+		mCurrFrameResource->ObjectCB->CopyData(0, mInstanceData.data(), (UINT)mInstanceData.size());
 	}
 }
 
@@ -337,6 +553,29 @@ void BaseApp::UpdateMainPassCB(const Timer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
+void BaseApp::BindMainPass(ID3D12GraphicsCommandList* cmdList)
+{
+	ID3D12DescriptorHeap* descriptorheaps[] = { mSrvDescriptorHeap.Get() };
+	cmdList->SetDescriptorHeaps(_countof(descriptorheaps), descriptorheaps);
+
+	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
+
+	auto matBuffer = mCurrFrameResource->MaterialBuffer->Resource();
+	cmdList->SetGraphicsRootShaderResourceView(matBufferRootParameterIndex, matBuffer->GetGPUVirtualAddress());
+
+	cmdList->SetGraphicsRootDescriptorTable(texRootParameterIndex, mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+
+	cmdList->RSSetViewports(1, &mScreenViewport);
+	cmdList->RSSetScissorRects(1, &mScissorRect);
+
+	auto currentBackBufferView = CurrentBackBufferView();
+	auto depthStencilView = DepthStencilView();
+	cmdList->OMSetRenderTargets(1, &currentBackBufferView, true, &depthStencilView);
+
+	auto passCB = mCurrFrameResource->PassCB->Resource();
+	cmdList->SetGraphicsRootConstantBufferView(passCBRootParameterIndex, passCB->GetGPUVirtualAddress());
+}
+
 void BaseApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const vector<RenderItem*>& ritems)
 {
 	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
@@ -347,6 +586,7 @@ void BaseApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const vector<R
 
 	cmdList->SetGraphicsRootShaderResourceView(visibilityRootParameterIndex, visibilityBuffer->GetGPUVirtualAddress());
 
+	GpuProfileScope scope(mGpuProfiler.get(), cmdList, mExecuteIndirectScope);
 	cmdList->ExecuteIndirect(mCurrCuller->GetCommandSignature(), (UINT)mCurrCuller->CountBuffer()->Count, mCurrCuller->GetIndirectBuffer(), 0, nullptr, 0);
 }
 
@@ -356,9 +596,7 @@ void BaseApp::BuildWireFramePSOs()
 	{
 		auto psoDesc = desc.second;
 		psoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
-		ComPtr<ID3D12PipelineState> wireframePSO;
-		ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&wireframePSO)));
-		mPSOs[desc.first + "_wireframe"] = wireframePSO;
+		mPipelines->AddGraphics(desc.first + "_wireframe", psoDesc);
 	}
 }
 
@@ -7,13 +7,26 @@
 #include "FrustumCulling.h"
 #include "CubeRenderTarget.h"
 #include "GPUFrustumCulling.h"
+#include "D3D12GpuProfiler.h"
+#include "D3D12RenderGraph.h"
+#include "FrameCapture.h"
+#include "FrameScheduler.h"
+#include "InstanceStorage.h"
+#include "PipelineStateLibrary.h"
+#include "TransformHierarchy.h"
+#include "UploadBatcher.h"
 
 const UINT CubeMapSize = 512;
 
+const char* const QueueTimelineLogPath = "QueueTimeline.log";
+const char* const ProfileSummaryPath = "ProfileSummary.txt";
+const char* const ProfileTracePath = "ProfileTrace.json";
+const char* const CullingStatsPath = "CullingStats.txt";
+
 class BaseApp : public D3DApp
 {
 public:
-	BaseApp(HINSTANCE hInstance);
+	BaseApp(HINSTANCE hInstance, uint32_t framesInFlight = DefaultFramesInFlight);
 	BaseApp(const BaseApp& rhs) = delete;
 	BaseApp& operator=(const BaseApp& rhs) = delete;
 	~BaseApp();
@@ -34,23 +47,49 @@ public:
 	virtual void OnKeyboardInput(const Timer& gt);
 
 	virtual void AnimateMaterials(const Timer& gt) {}
-	void CullRenderItems();
+	void UpdateTransforms();
+	void PackInstances();
+	void CullRenderItems(ID3D12GraphicsCommandList* cmdList);
 	void UpdateInstanceBuffer(const Timer& gt);
 	void UpdateMaterialBuffer(const Timer& gt);
 	void UpdateMainPassCB(const Timer& gt);
 
+	void BindMainPass(ID3D12GraphicsCommandList* cmdList);
 	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const vector<RenderItem*>& ritems);
 
 	void BuildWireFramePSOs();
 
 	void EnableD3D12DebugLayer();
 
+	// The instance's World follows node's world matrix from the next Update on.
+	// A null ritem unbinds the node; do so before removing it, handles are reused.
+	void BindInstance(TransformNode node, RenderItem* ritem, UINT instance);
+
+	// Call before Initialize.
+	void SetAsyncComputeMode(AsyncComputeMode mode) { mAsyncComputeMode = mode; }
+
+	// Records every frame's camera, instances and culling inputs to path, for
+	// FrameReplayer. Call before Initialize.
+	void SetCapturePath(const string& path);
+
 protected:
 	virtual void Build() {}
 
+	// Moves every render item's Instances into mInstanceStorage. Runs after Build().
+	void BuildInstanceStorage();
+
+	virtual wstring FrameStatsText() const override;
+
+	void RecordCapture(const Timer& gt);
+
+	// Declares the frame's render graph passes, recorded in parallel every Draw.
+	// Called once after Build(); the graph is compiled right after.
+	virtual void BuildPasses();
+
 protected:
 	bool mWireFrameMode = false;
 
+	unique_ptr<FrameScheduler> mFrameScheduler;
 	vector<unique_ptr<FrameResource>> mFrameResources;
 	FrameResource* mCurrFrameResource = nullptr;
 	int mCurrFrameResourceIndex = 0;
@@ -77,16 +116,63 @@ protected:
 	unordered_map<string, unique_ptr<Texture>> mTextures;
 	unordered_map<string, unique_ptr<Material>> mMaterials;
 	unordered_map<string, ComPtr<ID3DBlob>> mShaders;
-	unordered_map<string, ComPtr<ID3D12PipelineState>> mPSOs;
 	unordered_map<string, D3D12_GRAPHICS_PIPELINE_STATE_DESC> mPsoDescs;
 
+	// Every PSO, created in parallel after Build() and cached across runs.
+	unique_ptr<PipelineStateLibrary> mPipelines;
+
 	vector<D3D12_INPUT_ELEMENT_DESC> mStdInputLayout;
 
 	vector<unique_ptr<RenderItem>> mAllRitems;
 
 	vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count];
+
+	// Per-instance data of every render item, one array per component. Per-frame
+	// passes read it instead of RenderItem::Instances, which is empty after Build.
+	InstanceStorage mInstanceStorage;
+
+	// Parent-child placement of instances, e.g. parts attached to a vehicle. Move
+	// nodes with SetLocal; Update copies the world matrices that changed into the
+	// bound instances before they are packed.
+	TransformHierarchy mTransforms;
+
+	struct InstanceBinding
+	{
+		RenderItem* Item = nullptr;
+		UINT Instance = 0;
+	};
+	// Indexed by node.
+	vector<InstanceBinding> mInstanceBindings;
+
+	// Built by PackInstances before the frame slot is free, copied or culled after.
+	vector<ObjectData> mInstanceData;
+	vector<SceneObjectData> mSceneObjectData;
 	vector<Texture*> mTextureLayer[(int)TextureLayer::Count];
 
+	// Static geometry and other one-off uploads; flushed at the start of each frame.
+	unique_ptr<UploadBatcher> mUploadBatcher;
+
+	unique_ptr<D3D12RenderGraph> mRenderGraph;
+	RenderGraphResource mBackBufferResource = 0;
+	RenderGraphResource mDepthBufferResource = 0;
+	RenderGraphResource mIndirectArgsResource = 0;
+	RenderGraphResource mVisibilityResource = 0;
+	RenderGraphResource mCullingStatsResource = 0;
+
+	AsyncComputeMode mAsyncComputeMode = AsyncComputeMode::Overlapped;
+	// Written to QueueTimelineLogPath on exit.
+	QueueTimeline mQueueTimeline;
+
+	// CPU scopes and GPU timestamps; summary and trace are written on exit.
+	Profiler mProfiler;
+	unique_ptr<D3D12GpuProfiler> mGpuProfiler;
+	uint32_t mUpdateScope = 0;
+	uint32_t mWaitScope = 0;
+	uint32_t mDrawScope = 0;
+	uint32_t mPresentScope = 0;
+	uint32_t mCullScope = GpuProfiler::InvalidScope;
+	uint32_t mExecuteIndirectScope = GpuProfiler::InvalidScope;
+
 	PassConstants mMainPassCB;
 
 	Camera mCamera;
@@ -95,5 +181,14 @@ protected:
 
 	vector<unique_ptr<GPUFrustumCulling>> mCullers;
 	GPUFrustumCulling* mCurrCuller;
+
+	// GPU culling counters, read back frames in flight after they are produced.
+	// Written to CullingStatsPath on exit.
+	CullingStats mCullingStats;
+
+	unique_ptr<ofstream> mCaptureFile;
+	unique_ptr<FrameCaptureWriter> mCaptureWriter;
+	// Reused from frame to frame.
+	CaptureFrame mCapture;
 };
 
@@ -0,0 +1,57 @@
+// Checks BezierPatchUtil::EvaluateBatch against the scalar BezierUtil.hlsl port and
+// times CPU pre-tessellation of 1024 patches at the BezierTessellation factor of
+// 25. Standalone; it is not part of the app project.
+//
+//   cl /std:c++17 /O2 /EHsc /I.. BezierPatchBenchmark.cpp ../BezierPatch.cpp
+
+#include "BezierPatch.h"
+#include <chrono>
+#include <cstdio>
+
+int main()
+{
+	// The control points of the BezierTessellation demo patch.
+	const BezierPatch patch =
+	{
+		XMFLOAT3(-10.0f, -10.0f, +15.0f), XMFLOAT3(-5.0f, 0.0f, +15.0f), XMFLOAT3(+5.0f, 0.0f, +15.0f), XMFLOAT3(+10.0f, 0.0f, +15.0f),
+		XMFLOAT3(-15.0f, 0.0f, +5.0f), XMFLOAT3(-5.0f, 0.0f, +5.0f), XMFLOAT3(+5.0f, 20.0f, +5.0f), XMFLOAT3(+15.0f, 0.0f, +5.0f),
+		XMFLOAT3(-15.0f, 0.0f, -5.0f), XMFLOAT3(-5.0f, 0.0f, -5.0f), XMFLOAT3(+5.0f, 0.0f, -5.0f), XMFLOAT3(+15.0f, 0.0f, -5.0f),
+		XMFLOAT3(-10.0f, 10.0f, -15.0f), XMFLOAT3(-5.0f, 0.0f, -15.0f), XMFLOAT3(+5.0f, 0.0f, -15.0f), XMFLOAT3(+25.0f, 10.0f, -15.0f)
+	};
+
+	const uint32_t tessFactor = 25;
+	const uint32_t patchCount = 1024;
+
+	printf("max error %g\n", BezierPatchUtil::GetBatchError(patch, tessFactor));
+
+	vector<BezierPatch> patches(patchCount, patch);
+
+	auto start = chrono::high_resolution_clock::now();
+	auto meshData = BezierPatchUtil::Tessellate(patches, tessFactor);
+	auto batchEnd = chrono::high_resolution_clock::now();
+
+	float checksum = 0.0f;
+	const uint32_t rowSize = tessFactor + 1;
+	for (uint32_t p = 0; p < patchCount; ++p)
+	{
+		for (uint32_t i = 0; i < rowSize; ++i)
+		{
+			for (uint32_t j = 0; j < rowSize; ++j)
+			{
+				float u = (float)j / tessFactor;
+				float v = (float)i / tessFactor;
+				XMFLOAT3 pos = BezierPatchUtil::CubicBezierSum(patches[p], BezierPatchUtil::BernsteinBasis(u), BezierPatchUtil::BernsteinBasis(v));
+				XMFLOAT3 normal = BezierPatchUtil::EvaluateNormal(patches[p], u, v);
+				checksum += pos.y + normal.y;
+			}
+		}
+	}
+	auto scalarEnd = chrono::high_resolution_clock::now();
+
+	double batchMs = chrono::duration<double, milli>(batchEnd - start).count();
+	double scalarMs = chrono::duration<double, milli>(scalarEnd - batchEnd).count();
+
+	printf("%u patches, %zu vertices, %zu triangles\n", patchCount, meshData.Vertices.size(), meshData.Indices32.size() / 3);
+	printf("batch %.2f ms, scalar %.2f ms (checksum %g)\n", batchMs, scalarMs, checksum);
+	return 0;
+}
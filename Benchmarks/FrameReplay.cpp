@@ -0,0 +1,83 @@
+// Replays a capture recorded with "-capture file" through FrameReplayer and prints
+// one line per frame. Given the lines of an earlier run it compares instead and
+// fails on the first frame that differs, as a regression check. Standalone; it is
+// not part of the app project and needs no device, so it also builds on Linux.
+// There it needs the DirectXMath headers and a sal.h, which DirectXMath includes;
+// DirectXMath points to the one in the .NET runtime (src/coreclr/pal/inc/rt/sal.h).
+//
+//   cl /std:c++17 /O2 /EHsc /I.. FrameReplay.cpp ../FrameReplayer.cpp ../FrameCapture.cpp ../CullingStats.cpp ../ThreadPool.cpp
+//   g++ -std=c++17 -O2 -pthread -I.. -I<DirectXMath>/Inc -I<sal.h directory> FrameReplay.cpp ../FrameReplayer.cpp ../FrameCapture.cpp ../CullingStats.cpp ../ThreadPool.cpp
+//
+//   FrameReplay capture.bin [expected.txt]
+
+#include "FrameReplayer.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: FrameReplay capture.bin [expected.txt]\n");
+		return 2;
+	}
+
+	ifstream capture(argv[1], ios::binary);
+	FrameCaptureReader reader(capture);
+	if (!reader.IsValid())
+	{
+		printf("%s is not a frame capture\n", argv[1]);
+		return 2;
+	}
+
+	ifstream expected;
+	if (argc > 2)
+	{
+		expected.open(argv[2]);
+		if (!expected)
+		{
+			printf("cannot open %s\n", argv[2]);
+			return 2;
+		}
+	}
+
+	FrameReplayer replayer;
+	CaptureFrame frame;
+	ReplayFrameResult result;
+
+	uint64_t frames = 0;
+	double packMs = 0.0;
+	double cullMs = 0.0;
+
+	while (reader.Read(frame))
+	{
+		replayer.Replay(frame, result);
+		++frames;
+		packMs += result.PackMs;
+		cullMs += result.CullMs;
+
+		ostringstream line;
+		FrameReplayer::WriteResult(line, result);
+
+		if (!expected.is_open())
+		{
+			cout << line.str();
+			continue;
+		}
+
+		string expectedLine;
+		if (!getline(expected, expectedLine) || expectedLine + "\n" != line.str())
+		{
+			printf("frame %llu differs\n  expected: %s\n  replayed: %s", (unsigned long long)frame.Frame, expectedLine.c_str(), line.str().c_str());
+			return 1;
+		}
+	}
+
+	cerr << frames << " frames, pack " << (frames > 0 ? packMs / frames : 0.0)
+		<< " ms, cull " << (frames > 0 ? cullMs / frames : 0.0) << " ms per frame\n";
+	replayer.Stats().Write(cerr);
+	return 0;
+}
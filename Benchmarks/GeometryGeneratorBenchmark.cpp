@@ -0,0 +1,63 @@
+// Times each GeometryGenerator primitive generated from scratch against a
+// GeometryCache hit. Standalone; it is not part of the app project.
+//
+//   cl /std:c++17 /O2 /EHsc /I.. GeometryGeneratorBenchmark.cpp ../GeometryGenerator.cpp ../GeometryCache.cpp ../ThreadPool.cpp
+
+#include "GeometryCache.h"
+#include <chrono>
+#include <cstdio>
+
+int main()
+{
+	const int iterations = 1000;
+
+	struct Case
+	{
+		const char* Name;
+		GeometryKey Key;
+	};
+
+	const Case cases[] =
+	{
+		{ "box", GeometryKey::Box(1.0f, 1.0f, 1.0f, 3) },
+		{ "sphere", GeometryKey::Sphere(0.5f, 20, 20) },
+		{ "geosphere", GeometryKey::Geosphere(0.5f, 3) },
+		{ "geosphere6", GeometryKey::Geosphere(0.5f, 6) },
+		{ "cylinder", GeometryKey::Cylinder(0.5f, 0.3f, 3.0f, 20, 20) },
+		{ "grid", GeometryKey::Grid(20.0f, 30.0f, 60, 40) },
+		{ "quad", GeometryKey::Quad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f) }
+	};
+
+	GeometryCache cache;
+
+	for (auto& c : cases)
+	{
+		const int count = c.Key.Shape == GeometryShape::Geosphere && c.Key.Counts[0] == 6 ? 10 : iterations;
+
+		size_t checksum = 0;
+		auto start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			checksum += GeometryCache::Generate(c.Key).Indices32.size();
+		}
+		cache.Get(c.Key);
+
+		auto generateEnd = chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			checksum += cache.Get(c.Key)->Indices32.size();
+		}
+		auto cacheEnd = chrono::high_resolution_clock::now();
+
+		auto mesh = cache.Get(c.Key);
+		double generateUs = chrono::duration<double, micro>(generateEnd - start).count() / count;
+		double cacheUs = chrono::duration<double, micro>(cacheEnd - generateEnd).count() / count;
+
+		printf("%-10s %7zu vertices %7zu triangles  generate %9.2f us  cached %6.3f us (%zu)\n",
+			c.Name, mesh->Vertices.size(), mesh->Indices32.size() / 3, generateUs, cacheUs, checksum);
+	}
+
+	auto stats = cache.GetStats();
+	printf("hits %llu misses %llu\n", (unsigned long long)stats.Hits, (unsigned long long)stats.Misses);
+	return 0;
+}
@@ -0,0 +1,55 @@
+// Checks LandUtility::GetHillsRow against the scalar functions and times both on a
+// 4096x4096 grid. Exits with 1 if the error is past LandUtility::HillsRowMaxError.
+// Standalone; it is not part of the app project.
+//
+//   cl /std:c++17 /O2 /EHsc /I.. LandUtilityBenchmark.cpp ../ThreadPool.cpp ../MathHelper.cpp
+
+#include "LandUtility.h"
+#include <chrono>
+#include <cstdio>
+
+int main()
+{
+	const uint32_t gridSize = 4096;
+	const float worldSize = 4096.0f;
+
+	const float error = LandUtility::GetHillsRowError(worldSize, worldSize, 1025, 1027);
+	printf("max error %g\n", error);
+	if (!(error <= LandUtility::HillsRowMaxError))
+	{
+		printf("error is past the bound of %g\n", LandUtility::HillsRowMaxError);
+		return 1;
+	}
+
+	vector<float> heights(gridSize);
+	vector<XMFLOAT3> normals(gridSize);
+
+	auto start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < gridSize; ++i)
+	{
+		LandUtility::GetHillsRow(-0.5f * worldSize, 1.0f, 0.5f * worldSize - i, gridSize, heights.data(), normals.data());
+	}
+	auto batchEnd = chrono::high_resolution_clock::now();
+
+	float checksum = 0.0f;
+	for (uint32_t i = 0; i < gridSize; ++i)
+	{
+		for (uint32_t j = 0; j < gridSize; ++j)
+		{
+			float x = -0.5f * worldSize + j;
+			float z = 0.5f * worldSize - i;
+			checksum += LandUtility::GetHillsHeight(x, z) + LandUtility::GetHillsNormal(x, z).y;
+		}
+	}
+	auto scalarEnd = chrono::high_resolution_clock::now();
+
+	auto start2 = chrono::high_resolution_clock::now();
+	auto grid = LandUtility::CreateHillsGrid(worldSize, worldSize, gridSize, gridSize);
+	auto gridEnd = chrono::high_resolution_clock::now();
+
+	printf("batch rows   %10.2f ms\n", chrono::duration<double, milli>(batchEnd - start).count());
+	printf("scalar       %10.2f ms (checksum %g)\n", chrono::duration<double, milli>(scalarEnd - batchEnd).count(), checksum);
+	printf("hills grid   %10.2f ms (%zu vertices)\n", chrono::duration<double, milli>(gridEnd - start2).count(), grid.Vertices.size());
+
+	return 0;
+}
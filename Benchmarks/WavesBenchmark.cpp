@@ -0,0 +1,61 @@
+// Times Waves::Update on a 1024x1024 grid for a range of ThreadPool grain sizes.
+// Standalone; it is not part of the app project. Needs DirectXMath headers:
+//
+//   g++ -std=c++17 -O2 -I.. -I<DirectXMath>/Inc -I<sal.h directory> WavesBenchmark.cpp ../Waves.cpp ../WaveKernels.cpp ../ThreadPool.cpp -lpthread -o WavesBenchmark
+//   cl /std:c++17 /O2 /EHsc /I.. WavesBenchmark.cpp ../Waves.cpp ../WaveKernels.cpp ../ThreadPool.cpp
+
+#include "Waves.h"
+#include "WaveKernels.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	double TimeSteps(Waves& waves, int steps)
+	{
+		auto start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < steps; ++i)
+		{
+			// dt equal to the time step makes every call a full step.
+			waves.Update(0.03f);
+		}
+		auto end = chrono::high_resolution_clock::now();
+		return chrono::duration<double, milli>(end - start).count() / steps;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int gridSize = 1024;
+	const int steps = (argc > 1) ? atoi(argv[1]) : 50;
+	const bool pin = (argc > 2) && atoi(argv[2]) != 0;
+
+	ThreadPool pool(0, pin);
+
+	Waves waves(gridSize, gridSize, 1.0f, 0.03f, 4.0f, 0.2f);
+	waves.SetThreadPool(&pool);
+	waves.Disturb(gridSize / 2, gridSize / 2, 1.0f);
+
+	printf("%d threads, AVX2 %s, %d steps, pinned %s\n",
+		pool.ThreadCount(), WaveKernels::HasAVX2() ? "yes" : "no", steps, pin ? "yes" : "no");
+	printf("%8s %12s\n", "grain", "ms/step");
+
+	const int grains[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, gridSize };
+	for (int grain : grains)
+	{
+		waves.SetGrainSize(grain);
+
+		// Warm up the pool and the caches.
+		TimeSteps(waves, 2);
+
+		printf("%8d %12.3f\n", grain, TimeSteps(waves, steps));
+	}
+
+	WaveKernels::ForceScalar(true);
+	waves.SetGrainSize(WaveRowTile);
+	TimeSteps(waves, 2);
+	printf("%8s %12.3f\n", "scalar", TimeSteps(waves, steps));
+
+	return 0;
+}
@@ -0,0 +1,307 @@
+#include "BezierPatch.h"
+#include "SimdMath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// v / |v| per lane, zero where |v| is zero like XMVector3Normalize.
+	void Normalize4(__m128& x, __m128& y, __m128& z)
+	{
+		__m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 valid = _mm_cmpgt_ps(lenSq, _mm_setzero_ps());
+		__m128 invLen = SimdMath::Select(valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lenSq)), _mm_setzero_ps());
+
+		x = _mm_mul_ps(x, invLen);
+		y = _mm_mul_ps(y, invLen);
+		z = _mm_mul_ps(z, invLen);
+	}
+
+	void Store4(__m128 x, __m128 y, __m128 z, size_t lanes, XMFLOAT3* dst)
+	{
+		alignas(16) float out[3][4];
+		_mm_store_ps(out[0], x);
+		_mm_store_ps(out[1], y);
+		_mm_store_ps(out[2], z);
+		for (size_t k = 0; k < lanes; ++k)
+		{
+			dst[k] = XMFLOAT3(out[0][k], out[1][k], out[2][k]);
+		}
+	}
+
+	// Bernstein polynomials and their derivatives for four parameters at once;
+	// b[k] holds coefficient k for each lane.
+	void BernsteinBasis4(__m128 t, __m128 b[4], __m128 db[4])
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 three = _mm_set1_ps(3.0f);
+		const __m128 six = _mm_set1_ps(6.0f);
+
+		__m128 invT = _mm_sub_ps(one, t);
+		__m128 t2 = _mm_mul_ps(t, t);
+		__m128 invT2 = _mm_mul_ps(invT, invT);
+
+		b[0] = _mm_mul_ps(invT2, invT);
+		b[1] = _mm_mul_ps(three, _mm_mul_ps(t, invT2));
+		b[2] = _mm_mul_ps(three, _mm_mul_ps(t2, invT));
+		b[3] = _mm_mul_ps(t2, t);
+
+		__m128 tInvT = _mm_mul_ps(t, invT);
+		db[0] = _mm_mul_ps(_mm_set1_ps(-3.0f), invT2);
+		db[1] = _mm_sub_ps(_mm_mul_ps(three, invT2), _mm_mul_ps(six, tInvT));
+		db[2] = _mm_sub_ps(_mm_mul_ps(six, tInvT), _mm_mul_ps(three, t2));
+		db[3] = _mm_mul_ps(three, t2);
+	}
+
+	XMFLOAT3 Normalize(const XMFLOAT3& v)
+	{
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&v)));
+		return n;
+	}
+
+	XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(
+			a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x);
+	}
+}
+
+XMFLOAT4 BezierPatchUtil::BernsteinBasis(float t)
+{
+	float invT = 1.0f - t;
+
+	return XMFLOAT4(invT * invT * invT,
+		3.0f * t * invT * invT,
+		3.0f * t * t * invT,
+		t * t * t);
+}
+
+XMFLOAT4 BezierPatchUtil::dBernsteinBasis(float t)
+{
+	float invT = 1.0f - t;
+
+	return XMFLOAT4(-3 * invT * invT,
+		3 * invT * invT - 6 * t * invT,
+		6 * t * invT - 3 * t * t,
+		3 * t * t);
+}
+
+XMFLOAT3 BezierPatchUtil::CubicBezierSum(const BezierPatch& patch, const XMFLOAT4& basisU, const XMFLOAT4& basisV)
+{
+	const float bu[4] = { basisU.x, basisU.y, basisU.z, basisU.w };
+	const float bv[4] = { basisV.x, basisV.y, basisV.z, basisV.w };
+
+	XMFLOAT3 sum(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < 4; ++i)
+	{
+		XMFLOAT3 row(0.0f, 0.0f, 0.0f);
+		for (int j = 0; j < 4; ++j)
+		{
+			const XMFLOAT3& p = patch[i * 4 + j];
+			row.x += bu[j] * p.x;
+			row.y += bu[j] * p.y;
+			row.z += bu[j] * p.z;
+		}
+
+		sum.x += bv[i] * row.x;
+		sum.y += bv[i] * row.y;
+		sum.z += bv[i] * row.z;
+	}
+
+	return sum;
+}
+
+XMFLOAT3 BezierPatchUtil::EvaluateNormal(const BezierPatch& patch, float u, float v)
+{
+	XMFLOAT3 dpdu = CubicBezierSum(patch, dBernsteinBasis(u), BernsteinBasis(v));
+	XMFLOAT3 dpdv = CubicBezierSum(patch, BernsteinBasis(u), dBernsteinBasis(v));
+	return Normalize(Cross(dpdu, dpdv));
+}
+
+void BezierPatchUtil::EvaluateBatch(
+	const BezierPatch& patch,
+	const float* u,
+	const float* v,
+	size_t count,
+	XMFLOAT3* positions,
+	XMFLOAT3* normals,
+	XMFLOAT3* tangents)
+{
+	for (size_t base = 0; base < count; base += 4)
+	{
+		const size_t lanes = min<size_t>(4, count - base);
+
+		// Pad the last group with the final point so every lane is valid.
+		alignas(16) float uu[4];
+		alignas(16) float vv[4];
+		for (size_t k = 0; k < 4; ++k)
+		{
+			size_t src = base + min(k, lanes - 1);
+			uu[k] = u[src];
+			vv[k] = v[src];
+		}
+
+		__m128 bu[4], dbu[4], bv[4], dbv[4];
+		BernsteinBasis4(_mm_load_ps(uu), bu, dbu);
+		BernsteinBasis4(_mm_load_ps(vv), bv, dbv);
+
+		__m128 px = _mm_setzero_ps(), py = _mm_setzero_ps(), pz = _mm_setzero_ps();
+		__m128 ux = _mm_setzero_ps(), uy = _mm_setzero_ps(), uz = _mm_setzero_ps();
+		__m128 vx = _mm_setzero_ps(), vy = _mm_setzero_ps(), vz = _mm_setzero_ps();
+
+		for (int i = 0; i < 4; ++i)
+		{
+			// Row sums first, in the same order as CubicBezierSum.
+			__m128 rx = _mm_setzero_ps(), ry = _mm_setzero_ps(), rz = _mm_setzero_ps();
+			__m128 rdx = _mm_setzero_ps(), rdy = _mm_setzero_ps(), rdz = _mm_setzero_ps();
+
+			for (int j = 0; j < 4; ++j)
+			{
+				const XMFLOAT3& p = patch[i * 4 + j];
+				__m128 cx = _mm_set1_ps(p.x);
+				__m128 cy = _mm_set1_ps(p.y);
+				__m128 cz = _mm_set1_ps(p.z);
+
+				rx = _mm_add_ps(rx, _mm_mul_ps(bu[j], cx));
+				ry = _mm_add_ps(ry, _mm_mul_ps(bu[j], cy));
+				rz = _mm_add_ps(rz, _mm_mul_ps(bu[j], cz));
+
+				rdx = _mm_add_ps(rdx, _mm_mul_ps(dbu[j], cx));
+				rdy = _mm_add_ps(rdy, _mm_mul_ps(dbu[j], cy));
+				rdz = _mm_add_ps(rdz, _mm_mul_ps(dbu[j], cz));
+			}
+
+			px = _mm_add_ps(px, _mm_mul_ps(bv[i], rx));
+			py = _mm_add_ps(py, _mm_mul_ps(bv[i], ry));
+			pz = _mm_add_ps(pz, _mm_mul_ps(bv[i], rz));
+
+			ux = _mm_add_ps(ux, _mm_mul_ps(bv[i], rdx));
+			uy = _mm_add_ps(uy, _mm_mul_ps(bv[i], rdy));
+			uz = _mm_add_ps(uz, _mm_mul_ps(bv[i], rdz));
+
+			vx = _mm_add_ps(vx, _mm_mul_ps(dbv[i], rx));
+			vy = _mm_add_ps(vy, _mm_mul_ps(dbv[i], ry));
+			vz = _mm_add_ps(vz, _mm_mul_ps(dbv[i], rz));
+		}
+
+		if (positions)
+		{
+			Store4(px, py, pz, lanes, positions + base);
+		}
+
+		if (normals)
+		{
+			__m128 nx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+			__m128 ny = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+			__m128 nz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+
+			Normalize4(nx, ny, nz);
+			Store4(nx, ny, nz, lanes, normals + base);
+		}
+
+		if (tangents)
+		{
+			Normalize4(ux, uy, uz);
+			Store4(ux, uy, uz, lanes, tangents + base);
+		}
+	}
+}
+
+GeometryGenerator::MeshData BezierPatchUtil::Tessellate(const BezierPatch& patch, uint32_t tessFactor)
+{
+	return Tessellate(vector<BezierPatch>{ patch }, tessFactor);
+}
+
+GeometryGenerator::MeshData BezierPatchUtil::Tessellate(const vector<BezierPatch>& patches, uint32_t tessFactor)
+{
+	GeometryGenerator::MeshData meshData;
+
+	const uint32_t n = max(tessFactor, 1u);
+	const uint32_t rowSize = n + 1;
+	const uint32_t patchVertexCount = rowSize * rowSize;
+
+	meshData.Vertices.resize((size_t)patchVertexCount * patches.size());
+	meshData.Indices32.reserve((size_t)6 * n * n * patches.size());
+
+	// The domain grid is the same for every patch.
+	vector<float> us(patchVertexCount);
+	vector<float> vs(patchVertexCount);
+	for (uint32_t i = 0; i < rowSize; ++i)
+	{
+		for (uint32_t j = 0; j < rowSize; ++j)
+		{
+			us[i * rowSize + j] = (float)j / n;
+			vs[i * rowSize + j] = (float)i / n;
+		}
+	}
+
+	vector<XMFLOAT3> positions(patchVertexCount);
+	vector<XMFLOAT3> normals(patchVertexCount);
+	vector<XMFLOAT3> tangents(patchVertexCount);
+
+	for (size_t p = 0; p < patches.size(); ++p)
+	{
+		EvaluateBatch(patches[p], us.data(), vs.data(), patchVertexCount, positions.data(), normals.data(), tangents.data());
+
+		const uint32_t baseVertex = (uint32_t)(p * patchVertexCount);
+		for (uint32_t k = 0; k < patchVertexCount; ++k)
+		{
+			auto& vertex = meshData.Vertices[baseVertex + k];
+			vertex.Position = positions[k];
+			vertex.Normal = normals[k];
+			vertex.TangentU = tangents[k];
+			vertex.TexC = XMFLOAT2(us[k], vs[k]);
+		}
+
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			for (uint32_t j = 0; j < n; ++j)
+			{
+				uint32_t k = baseVertex + i * rowSize + j;
+
+				meshData.Indices32.push_back(k);
+				meshData.Indices32.push_back(k + 1);
+				meshData.Indices32.push_back(k + rowSize);
+
+				meshData.Indices32.push_back(k + rowSize);
+				meshData.Indices32.push_back(k + 1);
+				meshData.Indices32.push_back(k + rowSize + 1);
+			}
+		}
+	}
+
+	return meshData;
+}
+
+float BezierPatchUtil::GetBatchError(const BezierPatch& patch, uint32_t tessFactor)
+{
+	float extent = 1.0f;
+	for (auto& p : patch)
+	{
+		extent = max(extent, max(fabsf(p.x), max(fabsf(p.y), fabsf(p.z))));
+	}
+
+	GeometryGenerator::MeshData meshData = Tessellate(patch, tessFactor);
+
+	float error = 0.0f;
+	for (auto& vertex : meshData.Vertices)
+	{
+		float u = vertex.TexC.x;
+		float v = vertex.TexC.y;
+
+		XMFLOAT3 p = CubicBezierSum(patch, BernsteinBasis(u), BernsteinBasis(v));
+		XMFLOAT3 n = EvaluateNormal(patch, u, v);
+
+		error = max(error, fabsf(vertex.Position.x - p.x) / extent);
+		error = max(error, fabsf(vertex.Position.y - p.y) / extent);
+		error = max(error, fabsf(vertex.Position.z - p.z) / extent);
+		error = max(error, fabsf(vertex.Normal.x - n.x));
+		error = max(error, fabsf(vertex.Normal.y - n.y));
+		error = max(error, fabsf(vertex.Normal.z - n.z));
+	}
+
+	return error;
+}
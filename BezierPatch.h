@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <array>
+
+using namespace DirectX;
+using namespace std;
+
+// 16 control points of a cubic Bezier patch, row major in v like the
+// OutputPatch<BezierHullOut, 16> consumed by Shaders/BezierUtil.hlsl.
+typedef array<XMFLOAT3, 16> BezierPatch;
+
+// CPU version of BezierUtil.hlsl. The scalar functions follow the shader line for
+// line and serve as the reference; EvaluateBatch is the SSE2 path used to
+// pre-tessellate patches for passes that do not run the hull/domain stages.
+class BezierPatchUtil
+{
+public:
+	static XMFLOAT4 BernsteinBasis(float t);
+	static XMFLOAT4 dBernsteinBasis(float t);
+	static XMFLOAT3 CubicBezierSum(const BezierPatch& patch, const XMFLOAT4& basisU, const XMFLOAT4& basisV);
+
+	// Unit normal cross(dP/du, dP/dv), which points +y for the BezierTessellation
+	// patch.
+	static XMFLOAT3 EvaluateNormal(const BezierPatch& patch, float u, float v);
+
+	// Positions, unit normals and unit dP/du tangents at count domain points
+	// (u[i], v[i]). Any output may be null.
+	static void EvaluateBatch(
+		const BezierPatch& patch,
+		const float* u,
+		const float* v,
+		size_t count,
+		XMFLOAT3* positions,
+		XMFLOAT3* normals,
+		XMFLOAT3* tangents = nullptr);
+
+	// The quad domain of the hardware tessellator at integer factor
+	// tessFactor for all edges and the inside: (tessFactor + 1)^2 vertices and
+	// 2 * tessFactor^2 clockwise triangles.
+	static GeometryGenerator::MeshData Tessellate(const BezierPatch& patch, uint32_t tessFactor);
+
+	// Tessellates every patch into one mesh, patch after patch.
+	static GeometryGenerator::MeshData Tessellate(const vector<BezierPatch>& patches, uint32_t tessFactor);
+
+	// Largest difference between EvaluateBatch and the scalar reference over a
+	// tessFactor grid, positions relative to the patch extent.
+	static float GetBatchError(const BezierPatch& patch, uint32_t tessFactor);
+};
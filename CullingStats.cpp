@@ -0,0 +1,143 @@
+#include "CullingStats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+const char* CullingPlaneName(uint32_t plane)
+{
+	static const char* const names[CullingPlaneCount] = { "left", "right", "bottom", "top", "near", "far" };
+	return plane < CullingPlaneCount ? names[plane] : "unknown";
+}
+
+void CullingCounters::Reset()
+{
+	*this = CullingCounters();
+}
+
+void CullingCounters::AddCommand(uint32_t tested, uint32_t visible)
+{
+	TestedPerCommand.push_back(tested);
+	VisiblePerCommand.push_back(visible);
+	Tested += tested;
+	Visible += visible;
+}
+
+CullingHistogram::CullingHistogram(uint32_t bucketCount, uint32_t historySize)
+	: mBuckets(max(bucketCount, 1u), 0), mHistorySize(max(historySize, 1u))
+{
+}
+
+void CullingHistogram::Add(float visibleRatio)
+{
+	const uint32_t last = (uint32_t)mBuckets.size() - 1;
+	const uint32_t bucket = min((uint32_t)(max(visibleRatio, 0.0f) * mBuckets.size()), last);
+
+	if (mHistory.size() == mHistorySize)
+	{
+		--mBuckets[mHistory.front()];
+		mHistory.pop_front();
+	}
+
+	mHistory.push_back(bucket);
+	++mBuckets[bucket];
+}
+
+void CullingHistogram::Write(ostream& out) const
+{
+	const uint32_t barWidth = 40;
+	const uint32_t fullest = *max_element(mBuckets.begin(), mBuckets.end());
+	const uint32_t bucketCount = (uint32_t)mBuckets.size();
+
+	for (uint32_t i = 0; i < bucketCount; ++i)
+	{
+		const uint32_t width = fullest > 0 ? (mBuckets[i] * barWidth + fullest - 1) / fullest : 0;
+		out << "  " << setw(3) << i * 100 / bucketCount << "-" << setw(3) << (i + 1) * 100 / bucketCount << "% "
+			<< setw(6) << mBuckets[i] << " " << string(width, '#') << "\n";
+	}
+}
+
+CullingStats::CullingStats(uint32_t historySize, uint32_t bucketCount)
+	: mHistorySize(historySize), mBucketCount(bucketCount), mFrameHistogram(bucketCount, historySize)
+{
+}
+
+void CullingStats::AddFrame(uint64_t frame, const CullingCounters& counters)
+{
+	++mFrames;
+	mLastFrame = frame;
+	mLast = counters;
+
+	mTotalTested += counters.Tested;
+	mTotalVisible += counters.Visible;
+	for (uint32_t i = 0; i < CullingPlaneCount; ++i)
+	{
+		mTotalCulledByPlane[i] += counters.CulledByPlane[i];
+	}
+	mTotalCulledOther += counters.CulledOther;
+
+	if (counters.Tested > 0)
+	{
+		mFrameHistogram.Add(counters.VisibleRatio());
+	}
+
+	const uint32_t commandCount = (uint32_t)counters.TestedPerCommand.size();
+	while (mCommandHistograms.size() < commandCount)
+	{
+		mCommandHistograms.emplace_back(mBucketCount, mHistorySize);
+	}
+
+	for (uint32_t i = 0; i < commandCount; ++i)
+	{
+		if (counters.TestedPerCommand[i] > 0)
+		{
+			mCommandHistograms[i].Add((float)counters.VisiblePerCommand[i] / counters.TestedPerCommand[i]);
+		}
+	}
+}
+
+void CullingStats::Write(ostream& out) const
+{
+	const uint64_t culled = mTotalTested - mTotalVisible;
+	auto percent = [](uint64_t part, uint64_t whole)
+	{
+		return whole > 0 ? 100.0 * part / whole : 0.0;
+	};
+
+	out << fixed << setprecision(1)
+		<< "frames " << mFrames << " (last " << mLastFrame << ")\n"
+		<< "tested " << mTotalTested << ", visible " << mTotalVisible
+		<< " (" << percent(mTotalVisible, mTotalTested) << "%), culled " << culled << "\n";
+
+	out << "culled by plane\n";
+	for (uint32_t i = 0; i < CullingPlaneCount; ++i)
+	{
+		out << "  " << left << setw(8) << CullingPlaneName(i) << right << setw(10) << mTotalCulledByPlane[i]
+			<< " (" << percent(mTotalCulledByPlane[i], culled) << "%)\n";
+	}
+	if (mTotalCulledOther > 0)
+	{
+		out << "  " << left << setw(8) << "other" << right << setw(10) << mTotalCulledOther
+			<< " (" << percent(mTotalCulledOther, culled) << "%)\n";
+	}
+
+	out << "frame visible ratio, last " << mFrameHistogram.Samples() << " frames\n";
+	mFrameHistogram.Write(out);
+
+	for (uint32_t i = 0; i < CommandCount(); ++i)
+	{
+		const auto& histogram = mCommandHistograms[i];
+		if (histogram.Samples() == 0)
+		{
+			continue;
+		}
+
+		out << "command " << i << " visible ratio, last " << histogram.Samples() << " frames";
+		if (i < mLast.TestedPerCommand.size())
+		{
+			out << " (now " << mLast.VisiblePerCommand[i] << "/" << mLast.TestedPerCommand[i] << ")";
+		}
+		out << "\n";
+		histogram.Write(out);
+	}
+}
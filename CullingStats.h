@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+// Frustum planes in the order the culling kernel and ExtractPlanes use.
+enum class CullingPlane : uint32_t
+{
+	Left = 0,
+	Right,
+	Bottom,
+	Top,
+	Near,
+	Far,
+	Count
+};
+
+const uint32_t CullingPlaneCount = (uint32_t)CullingPlane::Count;
+
+const char* CullingPlaneName(uint32_t plane);
+
+// What one culling run did. The GPU kernel and the CPU paths in FrustumCulling
+// fill the same counters so the two can be compared.
+struct CullingCounters
+{
+	uint32_t Tested = 0;
+	uint32_t Visible = 0;
+
+	// Culled instances by the first plane, in CullingPlane order, they lie fully outside of.
+	uint32_t CulledByPlane[CullingPlaneCount] = {};
+
+	// Rejected by the exact box-frustum test while straddling every plane. CPU paths only;
+	// the kernel only has the plane test.
+	uint32_t CulledOther = 0;
+
+	// One entry per draw command.
+	vector<uint32_t> TestedPerCommand;
+	vector<uint32_t> VisiblePerCommand;
+
+	void Reset();
+
+	// Appends a command and adds its counts to Tested and Visible.
+	void AddCommand(uint32_t tested, uint32_t visible);
+
+	uint32_t Culled() const { return Tested - Visible; }
+	float VisibleRatio() const { return Tested > 0 ? (float)Visible / Tested : 0.0f; }
+};
+
+// Rolling histogram of visible ratios over the last historySize samples.
+class CullingHistogram
+{
+public:
+	explicit CullingHistogram(uint32_t bucketCount = 10, uint32_t historySize = 256);
+
+	void Add(float visibleRatio);
+
+	uint32_t BucketCount() const { return (uint32_t)mBuckets.size(); }
+	uint32_t Count(uint32_t bucket) const { return mBuckets[bucket]; }
+	uint32_t Samples() const { return (uint32_t)mHistory.size(); }
+
+	// One bar per bucket, scaled to the fullest one.
+	void Write(ostream& out) const;
+
+private:
+	vector<uint32_t> mBuckets;
+	deque<uint32_t> mHistory;
+	uint32_t mHistorySize = 0;
+};
+
+// Counters of past frames as they are read back, with rolling histograms of the
+// frame's and of each command's visible ratio.
+class CullingStats
+{
+public:
+	explicit CullingStats(uint32_t historySize = 256, uint32_t bucketCount = 10);
+
+	void AddFrame(uint64_t frame, const CullingCounters& counters);
+
+	uint64_t Frames() const { return mFrames; }
+	// Frame the latest counters belong to; they trail the frame being recorded.
+	uint64_t LastFrame() const { return mLastFrame; }
+	const CullingCounters& Last() const { return mLast; }
+
+	const CullingHistogram& FrameHistogram() const { return mFrameHistogram; }
+	uint32_t CommandCount() const { return (uint32_t)mCommandHistograms.size(); }
+	const CullingHistogram& CommandHistogram(uint32_t command) const { return mCommandHistograms[command]; }
+
+	// Totals, the plane breakdown and the histograms.
+	void Write(ostream& out) const;
+
+private:
+	uint32_t mHistorySize = 0;
+	uint32_t mBucketCount = 0;
+
+	uint64_t mFrames = 0;
+	uint64_t mLastFrame = 0;
+	CullingCounters mLast;
+
+	uint64_t mTotalTested = 0;
+	uint64_t mTotalVisible = 0;
+	uint64_t mTotalCulledByPlane[CullingPlaneCount] = {};
+	uint64_t mTotalCulledOther = 0;
+
+	CullingHistogram mFrameHistogram;
+	vector<CullingHistogram> mCommandHistograms;
+};
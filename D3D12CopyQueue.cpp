@@ -0,0 +1,131 @@
+#include "D3D12CopyQueue.h"
+
+D3D12CopyQueue::D3D12CopyQueue(ID3D12Device* device, UINT64 stagingPageSize)
+	: md3dDevice(device)
+{
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(md3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mQueue)));
+
+	mBatcher = make_unique<UploadBatcher>(md3dDevice, stagingPageSize);
+}
+
+D3D12CopyQueue::~D3D12CopyQueue()
+{
+	WaitIdle();
+}
+
+ID3D12CommandAllocator* D3D12CopyQueue::AcquireAllocator()
+{
+	const UINT64 completed = mBatcher->CompletedFenceValue();
+
+	for (auto& allocator : mAllocators)
+	{
+		if (allocator.Fence <= completed)
+		{
+			ThrowIfFailed(allocator.CmdListAlloc->Reset());
+			allocator.Fence = UINT64_MAX;
+			return allocator.CmdListAlloc.Get();
+		}
+	}
+
+	Allocator allocator;
+	ThrowIfFailed(md3dDevice->CreateCommandAllocator(
+		D3D12_COMMAND_LIST_TYPE_COPY,
+		IID_PPV_ARGS(allocator.CmdListAlloc.GetAddressOf())));
+	allocator.Fence = UINT64_MAX;
+	mAllocators.push_back(allocator);
+
+	return mAllocators.back().CmdListAlloc.Get();
+}
+
+uint64_t D3D12CopyQueue::Submit(const vector<const StreamRequest*>& batch)
+{
+	mBatcher->Recycle();
+
+	ID3D12CommandAllocator* cmdListAlloc = AcquireAllocator();
+
+	if (mCommandList == nullptr)
+	{
+		ThrowIfFailed(md3dDevice->CreateCommandList(
+			0,
+			D3D12_COMMAND_LIST_TYPE_COPY,
+			cmdListAlloc,
+			nullptr,
+			IID_PPV_ARGS(mCommandList.GetAddressOf())));
+	}
+	else
+	{
+		ThrowIfFailed(mCommandList->Reset(cmdListAlloc, nullptr));
+	}
+
+	for (auto request : batch)
+	{
+		auto upload = static_cast<const D3D12StreamUpload*>(request->Payload.get());
+
+		if (upload->Subresources.empty())
+		{
+			mBatcher->UploadBuffer(upload->Dest.Get(), upload->DestOffset, upload->Data, upload->ByteSize,
+				D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COMMON);
+		}
+		else
+		{
+			mBatcher->UploadTexture(upload->Dest.Get(), upload->FirstSubresource,
+				(UINT)upload->Subresources.size(), upload->Subresources.data(),
+				D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COMMON);
+		}
+	}
+
+	mBatcher->Flush(mCommandList.Get());
+	ThrowIfFailed(mCommandList->Close());
+
+	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
+	mQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+	mLastFence = mBatcher->Signal(mQueue.Get());
+
+	for (auto& allocator : mAllocators)
+	{
+		if (allocator.CmdListAlloc.Get() == cmdListAlloc)
+		{
+			allocator.Fence = mLastFence;
+		}
+	}
+
+	return mLastFence;
+}
+
+uint64_t D3D12CopyQueue::CompletedValue()
+{
+	return mBatcher->CompletedFenceValue();
+}
+
+void D3D12CopyQueue::WaitIdle()
+{
+	if (mBatcher == nullptr || mBatcher->CompletedFenceValue() >= mLastFence)
+	{
+		return;
+	}
+
+	HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+	ThrowIfFailed(mBatcher->Fence()->SetEventOnCompletion(mLastFence, eventHandle));
+	WaitForSingleObject(eventHandle, INFINITE);
+	CloseHandle(eventHandle);
+}
+
+shared_ptr<D3D12StreamUpload> D3D12CopyQueue::MakeBufferUpload(
+	ComPtr<ID3D12Resource> dest,
+	UINT64 destOffset,
+	const void* data,
+	UINT64 byteSize,
+	shared_ptr<const void> storage)
+{
+	auto upload = make_shared<D3D12StreamUpload>();
+	upload->Dest = move(dest);
+	upload->DestOffset = destOffset;
+	upload->Data = data;
+	upload->ByteSize = byteSize;
+	upload->Storage = move(storage);
+	return upload;
+}
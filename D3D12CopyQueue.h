@@ -0,0 +1,71 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "StreamingScheduler.h"
+#include "UploadBatcher.h"
+
+// Payload of a StreamRequest run by D3D12CopyQueue. Dest must be in COMMON; on the
+// copy queue it is promoted to COPY_DEST and decays back to COMMON afterwards, so
+// the direct queue can read it once the request completes.
+struct D3D12StreamUpload
+{
+	ComPtr<ID3D12Resource> Dest;
+
+	// Buffers: ByteSize bytes from Data to DestOffset.
+	UINT64 DestOffset = 0;
+	const void* Data = nullptr;
+	UINT64 ByteSize = 0;
+
+	// Textures: one entry per subresource starting at FirstSubresource.
+	UINT FirstSubresource = 0;
+	vector<D3D12_SUBRESOURCE_DATA> Subresources;
+
+	// Keeps Data and Subresources alive until the copy is recorded.
+	shared_ptr<const void> Storage;
+};
+
+// Runs streaming uploads on a D3D12_COMMAND_LIST_TYPE_COPY queue of its own, with
+// its own staging pages and fence, so runtime loads never go through the frame's
+// direct command list.
+class D3D12CopyQueue : public CopyQueueBackend
+{
+public:
+	D3D12CopyQueue(ID3D12Device* device, UINT64 stagingPageSize = 16ull * 1024 * 1024);
+	D3D12CopyQueue(const D3D12CopyQueue& rhs) = delete;
+	D3D12CopyQueue& operator=(const D3D12CopyQueue& rhs) = delete;
+	~D3D12CopyQueue();
+
+	virtual uint64_t Submit(const vector<const StreamRequest*>& batch) override;
+	virtual uint64_t CompletedValue() override;
+
+	// Blocks until every submitted batch has completed.
+	void WaitIdle();
+
+	ID3D12CommandQueue* Queue() const { return mQueue.Get(); }
+
+	static shared_ptr<D3D12StreamUpload> MakeBufferUpload(
+		ComPtr<ID3D12Resource> dest,
+		UINT64 destOffset,
+		const void* data,
+		UINT64 byteSize,
+		shared_ptr<const void> storage);
+
+private:
+	struct Allocator
+	{
+		ComPtr<ID3D12CommandAllocator> CmdListAlloc;
+		UINT64 Fence = 0;
+	};
+
+	ID3D12CommandAllocator* AcquireAllocator();
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+
+	ComPtr<ID3D12CommandQueue> mQueue;
+	ComPtr<ID3D12GraphicsCommandList> mCommandList;
+	vector<Allocator> mAllocators;
+
+	unique_ptr<UploadBatcher> mBatcher;
+	UINT64 mLastFence = 0;
+};
@@ -0,0 +1,37 @@
+#include "D3D12FrameFence.h"
+
+D3D12FrameFence::D3D12FrameFence(ID3D12Fence* fence)
+	: mFence(fence)
+{
+	mEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+
+	if (mEvent == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+D3D12FrameFence::~D3D12FrameFence()
+{
+	if (mEvent != nullptr)
+	{
+		CloseHandle(mEvent);
+	}
+}
+
+uint64_t D3D12FrameFence::CompletedValue()
+{
+	return mFence->GetCompletedValue();
+}
+
+void D3D12FrameFence::Wait(uint64_t value)
+{
+	if (mFence->GetCompletedValue() >= value)
+	{
+		return;
+	}
+
+	// Auto-reset: the wait consumes the signal, leaving the event ready for the next call.
+	ThrowIfFailed(mFence->SetEventOnCompletion(value, mEvent));
+	WaitForSingleObject(mEvent, INFINITE);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "FrameScheduler.h"
+
+// FrameFence over an ID3D12Fence. The Win32 event is created once and reused for
+// every wait instead of per call.
+class D3D12FrameFence : public FrameFence
+{
+public:
+	explicit D3D12FrameFence(ID3D12Fence* fence);
+	D3D12FrameFence(const D3D12FrameFence& rhs) = delete;
+	D3D12FrameFence& operator=(const D3D12FrameFence& rhs) = delete;
+	~D3D12FrameFence();
+
+	virtual uint64_t CompletedValue() override;
+	virtual void Wait(uint64_t value) override;
+
+private:
+	ID3D12Fence* mFence = nullptr;
+	HANDLE mEvent = nullptr;
+};
@@ -0,0 +1,124 @@
+#include "D3D12GpuProfiler.h"
+
+D3D12GpuProfiler::D3D12GpuProfiler(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, ID3D12CommandQueue* computeQueue,
+	Profiler* profiler, uint32_t frameSlots, uint32_t maxScopesPerQueue)
+	: mCore(profiler, frameSlots, maxScopesPerQueue)
+{
+	mQueues[(int)PassQueue::Graphics] = graphicsQueue;
+	mQueues[(int)PassQueue::Compute] = computeQueue;
+
+	D3D12_QUERY_HEAP_DESC heapDesc = {};
+	heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	heapDesc.Count = mCore.HeapQueryCount();
+
+	auto readbackHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+	auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT64) * mCore.HeapQueryCount());
+
+	for (int q = 0; q < (int)PassQueue::Count; ++q)
+	{
+		ThrowIfFailed(device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&mQueryHeaps[q])));
+
+		ThrowIfFailed(device->CreateCommittedResource(
+			&readbackHeap,
+			D3D12_HEAP_FLAG_NONE,
+			&readbackDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(&mReadback[q])));
+	}
+
+	Calibrate();
+}
+
+void D3D12GpuProfiler::Calibrate()
+{
+	LARGE_INTEGER qpcFrequency;
+	QueryPerformanceFrequency(&qpcFrequency);
+
+	for (int q = 0; q < (int)PassQueue::Count; ++q)
+	{
+		UINT64 frequency = 0;
+		UINT64 gpuTimestamp = 0;
+		UINT64 cpuTimestamp = 0;
+		if (FAILED(mQueues[q]->GetTimestampFrequency(&frequency)) ||
+			FAILED(mQueues[q]->GetClockCalibration(&gpuTimestamp, &cpuTimestamp)))
+		{
+			continue;
+		}
+
+		// The calibration's CPU side is a QPC value; move it onto the profiler's clock.
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		const double cpuMs = mCore.GetProfiler()->Now() -
+			(double)(now.QuadPart - (LONGLONG)cpuTimestamp) * 1000.0 / (double)qpcFrequency.QuadPart;
+
+		mCore.SetCalibration((PassQueue)q, frequency, gpuTimestamp, cpuMs);
+	}
+}
+
+void D3D12GpuProfiler::BeginFrame(uint32_t slot, uint64_t frame)
+{
+	if (mCore.HasResults(slot))
+	{
+		// Clocks drift apart slowly; recalibrating per frame keeps the trace aligned.
+		Calibrate();
+
+		for (int q = 0; q < (int)PassQueue::Count; ++q)
+		{
+			const uint32_t count = mCore.QueryCount((PassQueue)q);
+			if (count == 0)
+			{
+				continue;
+			}
+
+			const SIZE_T first = sizeof(UINT64) * mCore.FirstQuery(slot);
+			D3D12_RANGE readRange = { first, first + sizeof(UINT64) * count };
+			D3D12_RANGE writtenRange = { 0, 0 };
+
+			UINT8* data = nullptr;
+			ThrowIfFailed(mReadback[q]->Map(0, &readRange, reinterpret_cast<void**>(&data)));
+			mCore.Resolve(slot, (PassQueue)q, reinterpret_cast<const uint64_t*>(data + first));
+			mReadback[q]->Unmap(0, &writtenRange);
+		}
+	}
+
+	mSlot = slot;
+	mCore.BeginFrame(slot, frame);
+}
+
+void D3D12GpuProfiler::Begin(ID3D12GraphicsCommandList* cmdList, uint32_t scope)
+{
+	if (scope == GpuProfiler::InvalidScope)
+	{
+		return;
+	}
+
+	const int q = (int)mCore.ScopeQueue(scope);
+	cmdList->EndQuery(mQueryHeaps[q].Get(), D3D12_QUERY_TYPE_TIMESTAMP, mCore.BeginQuery(mSlot, scope));
+}
+
+void D3D12GpuProfiler::End(ID3D12GraphicsCommandList* cmdList, uint32_t scope)
+{
+	if (scope == GpuProfiler::InvalidScope)
+	{
+		return;
+	}
+
+	const int q = (int)mCore.ScopeQueue(scope);
+	cmdList->EndQuery(mQueryHeaps[q].Get(), D3D12_QUERY_TYPE_TIMESTAMP, mCore.EndQuery(mSlot, scope));
+	mCore.MarkWritten(mSlot, scope);
+}
+
+void D3D12GpuProfiler::Resolve(ID3D12GraphicsCommandList* cmdList, PassQueue queue)
+{
+	const uint32_t count = mCore.QueryCount(queue);
+	if (count == 0)
+	{
+		return;
+	}
+
+	const int q = (int)queue;
+	const uint32_t first = mCore.FirstQuery(mSlot);
+	cmdList->ResolveQueryData(mQueryHeaps[q].Get(), D3D12_QUERY_TYPE_TIMESTAMP, first, count,
+		mReadback[q].Get(), sizeof(UINT64) * first);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "GpuProfiler.h"
+
+// Issues the timestamp queries of a GpuProfiler on a graphics and a compute queue.
+// Each queue has a query heap and a readback buffer split into one region per frame
+// slot, the slot being the FrameResource index, so a slot's results are read once
+// the frame fence wait says the GPU is done with it.
+class D3D12GpuProfiler
+{
+public:
+	D3D12GpuProfiler(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, ID3D12CommandQueue* computeQueue,
+		Profiler* profiler, uint32_t frameSlots, uint32_t maxScopesPerQueue = 64);
+	D3D12GpuProfiler(const D3D12GpuProfiler& rhs) = delete;
+	D3D12GpuProfiler& operator=(const D3D12GpuProfiler& rhs) = delete;
+
+	uint32_t AddScope(const string& name, PassQueue queue) { return mCore.AddScope(name, queue); }
+
+	// Reads back the slot's previous frame, then starts recording frame into it.
+	void BeginFrame(uint32_t slot, uint64_t frame);
+
+	// Record on a list of the scope's queue. Thread-safe for different scopes.
+	void Begin(ID3D12GraphicsCommandList* cmdList, uint32_t scope);
+	void End(ID3D12GraphicsCommandList* cmdList, uint32_t scope);
+
+	// Copies the frame's queries on queue into the readback ring. Record it once per
+	// frame, after that queue's last End.
+	void Resolve(ID3D12GraphicsCommandList* cmdList, PassQueue queue);
+
+	const GpuProfiler& Core() const { return mCore; }
+
+private:
+	void Calibrate();
+
+private:
+	GpuProfiler mCore;
+	uint32_t mSlot = 0;
+
+	ID3D12CommandQueue* mQueues[(int)PassQueue::Count] = {};
+	ComPtr<ID3D12QueryHeap> mQueryHeaps[(int)PassQueue::Count];
+	ComPtr<ID3D12Resource> mReadback[(int)PassQueue::Count];
+};
+
+// Brackets its lifetime with a GPU scope; does nothing without a profiler.
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(D3D12GpuProfiler* profiler, ID3D12GraphicsCommandList* cmdList, uint32_t scope)
+		: mProfiler(profiler), mCmdList(cmdList), mScope(scope)
+	{
+		if (mProfiler != nullptr)
+		{
+			mProfiler->Begin(mCmdList, mScope);
+		}
+	}
+	GpuProfileScope(const GpuProfileScope& rhs) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope& rhs) = delete;
+	~GpuProfileScope()
+	{
+		if (mProfiler != nullptr)
+		{
+			mProfiler->End(mCmdList, mScope);
+		}
+	}
+
+private:
+	D3D12GpuProfiler* mProfiler = nullptr;
+	ID3D12GraphicsCommandList* mCmdList = nullptr;
+	uint32_t mScope = 0;
+};
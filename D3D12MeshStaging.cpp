@@ -0,0 +1,148 @@
+#include "D3D12MeshStaging.h"
+#include "FrameResource.h"
+
+static_assert(sizeof(PackedMeshVertex) == sizeof(Vertex), "PackedMeshVertex must match Vertex");
+
+D3D12MeshStaging::D3D12MeshStaging(ID3D12Device* device, UploadBatcher* batcher)
+	: md3dDevice(device), mBatcher(batcher)
+{
+}
+
+D3D12MeshStaging::~D3D12MeshStaging()
+{
+	if (mUploadBuffer != nullptr && mMappedData != nullptr)
+	{
+		mUploadBuffer->Unmap(0, nullptr);
+	}
+}
+
+uint8_t* D3D12MeshStaging::Map(uint64_t byteSize)
+{
+	if (mBatcher != nullptr)
+	{
+		mAllocation = mBatcher->Allocate(byteSize);
+		mMappedData = mAllocation.CpuAddress;
+		return mMappedData;
+	}
+
+	CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC uploadResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(max<UINT64>(byteSize, 1));
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&uploadHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&uploadResourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(mUploadBuffer.GetAddressOf())));
+
+	// Upload heaps are write combined; the builder only writes sequentially.
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(mUploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mMappedData)));
+	return mMappedData;
+}
+
+unique_ptr<MeshGeometry> D3D12MeshStaging::CreateGeometry(
+	const string& name,
+	const MeshBuildLayout& layout,
+	ID3D12GraphicsCommandList* cmdList,
+	bool keepCpuCopy)
+{
+	auto geo = make_unique<MeshGeometry>();
+	geo->Name = name;
+
+	if (keepCpuCopy)
+	{
+		ThrowIfFailed(D3DCreateBlob(layout.VertexBufferByteSize, &geo->VertexBufferCPU));
+		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), mMappedData, layout.VertexBufferByteSize);
+
+		ThrowIfFailed(D3DCreateBlob(layout.IndexBufferByteSize, &geo->IndexBufferCPU));
+		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), mMappedData + layout.IndexBufferOffset, layout.IndexBufferByteSize);
+	}
+
+	if (mUploadBuffer != nullptr)
+	{
+		mUploadBuffer->Unmap(0, nullptr);
+	}
+	mMappedData = nullptr;
+
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+
+	CD3DX12_RESOURCE_DESC vbDesc = CD3DX12_RESOURCE_DESC::Buffer(layout.VertexBufferByteSize);
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&vbDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(geo->VertexBufferGPU.GetAddressOf())));
+
+	CD3DX12_RESOURCE_DESC ibDesc = CD3DX12_RESOURCE_DESC::Buffer(layout.IndexBufferByteSize);
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&ibDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(geo->IndexBufferGPU.GetAddressOf())));
+
+	if (mBatcher != nullptr)
+	{
+		mBatcher->CopyBuffer(geo->VertexBufferGPU.Get(), 0, mAllocation, 0, layout.VertexBufferByteSize);
+		mBatcher->CopyBuffer(geo->IndexBufferGPU.Get(), 0, mAllocation, layout.IndexBufferOffset, layout.IndexBufferByteSize);
+	}
+	else
+	{
+		RecordCopies(geo.get(), layout, cmdList);
+
+		// One upload buffer backs both; DisposeUploaders releases it.
+		geo->VertexBufferUploader = move(mUploadBuffer);
+	}
+
+	geo->VertexByteStride = layout.VertexByteStride;
+	geo->VertexBufferByteSize = layout.VertexBufferByteSize;
+	geo->IndexFormat = layout.Indices32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+	geo->IndexBufferByteSize = layout.IndexBufferByteSize;
+
+	for (auto& s : layout.Submeshes)
+	{
+		SubmeshGeometry submesh;
+		submesh.IndexCount = s.IndexCount;
+		submesh.StartIndexLocation = s.StartIndexLocation;
+		submesh.BaseVertexLocation = s.BaseVertexLocation;
+
+		XMVECTOR vMin = XMLoadFloat3(&s.BoundsMin);
+		XMVECTOR vMax = XMLoadFloat3(&s.BoundsMax);
+		XMStoreFloat3(&submesh.Bounds.Center, 0.5f * (vMin + vMax));
+		XMStoreFloat3(&submesh.Bounds.Extents, 0.5f * (vMax - vMin));
+
+		geo->DrawArgs[s.Name] = submesh;
+	}
+
+	return geo;
+}
+
+void D3D12MeshStaging::RecordCopies(MeshGeometry* geo, const MeshBuildLayout& layout, ID3D12GraphicsCommandList* cmdList)
+{
+	CD3DX12_RESOURCE_BARRIER toCopyDest[2] =
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(geo->VertexBufferGPU.Get(),
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
+		CD3DX12_RESOURCE_BARRIER::Transition(geo->IndexBufferGPU.Get(),
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST)
+	};
+	cmdList->ResourceBarrier(2, toCopyDest);
+
+	cmdList->CopyBufferRegion(geo->VertexBufferGPU.Get(), 0,
+		mUploadBuffer.Get(), 0, layout.VertexBufferByteSize);
+	cmdList->CopyBufferRegion(geo->IndexBufferGPU.Get(), 0,
+		mUploadBuffer.Get(), layout.IndexBufferOffset, layout.IndexBufferByteSize);
+
+	CD3DX12_RESOURCE_BARRIER toGenericRead[2] =
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(geo->VertexBufferGPU.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ),
+		CD3DX12_RESOURCE_BARRIER::Transition(geo->IndexBufferGPU.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ)
+	};
+	cmdList->ResourceBarrier(2, toGenericRead);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "MeshBuilder.h"
+#include "UploadBatcher.h"
+
+// Upload memory holding the vertex and index data of one MeshBuilder::Build.
+// CreateGeometry copies it into default heap buffers. Without a batcher the
+// memory is a committed upload buffer that is handed to the MeshGeometry as its
+// uploader; with one it is a batcher allocation and the copies wait for its Flush.
+class D3D12MeshStaging : public MeshStagingBuffer
+{
+public:
+	D3D12MeshStaging(ID3D12Device* device, UploadBatcher* batcher = nullptr);
+	D3D12MeshStaging(const D3D12MeshStaging& rhs) = delete;
+	D3D12MeshStaging& operator=(const D3D12MeshStaging& rhs) = delete;
+	~D3D12MeshStaging();
+
+	virtual uint8_t* Map(uint64_t byteSize) override;
+
+	// Records the copies on cmdList, or queues them on the batcher. keepCpuCopy fills VertexBufferCPU and
+	// IndexBufferCPU from the staging memory; nothing else needs them.
+	unique_ptr<MeshGeometry> CreateGeometry(
+		const string& name,
+		const MeshBuildLayout& layout,
+		ID3D12GraphicsCommandList* cmdList,
+		bool keepCpuCopy = false);
+
+private:
+	void RecordCopies(MeshGeometry* geo, const MeshBuildLayout& layout, ID3D12GraphicsCommandList* cmdList);
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+	UploadBatcher* mBatcher = nullptr;
+	UploadAllocation mAllocation;
+	ComPtr<ID3D12Resource> mUploadBuffer;
+	uint8_t* mMappedData = nullptr;
+};
@@ -0,0 +1,169 @@
+#include "D3D12PassRecorder.h"
+
+D3D12PassRecorder::D3D12PassRecorder(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, ID3D12CommandQueue* computeQueue)
+	: mDevice(device)
+{
+	mQueues[(int)PassQueue::Graphics] = graphicsQueue;
+	mQueues[(int)PassQueue::Compute] = computeQueue;
+
+	for (int q = 0; q < (int)PassQueue::Count; ++q)
+	{
+		ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFences[q])));
+		mFenceWaits[q] = make_unique<D3D12FrameFence>(mFences[q].Get());
+	}
+}
+
+D3D12_COMMAND_LIST_TYPE D3D12PassRecorder::ListType(PassQueue queue)
+{
+	return queue == PassQueue::Compute ? D3D12_COMMAND_LIST_TYPE_COMPUTE : D3D12_COMMAND_LIST_TYPE_DIRECT;
+}
+
+uint32_t D3D12PassRecorder::AddPass(const string& name, PassQueue queue, RecordFunction record, const vector<uint32_t>& dependencies)
+{
+	uint32_t index = mGraph.AddPass(name, queue, dependencies);
+	mPasses.push_back({ move(record), nullptr });
+	return index;
+}
+
+void D3D12PassRecorder::WaitForSignal(PassQueue queue, UINT64 value)
+{
+	mFenceWaits[(int)queue]->Wait(value);
+}
+
+void D3D12PassRecorder::Clear()
+{
+	mGraph.Clear();
+	mPasses.clear();
+}
+
+void D3D12PassRecorder::Execute(vector<ComPtr<ID3D12CommandAllocator>>& allocators, ThreadPool& pool)
+{
+	// Allocators and lists are created here, on the calling thread, so the
+	// workers below only record.
+	if (allocators.size() < mPasses.size())
+	{
+		allocators.resize(mPasses.size());
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)mPasses.size(); ++i)
+	{
+		const D3D12_COMMAND_LIST_TYPE type = ListType(mGraph.GetPassQueue(i));
+
+		if (allocators[i] == nullptr)
+		{
+			ThrowIfFailed(mDevice->CreateCommandAllocator(type, IID_PPV_ARGS(allocators[i].GetAddressOf())));
+		}
+
+		if (mPasses[i].CmdList == nullptr)
+		{
+			ThrowIfFailed(mDevice->CreateCommandList(0, type, allocators[i].Get(), nullptr,
+				IID_PPV_ARGS(mPasses[i].CmdList.GetAddressOf())));
+			ThrowIfFailed(mPasses[i].CmdList->Close());
+		}
+	}
+
+	const auto& submissions = mGraph.Submissions();
+	mSubmissionFences.assign(submissions.size(), 0);
+
+	mLastSubmissionOnQueue.assign((int)PassQueue::Count, -1);
+	for (int i = 0; i < (int)submissions.size(); ++i)
+	{
+		mLastSubmissionOnQueue[(int)submissions[i].Queue] = i;
+	}
+
+	// Values from before this frame; the first submission on a queue waits on these
+	// for a cross-frame wait.
+	UINT64 previousFrameValues[(int)PassQueue::Count];
+	bool queueStarted[(int)PassQueue::Count] = {};
+
+	for (int q = 0; q < (int)PassQueue::Count; ++q)
+	{
+		previousFrameValues[q] = mFenceValues[q];
+		mFrameSignals[q] = 0;
+	}
+
+	if (mTimeline != nullptr)
+	{
+		for (int q = 0; q < (int)PassQueue::Count; ++q)
+		{
+			mTimeline->Update((PassQueue)q, mFences[q]->GetCompletedValue());
+		}
+		mTimeline->BeginFrame(mFrame);
+	}
+	++mFrame;
+
+	mGraph.Execute(pool,
+		[&](uint32_t pass)
+		{
+			auto& p = mPasses[pass];
+			ThrowIfFailed(allocators[pass]->Reset());
+			ThrowIfFailed(p.CmdList->Reset(allocators[pass].Get(), nullptr));
+			p.Record(p.CmdList.Get());
+			ThrowIfFailed(p.CmdList->Close());
+		},
+		[&](uint32_t index)
+		{
+			const PassSubmission& submission = submissions[index];
+			const int queueIndex = (int)submission.Queue;
+			const int otherIndex = 1 - queueIndex;
+			ID3D12CommandQueue* queue = mQueues[queueIndex];
+
+			UINT64 waitValue = 0;
+			if (mMode == AsyncComputeMode::Serialized)
+			{
+				waitValue = mFenceValues[otherIndex];
+			}
+			else
+			{
+				if (submission.WaitFor >= 0)
+				{
+					waitValue = mSubmissionFences[submission.WaitFor];
+				}
+				if (!queueStarted[queueIndex] && mCrossFrameWait[queueIndex])
+				{
+					waitValue = max(waitValue, previousFrameValues[otherIndex]);
+				}
+			}
+			queueStarted[queueIndex] = true;
+
+			// Waits already covered by an earlier one on this queue are skipped.
+			if (waitValue > mWaitedValues[queueIndex][otherIndex])
+			{
+				ThrowIfFailed(queue->Wait(mFences[otherIndex].Get(), waitValue));
+				mWaitedValues[queueIndex][otherIndex] = waitValue;
+			}
+			else
+			{
+				waitValue = 0;
+			}
+
+			mSubmitLists.clear();
+			for (uint32_t pass : submission.Passes)
+			{
+				mSubmitLists.push_back(mPasses[pass].CmdList.Get());
+			}
+			queue->ExecuteCommandLists((UINT)mSubmitLists.size(), mSubmitLists.data());
+
+			const bool signal = submission.Signal ||
+				mLastSubmissionOnQueue[queueIndex] == (int)index ||
+				mMode == AsyncComputeMode::Serialized ||
+				mTimeline != nullptr;
+
+			if (signal)
+			{
+				mSubmissionFences[index] = ++mFenceValues[queueIndex];
+				ThrowIfFailed(queue->Signal(mFences[queueIndex].Get(), mSubmissionFences[index]));
+				mFrameSignals[queueIndex] = mSubmissionFences[index];
+			}
+
+			if (mTimeline != nullptr)
+			{
+				string passes;
+				for (uint32_t pass : submission.Passes)
+				{
+					passes += (passes.empty() ? "" : "+") + mGraph.PassName(pass);
+				}
+				mTimeline->Submit(submission.Queue, passes, waitValue, mSubmissionFences[index]);
+			}
+		});
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "D3D12FrameFence.h"
+#include "PassGraph.h"
+#include "QueueTimeline.h"
+
+enum class AsyncComputeMode
+{
+	// Queues only wait where a pass depends on the other queue, so one frame's
+	// compute work runs alongside the previous frame's graphics work.
+	Overlapped,
+	// Every submission waits for the one before it, whatever its queue. No overlap;
+	// for comparing against.
+	Serialized
+};
+
+// Runs a PassGraph on a graphics and a compute queue. Each pass has its own command
+// list and, per frame resource, its own allocator of the matching type, so passes
+// record on separate threads without sharing anything. Cross-queue dependencies are
+// fenced on the recorder's own fences.
+class D3D12PassRecorder
+{
+public:
+	typedef function<void(ID3D12GraphicsCommandList*)> RecordFunction;
+
+	D3D12PassRecorder(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, ID3D12CommandQueue* computeQueue);
+	D3D12PassRecorder(const D3D12PassRecorder& rhs) = delete;
+	D3D12PassRecorder& operator=(const D3D12PassRecorder& rhs) = delete;
+
+	// record is called on a worker thread with the pass's list already reset, and
+	// must only touch state no other pass writes.
+	uint32_t AddPass(const string& name, PassQueue queue, RecordFunction record, const vector<uint32_t>& dependencies = {});
+	void Clear();
+
+	// Records every pass into allocators, one per pass and created on first use, then
+	// submits. The caller guarantees the GPU is done with those allocators, which for
+	// FrameResource::PassCmdListAllocs is the frame fence wait in Update.
+	void Execute(vector<ComPtr<ID3D12CommandAllocator>>& allocators, ThreadPool& pool = ThreadPool::Default());
+
+	PassGraph& Graph() { return mGraph; }
+
+	void SetMode(AsyncComputeMode mode) { mMode = mode; }
+	AsyncComputeMode Mode() const { return mMode; }
+
+	// Makes the frame's first submission on queue wait for everything the other
+	// queue was given in earlier frames. For resources shared between frames that
+	// both queues touch.
+	void SetCrossFrameWait(PassQueue queue, bool wait) { mCrossFrameWait[(int)queue] = wait; }
+
+	// Logs every submission; nullptr to stop.
+	void SetTimeline(QueueTimeline* timeline) { mTimeline = timeline; }
+
+	// The value queue's fence reaches once the last Execute's work on it is done;
+	// 0 if it had none. Each queue's last submission of a frame always signals.
+	UINT64 LastSignal(PassQueue queue) const { return mFrameSignals[(int)queue]; }
+
+	// Blocks the CPU until queue's fence reaches value.
+	void WaitForSignal(PassQueue queue, UINT64 value);
+
+private:
+	struct Pass
+	{
+		RecordFunction Record;
+		ComPtr<ID3D12GraphicsCommandList> CmdList;
+	};
+
+	static D3D12_COMMAND_LIST_TYPE ListType(PassQueue queue);
+
+private:
+	ID3D12Device* mDevice = nullptr;
+	ID3D12CommandQueue* mQueues[(int)PassQueue::Count] = {};
+
+	ComPtr<ID3D12Fence> mFences[(int)PassQueue::Count];
+	UINT64 mFenceValues[(int)PassQueue::Count] = {};
+	unique_ptr<D3D12FrameFence> mFenceWaits[(int)PassQueue::Count];
+
+	// Highest value of the column queue's fence the row queue has waited for.
+	UINT64 mWaitedValues[(int)PassQueue::Count][(int)PassQueue::Count] = {};
+	UINT64 mFrameSignals[(int)PassQueue::Count] = {};
+
+	AsyncComputeMode mMode = AsyncComputeMode::Overlapped;
+	bool mCrossFrameWait[(int)PassQueue::Count] = {};
+	QueueTimeline* mTimeline = nullptr;
+	uint64_t mFrame = 0;
+
+	PassGraph mGraph;
+	vector<Pass> mPasses;
+
+	vector<UINT64> mSubmissionFences;
+	vector<int> mLastSubmissionOnQueue;
+	vector<ID3D12CommandList*> mSubmitLists;
+};
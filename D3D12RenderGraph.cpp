@@ -0,0 +1,205 @@
+#include "D3D12RenderGraph.h"
+
+D3D12RenderGraph::D3D12RenderGraph(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, ID3D12CommandQueue* computeQueue)
+	: mDevice(device), mRecorder(device, graphicsQueue, computeQueue)
+{
+}
+
+RenderGraphResource D3D12RenderGraph::ImportResource(const string& name, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState)
+{
+	RenderGraphResource resource = mGraph.ImportResource(name, initialState, finalState);
+	mResources.resize(mGraph.ResourceCount());
+	mTransients.resize(mGraph.ResourceCount());
+	return resource;
+}
+
+void D3D12RenderGraph::SetImportedResource(RenderGraphResource resource, ID3D12Resource* d3dResource)
+{
+	mResources[resource] = d3dResource;
+}
+
+RenderGraphResource D3D12RenderGraph::CreateTransient(const string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue)
+{
+	RenderGraphHeap heap = RenderGraphHeap::Textures;
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		heap = RenderGraphHeap::Buffers;
+	}
+	else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+	{
+		heap = RenderGraphHeap::RenderTargets;
+	}
+
+	auto info = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+
+	RenderGraphResource resource = mGraph.CreateTransient(name, info.SizeInBytes, info.Alignment, (uint32_t)heap);
+	mResources.resize(mGraph.ResourceCount());
+	mTransients.resize(mGraph.ResourceCount());
+
+	Transient& transient = mTransients[resource];
+	transient.Desc = desc;
+	transient.Alignment = info.Alignment;
+	transient.HasClearValue = clearValue != nullptr;
+	if (clearValue != nullptr)
+	{
+		transient.ClearValue = *clearValue;
+	}
+	return resource;
+}
+
+uint32_t D3D12RenderGraph::AddPass(const string& name, PassQueue queue, RecordFunction record, bool sideEffects)
+{
+	mRecords.push_back(move(record));
+	return mGraph.AddPass(name, queue, sideEffects);
+}
+
+void D3D12RenderGraph::Compile()
+{
+	mGraph.Compile();
+
+	static const D3D12_HEAP_FLAGS HeapFlags[(int)RenderGraphHeap::Count] =
+	{
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES
+	};
+
+	for (RenderGraphResource r = 0; r < mGraph.ResourceCount(); ++r)
+	{
+		if (mGraph.IsTransient(r))
+		{
+			mResources[r] = nullptr;
+		}
+	}
+
+	UINT64 heapAlignment[(int)RenderGraphHeap::Count];
+	for (auto& alignment : heapAlignment)
+	{
+		alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+	for (RenderGraphResource r = 0; r < mGraph.ResourceCount(); ++r)
+	{
+		if (mGraph.IsTransient(r))
+		{
+			heapAlignment[mGraph.HeapClass(r)] = max(heapAlignment[mGraph.HeapClass(r)], mTransients[r].Alignment);
+		}
+	}
+
+	for (uint32_t heap = 0; heap < (uint32_t)RenderGraphHeap::Count; ++heap)
+	{
+		mHeaps[heap] = nullptr;
+
+		const UINT64 alignment = heapAlignment[heap];
+		const UINT64 size = (mGraph.HeapSize(heap) + alignment - 1) / alignment * alignment;
+		if (size == 0)
+		{
+			continue;
+		}
+
+		CD3DX12_HEAP_DESC heapDesc(size, D3D12_HEAP_TYPE_DEFAULT, alignment, HeapFlags[heap]);
+		ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&mHeaps[heap])));
+	}
+
+	for (RenderGraphResource r = 0; r < mGraph.ResourceCount(); ++r)
+	{
+		if (!mGraph.IsTransient(r) || mHeaps[mGraph.HeapClass(r)] == nullptr)
+		{
+			continue;
+		}
+
+		const Transient& transient = mTransients[r];
+		ThrowIfFailed(mDevice->CreatePlacedResource(
+			mHeaps[mGraph.HeapClass(r)].Get(),
+			mGraph.HeapOffset(r),
+			&transient.Desc,
+			mGraph.InitialState(r),
+			transient.HasClearValue ? &transient.ClearValue : nullptr,
+			IID_PPV_ARGS(&mResources[r])));
+	}
+
+	// Transients are reused every frame, so with both queues on one, the next
+	// frame's work on either queue must not start before this frame's is done.
+	bool sharedTransients = false;
+	for (RenderGraphResource r = 0; r < mGraph.ResourceCount(); ++r)
+	{
+		const uint32_t mask = mGraph.QueueMask(r);
+		sharedTransients |= mGraph.IsTransient(r) && (mask & (mask - 1)) != 0;
+	}
+	mRecorder.SetCrossFrameWait(PassQueue::Graphics, sharedTransients);
+	mRecorder.SetCrossFrameWait(PassQueue::Compute, sharedTransients);
+
+	mRecorder.Clear();
+	const auto& compiled = mGraph.CompiledPasses();
+
+	// With a profiler every pass is a GPU scope, and the last pass on each queue
+	// resolves that queue's queries.
+	uint32_t lastOnQueue[(int)PassQueue::Count];
+	for (auto& last : lastOnQueue)
+	{
+		last = UINT32_MAX;
+	}
+	for (uint32_t position = 0; position < (uint32_t)compiled.size(); ++position)
+	{
+		lastOnQueue[(int)mGraph.GetPassQueue(compiled[position].Pass)] = position;
+	}
+
+	for (uint32_t position = 0; position < (uint32_t)compiled.size(); ++position)
+	{
+		const uint32_t pass = compiled[position].Pass;
+		const PassQueue queue = mGraph.GetPassQueue(pass);
+
+		const uint32_t scope = mProfiler != nullptr ? mProfiler->AddScope(mGraph.PassName(pass), queue) : GpuProfiler::InvalidScope;
+		const bool resolve = mProfiler != nullptr && lastOnQueue[(int)queue] == position;
+
+		mRecorder.AddPass(mGraph.PassName(pass), queue, [this, position, queue, scope, resolve](ID3D12GraphicsCommandList* cmdList)
+			{
+				const RenderGraphCompiledPass& p = mGraph.CompiledPasses()[position];
+				{
+					GpuProfileScope profileScope(mProfiler, cmdList, scope);
+					RecordBarriers(cmdList, p.Barriers);
+					mRecords[p.Pass](cmdList);
+					RecordBarriers(cmdList, p.PostBarriers);
+				}
+				if (resolve)
+				{
+					mProfiler->Resolve(cmdList, queue);
+				}
+			}, compiled[position].Dependencies);
+	}
+}
+
+void D3D12RenderGraph::Execute(vector<ComPtr<ID3D12CommandAllocator>>& allocators, ThreadPool& pool)
+{
+	mRecorder.Execute(allocators, pool);
+}
+
+void D3D12RenderGraph::RecordBarriers(ID3D12GraphicsCommandList* cmdList, const vector<RenderGraphBarrier>& barriers) const
+{
+	if (barriers.empty())
+	{
+		return;
+	}
+
+	vector<D3D12_RESOURCE_BARRIER> d3dBarriers;
+	d3dBarriers.reserve(barriers.size());
+
+	for (auto& barrier : barriers)
+	{
+		ID3D12Resource* resource = mResources[barrier.Resource].Get();
+
+		switch (barrier.Type)
+		{
+		case RenderGraphBarrier::BarrierType::Transition:
+			d3dBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, barrier.Before, barrier.After));
+			break;
+		case RenderGraphBarrier::BarrierType::Aliasing:
+			d3dBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource));
+			break;
+		case RenderGraphBarrier::BarrierType::UnorderedAccess:
+			d3dBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+			break;
+		}
+	}
+
+	cmdList->ResourceBarrier((UINT)d3dBarriers.size(), d3dBarriers.data());
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "D3D12GpuProfiler.h"
+#include "D3D12PassRecorder.h"
+#include "RenderGraph.h"
+
+// Heaps transients are placed in. Kept apart so the graph also runs on resource
+// heap tier 1 hardware.
+enum class RenderGraphHeap : uint32_t
+{
+	Buffers = 0,
+	RenderTargets,
+	Textures,
+	Count
+};
+
+// Runs a RenderGraph: creates the transient heaps and placed resources, records the
+// derived barriers around each pass and hands the passes to a D3D12PassRecorder in
+// the compiled order. Aliased render targets and depth buffers must be cleared (or
+// discarded) by the first pass writing them, as D3D12 requires.
+class D3D12RenderGraph
+{
+public:
+	typedef D3D12PassRecorder::RecordFunction RecordFunction;
+
+	D3D12RenderGraph(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, ID3D12CommandQueue* computeQueue);
+	D3D12RenderGraph(const D3D12RenderGraph& rhs) = delete;
+	D3D12RenderGraph& operator=(const D3D12RenderGraph& rhs) = delete;
+
+	RenderGraphResource ImportResource(const string& name, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState);
+
+	// Imported resources can change every frame (back buffers, per-frame buffers);
+	// bind the current one before Execute.
+	void SetImportedResource(RenderGraphResource resource, ID3D12Resource* d3dResource);
+
+	RenderGraphResource CreateTransient(const string& name, const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+	uint32_t AddPass(const string& name, PassQueue queue, RecordFunction record, bool sideEffects = false);
+	void Read(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state) { mGraph.Read(pass, resource, state); }
+	void Write(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state) { mGraph.Write(pass, resource, state); }
+	void DependsOn(uint32_t pass, uint32_t other) { mGraph.DependsOn(pass, other); }
+
+	// Times every pass on the GPU. Set before Compile.
+	void SetProfiler(D3D12GpuProfiler* profiler) { mProfiler = profiler; }
+
+	// Call once the passes are declared, and again after changing them.
+	void Compile();
+
+	void Execute(vector<ComPtr<ID3D12CommandAllocator>>& allocators, ThreadPool& pool = ThreadPool::Default());
+
+	ID3D12Resource* Resource(RenderGraphResource resource) const { return mResources[resource].Get(); }
+
+	const RenderGraph& Graph() const { return mGraph; }
+
+	// Submission mode, timeline and per-frame fences.
+	D3D12PassRecorder& Recorder() { return mRecorder; }
+
+private:
+	struct Transient
+	{
+		D3D12_RESOURCE_DESC Desc = {};
+		UINT64 Alignment = 0;
+		bool HasClearValue = false;
+		D3D12_CLEAR_VALUE ClearValue = {};
+	};
+
+	void RecordBarriers(ID3D12GraphicsCommandList* cmdList, const vector<RenderGraphBarrier>& barriers) const;
+
+private:
+	ID3D12Device* mDevice = nullptr;
+
+	RenderGraph mGraph;
+	D3D12PassRecorder mRecorder;
+	D3D12GpuProfiler* mProfiler = nullptr;
+
+	vector<RecordFunction> mRecords;
+
+	// Indexed by RenderGraphResource; imported entries hold whatever was bound last.
+	vector<ComPtr<ID3D12Resource>> mResources;
+	vector<Transient> mTransients;
+
+	ComPtr<ID3D12Heap> mHeaps[(int)RenderGraphHeap::Count];
+};
@@ -0,0 +1,186 @@
+#include "D3D12TextureUploadBackend.h"
+
+D3D12TextureUploadBackend::D3D12TextureUploadBackend(ID3D12Device* device)
+	: md3dDevice(device)
+{
+}
+
+D3D12TextureUploadBackend::~D3D12TextureUploadBackend()
+{
+}
+
+void D3D12TextureUploadBackend::BeginFrame(ID3D12GraphicsCommandList* cmdList, UINT64 fenceValue)
+{
+	mCommandList = cmdList;
+	mFenceValue = fenceValue;
+}
+
+void D3D12TextureUploadBackend::ReleaseRetired(UINT64 completedFenceValue)
+{
+	mRetired.erase(
+		remove_if(mRetired.begin(), mRetired.end(), [completedFenceValue](const RetiredResource& e)
+			{
+				return e.Fence <= completedFenceValue;
+			}),
+		mRetired.end());
+}
+
+void D3D12TextureUploadBackend::SetResidentMips(const StreamingTexture& texture, uint32_t firstMip)
+{
+	assert(mCommandList != nullptr);
+
+	const auto& layout = texture.Layout;
+	auto& resident = mResidentTextures[&texture];
+
+	if (firstMip >= layout.MipCount)
+	{
+		Retire(resident.Resource);
+		mResidentTextures.erase(&texture);
+		return;
+	}
+
+	auto newTexture = CreateTexture(layout, firstMip);
+	const UINT newMipLevels = layout.MipCount - firstMip;
+
+	auto toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(newTexture.Get(),
+		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+	mCommandList->ResourceBarrier(1, &toCopyDest);
+
+	uint32_t keptMip = layout.MipCount;
+
+	if (resident.Resource != nullptr)
+	{
+		keptMip = max(firstMip, resident.FirstMip);
+		const UINT oldMipLevels = layout.MipCount - resident.FirstMip;
+
+		auto toCopySource = CD3DX12_RESOURCE_BARRIER::Transition(resident.Resource.Get(),
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		mCommandList->ResourceBarrier(1, &toCopySource);
+
+		for (UINT item = 0; item < layout.ArraySize; ++item)
+		{
+			for (UINT mip = keptMip; mip < layout.MipCount; ++mip)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(newTexture.Get(),
+					D3D12CalcSubresource(mip - firstMip, item, 0, newMipLevels, layout.ArraySize));
+				CD3DX12_TEXTURE_COPY_LOCATION src(resident.Resource.Get(),
+					D3D12CalcSubresource(mip - resident.FirstMip, item, 0, oldMipLevels, layout.ArraySize));
+				mCommandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+		}
+
+		Retire(resident.Resource);
+	}
+
+	if (firstMip < keptMip)
+	{
+		UploadMips(texture, newTexture.Get(), firstMip, keptMip);
+	}
+
+	auto toShaderResource = CD3DX12_RESOURCE_BARRIER::Transition(newTexture.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	mCommandList->ResourceBarrier(1, &toShaderResource);
+
+	resident.Resource = newTexture;
+	resident.FirstMip = firstMip;
+}
+
+void D3D12TextureUploadBackend::Release(const StreamingTexture& texture)
+{
+	auto it = mResidentTextures.find(&texture);
+	if (it != mResidentTextures.end())
+	{
+		Retire(it->second.Resource);
+		mResidentTextures.erase(it);
+	}
+}
+
+ID3D12Resource* D3D12TextureUploadBackend::GetResource(const StreamingTexture& texture) const
+{
+	auto it = mResidentTextures.find(&texture);
+	return (it == mResidentTextures.end()) ? nullptr : it->second.Resource.Get();
+}
+
+uint32_t D3D12TextureUploadBackend::GetFirstMip(const StreamingTexture& texture) const
+{
+	auto it = mResidentTextures.find(&texture);
+	return (it == mResidentTextures.end()) ? texture.Layout.MipCount : it->second.FirstMip;
+}
+
+ComPtr<ID3D12Resource> D3D12TextureUploadBackend::CreateTexture(const DDSTextureLayout& layout, uint32_t firstMip)
+{
+	const auto& top = layout.Subresource(firstMip);
+
+	D3D12_RESOURCE_DESC texDesc = {};
+	texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	texDesc.Alignment = 0;
+	texDesc.Width = top.Width;
+	texDesc.Height = top.Height;
+	texDesc.DepthOrArraySize = (UINT16)layout.ArraySize;
+	texDesc.MipLevels = (UINT16)(layout.MipCount - firstMip);
+	texDesc.Format = layout.Format;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	ComPtr<ID3D12Resource> texture;
+	auto defaultProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&defaultProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(texture.GetAddressOf())));
+
+	return texture;
+}
+
+void D3D12TextureUploadBackend::UploadMips(const StreamingTexture& texture, ID3D12Resource* dest, uint32_t firstMip, uint32_t endMip)
+{
+	const auto& layout = texture.Layout;
+	const UINT mipLevels = layout.MipCount - firstMip;
+	const UINT mipCount = endMip - firstMip;
+
+	vector<D3D12_SUBRESOURCE_DATA> initData(mipCount);
+
+	// The new mips of each array slice are contiguous subresources, the slices are not.
+	for (UINT item = 0; item < layout.ArraySize; ++item)
+	{
+		for (UINT mip = firstMip; mip < endMip; ++mip)
+		{
+			const auto& sub = layout.Subresource(mip, item);
+			auto& data = initData[mip - firstMip];
+			data.pData = texture.Data + sub.Offset;
+			data.RowPitch = (LONG_PTR)sub.RowBytes;
+			data.SlicePitch = (LONG_PTR)(sub.RowBytes * sub.NumRows);
+		}
+
+		const UINT firstSubresource = D3D12CalcSubresource(0, item, 0, mipLevels, layout.ArraySize);
+		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(dest, firstSubresource, mipCount);
+
+		ComPtr<ID3D12Resource> uploadBuffer;
+		auto uploadProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
+		ThrowIfFailed(md3dDevice->CreateCommittedResource(
+			&uploadProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&uploadBufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
+
+		UpdateSubresources(mCommandList, dest, uploadBuffer.Get(), 0, firstSubresource, mipCount, initData.data());
+
+		Retire(uploadBuffer);
+	}
+}
+
+void D3D12TextureUploadBackend::Retire(ComPtr<ID3D12Resource> resource)
+{
+	if (resource != nullptr)
+	{
+		mRetired.push_back({ resource, mFenceValue });
+	}
+}
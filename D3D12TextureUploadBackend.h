@@ -0,0 +1,52 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "TextureStreamer.h"
+
+// Keeps one committed texture per streamed texture holding exactly the resident
+// mips. Changing the resident range re-creates the texture, copies the mips that
+// stay resident on the GPU and uploads the new ones straight from the mapped file.
+class D3D12TextureUploadBackend : public TextureUploadBackend
+{
+public:
+	D3D12TextureUploadBackend(ID3D12Device* device);
+	D3D12TextureUploadBackend(const D3D12TextureUploadBackend& rhs) = delete;
+	D3D12TextureUploadBackend& operator=(const D3D12TextureUploadBackend& rhs) = delete;
+	~D3D12TextureUploadBackend();
+
+	// Copies are recorded on cmdList; resources replaced by them are kept alive until
+	// fenceValue has completed.
+	void BeginFrame(ID3D12GraphicsCommandList* cmdList, UINT64 fenceValue);
+	void ReleaseRetired(UINT64 completedFenceValue);
+
+	virtual void SetResidentMips(const StreamingTexture& texture, uint32_t firstMip) override;
+	virtual void Release(const StreamingTexture& texture) override;
+
+	ID3D12Resource* GetResource(const StreamingTexture& texture) const;
+	uint32_t GetFirstMip(const StreamingTexture& texture) const;
+
+private:
+	struct ResidentTexture
+	{
+		ComPtr<ID3D12Resource> Resource;
+		uint32_t FirstMip = 0;
+	};
+
+	struct RetiredResource
+	{
+		ComPtr<ID3D12Resource> Resource;
+		UINT64 Fence = 0;
+	};
+
+	ComPtr<ID3D12Resource> CreateTexture(const DDSTextureLayout& layout, uint32_t firstMip);
+	void UploadMips(const StreamingTexture& texture, ID3D12Resource* dest, uint32_t firstMip, uint32_t endMip);
+	void Retire(ComPtr<ID3D12Resource> resource);
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+	UINT64 mFenceValue = 0;
+
+	unordered_map<const StreamingTexture*, ResidentTexture> mResidentTextures;
+	vector<RetiredResource> mRetired;
+};
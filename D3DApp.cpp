@@ -88,7 +88,7 @@ int D3DApp::Run()
 			{
 				CalculateFrameStats();
 				Update(mTimer);
-				// TODO : Run Compute work on a different thread
+				// BaseApp records compute work on worker threads as part of Draw.
 				DoComputeWork(mTimer);
 				Draw(mTimer);
 			}
@@ -437,6 +437,9 @@ ThrowIfFailed(md3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE,
 ThrowIfFailed(md3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE,
 	IID_PPV_ARGS(&mComputeFence)));
 
+mFrameFence = make_unique<D3D12FrameFence>(mFence.Get());
+mComputeFrameFence = make_unique<D3D12FrameFence>(mComputeFence.Get());
+
 mRtvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 mDsvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 mCbvSrvUavDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
@@ -542,16 +545,7 @@ void D3DApp::FlushCommandQueue()
 
 	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mCurrentFence));
 
-	if (mFence->GetCompletedValue() < mCurrentFence)
-	{
-		// HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-		HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-
-		ThrowIfFailed(mFence->SetEventOnCompletion(mCurrentFence, eventHandle));
-
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+	mFrameFence->Wait(mCurrentFence);
 }
 
 void D3DApp::FlushComputeCommandQueue()
@@ -560,14 +554,7 @@ void D3DApp::FlushComputeCommandQueue()
 
 	ThrowIfFailed(mComputeCommandQueue->Signal(mComputeFence.Get(), mCurrentComputeFence));
 
-	if (mComputeFence->GetCompletedValue() < mCurrentComputeFence)
-	{
-		// HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-		HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-		ThrowIfFailed(mComputeFence->SetEventOnCompletion(mCurrentComputeFence, eventHandle));
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+	mComputeFrameFence->Wait(mCurrentComputeFence);
 }
 
 ID3D12Resource* D3DApp::CurrentBackBuffer() const
@@ -605,7 +592,8 @@ void D3DApp::CalculateFrameStats()
 
 		wstring windowText = mMainWndCaption +
 			L"   fps: " + fpsStr +
-			L"  mspf: " + mspfStr;
+			L"  mspf: " + mspfStr +
+			FrameStatsText();
 
 		SetWindowText(mhMainWnd, windowText.c_str());
 
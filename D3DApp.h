@@ -4,6 +4,7 @@
 #endif
 
 #include "D3DUtil.h"
+#include "D3D12FrameFence.h"
 #include "Timer.h"
 
 #pragma comment(lib,"d3dcompiler.lib")
@@ -62,6 +63,8 @@ protected:
 	D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView() const;
 
 	void CalculateFrameStats();
+	// Appended to the fps line in the window caption.
+	virtual wstring FrameStatsText() const { return L""; }
 
 	void LogAdapters();
 	void LogAdapterOutputs(IDXGIAdapter* adapter);
@@ -91,6 +94,8 @@ protected:
 	ComPtr<ID3D12Fence> mComputeFence;
 	UINT64 mCurrentFence = 0;
 	UINT64 mCurrentComputeFence = 0;
+	unique_ptr<D3D12FrameFence> mFrameFence;
+	unique_ptr<D3D12FrameFence> mComputeFrameFence;
 
 	ComPtr<ID3D12CommandQueue> mCommandQueue;
 	ComPtr<ID3D12CommandQueue> mComputeCommandQueue;
@@ -0,0 +1,48 @@
+#include "D3DShaderCompiler.h"
+#include <cstdio>
+
+bool D3DShaderCompiler::Compile(const ShaderCompileRequest& request, vector<uint8_t>& byteCode, string& errors)
+{
+	vector<D3D_SHADER_MACRO> macros;
+	macros.reserve(request.Defines.size() + 1);
+	for (auto& define : request.Defines)
+	{
+		macros.push_back({ define.Name.c_str(), define.Value.c_str() });
+	}
+	macros.push_back({ nullptr, nullptr });
+
+	wstring filename = AnsiToWString(request.Path);
+
+	ComPtr<ID3DBlob> blob = nullptr;
+	ComPtr<ID3DBlob> errorBlob;
+
+	HRESULT hr = D3DCompileFromFile(filename.c_str(), macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		request.EntryPoint.c_str(),
+		request.Target.c_str(), request.Flags, 0, &blob, &errorBlob);
+
+	if (errorBlob != nullptr)
+	{
+		errors.assign((const char*)errorBlob->GetBufferPointer(), errorBlob->GetBufferSize());
+	}
+
+	if (FAILED(hr))
+	{
+		// Missing files and the like fail without an error blob.
+		if (errors.empty())
+		{
+			char message[64];
+			snprintf(message, sizeof(message), "D3DCompileFromFile failed with 0x%08lx\n", (unsigned long)hr);
+			errors = request.Path + ": " + message;
+		}
+		return false;
+	}
+
+	const uint8_t* data = (const uint8_t*)blob->GetBufferPointer();
+	byteCode.assign(data, data + blob->GetBufferSize());
+	return true;
+}
+
+string D3DShaderCompiler::Version() const
+{
+	return "d3dcompiler_" + to_string(D3D_COMPILER_VERSION);
+}
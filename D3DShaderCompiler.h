@@ -0,0 +1,14 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "ShaderCache.h"
+
+// ShaderCompiler on top of D3DCompileFromFile with the standard include handler.
+// Failures return false with the compiler's messages in errors; D3DUtil::CompileShader
+// sends those to the debug output and throws, like it always did.
+class D3DShaderCompiler : public ShaderCompiler
+{
+public:
+	virtual bool Compile(const ShaderCompileRequest& request, vector<uint8_t>& byteCode, string& errors) override;
+	virtual string Version() const override;
+};
@@ -1,4 +1,5 @@
 #include "D3DUtil.h"
+#include "D3DShaderCompiler.h"
 #include <comdef.h>
 #include <fstream>
 
@@ -101,20 +102,35 @@ ComPtr<ID3DBlob> D3DUtil::CompileShader(
 	compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
-	HRESULT hr = S_OK;
+	// Bytecode is reused across runs until a shader, one of its includes, the
+	// defines or the compiler change.
+	static D3DShaderCompiler compiler;
+	static bool cacheDirectoryReady = CreateDirectoryA(ShaderCacheDirectory, nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+	static ShaderCache cache(&compiler, cacheDirectoryReady ? ShaderCacheDirectory : "");
 
-	ComPtr<ID3DBlob> byteCode = nullptr;
-	ComPtr<ID3DBlob> errors;
+	ShaderCompileRequest request;
+	// The cache opens the narrow path with the same code page AnsiToWString uses.
+	request.Path = WStringToAnsi(filename);
+	request.EntryPoint = entrypoint;
+	request.Target = target;
+	request.Flags = compileFlags;
 
-	hr = D3DCompileFromFile(filename.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		entrypoint.c_str(),
-		target.c_str(), compileFlags, 0, &byteCode, &errors);
+	for (auto define = defines; define != nullptr && define->Name != nullptr; ++define)
+	{
+		request.Defines.push_back({ define->Name, define->Definition != nullptr ? define->Definition : "" });
+	}
 
-	if (errors != nullptr)
+	string errors;
+	ShaderByteCode code = cache.Get(request, &errors);
+	if (code == nullptr)
 	{
-		OutputDebugStringA((char*)errors->GetBufferPointer());
+		OutputDebugStringA(errors.c_str());
+		throw DxException(E_FAIL, L"D3DUtil::CompileShader", filename, __LINE__);
 	}
-	ThrowIfFailed(hr);
+
+	ComPtr<ID3DBlob> byteCode = nullptr;
+	ThrowIfFailed(D3DCreateBlob(code->size(), &byteCode));
+	CopyMemory(byteCode->GetBufferPointer(), code->data(), code->size());
 
 	return byteCode;
 }
@@ -22,7 +22,8 @@
 #include "D3DX12.h"
 #include "MathHelper.h"
 
-extern const int gNumFrameResources;
+// Frames the CPU may run ahead of the GPU; set by BaseApp before anything is built.
+extern int gNumFrameResources;
 
 using namespace Microsoft::WRL;
 using namespace std;
@@ -59,6 +60,22 @@ inline std::wstring AnsiToWString(const std::string& str)
 	return std::wstring(buffer);
 }
 
+inline std::string WStringToAnsi(const std::wstring& str)
+{
+	int size = WideCharToMultiByte(CP_ACP, 0, str.c_str(), -1, nullptr, 0, nullptr, nullptr);
+	if (size <= 1)
+	{
+		return std::string();
+	}
+
+	std::string result(size - 1, '\0');
+	WideCharToMultiByte(CP_ACP, 0, str.c_str(), -1, &result[0], size, nullptr, nullptr);
+	return result;
+}
+
+const char* const ShaderCacheDirectory = "ShaderCache";
+const char* const PipelineLibraryPath = "ShaderCache/PipelineLibrary.bin";
+
 class D3DUtil
 {
 public:
@@ -86,6 +103,7 @@ public:
 		UINT64 byteSize,
 		Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
 
+	// Goes through a ShaderCache in ShaderCacheDirectory.
 	static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
 		const std::wstring& filename,
 		const D3D_SHADER_MACRO* defins,
@@ -214,6 +232,8 @@ struct Texture
 	string Name;
 	wstring Filename;
 
+	int SrvHeapIndex = -1;
+
 	ComPtr<ID3D12Resource> Resource = nullptr;
 	ComPtr<ID3D12Resource> UploadHeap = nullptr;
 };
@@ -0,0 +1,173 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureLayout.h
+//
+// DDS file structure definitions and header/subresource layout parsing shared by
+// DDSTextureLoader and the texture streaming path.
+//
+// Nothing in here touches a device, so the layout of a DDS file can be computed from
+// the first few bytes of a memory-mapped file without faulting in the pixel data.
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <dxgiformat.h>
+#include <d3d12.h>
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+#define DDS_DIMENSION_TEXTURE1D 2
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_DIMENSION_TEXTURE3D 4
+
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+
+namespace DirectX
+{
+	// Placement of one subresource inside the DDS file. Offsets are relative to the
+	// start of the file (including the magic number), so they can be applied directly
+	// to a mapped view.
+	struct DDSSubresourceLayout
+	{
+		size_t Offset = 0;
+		size_t NumBytes = 0;
+		size_t RowBytes = 0;
+		size_t NumRows = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t Depth = 0;
+	};
+
+	struct DDSTextureLayout
+	{
+		D3D12_RESOURCE_DIMENSION Dimension = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+		DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t Depth = 0;
+		uint32_t MipCount = 0;
+		uint32_t ArraySize = 0;
+		bool IsCubeMap = false;
+
+		size_t HeaderSize = 0;
+		size_t FileSize = 0;
+
+		// Indexed like D3D12 subresources: mip + arraySlice * MipCount.
+		std::vector<DDSSubresourceLayout> Subresources;
+
+		const DDSSubresourceLayout& Subresource(uint32_t mip, uint32_t arraySlice = 0) const
+		{
+			return Subresources[mip + arraySlice * MipCount];
+		}
+
+		// Bytes needed to hold mips [firstMip, MipCount) of every array slice.
+		size_t MipRangeBytes(uint32_t firstMip) const;
+	};
+
+	size_t BitsPerPixel(DXGI_FORMAT fmt);
+
+	void GetSurfaceInfo(size_t width,
+		size_t height,
+		DXGI_FORMAT fmt,
+		size_t* outNumBytes,
+		size_t* outRowBytes,
+		size_t* outNumRows);
+
+	DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf);
+
+	// Parses the DDS header at the start of ddsData and computes where every
+	// subresource lives. Only the header bytes are read; ddsDataSize is used to
+	// verify that the described subresources fit inside the file.
+	HRESULT GetDDSTextureLayout(const uint8_t* ddsData,
+		size_t ddsDataSize,
+		DDSTextureLayout& layout);
+}
@@ -0,0 +1,164 @@
+#include "FrameCapture.h"
+#include <cstring>
+
+namespace
+{
+	const uint32_t StreamMagic = 0x50414346; // "FCAP"
+	const uint32_t StreamVersion = 1;
+	const uint32_t FrameMagic = 0x4d415246; // "FRAM"
+
+	// Counts above this are taken for a damaged stream rather than allocated.
+	const uint32_t MaxCount = 1u << 24;
+
+	static_assert(sizeof(CaptureInstance) == 2 * sizeof(XMFLOAT4X4) + sizeof(uint32_t), "instances are stored as they are laid out");
+	static_assert(sizeof(CaptureCullObject) == sizeof(XMFLOAT4) + sizeof(XMFLOAT3), "cull objects are stored as they are laid out");
+
+	template<typename T>
+	bool SameElements(const vector<T>& a, const vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+	}
+}
+
+FrameCaptureWriter::FrameCaptureWriter(ostream& out)
+	: mOut(out)
+{
+	WriteValue(StreamMagic);
+	WriteValue(StreamVersion);
+}
+
+void FrameCaptureWriter::WriteBytes(const void* data, size_t size)
+{
+	mOut.write(reinterpret_cast<const char*>(data), size);
+	mBytes += size;
+}
+
+void FrameCaptureWriter::Write(const CaptureFrame& frame)
+{
+	WriteValue(FrameMagic);
+	WriteValue(frame.Frame);
+	WriteValue(frame.DeltaTime);
+	WriteValue(frame.TotalTime);
+	WriteValue(frame.View);
+	WriteValue(frame.Proj);
+
+	WriteValue((uint32_t)frame.Items.size());
+	for (size_t i = 0; i < frame.Items.size(); ++i)
+	{
+		const auto& item = frame.Items[i];
+		WriteValue(item.ObjectIndex);
+		WriteValue(item.MaterialIndex);
+		WriteValue(item.BoundsCenter);
+		WriteValue(item.BoundsExtents);
+		WriteValue((uint32_t)item.Instances.size());
+
+		const uint8_t changed = mFrames == 0 || i >= mPrevious.Items.size()
+			|| !SameElements(item.Instances, mPrevious.Items[i].Instances);
+		WriteValue(changed);
+		if (changed && !item.Instances.empty())
+		{
+			WriteBytes(item.Instances.data(), sizeof(CaptureInstance) * item.Instances.size());
+		}
+	}
+
+	WriteValue(frame.CullCommandCount);
+	WriteValue((uint32_t)frame.CullObjects.size());
+
+	const uint8_t changed = mFrames == 0 || !SameElements(frame.CullObjects, mPrevious.CullObjects);
+	WriteValue(changed);
+	if (changed && !frame.CullObjects.empty())
+	{
+		WriteBytes(frame.CullObjects.data(), sizeof(CaptureCullObject) * frame.CullObjects.size());
+	}
+
+	mPrevious = frame;
+	++mFrames;
+}
+
+FrameCaptureReader::FrameCaptureReader(istream& in)
+	: mIn(in)
+{
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	mValid = ReadValue(magic) && ReadValue(version) && magic == StreamMagic && version == StreamVersion;
+}
+
+bool FrameCaptureReader::ReadBytes(void* data, size_t size)
+{
+	mIn.read(reinterpret_cast<char*>(data), size);
+	return (size_t)mIn.gcount() == size;
+}
+
+bool FrameCaptureReader::Read(CaptureFrame& frame)
+{
+	uint32_t magic = 0;
+	if (!mValid || !ReadValue(magic) || magic != FrameMagic)
+	{
+		return false;
+	}
+
+	uint32_t itemCount = 0;
+	if (!ReadValue(frame.Frame) || !ReadValue(frame.DeltaTime) || !ReadValue(frame.TotalTime)
+		|| !ReadValue(frame.View) || !ReadValue(frame.Proj) || !ReadValue(itemCount) || itemCount > MaxCount)
+	{
+		return false;
+	}
+
+	frame.Items.resize(itemCount);
+	for (uint32_t i = 0; i < itemCount; ++i)
+	{
+		auto& item = frame.Items[i];
+		uint32_t instanceCount = 0;
+		uint8_t changed = 0;
+		if (!ReadValue(item.ObjectIndex) || !ReadValue(item.MaterialIndex)
+			|| !ReadValue(item.BoundsCenter) || !ReadValue(item.BoundsExtents)
+			|| !ReadValue(instanceCount) || !ReadValue(changed) || instanceCount > MaxCount)
+		{
+			return false;
+		}
+
+		if (changed)
+		{
+			item.Instances.resize(instanceCount);
+			if (instanceCount > 0 && !ReadBytes(item.Instances.data(), sizeof(CaptureInstance) * instanceCount))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if (i >= mPrevious.Items.size() || mPrevious.Items[i].Instances.size() != instanceCount)
+			{
+				return false;
+			}
+			item.Instances = mPrevious.Items[i].Instances;
+		}
+	}
+
+	uint32_t cullObjectCount = 0;
+	uint8_t changed = 0;
+	if (!ReadValue(frame.CullCommandCount) || !ReadValue(cullObjectCount) || !ReadValue(changed) || cullObjectCount > MaxCount)
+	{
+		return false;
+	}
+
+	if (changed)
+	{
+		frame.CullObjects.resize(cullObjectCount);
+		if (cullObjectCount > 0 && !ReadBytes(frame.CullObjects.data(), sizeof(CaptureCullObject) * cullObjectCount))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if (mPrevious.CullObjects.size() != cullObjectCount)
+		{
+			return false;
+		}
+		frame.CullObjects = mPrevious.CullObjects;
+	}
+
+	mPrevious = frame;
+	return true;
+}
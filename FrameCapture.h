@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace std;
+using namespace DirectX;
+
+struct CaptureInstance
+{
+	XMFLOAT4X4 World;
+	XMFLOAT4X4 TexTransform;
+	uint32_t MaterialIndex = 0;
+};
+
+struct CaptureRenderItem
+{
+	uint32_t ObjectIndex = 0;
+	uint32_t MaterialIndex = 0;
+	XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f };
+	vector<CaptureInstance> Instances;
+};
+
+// One entry of GPUFrustumCulling's scene object buffer.
+struct CaptureCullObject
+{
+	XMFLOAT4 WorldPosition;
+	XMFLOAT3 Size;
+};
+
+// What a frame's CPU work starts from: the camera, every render item's instances
+// and the inputs of GPUFrustumCulling::CullSceneObjects.
+struct CaptureFrame
+{
+	uint64_t Frame = 0;
+	float DeltaTime = 0.0f;
+	float TotalTime = 0.0f;
+
+	// Row vector matrices as Camera returns them, not transposed.
+	XMFLOAT4X4 View;
+	XMFLOAT4X4 Proj;
+
+	vector<CaptureRenderItem> Items;
+
+	uint32_t CullCommandCount = 0;
+	vector<CaptureCullObject> CullObjects;
+};
+
+// Binary capture stream: a header, then one record per frame. Instances of a render
+// item and the cull objects are only stored when they differ from the previous
+// frame's, so static scenes cost little more than the camera per frame.
+class FrameCaptureWriter
+{
+public:
+	// Writes the header; out must be opened in binary mode.
+	explicit FrameCaptureWriter(ostream& out);
+	FrameCaptureWriter(const FrameCaptureWriter& rhs) = delete;
+	FrameCaptureWriter& operator=(const FrameCaptureWriter& rhs) = delete;
+
+	void Write(const CaptureFrame& frame);
+
+	uint64_t Frames() const { return mFrames; }
+	uint64_t Bytes() const { return mBytes; }
+	bool Good() const { return mOut.good(); }
+
+private:
+	void WriteBytes(const void* data, size_t size);
+
+	template<typename T>
+	void WriteValue(const T& value) { WriteBytes(&value, sizeof(T)); }
+
+private:
+	ostream& mOut;
+	uint64_t mFrames = 0;
+	uint64_t mBytes = 0;
+
+	// Last frame written, to leave out what did not change.
+	CaptureFrame mPrevious;
+};
+
+class FrameCaptureReader
+{
+public:
+	// Reads the header; in must be opened in binary mode.
+	explicit FrameCaptureReader(istream& in);
+	FrameCaptureReader(const FrameCaptureReader& rhs) = delete;
+	FrameCaptureReader& operator=(const FrameCaptureReader& rhs) = delete;
+
+	// False if the stream is not a capture or was written by another version.
+	bool IsValid() const { return mValid; }
+
+	// False at the end of the stream or on a truncated or malformed record.
+	bool Read(CaptureFrame& frame);
+
+private:
+	bool ReadBytes(void* data, size_t size);
+
+	template<typename T>
+	bool ReadValue(T& value) { return ReadBytes(&value, sizeof(T)); }
+
+private:
+	istream& mIn;
+	bool mValid = false;
+
+	CaptureFrame mPrevious;
+};
@@ -0,0 +1,221 @@
+#include "FrameReplayer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	XMFLOAT4X4 Transpose(const XMFLOAT4X4& m)
+	{
+		return XMFLOAT4X4(
+			m._11, m._21, m._31, m._41,
+			m._12, m._22, m._32, m._42,
+			m._13, m._23, m._33, m._43,
+			m._14, m._24, m._34, m._44);
+	}
+
+	XMFLOAT4X4 Multiply(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		XMFLOAT4X4 r;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+			}
+		}
+		return r;
+	}
+
+	uint64_t HashIndex(uint64_t hash, uint32_t value)
+	{
+		// FNV-1a over the value's bytes.
+		for (int i = 0; i < 4; ++i)
+		{
+			hash ^= (value >> (8 * i)) & 0xff;
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	double MsSince(chrono::high_resolution_clock::time_point start)
+	{
+		return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+void FrameReplayer::Replay(const CaptureFrame& frame, ReplayFrameResult& result)
+{
+	result = ReplayFrameResult();
+	result.Frame = frame.Frame;
+
+	auto packStart = chrono::high_resolution_clock::now();
+	PackInstances(frame);
+	result.PackMs = MsSince(packStart);
+	result.UploadBytes = sizeof(ReplayObjectData) * mInstances.size();
+
+	const size_t compared = min(mCullObjects.size(), frame.CullObjects.size());
+	for (size_t i = 0; i < compared; ++i)
+	{
+		if (memcmp(&mCullObjects[i], &frame.CullObjects[i], sizeof(CaptureCullObject)) != 0)
+		{
+			++result.CullInputMismatches;
+		}
+	}
+	result.CullInputMismatches += (uint32_t)(max(mCullObjects.size(), frame.CullObjects.size()) - compared);
+
+	auto cullStart = chrono::high_resolution_clock::now();
+	Cull(frame, result);
+	result.CullMs = MsSince(cullStart);
+
+	mStats.AddFrame(frame.Frame, result.Culling);
+}
+
+void FrameReplayer::PackInstances(const CaptureFrame& frame)
+{
+	uint32_t instanceCount = 0;
+	uint32_t cullObjectCount = 0;
+
+	for (auto& item : frame.Items)
+	{
+		instanceCount = max(instanceCount, item.ObjectIndex + (uint32_t)item.Instances.size());
+		cullObjectCount += (uint32_t)item.Instances.size();
+	}
+
+	mInstances.resize(instanceCount);
+	mCullObjects.resize(cullObjectCount);
+
+	uint32_t cullOffset = 0;
+
+	for (auto& item : frame.Items)
+	{
+		const uint32_t objectOffset = item.ObjectIndex;
+		const uint32_t itemCullOffset = cullOffset;
+
+		ThreadPool::Default().ParallelFor(0, (int)item.Instances.size(), 1024, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				const auto& instance = item.Instances[i];
+
+				ReplayObjectData& objData = mInstances[objectOffset + i];
+				objData.World = Transpose(instance.World);
+				objData.TexTransform = Transpose(instance.TexTransform);
+				objData.MaterialIndex = instance.MaterialIndex;
+
+				CaptureCullObject& cullObject = mCullObjects[itemCullOffset + i];
+				cullObject.WorldPosition = XMFLOAT4(instance.World._41, instance.World._42, instance.World._43, instance.World._44);
+				cullObject.Size = item.BoundsExtents;
+			}
+		});
+
+		cullOffset += (uint32_t)item.Instances.size();
+	}
+}
+
+void FrameReplayer::Cull(const CaptureFrame& frame, ReplayFrameResult& result)
+{
+	XMFLOAT4 planes[CullingPlaneCount];
+	ExtractPlanes(Multiply(frame.View, frame.Proj), planes);
+
+	const uint32_t objectCount = (uint32_t)frame.CullObjects.size();
+	const uint32_t groupCount = (objectCount + ObjectsPerCommand - 1) / ObjectsPerCommand;
+	const uint32_t commandCount = min(groupCount, frame.CullCommandCount);
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (uint32_t command = 0; command < commandCount; ++command)
+	{
+		uint32_t tested = 0;
+		uint32_t visible = 0;
+
+		for (uint32_t thread = 0; thread < ObjectsPerCommand; ++thread)
+		{
+			// SV_DispatchThreadID in the kernel.
+			const uint32_t index = command * ObjectsPerCommand + thread;
+			if (index >= objectCount)
+			{
+				break;
+			}
+
+			++tested;
+			const uint32_t plane = FirstOutsidePlane(planes, frame.CullObjects[index]);
+			if (plane == CullingPlaneCount)
+			{
+				++visible;
+				hash = HashIndex(hash, index);
+			}
+			else
+			{
+				++result.Culling.CulledByPlane[plane];
+			}
+		}
+
+		result.Culling.AddCommand(tested, visible);
+		hash = HashIndex(hash, ~0u);
+	}
+
+	result.VisibilityHash = hash;
+}
+
+void FrameReplayer::ExtractPlanes(const XMFLOAT4X4& viewProj, XMFLOAT4 planes[CullingPlaneCount])
+{
+	XMFLOAT4X4 m = Transpose(viewProj);
+
+	const XMFLOAT4 planeEquations[CullingPlaneCount] =
+	{
+		XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41), // Left
+		XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41), // Right
+		XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42), // Bottom
+		XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42), // Top
+		XMFLOAT4(m._13, m._23, m._33, m._43), // Near
+		XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43), // Far
+	};
+
+	for (uint32_t i = 0; i < CullingPlaneCount; ++i)
+	{
+		const XMFLOAT4& p = planeEquations[i];
+		const float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z + p.w * p.w);
+		planes[i] = XMFLOAT4(p.x, p.y, p.z, length > 0.0f ? p.w / length : 0.0f);
+	}
+}
+
+uint32_t FrameReplayer::FirstOutsidePlane(const XMFLOAT4 planes[CullingPlaneCount], const CaptureCullObject& object)
+{
+	const float halfSize[3] = { object.Size.x * 0.5f, object.Size.y * 0.5f, object.Size.z * 0.5f };
+	const float position[3] = { object.WorldPosition.x, object.WorldPosition.y, object.WorldPosition.z };
+
+	for (uint32_t i = 0; i < CullingPlaneCount; ++i)
+	{
+		const float normal[3] = { planes[i].x, planes[i].y, planes[i].z };
+
+		float dot = 0.0f;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			dot += normal[axis] * (position[axis] + (normal[axis] > 0.0f ? halfSize[axis] : -halfSize[axis]));
+		}
+
+		if (dot + planes[i].w < 0.0f)
+		{
+			return i;
+		}
+	}
+	return CullingPlaneCount;
+}
+
+void FrameReplayer::WriteResult(ostream& out, const ReplayFrameResult& result)
+{
+	out << result.Frame << "\t" << result.Culling.Tested << "\t" << result.Culling.Visible;
+	for (uint32_t i = 0; i < CullingPlaneCount; ++i)
+	{
+		out << "\t" << result.Culling.CulledByPlane[i];
+	}
+
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)result.VisibilityHash);
+	out << "\t" << result.UploadBytes << "\t" << result.CullInputMismatches << "\t" << hash << "\n";
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CullingStats.h"
+#include "FrameCapture.h"
+
+// Same layout as ObjectData, which needs the D3D headers.
+struct ReplayObjectData
+{
+	XMFLOAT4X4 World;
+	XMFLOAT4X4 TexTransform;
+	uint32_t MaterialIndex = 0;
+	uint32_t Pad[7] = {};
+};
+
+struct ReplayFrameResult
+{
+	uint64_t Frame = 0;
+	CullingCounters Culling;
+
+	// Instance data the frame copies to its object buffer.
+	uint64_t UploadBytes = 0;
+
+	// Captured cull objects that packing the captured instances does not reproduce.
+	uint32_t CullInputMismatches = 0;
+
+	// Of the visible object indices of every command, in order; equal hashes mean
+	// the frame culled the same way.
+	uint64_t VisibilityHash = 0;
+
+	double PackMs = 0.0;
+	double CullMs = 0.0;
+};
+
+// Re-runs a captured frame's CPU work without a device: instance packing as
+// BaseApp::PackInstances does it and culling as the GPUFrustumCulling kernel does
+// it. Headless, so captures from a session replay anywhere, Linux included.
+class FrameReplayer
+{
+public:
+	void Replay(const CaptureFrame& frame, ReplayFrameResult& result);
+
+	// Counters of every replayed frame.
+	const CullingStats& Stats() const { return mStats; }
+	const vector<ReplayObjectData>& PackedInstances() const { return mInstances; }
+
+	// One line per frame, stable across runs and platforms; timings are left out.
+	static void WriteResult(ostream& out, const ReplayFrameResult& result);
+
+	// Planes in CullingPlane order exactly as GPUFrustumCulling::ExtractPlanes
+	// uploads them: xyz the plane equation's normal, w its normalised distance.
+	static void ExtractPlanes(const XMFLOAT4X4& viewProj, XMFLOAT4 planes[CullingPlaneCount]);
+
+	// The kernel's test; CullingPlaneCount if the object is not outside any plane.
+	static uint32_t FirstOutsidePlane(const XMFLOAT4 planes[CullingPlaneCount], const CaptureCullObject& object);
+
+	// Thread group size of the kernel, one group per command.
+	static constexpr uint32_t ObjectsPerCommand = 128;
+
+private:
+	void PackInstances(const CaptureFrame& frame);
+	void Cull(const CaptureFrame& frame, ReplayFrameResult& result);
+
+private:
+	CullingStats mStats;
+
+	vector<ReplayObjectData> mInstances;
+	vector<CaptureCullObject> mCullObjects;
+};
@@ -91,12 +91,14 @@ struct FrameResource
 	FrameResource& operator=(const FrameResource& rhs) = delete;
 	~FrameResource();
 
-	ComPtr<ID3D12CommandAllocator> CmdListAlloc;
+	// One per pass of BaseApp's D3D12PassRecorder, created on first use.
+	vector<ComPtr<ID3D12CommandAllocator>> PassCmdListAllocs;
 
 	unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
 	unique_ptr<UploadBuffer<ObjectData>> ObjectCB = nullptr;
 	unique_ptr<UploadBuffer<MaterialData>> MaterialBuffer = nullptr;
 
-	UINT64 Fence = 0;
+	// Compute fence value of the frame's last compute submission. The frame fence
+	// only covers compute work a graphics pass waited for.
 	UINT64 ComputeFence = 0;
 };
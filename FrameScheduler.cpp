@@ -0,0 +1,103 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+
+FrameScheduler::FrameScheduler(FrameFence* fence, uint32_t framesInFlight, uint32_t historySize)
+	: mFence(fence), mHistorySize(max(historySize, 1u))
+{
+	framesInFlight = min(max(framesInFlight, 1u), MaxFramesInFlight);
+	mSlotFences.resize(framesInFlight, 0);
+
+	// BeginFrame advances first, so the first frame lands in slot 0.
+	mSlot = framesInFlight - 1;
+
+	mHistory.reserve(mHistorySize);
+	mSorted.reserve(mHistorySize);
+}
+
+uint32_t FrameScheduler::BeginFrame()
+{
+	mSlot = (mSlot + 1) % FramesInFlight();
+	++mStats.Frames;
+	return mSlot;
+}
+
+double FrameScheduler::WaitForSlot()
+{
+	const uint64_t fence = mSlotFences[mSlot];
+
+	double blocked = 0.0;
+
+	if (fence != 0 && mFence->CompletedValue() < fence)
+	{
+		auto start = chrono::steady_clock::now();
+		mFence->Wait(fence);
+		blocked = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+		++mStats.BlockedFrames;
+	}
+
+	RecordBlocked(blocked);
+	return blocked;
+}
+
+void FrameScheduler::EndFrame(uint64_t fenceValue)
+{
+	mSlotFences[mSlot] = fenceValue;
+	mLastFence = max(mLastFence, fenceValue);
+}
+
+void FrameScheduler::WaitForIdle()
+{
+	if (mLastFence != 0 && mFence->CompletedValue() < mLastFence)
+	{
+		mFence->Wait(mLastFence);
+	}
+}
+
+void FrameScheduler::RecordBlocked(double milliseconds)
+{
+	mStats.LastBlockedMs = milliseconds;
+	mStats.TotalBlockedMs += milliseconds;
+	mStats.MaxBlockedMs = max(mStats.MaxBlockedMs, milliseconds);
+
+	if (mHistory.size() < mHistorySize)
+	{
+		mHistory.push_back(milliseconds);
+	}
+	else
+	{
+		mHistory[mHistoryNext] = milliseconds;
+	}
+	mHistoryNext = (mHistoryNext + 1) % mHistorySize;
+
+	mSorted = mHistory;
+	sort(mSorted.begin(), mSorted.end());
+
+	double sum = 0.0;
+	for (double ms : mSorted)
+	{
+		sum += ms;
+	}
+
+	auto percentile = [this](double p)
+	{
+		size_t index = (size_t)(p * (mSorted.size() - 1) + 0.5);
+		return mSorted[index];
+	};
+
+	mStats.AverageBlockedMs = sum / mSorted.size();
+	mStats.P50BlockedMs = percentile(0.50);
+	mStats.P95BlockedMs = percentile(0.95);
+	mStats.P99BlockedMs = percentile(0.99);
+}
+
+void SimulatedFrameFence::Wait(uint64_t value)
+{
+	Waits.push_back(value);
+	mCompleted = max(mCompleted, value);
+}
+
+void SimulatedFrameFence::Complete(uint64_t value)
+{
+	mCompleted = max(mCompleted, value);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+const uint32_t DefaultFramesInFlight = 3;
+const uint32_t MaxFramesInFlight = 8;
+
+// The fence the frame's last submission signals. Wait blocks the calling thread;
+// implementations keep one wait object and reuse it for every call.
+class FrameFence
+{
+public:
+	virtual ~FrameFence() = default;
+
+	virtual uint64_t CompletedValue() = 0;
+	virtual void Wait(uint64_t value) = 0;
+};
+
+struct FrameSchedulerStats
+{
+	uint64_t Frames = 0;
+	// Frames whose slot was still in use by the GPU when the CPU got to it.
+	uint64_t BlockedFrames = 0;
+	double LastBlockedMs = 0.0;
+	double TotalBlockedMs = 0.0;
+	double MaxBlockedMs = 0.0;
+	// Over the last HistorySize frames.
+	double AverageBlockedMs = 0.0;
+	double P50BlockedMs = 0.0;
+	double P95BlockedMs = 0.0;
+	double P99BlockedMs = 0.0;
+};
+
+// Hands out frame slots round robin and keeps up to FramesInFlight frames queued
+// on the GPU. A frame is split in two around WaitForSlot: work that only touches
+// CPU memory runs before it, overlapping the GPU finishing the slot's previous
+// frame; writes to the slot's upload buffers go after it.
+class FrameScheduler
+{
+public:
+	FrameScheduler(FrameFence* fence, uint32_t framesInFlight = DefaultFramesInFlight, uint32_t historySize = 256);
+	FrameScheduler(const FrameScheduler& rhs) = delete;
+	FrameScheduler& operator=(const FrameScheduler& rhs) = delete;
+
+	uint32_t FramesInFlight() const { return (uint32_t)mSlotFences.size(); }
+	uint32_t CurrentSlot() const { return mSlot; }
+	uint64_t CurrentFrame() const { return mStats.Frames; }
+
+	// Moves to the next slot without waiting and returns it.
+	uint32_t BeginFrame();
+
+	// Blocks until the GPU is done with the last frame that used the current slot
+	// and returns how long that took in milliseconds.
+	double WaitForSlot();
+
+	// The fence value the current frame's last submission signals.
+	void EndFrame(uint64_t fenceValue);
+
+	// Blocks until every frame handed to EndFrame has completed.
+	void WaitForIdle();
+
+	const FrameSchedulerStats& Stats() const { return mStats; }
+
+private:
+	void RecordBlocked(double milliseconds);
+
+private:
+	FrameFence* mFence = nullptr;
+
+	vector<uint64_t> mSlotFences;
+	uint32_t mSlot = 0;
+	uint64_t mLastFence = 0;
+
+	vector<double> mHistory;
+	uint32_t mHistorySize = 0;
+	uint32_t mHistoryNext = 0;
+	vector<double> mSorted;
+
+	FrameSchedulerStats mStats;
+};
+
+// Fence driven by hand for tests: Complete plays the GPU; Wait completes up to the
+// requested value immediately and remembers that it had to.
+class SimulatedFrameFence : public FrameFence
+{
+public:
+	virtual uint64_t CompletedValue() override { return mCompleted; }
+	virtual void Wait(uint64_t value) override;
+
+	void Complete(uint64_t value);
+
+	vector<uint64_t> Waits;
+
+private:
+	uint64_t mCompleted = 0;
+};
@@ -3,6 +3,7 @@
 #include "D3DUtil.h"
 #include "FrameResource.h"
 #include "UploadBuffer.h"
+#include "Waves.h"
 
 struct FrameWave
 {
@@ -12,17 +13,37 @@ public:
 	FrameWave& operator= (const FrameWave& rhs) = delete;
 	~FrameWave();
 
+	// Writes a finished surface into this frame's vertex buffer.
+	void UploadSurface(const Waves& waves, const WaveSurface& surface);
+
 	unique_ptr<UploadBuffer<Vertex>> WavesVB = nullptr;
 
 	UINT64 Fence = 0;
 };
 
-FrameWave::FrameWave(ID3D12Device* device, UINT waveVertCount)
+inline FrameWave::FrameWave(ID3D12Device* device, UINT waveVertCount)
 {
 	WavesVB = make_unique<UploadBuffer<Vertex>>(device, waveVertCount, false);
 }
 
-FrameWave::~FrameWave()
+inline FrameWave::~FrameWave()
+{
+
+}
+
+inline void FrameWave::UploadSurface(const Waves& waves, const WaveSurface& surface)
 {
+	const float width = waves.Width();
+	const float depth = waves.Depth();
+
+	for (int i = 0; i < waves.VertexCount(); ++i)
+	{
+		Vertex v;
+		v.Pos = waves.GridPosition(i, surface.Height[i]);
+		v.Normal = XMFLOAT3(surface.NormalX[i], surface.NormalY[i], surface.NormalZ[i]);
+		v.TexC.x = 0.5f + v.Pos.x / width;
+		v.TexC.y = 0.5f - v.Pos.z / depth;
 
+		WavesVB->CopyData(i, v);
+	}
 }
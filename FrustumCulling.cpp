@@ -1,22 +1,54 @@
 #include "FrustumCulling.h"
 
+namespace
+{
+	// Counts a culled box against the first plane, in CullingPlane order, it lies fully
+	// outside of, the way the GPU kernel does.
+	void CountCulled(const BoundingFrustum& frustum, const BoundingBox& box, CullingCounters& counters)
+	{
+		XMVECTOR nearPlane, farPlane, rightPlane, leftPlane, topPlane, bottomPlane;
+		frustum.GetPlanes(&nearPlane, &farPlane, &rightPlane, &leftPlane, &topPlane, &bottomPlane);
+
+		// The frustum's planes face outward.
+		const XMVECTOR planes[CullingPlaneCount] = { leftPlane, rightPlane, bottomPlane, topPlane, nearPlane, farPlane };
+		for (uint32_t i = 0; i < CullingPlaneCount; ++i)
+		{
+			if (box.Intersects(planes[i]) == FRONT)
+			{
+				++counters.CulledByPlane[i];
+				return;
+			}
+		}
+		++counters.CulledOther;
+	}
+}
+
 void FrustumCulling::UpdateCameraFrustum(const Camera& camera)
 {
 	BoundingFrustum::CreateFromMatrix(mCameraFrustum, camera.GetProj());
 }
 
-void FrustumCulling::CullRenderItems(const Camera& camera, const RenderItem* ritem, vector<ObjectData>& visibleRitems)
+void FrustumCulling::CullRenderItems(const Camera& camera, const InstanceArchetype& instances, vector<ObjectData>& visibleRitems, CullingCounters* counters)
 {
+	const UINT firstVisible = (UINT)visibleRitems.size();
+	UINT tested = 0;
+
 	XMMATRIX view = camera.GetView();
 	auto detView = XMMatrixDeterminant(view);
 	XMMATRIX invView = XMMatrixInverse(&detView, view);
 
-	const auto& instanceData = ritem->Instances;
+	const BoundingBox bounds(instances.BoundsCenter, instances.BoundsExtents);
 
-	for (UINT i = 0; i < (UINT)instanceData.size(); ++i)
+	for (UINT i = 0; i < instances.Size(); ++i)
 	{
-		XMMATRIX world = XMLoadFloat4x4(&instanceData[i].World);
-		XMMATRIX texTransform = XMLoadFloat4x4(&instanceData[i].TexTransform);
+		if ((instances.Flags[i] & InstanceVisible) == 0)
+		{
+			continue;
+		}
+		++tested;
+
+		XMMATRIX world = XMLoadFloat4x4(&instances.World[i]);
+		XMMATRIX texTransform = instances.HasTexTransforms() ? XMLoadFloat4x4(&instances.TexTransform[i]) : XMMatrixIdentity();
 
 		auto detWorld = XMMatrixDeterminant(world);
 		XMMATRIX invWorld = XMMatrixInverse(&detWorld, world);
@@ -26,12 +58,51 @@ void FrustumCulling::CullRenderItems(const Camera& camera, const RenderItem* rit
 		BoundingFrustum localSpaceFrustum;
 		mCameraFrustum.Transform(localSpaceFrustum, viewToLocal);
 
-		if ((localSpaceFrustum.Contains(ritem->Bounds) != DISJOINT) || !mFrustumCullingEnabled)
+		if ((localSpaceFrustum.Contains(bounds) != DISJOINT) || !mFrustumCullingEnabled)
 		{
 			ObjectData data;
 			XMStoreFloat4x4(&data.World, XMMatrixTranspose(world));
 			XMStoreFloat4x4(&data.TexTransform, XMMatrixTranspose(texTransform));
+			data.MaterialIndex = instances.InstanceMaterial[i];
 			visibleRitems.push_back(data);
 		}
+		else if (counters != nullptr)
+		{
+			CountCulled(localSpaceFrustum, bounds, *counters);
+		}
+	}
+
+	if (counters != nullptr)
+	{
+		counters->AddCommand(tested, (UINT)visibleRitems.size() - firstVisible);
+	}
+}
+
+void FrustumCulling::CullBounds(const Camera& camera, const vector<BoundingBox>& worldBounds, vector<UINT>& visibleIndices, CullingCounters* counters)
+{
+	const UINT firstVisible = (UINT)visibleIndices.size();
+
+	XMMATRIX view = camera.GetView();
+	auto detView = XMMatrixDeterminant(view);
+	XMMATRIX invView = XMMatrixInverse(&detView, view);
+
+	BoundingFrustum worldSpaceFrustum;
+	mCameraFrustum.Transform(worldSpaceFrustum, invView);
+
+	for (UINT i = 0; i < (UINT)worldBounds.size(); ++i)
+	{
+		if ((worldSpaceFrustum.Contains(worldBounds[i]) != DISJOINT) || !mFrustumCullingEnabled)
+		{
+			visibleIndices.push_back(i);
+		}
+		else if (counters != nullptr)
+		{
+			CountCulled(worldSpaceFrustum, worldBounds[i], *counters);
+		}
+	}
+
+	if (counters != nullptr)
+	{
+		counters->AddCommand((UINT)worldBounds.size(), (UINT)visibleIndices.size() - firstVisible);
 	}
 }
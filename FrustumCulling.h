@@ -1,14 +1,20 @@
 #pragma once
 
 #include "Camera.h"
+#include "CullingStats.h"
 #include "RenderItem.h"
 #include "FrameResource.h"
+#include "InstanceStorage.h"
 
 class FrustumCulling
 {
 public:
 	void UpdateCameraFrustum(const Camera& camera);
-	void CullRenderItems(const Camera& camera, const RenderItem* ritem, vector<ObjectData>& visibleRitems);
+	// Instances without InstanceVisible are skipped. With counters, each call adds one
+	// command to them, like a draw command of the GPU culler.
+	void CullRenderItems(const Camera& camera, const InstanceArchetype& instances, vector<ObjectData>& visibleRitems, CullingCounters* counters = nullptr);
+	// Indices of the world space boxes that intersect the frustum.
+	void CullBounds(const Camera& camera, const vector<BoundingBox>& worldBounds, vector<UINT>& visibleIndices, CullingCounters* counters = nullptr);
 	void SetFrustumCullingEnabled(bool enabled) { mFrustumCullingEnabled = enabled; }
 
 private:
@@ -1,16 +1,12 @@
 #include "GPUFrustumCulling.h"
 
-void GPUFrustumCulling::Build(ID3D12Device* device, ID3D12RootSignature* graphicsRootSig)
+void GPUFrustumCulling::Build(ID3D12Device* device, ID3D12RootSignature* graphicsRootSig, PipelineStateLibrary* pipelines)
 {
-	ThrowIfFailed(device->CreateCommandAllocator(
-		D3D12_COMMAND_LIST_TYPE_COMPUTE,
-		IID_PPV_ARGS(mCommandAllocator.GetAddressOf())));
-
-	BuildRootSignature(device);
+	BuildRootSignature(device, pipelines);
 	BuildComputeShader();
 	BuildCommandSignature(device, graphicsRootSig);
 	BuildIndirectCommandBuffer(device);
-	BuildPSO(device);
+	BuildPSO(pipelines);
 }
 
 void GPUFrustumCulling::UpdateSceneObjectBuffer(const vector<SceneObjectData>& sceneObjects)
@@ -44,62 +40,74 @@ void GPUFrustumCulling::CullSceneObjects(ID3D12Device* device, ID3D12GraphicsCom
 {
 	UpdateSceneObjectBuffer(sceneObjects);
 	UpdateFrustumPlaneBuffer(viewProjMatrix);
+	mCountBuffer->ObjectCount = (UINT)sceneObjects.size();
 
-	cmdList->SetPipelineState(mPSO.Get());
+	cmdList->SetPipelineState(mPipelines->Get(mPSO));
 
 	cmdList->SetComputeRootSignature(mRootSignature.Get());
 
-	cmdList->SetComputeRoot32BitConstants(0, 1, reinterpret_cast<void*>(&mCountBuffer->Count), 0);
+	cmdList->SetComputeRoot32BitConstants(0, 2, reinterpret_cast<void*>(mCountBuffer.get()), 0);
 
 	cmdList->SetComputeRootShaderResourceView(1, mSceneObjectBuffer->Resource()->GetGPUVirtualAddress());
 
 	cmdList->SetComputeRootShaderResourceView(2, mFrustumPlaneBuffer->Resource()->GetGPUVirtualAddress());
 
-	auto toCopy = CD3DX12_RESOURCE_BARRIER::Transition(
-		mIndirectBuffer.Get(),
-		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
-		D3D12_RESOURCE_STATE_COPY_DEST);
-
-	cmdList->ResourceBarrier(1, &toCopy);
-
-	cmdList->CopyBufferRegion(mIndirectBuffer.Get(), 0, mIndirectResetBuffer->Resource(), 0, sizeof(IndirectCommand) * MaximumCommandAmount);
-
-	CD3DX12_RESOURCE_BARRIER toCSState[2];
-
-	toCSState[0] = CD3DX12_RESOURCE_BARRIER::Transition(
-		mIndirectBuffer.Get(),
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-	toCSState[1] = CD3DX12_RESOURCE_BARRIER::Transition(
-		mIndirectOutputVisibilityBuffer.Get(),
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-	cmdList->ResourceBarrier(size(toCSState), toCSState);
-
 	cmdList->SetComputeRootUnorderedAccessView(3, mIndirectBuffer->GetGPUVirtualAddress());
 
 	cmdList->SetComputeRootUnorderedAccessView(4, mIndirectOutputVisibilityBuffer->GetGPUVirtualAddress());
 
+	cmdList->SetComputeRootUnorderedAccessView(5, mCullingStatsBuffer->GetGPUVirtualAddress());
+
 	cmdList->Dispatch(
 		(UINT)ceilf((float)sceneObjects.size() / ThreadGroupSize),
 		1,
 		1);
+}
 
-	CD3DX12_RESOURCE_BARRIER toDrawState[2];
+void GPUFrustumCulling::ResetIndirectCommands(ID3D12GraphicsCommandList* cmdList)
+{
+	cmdList->CopyBufferRegion(mIndirectBuffer.Get(), 0, mIndirectResetBuffer->Resource(), 0, IndirectCommandBytes);
+	cmdList->CopyBufferRegion(mCullingStatsBuffer.Get(), 0, mCullingStatsResetBuffer->Resource(), 0, sizeof(UINT) * CullingStatsCount);
+}
+
+void GPUFrustumCulling::CopyStatsToReadback(ID3D12GraphicsCommandList* cmdList)
+{
+	cmdList->CopyBufferRegion(mStatsReadback.Get(), 0, mIndirectBuffer.Get(), 0, IndirectCommandBytes);
+	cmdList->CopyBufferRegion(mStatsReadback.Get(), IndirectCommandBytes, mCullingStatsBuffer.Get(), 0, sizeof(UINT) * CullingStatsCount);
+
+	mReadbackCommandCount = mCountBuffer->Count;
+	mReadbackPending = true;
+}
 
-	toDrawState[0] = CD3DX12_RESOURCE_BARRIER::Transition(
-		mIndirectBuffer.Get(),
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+bool GPUFrustumCulling::ReadStats(CullingCounters& counters)
+{
+	if (!mReadbackPending)
+	{
+		return false;
+	}
 
-	toDrawState[1] = CD3DX12_RESOURCE_BARRIER::Transition(
-		mIndirectOutputVisibilityBuffer.Get(),
-		D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	D3D12_RANGE readRange = { 0, IndirectCommandBytes + sizeof(UINT) * CullingStatsCount };
+	D3D12_RANGE writtenRange = { 0, 0 };
 
-	cmdList->ResourceBarrier(size(toDrawState), toDrawState);
+	UINT8* data = nullptr;
+	ThrowIfFailed(mStatsReadback->Map(0, &readRange, reinterpret_cast<void**>(&data)));
+
+	auto commands = reinterpret_cast<const IndirectCommand*>(data);
+	auto stats = reinterpret_cast<const UINT*>(data + IndirectCommandBytes);
+
+	counters.Reset();
+	for (UINT i = 0; i < PlaneCount; ++i)
+	{
+		counters.CulledByPlane[i] = stats[i];
+	}
+	for (UINT i = 0; i < mReadbackCommandCount; ++i)
+	{
+		counters.AddCommand(stats[PlaneCount + i], commands[i].drawArgument.InstanceCount);
+	}
+
+	mStatsReadback->Unmap(0, &writtenRange);
+	mReadbackPending = false;
+	return true;
 }
 
 void GPUFrustumCulling::ExtractPlanes(const XMMATRIX& viewProjMatrix, vector<Plane>& planes)
@@ -149,14 +157,15 @@ void GPUFrustumCulling::ExtractPlanes(const XMMATRIX& viewProjMatrix, vector<Pla
 	}
 }
 
-void GPUFrustumCulling::BuildRootSignature(ID3D12Device* device)
+void GPUFrustumCulling::BuildRootSignature(ID3D12Device* device, PipelineStateLibrary* pipelines)
 {
-	CD3DX12_ROOT_PARAMETER csSlotRootParameter[5];
-	csSlotRootParameter[0].InitAsConstantBufferView(0); // cb for command
+	CD3DX12_ROOT_PARAMETER csSlotRootParameter[6];
+	csSlotRootParameter[0].InitAsConstants(2, 0); // command and object counts
 	csSlotRootParameter[1].InitAsShaderResourceView(0, 0); // srv for object transform
 	csSlotRootParameter[2].InitAsShaderResourceView(0, 1); // srv for planes
 	csSlotRootParameter[3].InitAsUnorderedAccessView(1); // uav for output and input
 	csSlotRootParameter[4].InitAsUnorderedAccessView(0); // uav for visibility
+	csSlotRootParameter[5].InitAsUnorderedAccessView(2); // uav for culling stats
 
 	CD3DX12_ROOT_SIGNATURE_DESC csRootSigDesc(size(csSlotRootParameter), csSlotRootParameter,
 		0, nullptr,
@@ -180,6 +189,8 @@ void GPUFrustumCulling::BuildRootSignature(ID3D12Device* device)
 		serializedRootSig->GetBufferPointer(),
 		serializedRootSig->GetBufferSize(),
 		IID_PPV_ARGS(mRootSignature.GetAddressOf())));
+
+	pipelines->RegisterRootSignature(mRootSignature.Get(), serializedRootSig.Get());
 }
 
 void GPUFrustumCulling::BuildComputeShader()
@@ -208,10 +219,6 @@ void GPUFrustumCulling::BuildIndirectCommandBuffer(ID3D12Device* device)
 	auto sceneObjectCount = MaximumObjectAmountPerCommand;
 	auto byteSize = CommandSizePerFrame;
 
-	ThrowIfFailed(device->CreateCommandAllocator(
-		D3D12_COMMAND_LIST_TYPE_DIRECT,
-		IID_PPV_ARGS(mCommandAllocator.GetAddressOf())));
-
 	mSceneObjectBuffer = make_unique<UploadBuffer<SceneObjectData>>(device, MaximumObjectAmount, false);
 	mFrustumPlaneBuffer = make_unique<UploadBuffer<Plane>>(device, PlaneCount, false);
 	mIndirectResetBuffer = make_unique<UploadBuffer<IndirectCommand>>(device, MaximumCommandAmount, false);
@@ -220,7 +227,7 @@ void GPUFrustumCulling::BuildIndirectCommandBuffer(ID3D12Device* device)
 	mCountBuffer->Count = sceneObjectCount;
 
 	auto defaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-	auto uavDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(IndirectCommand) * MaximumCommandAmount,
+	auto uavDesc = CD3DX12_RESOURCE_DESC::Buffer(IndirectCommandBytes,
 		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
 	ThrowIfFailed(device->CreateCommittedResource(
@@ -243,9 +250,39 @@ void GPUFrustumCulling::BuildIndirectCommandBuffer(ID3D12Device* device)
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
 		nullptr,
 		IID_PPV_ARGS(&mIndirectOutputVisibilityBuffer)));
+
+	// Culling stats, cleared from a zeroed upload buffer each frame and read back later
+	mCullingStatsResetBuffer = make_unique<UploadBuffer<UINT>>(device, CullingStatsCount, false);
+	for (UINT i = 0; i < CullingStatsCount; ++i)
+	{
+		mCullingStatsResetBuffer->CopyData(i, 0u);
+	}
+
+	auto statsBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(
+		sizeof(UINT) * CullingStatsCount,
+		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&defaultHeapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&statsBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_SOURCE,
+		nullptr,
+		IID_PPV_ARGS(&mCullingStatsBuffer)));
+
+	auto readbackHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+	auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(IndirectCommandBytes + sizeof(UINT) * CullingStatsCount);
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&readbackHeapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&readbackDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&mStatsReadback)));
 }
 
-void GPUFrustumCulling::BuildPSO(ID3D12Device* device)
+void GPUFrustumCulling::BuildPSO(PipelineStateLibrary* pipelines)
 {
 	D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
 	computePsoDesc.pRootSignature = mRootSignature.Get();
@@ -255,7 +292,8 @@ void GPUFrustumCulling::BuildPSO(ID3D12Device* device)
 		mCSShaderByteCode->GetBufferSize()
 	};
 	computePsoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-	ThrowIfFailed(device->CreateComputePipelineState(
-		&computePsoDesc,
-		IID_PPV_ARGS(&mPSO)));
+
+	// Every frame's culler asks for the same pipeline; the library creates it once.
+	mPipelines = pipelines;
+	mPSO = pipelines->AddCompute("gpuFrustumCulling", computePsoDesc);
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include <memory>
 #include "UploadBuffer.h"
+#include "CullingStats.h"
+#include "PipelineStateLibrary.h"
 
 struct SceneObjectData
 {
@@ -26,22 +28,38 @@ struct Plane
 struct CountCommand
 {
 	UINT Count;
+	UINT ObjectCount;
 	UINT pad0;
 	UINT pad1;
-	UINT pad2;
 };
 
 class GPUFrustumCulling
 {
 public:
-	void Build(ID3D12Device* device, ID3D12RootSignature* graphicsRootSig);
+	void Build(ID3D12Device* device, ID3D12RootSignature* graphicsRootSig, PipelineStateLibrary* pipelines);
 	void UpdateIndirectCommand(const vector<IndirectCommand> commands);
+
+	// Clears the indirect buffer's commands and the culling stats; both must be in COPY_DEST.
+	void ResetIndirectCommands(ID3D12GraphicsCommandList* cmdList);
+
+	// The indirect, visibility and stats buffers must be in UNORDERED_ACCESS. Between
+	// frames the render graph keeps them in INDIRECT_ARGUMENT,
+	// NON_PIXEL_SHADER_RESOURCE and COPY_SOURCE, the states they are created in.
 	void CullSceneObjects(
 		ID3D12Device* device,
 		ID3D12GraphicsCommandList* cmdList,
 		const XMMATRIX& viewProjMatrix,
 		const vector<SceneObjectData>& sceneObjects);
 
+	// Copies the commands and the stats to this culler's readback buffer; both must
+	// be in COPY_SOURCE.
+	void CopyStatsToReadback(ID3D12GraphicsCommandList* cmdList);
+
+	// Counters of the frame last copied by CopyStatsToReadback. Call once that frame's
+	// fence has passed, i.e. when this culler's frame slot comes round again, so the
+	// read never waits on the GPU. False if nothing was copied yet.
+	bool ReadStats(CullingCounters& counters);
+
 	ID3D12CommandSignature* GetCommandSignature()
 	{
 		return mCommandSignature.Get();
@@ -52,14 +70,14 @@ public:
 		return mIndirectOutputVisibilityBuffer.Get();
 	}
 
-	ComPtr<ID3D12CommandAllocator> CommandAllocator()
+	ID3D12Resource* GetIndirectBuffer()
 	{
-		return mCommandAllocator;
+		return mIndirectBuffer.Get();
 	}
 
-	ID3D12Resource* GetIndirectBuffer()
+	ID3D12Resource* GetStatsResource()
 	{
-		return mIndirectBuffer.Get();
+		return mCullingStatsBuffer.Get();
 	}
 
 	CountCommand* CountBuffer()
@@ -68,11 +86,11 @@ public:
 	}
 
 private:
-	void BuildRootSignature(ID3D12Device* device);
+	void BuildRootSignature(ID3D12Device* device, PipelineStateLibrary* pipelines);
 	void BuildComputeShader();
 	void BuildCommandSignature(ID3D12Device* device, ID3D12RootSignature* graphicsRootSignature);
 	void BuildIndirectCommandBuffer(ID3D12Device* device);
-	void BuildPSO(ID3D12Device* device);
+	void BuildPSO(PipelineStateLibrary* pipelines);
 
 	void UpdateSceneObjectBuffer(const vector<SceneObjectData>& sceneObjects);
 	void UpdateFrustumPlaneBuffer(const XMMATRIX& viewProj);
@@ -87,7 +105,6 @@ public:
 	static constexpr UINT CommandBufferCounterOffset = D3DUtil::AlignForUAVCounter(CommandSizePerFrame);
 
 private:
-	ComPtr<ID3D12CommandAllocator> mCommandAllocator;
 	unique_ptr<UploadBuffer<SceneObjectData>> mSceneObjectBuffer;
 	unique_ptr<UploadBuffer<Plane>> mFrustumPlaneBuffer;
 	unique_ptr<UploadBuffer<IndirectCommand>> mIndirectResetBuffer;
@@ -98,12 +115,26 @@ private:
 
 	ComPtr<ID3D12Resource> mIndirectOutputVisibilityBuffer;
 
+	// Culled instances per plane, then instances tested per command.
+	ComPtr<ID3D12Resource> mCullingStatsBuffer;
+	unique_ptr<UploadBuffer<UINT>> mCullingStatsResetBuffer;
+
+	// Commands followed by the stats, as of the last CopyStatsToReadback.
+	ComPtr<ID3D12Resource> mStatsReadback;
+	UINT mReadbackCommandCount = 0;
+	bool mReadbackPending = false;
+
 	ComPtr<ID3D12RootSignature> mRootSignature;
 
 	ComPtr<ID3DBlob> mCSShaderByteCode;
 
-	ComPtr<ID3D12PipelineState> mPSO;
+	PipelineStateLibrary* mPipelines = nullptr;
+	uint32_t mPSO = PipelineStateRegistry::InvalidId;
 
 	static constexpr UINT PlaneCount = 6;
 	static constexpr UINT ThreadGroupSize = 128;
+	static constexpr UINT CullingStatsCount = PlaneCount + MaximumCommandAmount;
+	static constexpr UINT IndirectCommandBytes = sizeof(IndirectCommand) * MaximumCommandAmount;
+
+	static_assert(PlaneCount == CullingPlaneCount, "the kernel counts culled instances per CullingPlane");
 };
@@ -8,7 +8,7 @@
 class GPUFrustumCullingApp : public BaseApp
 {
 public:
-	GPUFrustumCullingApp(HINSTANCE hInstance);
+	GPUFrustumCullingApp(HINSTANCE hInstance, uint32_t framesInFlight);
 	GPUFrustumCullingApp(const GPUFrustumCullingApp& rhs) = delete;
 	GPUFrustumCullingApp& operator=(const GPUFrustumCullingApp& rhs) = delete;
 	~GPUFrustumCullingApp();
@@ -37,7 +37,28 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 #endif
 	try
 	{
-		GPUFrustumCullingApp app(hInstance);
+		// "-frames N" sets how many frames the CPU may queue ahead of the GPU.
+		uint32_t framesInFlight = DefaultFramesInFlight;
+		if (const char* arg = strstr(cmdLine, "-frames "))
+		{
+			framesInFlight = (uint32_t)atoi(arg + strlen("-frames "));
+		}
+
+		GPUFrustumCullingApp app(hInstance, framesInFlight);
+
+		// "-serialcompute" turns off culling/shading overlap, for comparison.
+		if (strstr(cmdLine, "-serialcompute") != nullptr)
+		{
+			app.SetAsyncComputeMode(AsyncComputeMode::Serialized);
+		}
+
+		// "-capture file" records the session for Benchmarks/FrameReplay.
+		if (const char* arg = strstr(cmdLine, "-capture "))
+		{
+			arg += strlen("-capture ");
+			app.SetCapturePath(string(arg, strcspn(arg, " ")));
+		}
+
 		if (!app.Initialize())
 		{
 			return 0;
@@ -51,8 +72,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 	}
 }
 
-GPUFrustumCullingApp::GPUFrustumCullingApp(HINSTANCE hInstance)
-	:BaseApp(hInstance)
+GPUFrustumCullingApp::GPUFrustumCullingApp(HINSTANCE hInstance, uint32_t framesInFlight)
+	:BaseApp(hInstance, framesInFlight)
 {
 }
 
@@ -124,7 +145,8 @@ void GPUFrustumCullingApp::LoadShapes()
 		md3dDevice.Get(),
 		mCommandList.Get(),
 		shapeNames[0],
-		shapeFilenames[0]);
+		shapeFilenames[0],
+		mUploadBatcher.get());
 
 	mGeometries[mesh->Name] = move(mesh);
 }
@@ -172,6 +194,8 @@ void GPUFrustumCullingApp::BuildRootSignature()
 		serializedRootSig->GetBufferPointer(),
 		serializedRootSig->GetBufferSize(),
 		IID_PPV_ARGS(mRootSignature.GetAddressOf())));
+
+	mPipelines->RegisterRootSignature(mRootSignature.Get(), serializedRootSig.Get());
 }
 
 void GPUFrustumCullingApp::BuildDescriptorHeaps()
@@ -192,8 +216,11 @@ void GPUFrustumCullingApp::BuildDescriptorHeaps()
 	srvDesc.Texture2D.MostDetailedMip = 0;
 	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
 
+	int srvHeapIndex = 0;
 	for (auto& tex : mTextures)
 	{
+		tex.second->SrvHeapIndex = srvHeapIndex++;
+
 		auto resource = tex.second->Resource;
 		srvDesc.Format = resource->GetDesc().Format;
 		srvDesc.Texture2D.MipLevels = resource->GetDesc().MipLevels;
@@ -321,7 +348,7 @@ void GPUFrustumCullingApp::BuildGPUCullers()
 		vector<IndirectCommand> commands;
 		auto culler = make_unique<GPUFrustumCulling>();
 
-		culler->Build(md3dDevice.Get(), mRootSignature.Get());
+		culler->Build(md3dDevice.Get(), mRootSignature.Get(), mPipelines.get());
 
 		for (auto& e : mAllRitems)
 		{
@@ -371,6 +398,6 @@ void GPUFrustumCullingApp::BuildPSOs()
 	opaquePsoDesc.SampleDesc.Count = m4xMsaaState ? 4 : 1;
 	opaquePsoDesc.SampleDesc.Quality = m4xMsaaState ? (m4xMsaaQuality - 1) : 0;
 	opaquePsoDesc.DSVFormat = mDepthStencilFormat;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
-		&opaquePsoDesc, IID_PPV_ARGS(&mPSOs["opaque"])));
+	mPsoDescs["opaque"] = opaquePsoDesc;
+	mPipelines->AddGraphics("opaque", opaquePsoDesc);
 }
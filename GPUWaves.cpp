@@ -0,0 +1,222 @@
+#include "GPUWaves.h"
+
+void GPUWaves::Build(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	int m, int n, float dx, float dt, float speed, float damping)
+{
+	mConstants = MakeWaveConstants(m, n, dx, dt, speed, damping);
+	mTimeStep = dt;
+
+	BuildRootSignature(device);
+	BuildComputeShaders();
+	BuildBuffers(device);
+	BuildPSOs(device);
+
+	// Committed resources start zeroed, which is the flat initial state.
+	BuildVertices(cmdList);
+}
+
+void GPUWaves::Update(ID3D12GraphicsCommandList* cmdList, int substeps)
+{
+	if (substeps <= 0)
+	{
+		return;
+	}
+
+	SetRoot(cmdList);
+	cmdList->SetPipelineState(mUpdatePSO.Get());
+
+	for (int step = 0; step < substeps; ++step)
+	{
+		auto prev = mSolutions[1 - mCurrSolution].Get();
+		auto curr = mSolutions[mCurrSolution].Get();
+
+		cmdList->SetComputeRootUnorderedAccessView(1, prev->GetGPUVirtualAddress());
+		cmdList->SetComputeRootUnorderedAccessView(2, curr->GetGPUVirtualAddress());
+
+		cmdList->Dispatch(
+			(mConstants.NumCols + WaveTileSize - 1) / WaveTileSize,
+			(mConstants.NumRows + WaveTileSize - 1) / WaveTileSize,
+			1);
+
+		// The next step reads what this one wrote and writes what this one read,
+		// so both solutions have to be ordered before it.
+		D3D12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::UAV(prev),
+			CD3DX12_RESOURCE_BARRIER::UAV(curr),
+		};
+		cmdList->ResourceBarrier(_countof(barriers), barriers);
+
+		mCurrSolution = 1 - mCurrSolution;
+	}
+
+	BuildVertices(cmdList);
+}
+
+void GPUWaves::Disturb(ID3D12GraphicsCommandList* cmdList, int i, int j, float magnitude)
+{
+	assert(i > 1 && i < (int)mConstants.NumRows - 2);
+	assert(j > 1 && j < (int)mConstants.NumCols - 2);
+
+	WaveConstants constants = mConstants;
+	constants.DisturbRow = (uint32_t)i;
+	constants.DisturbCol = (uint32_t)j;
+	constants.DisturbMagnitude = magnitude;
+
+	auto curr = mSolutions[mCurrSolution].Get();
+
+	cmdList->SetPipelineState(mDisturbPSO.Get());
+	cmdList->SetComputeRootSignature(mRootSignature.Get());
+	cmdList->SetComputeRoot32BitConstants(0, ConstantCount, &constants, 0);
+	cmdList->SetComputeRootUnorderedAccessView(1, mSolutions[1 - mCurrSolution]->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(2, curr->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(3, mVertexBuffer->GetGPUVirtualAddress());
+
+	cmdList->Dispatch(1, 1, 1);
+
+	auto written = CD3DX12_RESOURCE_BARRIER::UAV(curr);
+	cmdList->ResourceBarrier(1, &written);
+}
+
+D3D12_VERTEX_BUFFER_VIEW GPUWaves::VertexBufferView() const
+{
+	D3D12_VERTEX_BUFFER_VIEW vbv;
+	vbv.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
+	vbv.StrideInBytes = sizeof(WaveVertex);
+	vbv.SizeInBytes = VertexCount() * sizeof(WaveVertex);
+	return vbv;
+}
+
+void GPUWaves::SetRoot(ID3D12GraphicsCommandList* cmdList)
+{
+	cmdList->SetComputeRootSignature(mRootSignature.Get());
+	cmdList->SetComputeRoot32BitConstants(0, ConstantCount, &mConstants, 0);
+	cmdList->SetComputeRootUnorderedAccessView(3, mVertexBuffer->GetGPUVirtualAddress());
+}
+
+void GPUWaves::BuildVertices(ID3D12GraphicsCommandList* cmdList)
+{
+	SetRoot(cmdList);
+	cmdList->SetPipelineState(mNormalsPSO.Get());
+
+	cmdList->SetComputeRootUnorderedAccessView(1, mSolutions[1 - mCurrSolution]->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(2, mSolutions[mCurrSolution]->GetGPUVirtualAddress());
+
+	auto toUAV = CD3DX12_RESOURCE_BARRIER::Transition(
+		mVertexBuffer.Get(),
+		D3D12_RESOURCE_STATE_COMMON,
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	cmdList->ResourceBarrier(1, &toUAV);
+
+	cmdList->Dispatch(
+		(mConstants.NumCols + WaveTileSize - 1) / WaveTileSize,
+		(mConstants.NumRows + WaveTileSize - 1) / WaveTileSize,
+		1);
+
+	auto toCommon = CD3DX12_RESOURCE_BARRIER::Transition(
+		mVertexBuffer.Get(),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+		D3D12_RESOURCE_STATE_COMMON);
+	cmdList->ResourceBarrier(1, &toCommon);
+}
+
+void GPUWaves::BuildRootSignature(ID3D12Device* device)
+{
+	CD3DX12_ROOT_PARAMETER csSlotRootParameter[4];
+	csSlotRootParameter[0].InitAsConstants(ConstantCount, 0); // cbWaves
+	csSlotRootParameter[1].InitAsUnorderedAccessView(0); // previous solution, written in place
+	csSlotRootParameter[2].InitAsUnorderedAccessView(1); // current solution
+	csSlotRootParameter[3].InitAsUnorderedAccessView(2); // vertices
+
+	CD3DX12_ROOT_SIGNATURE_DESC csRootSigDesc(size(csSlotRootParameter), csSlotRootParameter,
+		0, nullptr,
+		D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+	ComPtr<ID3DBlob> serializedRootSig = nullptr;
+	ComPtr<ID3DBlob> errorBlob = nullptr;
+
+	HRESULT hr = D3D12SerializeRootSignature(&csRootSigDesc,
+		D3D_ROOT_SIGNATURE_VERSION_1,
+		serializedRootSig.GetAddressOf(),
+		errorBlob.GetAddressOf());
+
+	if (errorBlob != nullptr)
+	{
+		OutputDebugStringA((char*)errorBlob->GetBufferPointer());
+	}
+	ThrowIfFailed(hr);
+	ThrowIfFailed(device->CreateRootSignature(
+		0,
+		serializedRootSig->GetBufferPointer(),
+		serializedRootSig->GetBufferSize(),
+		IID_PPV_ARGS(mRootSignature.GetAddressOf())));
+}
+
+void GPUWaves::BuildComputeShaders()
+{
+	mUpdateCSByteCode = D3DUtil::CompileShader(L"Shaders\\Waves.hlsl", nullptr, "UpdateCS", "cs_5_1");
+	mNormalsCSByteCode = D3DUtil::CompileShader(L"Shaders\\Waves.hlsl", nullptr, "NormalsCS", "cs_5_1");
+	mDisturbCSByteCode = D3DUtil::CompileShader(L"Shaders\\Waves.hlsl", nullptr, "DisturbCS", "cs_5_1");
+}
+
+void GPUWaves::BuildBuffers(ID3D12Device* device)
+{
+	auto defaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+
+	auto solutionDesc = CD3DX12_RESOURCE_DESC::Buffer(
+		(UINT64)VertexCount() * sizeof(float),
+		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+	for (auto& solution : mSolutions)
+	{
+		ThrowIfFailed(device->CreateCommittedResource(
+			&defaultHeapProps,
+			D3D12_HEAP_FLAG_NONE,
+			&solutionDesc,
+			D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+			nullptr,
+			IID_PPV_ARGS(solution.GetAddressOf())));
+	}
+
+	auto vertexDesc = CD3DX12_RESOURCE_DESC::Buffer(
+		(UINT64)VertexCount() * sizeof(WaveVertex),
+		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&defaultHeapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&vertexDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(mVertexBuffer.GetAddressOf())));
+}
+
+void GPUWaves::BuildPSOs(ID3D12Device* device)
+{
+	D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+	computePsoDesc.pRootSignature = mRootSignature.Get();
+	computePsoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+
+	computePsoDesc.CS =
+	{
+		reinterpret_cast<BYTE*>(mUpdateCSByteCode->GetBufferPointer()),
+		mUpdateCSByteCode->GetBufferSize()
+	};
+	ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mUpdatePSO)));
+
+	computePsoDesc.CS =
+	{
+		reinterpret_cast<BYTE*>(mNormalsCSByteCode->GetBufferPointer()),
+		mNormalsCSByteCode->GetBufferSize()
+	};
+	ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mNormalsPSO)));
+
+	computePsoDesc.CS =
+	{
+		reinterpret_cast<BYTE*>(mDisturbCSByteCode->GetBufferPointer()),
+		mDisturbCSByteCode->GetBufferSize()
+	};
+	ThrowIfFailed(device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&mDisturbPSO)));
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "WavesTiledEmulator.h"
+
+// Waves on the GPU, see Shaders/Waves.hlsl. The solution never leaves video memory
+// and NormalsCS writes the vertex buffer directly, so nothing goes through an
+// upload ring. All work is recorded on whatever list is passed in; a compute
+// queue list works.
+class GPUWaves
+{
+public:
+	void Build(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		int m, int n, float dx, float dt, float speed, float damping);
+
+	// Runs substeps fixed time steps and rebuilds the vertices. The vertex buffer
+	// is left in COMMON so the direct queue can promote it to a vertex buffer.
+	void Update(ID3D12GraphicsCommandList* cmdList, int substeps);
+	void Disturb(ID3D12GraphicsCommandList* cmdList, int i, int j, float magnitude);
+
+	UINT VertexCount() const { return mConstants.NumRows * mConstants.NumCols; }
+	float TimeStep() const { return mTimeStep; }
+
+	D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const;
+
+	ID3D12Resource* GetVertexBuffer()
+	{
+		return mVertexBuffer.Get();
+	}
+
+private:
+	void BuildRootSignature(ID3D12Device* device);
+	void BuildComputeShaders();
+	void BuildBuffers(ID3D12Device* device);
+	void BuildPSOs(ID3D12Device* device);
+
+	void SetRoot(ID3D12GraphicsCommandList* cmdList);
+	void BuildVertices(ID3D12GraphicsCommandList* cmdList);
+
+public:
+	struct WaveVertex
+	{
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+		XMFLOAT2 TexC;
+	};
+
+private:
+	WaveConstants mConstants;
+	float mTimeStep = 0.0f;
+
+	ComPtr<ID3D12Resource> mSolutions[2];
+	int mCurrSolution = 0;
+
+	ComPtr<ID3D12Resource> mVertexBuffer;
+
+	ComPtr<ID3D12RootSignature> mRootSignature;
+
+	ComPtr<ID3DBlob> mUpdateCSByteCode;
+	ComPtr<ID3DBlob> mNormalsCSByteCode;
+	ComPtr<ID3DBlob> mDisturbCSByteCode;
+
+	ComPtr<ID3D12PipelineState> mUpdatePSO;
+	ComPtr<ID3D12PipelineState> mNormalsPSO;
+	ComPtr<ID3D12PipelineState> mDisturbPSO;
+
+	static constexpr UINT ConstantCount = sizeof(WaveConstants) / sizeof(UINT);
+};
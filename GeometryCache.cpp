@@ -0,0 +1,195 @@
+#include "GeometryCache.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+
+GeometryKey GeometryKey::Box(float width, float height, float depth, uint32_t numSubdivisions)
+{
+	GeometryKey key;
+	key.Shape = GeometryShape::Box;
+	key.Params[0] = width;
+	key.Params[1] = height;
+	key.Params[2] = depth;
+	key.Counts[0] = numSubdivisions;
+	return key;
+}
+
+GeometryKey GeometryKey::Sphere(float radius, uint32_t sliceCount, uint32_t stackCount)
+{
+	GeometryKey key;
+	key.Shape = GeometryShape::Sphere;
+	key.Params[0] = radius;
+	key.Counts[0] = sliceCount;
+	key.Counts[1] = stackCount;
+	return key;
+}
+
+GeometryKey GeometryKey::Geosphere(float radius, uint32_t numSubdivisions)
+{
+	GeometryKey key;
+	key.Shape = GeometryShape::Geosphere;
+	key.Params[0] = radius;
+	key.Counts[0] = numSubdivisions;
+	return key;
+}
+
+GeometryKey GeometryKey::Cylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount)
+{
+	GeometryKey key;
+	key.Shape = GeometryShape::Cylinder;
+	key.Params[0] = bottomRadius;
+	key.Params[1] = topRadius;
+	key.Params[2] = height;
+	key.Counts[0] = sliceCount;
+	key.Counts[1] = stackCount;
+	return key;
+}
+
+GeometryKey GeometryKey::Grid(float width, float depth, uint32_t m, uint32_t n)
+{
+	GeometryKey key;
+	key.Shape = GeometryShape::Grid;
+	key.Params[0] = width;
+	key.Params[1] = depth;
+	key.Counts[0] = m;
+	key.Counts[1] = n;
+	return key;
+}
+
+GeometryKey GeometryKey::Quad(float x, float y, float w, float h, float depth)
+{
+	GeometryKey key;
+	key.Shape = GeometryShape::Quad;
+	key.Params[0] = x;
+	key.Params[1] = y;
+	key.Params[2] = w;
+	key.Params[3] = h;
+	key.Params[4] = depth;
+	return key;
+}
+
+bool GeometryKey::operator==(const GeometryKey& rhs) const
+{
+	return Shape == rhs.Shape
+		&& memcmp(Params, rhs.Params, sizeof(Params)) == 0
+		&& memcmp(Counts, rhs.Counts, sizeof(Counts)) == 0;
+}
+
+size_t GeometryKeyHash::operator()(const GeometryKey& key) const
+{
+	// FNV-1a over the shape, parameter bits and counts.
+	uint32_t words[8];
+	words[0] = (uint32_t)key.Shape;
+	memcpy(&words[1], key.Params, sizeof(key.Params));
+	memcpy(&words[6], key.Counts, sizeof(key.Counts));
+
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t word : words)
+	{
+		hash ^= word;
+		hash *= 1099511628211ull;
+	}
+
+	return (size_t)hash;
+}
+
+GeometryGenerator::MeshData GeometryCache::Generate(const GeometryKey& key)
+{
+	GeometryGenerator geoGen;
+	const float* p = key.Params;
+	const uint32_t* c = key.Counts;
+
+	switch (key.Shape)
+	{
+	case GeometryShape::Box:
+		return geoGen.CreateBox(p[0], p[1], p[2], c[0]);
+	case GeometryShape::Sphere:
+		return geoGen.CreateSphere(p[0], c[0], c[1]);
+	case GeometryShape::Geosphere:
+		return geoGen.CreateGeosphere(p[0], c[0]);
+	case GeometryShape::Cylinder:
+		return geoGen.CreateCylinder(p[0], p[1], p[2], c[0], c[1]);
+	case GeometryShape::Grid:
+		return geoGen.CreateGrid(p[0], p[1], c[0], c[1]);
+	case GeometryShape::Quad:
+		return geoGen.CreateQuad(p[0], p[1], p[2], p[3], p[4]);
+	}
+
+	return GeometryGenerator::MeshData();
+}
+
+GeometryCache::MeshDataPtr GeometryCache::Get(const GeometryKey& key)
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		auto it = mMeshes.find(key);
+		if (it != mMeshes.end())
+		{
+			++mStats.Hits;
+			return it->second;
+		}
+
+		++mStats.Misses;
+	}
+
+	// Generate without holding the lock. Two threads missing on the same key both
+	// build it and the first one stored wins.
+	auto mesh = make_shared<const GeometryGenerator::MeshData>(Generate(key));
+
+	lock_guard<mutex> lock(mMutex);
+	return mMeshes.emplace(key, mesh).first->second;
+}
+
+void GeometryCache::Prefetch(const vector<GeometryKey>& keys)
+{
+	vector<GeometryKey> missing;
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		for (auto& key : keys)
+		{
+			if (mMeshes.find(key) == mMeshes.end()
+				&& find(missing.begin(), missing.end(), key) == missing.end())
+			{
+				missing.push_back(key);
+			}
+		}
+	}
+
+	vector<MeshDataPtr> meshes(missing.size());
+
+	ThreadPool::Default().ParallelFor(0, (int)missing.size(), 1,
+		[&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				meshes[i] = make_shared<const GeometryGenerator::MeshData>(Generate(missing[i]));
+			}
+		});
+
+	lock_guard<mutex> lock(mMutex);
+	mStats.Misses += missing.size();
+	for (size_t i = 0; i < missing.size(); ++i)
+	{
+		mMeshes.emplace(missing[i], meshes[i]);
+	}
+}
+
+void GeometryCache::Clear()
+{
+	lock_guard<mutex> lock(mMutex);
+	mMeshes.clear();
+}
+
+size_t GeometryCache::Size()
+{
+	lock_guard<mutex> lock(mMutex);
+	return mMeshes.size();
+}
+
+GeometryCache::Stats GeometryCache::GetStats()
+{
+	lock_guard<mutex> lock(mMutex);
+	return mStats;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+enum class GeometryShape : uint32_t
+{
+	Box,
+	Sphere,
+	Geosphere,
+	Cylinder,
+	Grid,
+	Quad
+};
+
+// The parameters of one GeometryGenerator call. Floats are compared bit for bit.
+struct GeometryKey
+{
+	GeometryShape Shape = GeometryShape::Box;
+	float Params[5] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	uint32_t Counts[2] = { 0, 0 };
+
+	static GeometryKey Box(float width, float height, float depth, uint32_t numSubdivisions);
+	static GeometryKey Sphere(float radius, uint32_t sliceCount, uint32_t stackCount);
+	static GeometryKey Geosphere(float radius, uint32_t numSubdivisions);
+	static GeometryKey Cylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount);
+	static GeometryKey Grid(float width, float depth, uint32_t m, uint32_t n);
+	static GeometryKey Quad(float x, float y, float w, float h, float depth);
+
+	bool operator==(const GeometryKey& rhs) const;
+};
+
+struct GeometryKeyHash
+{
+	size_t operator()(const GeometryKey& key) const;
+};
+
+// Memoizes GeometryGenerator by parameters. Meshes are shared and immutable, so a
+// repeated request costs a hash lookup. Safe to call from several threads.
+class GeometryCache
+{
+public:
+	using MeshDataPtr = shared_ptr<const GeometryGenerator::MeshData>;
+
+	struct Stats
+	{
+		uint64_t Hits = 0;
+		uint64_t Misses = 0;
+	};
+
+	MeshDataPtr Get(const GeometryKey& key);
+
+	MeshDataPtr CreateBox(float width, float height, float depth, uint32_t numSubdivisions)
+	{
+		return Get(GeometryKey::Box(width, height, depth, numSubdivisions));
+	}
+
+	MeshDataPtr CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount)
+	{
+		return Get(GeometryKey::Sphere(radius, sliceCount, stackCount));
+	}
+
+	MeshDataPtr CreateGeosphere(float radius, uint32_t numSubdivisions)
+	{
+		return Get(GeometryKey::Geosphere(radius, numSubdivisions));
+	}
+
+	MeshDataPtr CreateCylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount)
+	{
+		return Get(GeometryKey::Cylinder(bottomRadius, topRadius, height, sliceCount, stackCount));
+	}
+
+	MeshDataPtr CreateGrid(float width, float depth, uint32_t m, uint32_t n)
+	{
+		return Get(GeometryKey::Grid(width, depth, m, n));
+	}
+
+	MeshDataPtr CreateQuad(float x, float y, float w, float h, float depth)
+	{
+		return Get(GeometryKey::Quad(x, y, w, h, depth));
+	}
+
+	// Generates the missing meshes of keys in parallel on ThreadPool::Default(),
+	// e.g. from a level's prop list before it is instantiated.
+	void Prefetch(const vector<GeometryKey>& keys);
+
+	void Clear();
+	size_t Size();
+	Stats GetStats();
+
+	static GeometryGenerator::MeshData Generate(const GeometryKey& key);
+
+private:
+	mutex mMutex;
+	unordered_map<GeometryKey, MeshDataPtr, GeometryKeyHash> mMeshes;
+	Stats mStats;
+};
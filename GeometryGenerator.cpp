@@ -1,5 +1,6 @@
 #include "GeometryGenerator.h"
 #include <algorithm>
+#include <unordered_map>
 
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
@@ -89,6 +90,9 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 		1.0f, 0.0f, 0.0f,
 		0.0f, 1.0f);
 
+	meshData.Vertices.reserve(2 + (size_t)(stackCount - 1) * (sliceCount + 1));
+	meshData.Indices32.reserve((size_t)6 * sliceCount * (stackCount - 1));
+
 	meshData.Vertices.push_back(topVertex);
 
 	float phiStep = XM_PI / stackCount;
@@ -97,7 +101,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	for (uint32 i = 1; i <= stackCount - 1; ++i)
 	{
 		float phi = i * phiStep;
-		for (uint32 j = 0; j <= stackCount; ++j)
+		for (uint32 j = 0; j <= sliceCount; ++j)
 		{
 			float theta = j * thetaStep;
 
@@ -125,7 +129,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 
 	meshData.Vertices.push_back(bottomVertex);
 
-	for (uint32 i = 1; i < sliceCount; ++i)
+	for (uint32 i = 1; i <= sliceCount; ++i)
 	{
 		meshData.Indices32.push_back(0);
 		meshData.Indices32.push_back(i + 1);
@@ -189,6 +193,12 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 		10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
 	};
 
+	// Welded subdivision: each level turns V, F into V + 3F/2, 4F, so the final
+	// sizes are 10 * 4^n + 2 vertices and 20 * 4^n triangles.
+	const size_t levelScale = (size_t)1 << (2 * numSubdivisions);
+	meshData.Vertices.reserve(10 * levelScale + 2);
+	meshData.Indices32.reserve(60 * levelScale);
+
 	meshData.Vertices.resize(12);
 	meshData.Indices32.assign(&k[0], &k[60]);
 
@@ -243,6 +253,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 
 	uint32 ringCount = stackCount + 1;
 
+	// Side rings plus a ring and a center vertex for each cap.
+	meshData.Vertices.reserve((size_t)ringCount * (sliceCount + 1) + 2 * (sliceCount + 2));
+	meshData.Indices32.reserve((size_t)6 * sliceCount * stackCount + 6 * sliceCount);
+
 	for (uint32 i = 0; i < ringCount; ++i)
 	{
 		float y = -0.5f * height + i * stackHeight;
@@ -377,45 +391,63 @@ GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, floa
 
 void GeometryGenerator::Subdivide(MeshData& meshData)
 {
-	MeshData inputCopy = meshData;
+	// The input vertices stay where they are and each edge midpoint is added once,
+	// keyed by its two vertex indices, so triangles sharing an edge share the new
+	// vertex instead of each getting a copy.
+	vector<uint32> inputIndices;
+	inputIndices.swap(meshData.Indices32);
+
+	uint32 numTris = (uint32)inputIndices.size() / 3;
+
+	// Closed meshes have 3F/2 edges; open ones grow past the reservation.
+	meshData.Vertices.reserve(meshData.Vertices.size() + (3 * (size_t)numTris + 1) / 2);
+	meshData.Indices32.reserve((size_t)numTris * 12);
+
+	unordered_map<uint64_t, uint32> midPoints;
+	midPoints.reserve((3 * (size_t)numTris + 1) / 2);
 
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
+	auto midPointIndex = [&](uint32 a, uint32 b)
+		{
+			uint64_t key = ((uint64_t)min(a, b) << 32) | max(a, b);
+
+			auto it = midPoints.find(key);
+			if (it != midPoints.end())
+			{
+				return it->second;
+			}
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size() / 3;
+			Vertex m = MidPoint(meshData.Vertices[a], meshData.Vertices[b]);
+			uint32 index = (uint32)meshData.Vertices.size();
+			meshData.Vertices.push_back(m);
+			midPoints.emplace(key, index);
+			return index;
+		};
 
 	for (uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 0]];
-		Vertex v1 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 1]];
-		Vertex v2 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 2]];
-
-		Vertex m0 = MidPoint(v0, v1);
-		Vertex m1 = MidPoint(v1, v2);
-		Vertex m2 = MidPoint(v0, v2);
-
-		meshData.Vertices.push_back(v0);
-		meshData.Vertices.push_back(v1);
-		meshData.Vertices.push_back(v2);
-		meshData.Vertices.push_back(m0);
-		meshData.Vertices.push_back(m1);
-		meshData.Vertices.push_back(m2);
-
-		meshData.Indices32.push_back(i * 6 + 0);
-		meshData.Indices32.push_back(i * 6 + 3);
-		meshData.Indices32.push_back(i * 6 + 5);
-
-		meshData.Indices32.push_back(i * 6 + 3);
-		meshData.Indices32.push_back(i * 6 + 4);
-		meshData.Indices32.push_back(i * 6 + 5);
-
-		meshData.Indices32.push_back(i * 6 + 5);
-		meshData.Indices32.push_back(i * 6 + 4);
-		meshData.Indices32.push_back(i * 6 + 2);
-
-		meshData.Indices32.push_back(i * 6 + 3);
-		meshData.Indices32.push_back(i * 6 + 1);
-		meshData.Indices32.push_back(i * 6 + 4);
+		uint32 v0 = inputIndices[i * 3 + 0];
+		uint32 v1 = inputIndices[i * 3 + 1];
+		uint32 v2 = inputIndices[i * 3 + 2];
+
+		uint32 m0 = midPointIndex(v0, v1);
+		uint32 m1 = midPointIndex(v1, v2);
+		uint32 m2 = midPointIndex(v0, v2);
+
+		meshData.Indices32.push_back(v0);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m2);
+
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(m2);
+
+		meshData.Indices32.push_back(m2);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(v2);
+
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(v1);
+		meshData.Indices32.push_back(m1);
 	}
 }
 
@@ -0,0 +1,115 @@
+#include "GpuProfiler.h"
+#include <algorithm>
+#include <cassert>
+
+GpuProfiler::GpuProfiler(Profiler* profiler, uint32_t frameSlots, uint32_t maxScopesPerQueue)
+	: mProfiler(profiler), mSlotCount(max(frameSlots, 1u)), mMaxScopesPerQueue(max(maxScopesPerQueue, 1u))
+{
+	mScopeStride = mMaxScopesPerQueue * (uint32_t)PassQueue::Count;
+	mScopes.reserve(mScopeStride);
+	mSlotFrames.assign(mSlotCount, NoFrame);
+	mWritten.assign(mSlotCount * mScopeStride, 0);
+
+	for (auto& scope : mTotalScopes)
+	{
+		scope = InvalidScope;
+	}
+}
+
+ProfileTrack GpuProfiler::TrackOf(PassQueue queue)
+{
+	return queue == PassQueue::Compute ? ProfileTrack::GpuCompute : ProfileTrack::GpuGraphics;
+}
+
+uint32_t GpuProfiler::AddScope(const string& name, PassQueue queue)
+{
+	const uint32_t profilerScope = mProfiler->RegisterScope(name, TrackOf(queue));
+
+	for (uint32_t i = 0; i < (uint32_t)mScopes.size(); ++i)
+	{
+		if (mScopes[i].Queue == queue && mScopes[i].ProfilerScope == profilerScope)
+		{
+			return i;
+		}
+	}
+
+	uint32_t& count = mScopeCounts[(int)queue];
+	assert(count < mMaxScopesPerQueue && "Too many GPU scopes on one queue.");
+	if (count == mMaxScopesPerQueue)
+	{
+		return InvalidScope;
+	}
+
+	if (mTotalScopes[(int)queue] == InvalidScope)
+	{
+		mTotalScopes[(int)queue] = mProfiler->RegisterScope("frame", TrackOf(queue));
+	}
+
+	Scope scope;
+	scope.Queue = queue;
+	scope.Index = count++;
+	scope.ProfilerScope = profilerScope;
+	mScopes.push_back(scope);
+	return (uint32_t)mScopes.size() - 1;
+}
+
+void GpuProfiler::SetCalibration(PassQueue queue, uint64_t frequency, uint64_t gpuTimestamp, double cpuMs)
+{
+	Calibration& calibration = mCalibrations[(int)queue];
+	calibration.Frequency = frequency;
+	calibration.GpuTimestamp = gpuTimestamp;
+	calibration.CpuMs = cpuMs;
+}
+
+void GpuProfiler::BeginFrame(uint32_t slot, uint64_t frame)
+{
+	mSlotFrames[slot] = frame;
+	fill_n(mWritten.begin() + slot * mScopeStride, mScopeStride, (uint8_t)0);
+}
+
+void GpuProfiler::Resolve(uint32_t slot, PassQueue queue, const uint64_t* timestamps)
+{
+	const Calibration& calibration = mCalibrations[(int)queue];
+	const uint64_t frame = mSlotFrames[slot];
+
+	if (calibration.Frequency == 0 || frame == NoFrame)
+	{
+		return;
+	}
+
+	const double msPerTick = 1000.0 / (double)calibration.Frequency;
+	auto toCpuMs = [&](uint64_t timestamp)
+	{
+		// Signed: timestamps may be from before the calibration point.
+		return calibration.CpuMs + (double)(int64_t)(timestamp - calibration.GpuTimestamp) * msPerTick;
+	};
+
+	uint64_t first = UINT64_MAX;
+	uint64_t last = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)mScopes.size(); ++i)
+	{
+		const Scope& scope = mScopes[i];
+		if (scope.Queue != queue || !mWritten[slot * mScopeStride + i])
+		{
+			continue;
+		}
+
+		const uint64_t begin = timestamps[scope.Index * 2];
+		const uint64_t end = timestamps[scope.Index * 2 + 1];
+		if (end < begin)
+		{
+			continue;
+		}
+
+		mProfiler->AddSample(scope.ProfilerScope, frame, toCpuMs(begin), (double)(end - begin) * msPerTick);
+
+		first = min(first, begin);
+		last = max(last, end);
+	}
+
+	if (first <= last)
+	{
+		mProfiler->AddSample(mTotalScopes[(int)queue], frame, toCpuMs(first), (double)(last - first) * msPerTick);
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "PassGraph.h"
+#include "Profiler.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Timestamp query layout of GPU scopes and the conversion of resolved timestamps
+// into Profiler samples. Each frame slot owns a fixed range of queries per queue,
+// two per scope, so the range to resolve is known before the frame is recorded.
+// Headless: D3D12GpuProfiler issues and reads back the queries, tests can feed
+// synthetic timestamps to Resolve.
+class GpuProfiler
+{
+public:
+	static constexpr uint32_t InvalidScope = UINT32_MAX;
+
+	GpuProfiler(Profiler* profiler, uint32_t frameSlots, uint32_t maxScopesPerQueue = 64);
+	GpuProfiler(const GpuProfiler& rhs) = delete;
+	GpuProfiler& operator=(const GpuProfiler& rhs) = delete;
+
+	// Add scopes before the first frame. A scope must be written once every frame:
+	// its queries are resolved either way, and one never written reads as garbage.
+	// The same name on the same queue gives the same scope.
+	uint32_t AddScope(const string& name, PassQueue queue);
+
+	PassQueue ScopeQueue(uint32_t scope) const { return mScopes[scope].Queue; }
+
+	// Indices into the queue's query heap.
+	uint32_t BeginQuery(uint32_t slot, uint32_t scope) const { return FirstQuery(slot) + mScopes[scope].Index * 2; }
+	uint32_t EndQuery(uint32_t slot, uint32_t scope) const { return BeginQuery(slot, scope) + 1; }
+	uint32_t FirstQuery(uint32_t slot) const { return slot * QueriesPerSlot(); }
+	uint32_t QueriesPerSlot() const { return mMaxScopesPerQueue * 2; }
+	uint32_t HeapQueryCount() const { return mSlotCount * QueriesPerSlot(); }
+
+	// Queries of a slot in use on queue, starting at FirstQuery.
+	uint32_t QueryCount(PassQueue queue) const { return mScopeCounts[(int)queue] * 2; }
+
+	// Timestamp ticks per second of queue, and a GPU timestamp and Profiler::Now
+	// value taken at the same moment.
+	void SetCalibration(PassQueue queue, uint64_t frequency, uint64_t gpuTimestamp, double cpuMs);
+
+	// Called as End is recorded; safe from several threads for different scopes.
+	void MarkWritten(uint32_t slot, uint32_t scope) { mWritten[slot * mScopeStride + scope] = 1; }
+
+	// Starts recording frame into slot. Resolve the slot's previous frame first.
+	void BeginFrame(uint32_t slot, uint64_t frame);
+
+	// Whether slot holds a finished frame not resolved yet.
+	bool HasResults(uint32_t slot) const { return mSlotFrames[slot] != NoFrame; }
+
+	// timestamps holds QueryCount(queue) values read back from the slot's range on
+	// queue. Adds a sample per written scope and one for the queue's whole frame,
+	// from the first begin to the last end.
+	void Resolve(uint32_t slot, PassQueue queue, const uint64_t* timestamps);
+
+	// Profiler scope of the queue's per-frame total.
+	uint32_t TotalScope(PassQueue queue) const { return mTotalScopes[(int)queue]; }
+
+	Profiler* GetProfiler() const { return mProfiler; }
+
+private:
+	struct Scope
+	{
+		PassQueue Queue = PassQueue::Graphics;
+		// Position among the queue's scopes.
+		uint32_t Index = 0;
+		uint32_t ProfilerScope = 0;
+	};
+
+	struct Calibration
+	{
+		uint64_t Frequency = 0;
+		uint64_t GpuTimestamp = 0;
+		double CpuMs = 0.0;
+	};
+
+	static constexpr uint64_t NoFrame = UINT64_MAX;
+
+	static ProfileTrack TrackOf(PassQueue queue);
+
+private:
+	Profiler* mProfiler = nullptr;
+	uint32_t mSlotCount = 0;
+	uint32_t mMaxScopesPerQueue = 0;
+
+	vector<Scope> mScopes;
+	// Written flags per slot, one per possible scope.
+	uint32_t mScopeStride = 0;
+	uint32_t mScopeCounts[(int)PassQueue::Count] = {};
+	uint32_t mTotalScopes[(int)PassQueue::Count];
+	Calibration mCalibrations[(int)PassQueue::Count];
+
+	vector<uint64_t> mSlotFrames;
+	vector<uint8_t> mWritten;
+};
@@ -0,0 +1,126 @@
+#include "InstanceStorage.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	XMFLOAT4 TranslationOf(const XMFLOAT4X4& world)
+	{
+		return XMFLOAT4(world._41, world._42, world._43, world._44);
+	}
+}
+
+const XMFLOAT4X4& InstanceStorage::Identity()
+{
+	static const XMFLOAT4X4 identity(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+	return identity;
+}
+
+uint32_t InstanceStorage::AddArchetype(uint32_t objectOffset, const XMFLOAT3& boundsCenter, const XMFLOAT3& boundsExtents)
+{
+	InstanceArchetype archetype;
+	archetype.ObjectOffset = objectOffset;
+	archetype.BoundsCenter = boundsCenter;
+	archetype.BoundsExtents = boundsExtents;
+
+	mArchetypes.push_back(move(archetype));
+	return (uint32_t)mArchetypes.size() - 1;
+}
+
+uint32_t InstanceStorage::AddInstance(uint32_t archetype, const XMFLOAT4X4& world, uint32_t materialIndex, uint8_t flags)
+{
+	auto& a = mArchetypes[archetype];
+
+	a.World.push_back(world);
+	a.Position.push_back(TranslationOf(world));
+	if (a.HasTexTransforms())
+	{
+		a.TexTransform.push_back(Identity());
+	}
+	a.InstanceMaterial.push_back(materialIndex);
+	a.Flags.push_back(flags);
+
+	return a.Size() - 1;
+}
+
+void InstanceStorage::RemoveInstance(uint32_t archetype, uint32_t index)
+{
+	auto& a = mArchetypes[archetype];
+	const uint32_t last = a.Size() - 1;
+
+	a.World[index] = a.World[last];
+	a.Position[index] = a.Position[last];
+	if (a.HasTexTransforms())
+	{
+		a.TexTransform[index] = a.TexTransform[last];
+		a.TexTransform.pop_back();
+	}
+	a.InstanceMaterial[index] = a.InstanceMaterial[last];
+	a.Flags[index] = a.Flags[last];
+
+	a.World.pop_back();
+	a.Position.pop_back();
+	a.InstanceMaterial.pop_back();
+	a.Flags.pop_back();
+}
+
+void InstanceStorage::Reserve(uint32_t archetype, uint32_t count)
+{
+	auto& a = mArchetypes[archetype];
+	a.World.reserve(count);
+	a.Position.reserve(count);
+	a.InstanceMaterial.reserve(count);
+	a.Flags.reserve(count);
+}
+
+void InstanceStorage::SetWorld(uint32_t archetype, uint32_t index, const XMFLOAT4X4& world)
+{
+	auto& a = mArchetypes[archetype];
+	a.World[index] = world;
+	a.Position[index] = TranslationOf(world);
+}
+
+void InstanceStorage::SetTexTransform(uint32_t archetype, uint32_t index, const XMFLOAT4X4& texTransform)
+{
+	auto& a = mArchetypes[archetype];
+	if (!a.HasTexTransforms())
+	{
+		if (memcmp(&texTransform, &Identity(), sizeof(XMFLOAT4X4)) == 0)
+		{
+			return;
+		}
+		a.TexTransform.assign(a.Size(), Identity());
+	}
+	a.TexTransform[index] = texTransform;
+}
+
+const XMFLOAT4X4& InstanceStorage::TexTransform(uint32_t archetype, uint32_t index) const
+{
+	const auto& a = mArchetypes[archetype];
+	return a.HasTexTransforms() ? a.TexTransform[index] : Identity();
+}
+
+uint32_t InstanceStorage::InstanceCount() const
+{
+	uint32_t count = 0;
+	for (auto& a : mArchetypes)
+	{
+		count += a.Size();
+	}
+	return count;
+}
+
+uint32_t InstanceStorage::ObjectSlotCount() const
+{
+	uint32_t count = 0;
+	for (auto& a : mArchetypes)
+	{
+		count = max(count, a.ObjectOffset + a.Size());
+	}
+	return count;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace std;
+using namespace DirectX;
+
+enum InstanceFlags : uint8_t
+{
+	InstanceVisible = 1 << 0,
+};
+
+// The instances of one render item, one contiguous array per component, so a pass
+// only loads what it reads: culling walks Position, not the 64 byte matrices.
+struct InstanceArchetype
+{
+	// ObjectData slot of the first instance; the rest follow it.
+	uint32_t ObjectOffset = 0;
+
+	// Of the item's mesh, in its local space.
+	XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f };
+
+	vector<XMFLOAT4X4> World;
+	// World's translation row, kept in step by InstanceStorage::SetWorld.
+	vector<XMFLOAT4> Position;
+	// Empty while every instance uses the identity.
+	vector<XMFLOAT4X4> TexTransform;
+	// Written to each instance's ObjectData.
+	vector<uint32_t> InstanceMaterial;
+	vector<uint8_t> Flags;
+
+	uint32_t Size() const { return (uint32_t)World.size(); }
+	bool HasTexTransforms() const { return !TexTransform.empty(); }
+};
+
+// Per-instance data of every render item, grouped into one archetype per item.
+// Instances are addressed by archetype and index; indices stay put while no
+// instance of the archetype is removed.
+class InstanceStorage
+{
+public:
+	uint32_t AddArchetype(uint32_t objectOffset, const XMFLOAT3& boundsCenter, const XMFLOAT3& boundsExtents);
+
+	uint32_t AddInstance(uint32_t archetype, const XMFLOAT4X4& world, uint32_t materialIndex, uint8_t flags = InstanceVisible);
+
+	// Moves the archetype's last instance into index, like a swap with the back.
+	void RemoveInstance(uint32_t archetype, uint32_t index);
+
+	void Reserve(uint32_t archetype, uint32_t count);
+
+	void SetWorld(uint32_t archetype, uint32_t index, const XMFLOAT4X4& world);
+	// The first non-identity transform gives the archetype its TexTransform array.
+	void SetTexTransform(uint32_t archetype, uint32_t index, const XMFLOAT4X4& texTransform);
+	void SetFlags(uint32_t archetype, uint32_t index, uint8_t flags) { mArchetypes[archetype].Flags[index] = flags; }
+
+	const XMFLOAT4X4& TexTransform(uint32_t archetype, uint32_t index) const;
+
+	uint32_t ArchetypeCount() const { return (uint32_t)mArchetypes.size(); }
+	const InstanceArchetype& Archetype(uint32_t archetype) const { return mArchetypes[archetype]; }
+
+	uint32_t InstanceCount() const;
+	// One past the last ObjectData slot in use.
+	uint32_t ObjectSlotCount() const;
+
+	static const XMFLOAT4X4& Identity();
+
+private:
+	vector<InstanceArchetype> mArchetypes;
+};
@@ -0,0 +1,240 @@
+#include "LandTessellation.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+	float Saturate(float v)
+	{
+		return min(max(v, 0.0f), 1.0f);
+	}
+
+	// Integer partitioning: factors are clamped to [1, 64] and rounded up.
+	uint32_t IntegerFactor(float factor)
+	{
+		return (uint32_t)ceilf(min(max(factor, 1.0f), 64.0f));
+	}
+}
+
+QuadPatchTess ComputeLandPatchTess(
+	const LandPatch& patch,
+	const XMFLOAT4X4& world,
+	const XMFLOAT3& eyePosW,
+	const LandTessellationParams& params)
+{
+	XMFLOAT3 centerL(
+		0.25f * (patch[0].x + patch[1].x + patch[2].x + patch[3].x),
+		0.25f * (patch[0].y + patch[1].y + patch[2].y + patch[3].y),
+		0.25f * (patch[0].z + patch[1].z + patch[2].z + patch[3].z));
+
+	// mul(float4(centerL, 1.0f), gWorld)
+	float cx = centerL.x * world._11 + centerL.y * world._21 + centerL.z * world._31 + world._41;
+	float cy = centerL.x * world._12 + centerL.y * world._22 + centerL.z * world._32 + world._42;
+	float cz = centerL.x * world._13 + centerL.y * world._23 + centerL.z * world._33 + world._43;
+
+	float dx = cx - eyePosW.x;
+	float dy = cy - eyePosW.y;
+	float dz = cz - eyePosW.z;
+	float d = sqrtf(dx * dx + dy * dy + dz * dz);
+
+	const float d0 = params.MinDistance;
+	const float d1 = params.MaxDistance;
+	float tess = min(64.0f * Saturate((d1 - d) / (d1 - d0)), params.MaxTessFactor);
+
+	QuadPatchTess pt;
+	for (auto& edge : pt.EdgeTess)
+	{
+		edge = tess;
+	}
+	pt.InsideTess[0] = tess;
+	pt.InsideTess[1] = tess;
+	return pt;
+}
+
+uint32_t CountQuadDomainTriangles(const QuadPatchTess& tess)
+{
+	for (float edge : tess.EdgeTess)
+	{
+		if (!(edge > 0.0f))
+		{
+			return 0;
+		}
+	}
+
+	uint32_t edges[4];
+	uint32_t maxEdge = 1;
+	for (int i = 0; i < 4; ++i)
+	{
+		edges[i] = IntegerFactor(tess.EdgeTess[i]);
+		maxEdge = max(maxEdge, edges[i]);
+	}
+
+	uint32_t insideU = IntegerFactor(tess.InsideTess[0]);
+	uint32_t insideV = IntegerFactor(tess.InsideTess[1]);
+
+	if (maxEdge == 1 && insideU == 1 && insideV == 1)
+	{
+		return 2;
+	}
+
+	// With a real interior, an inside factor of 1 still needs one ring.
+	insideU = max(insideU, 2u);
+	insideV = max(insideV, 2u);
+
+	// Interior grid plus a transition strip from each outer edge to the interior
+	// edge facing it. Edges 0 and 2 (u == 0, u == 1) face the v direction.
+	uint32_t triangles = 2 * (insideU - 2) * (insideV - 2);
+	triangles += edges[0] + insideV - 2;
+	triangles += edges[2] + insideV - 2;
+	triangles += edges[1] + insideU - 2;
+	triangles += edges[3] + insideU - 2;
+	return triangles;
+}
+
+LandTessellationAnalyzer::LandTessellationAnalyzer(vector<LandPatch> patches, const XMFLOAT4X4& world)
+	: mPatches(move(patches)), mWorld(world)
+{
+}
+
+vector<LandPatch> LandTessellationAnalyzer::MakeGridPatches(float width, float depth, uint32_t m, uint32_t n)
+{
+	vector<LandPatch> patches;
+	if (m < 2 || n < 2)
+	{
+		return patches;
+	}
+	patches.reserve((size_t)(m - 1) * (n - 1));
+
+	const float halfWidth = 0.5f * width;
+	const float halfDepth = 0.5f * depth;
+	const float dx = width / (n - 1);
+	const float dz = depth / (m - 1);
+
+	for (uint32_t i = 0; i < m - 1; ++i)
+	{
+		for (uint32_t j = 0; j < n - 1; ++j)
+		{
+			float x0 = -halfWidth + j * dx;
+			float z0 = halfDepth - i * dz;
+
+			LandPatch patch;
+			patch[0] = XMFLOAT3(x0, 0.0f, z0);
+			patch[1] = XMFLOAT3(x0 + dx, 0.0f, z0);
+			patch[2] = XMFLOAT3(x0, 0.0f, z0 - dz);
+			patch[3] = XMFLOAT3(x0 + dx, 0.0f, z0 - dz);
+			patches.push_back(patch);
+		}
+	}
+
+	return patches;
+}
+
+LandTessellationFrame LandTessellationAnalyzer::AnalyzeFrame(const XMFLOAT3& eyePosW, const LandTessellationParams& params) const
+{
+	LandTessellationFrame frame;
+
+	for (auto& patch : mPatches)
+	{
+		QuadPatchTess tess = ComputeLandPatchTess(patch, mWorld, eyePosW, params);
+
+		uint32_t triangles = CountQuadDomainTriangles(tess);
+		if (triangles == 0)
+		{
+			++frame.CulledPatches;
+		}
+
+		frame.Triangles += triangles;
+		frame.MaxTessFactor = max(frame.MaxTessFactor, tess.EdgeTess[0]);
+	}
+
+	return frame;
+}
+
+LandTessellationReport LandTessellationAnalyzer::AnalyzePath(const vector<XMFLOAT3>& eyePath, const LandTessellationParams& params) const
+{
+	LandTessellationReport report;
+	report.Frames.reserve(eyePath.size());
+
+	uint64_t total = 0;
+	for (auto& eye : eyePath)
+	{
+		report.Frames.push_back(AnalyzeFrame(eye, params));
+		total += report.Frames.back().Triangles;
+	}
+
+	if (!report.Frames.empty())
+	{
+		auto range = minmax_element(report.Frames.begin(), report.Frames.end(),
+			[](const LandTessellationFrame& a, const LandTessellationFrame& b)
+			{
+				return a.Triangles < b.Triangles;
+			});
+
+		report.MinTriangles = range.first->Triangles;
+		report.MaxTriangles = range.second->Triangles;
+		report.AverageTriangles = (double)total / report.Frames.size();
+	}
+
+	return report;
+}
+
+float LandTessellationAnalyzer::FindMaxTessFactor(const vector<XMFLOAT3>& eyePath, uint64_t triangleBudget, const LandTessellationParams& params) const
+{
+	auto fits = [&](float cap)
+		{
+			LandTessellationParams capped = params;
+			capped.MaxTessFactor = cap;
+			return AnalyzePath(eyePath, capped).MaxTriangles <= triangleBudget;
+		};
+
+	// Triangle counts only grow with the cap, so bisect over whole factors.
+	int lo = 0;
+	int hi = (int)min(64.0f, floorf(params.MaxTessFactor));
+
+	if (hi >= 1 && fits((float)hi))
+	{
+		return (float)hi;
+	}
+
+	while (hi - lo > 1)
+	{
+		int mid = (lo + hi) / 2;
+		if (fits((float)mid))
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return (float)lo;
+}
+
+string LandTessellationAnalyzer::FormatReport(const LandTessellationReport& report)
+{
+	ostringstream oss;
+	oss << "frames " << report.Frames.size()
+		<< " triangles min " << report.MinTriangles
+		<< " avg " << (uint64_t)report.AverageTriangles
+		<< " max " << report.MaxTriangles << "\n";
+
+	for (size_t i = 0; i < report.Frames.size(); ++i)
+	{
+		auto& frame = report.Frames[i];
+		oss << i << "\t" << frame.Triangles << "\t" << frame.CulledPatches << "\t" << frame.MaxTessFactor << "\n";
+	}
+
+	return oss.str();
+}
+
+string LandTessellationAnalyzer::MaxTessFactorDefine(float maxTessFactor)
+{
+	ostringstream oss;
+	oss.setf(ios::fixed);
+	oss.precision(1);
+	oss << maxTessFactor << "f";
+	return oss.str();
+}
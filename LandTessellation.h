@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace std;
+using namespace DirectX;
+
+// CPU copy of ConstantHS in Shaders/LandTessellation.hlsl plus triangle counting
+// for the quad domain with integer partitioning, so tessellation cost can be
+// measured along a camera path without a device.
+
+struct LandTessellationParams
+{
+	float MinDistance = 20.0f;
+	float MaxDistance = 200.0f;
+	// LAND_MAX_TESS_FACTOR; the shader default is the hardware limit.
+	float MaxTessFactor = 64.0f;
+};
+
+struct QuadPatchTess
+{
+	float EdgeTess[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float InsideTess[2] = { 0.0f, 0.0f };
+};
+
+// Four control points in local space; world uses the shader's row vector convention.
+typedef array<XMFLOAT3, 4> LandPatch;
+
+QuadPatchTess ComputeLandPatchTess(
+	const LandPatch& patch,
+	const XMFLOAT4X4& world,
+	const XMFLOAT3& eyePosW,
+	const LandTessellationParams& params);
+
+// Triangles the tessellator emits for one quad patch. A patch with any edge
+// factor <= 0 is culled and emits none.
+uint32_t CountQuadDomainTriangles(const QuadPatchTess& tess);
+
+struct LandTessellationFrame
+{
+	uint64_t Triangles = 0;
+	uint32_t CulledPatches = 0;
+	float MaxTessFactor = 0.0f;
+};
+
+struct LandTessellationReport
+{
+	vector<LandTessellationFrame> Frames;
+	uint64_t MinTriangles = 0;
+	uint64_t MaxTriangles = 0;
+	double AverageTriangles = 0.0;
+};
+
+class LandTessellationAnalyzer
+{
+public:
+	LandTessellationAnalyzer(vector<LandPatch> patches, const XMFLOAT4X4& world);
+
+	// Grid of quads like the one LandTessellation draws: m x n vertices over
+	// width x depth, one patch per cell. Empty when m or n is less than 2.
+	static vector<LandPatch> MakeGridPatches(float width, float depth, uint32_t m, uint32_t n);
+
+	LandTessellationFrame AnalyzeFrame(const XMFLOAT3& eyePosW, const LandTessellationParams& params) const;
+	LandTessellationReport AnalyzePath(const vector<XMFLOAT3>& eyePath, const LandTessellationParams& params) const;
+
+	// Largest whole LAND_MAX_TESS_FACTOR, at most params.MaxTessFactor, that keeps
+	// every frame of eyePath within triangleBudget. Returns 0 when even a cap of 1
+	// does not fit.
+	float FindMaxTessFactor(const vector<XMFLOAT3>& eyePath, uint64_t triangleBudget, const LandTessellationParams& params) const;
+
+	static string FormatReport(const LandTessellationReport& report);
+
+	// Value for the LAND_MAX_TESS_FACTOR shader define, e.g. "13.0f".
+	static string MaxTessFactorDefine(float maxTessFactor);
+
+private:
+	vector<LandPatch> mPatches;
+	XMFLOAT4X4 mWorld;
+};
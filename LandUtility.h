@@ -1,5 +1,8 @@
 #pragma once
 #include "D3DUtil.h"
+#include "GeometryGenerator.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
 
 using namespace DirectX;
 
@@ -22,4 +25,142 @@ public:
 		XMStoreFloat3(&n, unitNormal);
 		return n;
 	}
+
+	// Batch version of GetHillsHeight/GetHillsNormal for count points of one grid
+	// row: x = x0 + j * dx at a fixed z. The z terms are evaluated once per row and
+	// the x terms four at a time with SimdMath::SinCos; the last partial group goes
+	// through the same path so a point gets the same result wherever it sits in a
+	// row. Either output may be null.
+	static void GetHillsRow(float x0, float dx, float z, uint32_t count, float* heights, XMFLOAT3* normals)
+	{
+		const float sinZ = sinf(0.1f * z);
+		const float cosZ = cosf(0.1f * z);
+
+		const __m128 vz = _mm_set1_ps(z);
+		const __m128 vx0 = _mm_set1_ps(x0);
+		const __m128 vdx = _mm_set1_ps(dx);
+		const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		const __m128 tenth = _mm_set1_ps(0.1f);
+		const __m128 cosZ3 = _mm_set1_ps(0.3f * cosZ);
+		const __m128 sinZ3 = _mm_set1_ps(0.03f * sinZ);
+
+		for (uint32_t j = 0; j < count; j += 4)
+		{
+			const uint32_t lanes = min(4u, count - j);
+
+			__m128 x = _mm_add_ps(vx0, _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)j), lane), vdx));
+
+			__m128 s, c;
+			SimdMath::SinCos(_mm_mul_ps(tenth, x), &s, &c);
+
+			if (heights)
+			{
+				// 0.3 * (z * sin(0.1x) + x * cos(0.1z))
+				__m128 h = _mm_add_ps(_mm_mul_ps(vz, s), _mm_mul_ps(x, _mm_set1_ps(cosZ)));
+				h = _mm_mul_ps(_mm_set1_ps(0.3f), h);
+
+				if (lanes == 4)
+				{
+					_mm_storeu_ps(heights + j, h);
+				}
+				else
+				{
+					float outH[4];
+					_mm_storeu_ps(outH, h);
+					copy(outH, outH + lanes, heights + j);
+				}
+			}
+
+			if (normals)
+			{
+				__m128 nx = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(-0.03f), _mm_mul_ps(vz, c)), cosZ3);
+				__m128 nz = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.3f), s), _mm_mul_ps(sinZ3, x));
+
+				__m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_set1_ps(1.0f)), _mm_mul_ps(nz, nz));
+				__m128 invLen = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lenSq));
+
+				float outX[4], outY[4], outZ[4];
+				_mm_storeu_ps(outX, _mm_mul_ps(nx, invLen));
+				_mm_storeu_ps(outY, invLen);
+				_mm_storeu_ps(outZ, _mm_mul_ps(nz, invLen));
+
+				for (uint32_t k = 0; k < lanes; ++k)
+				{
+					normals[j + k] = XMFLOAT3(outX[k], outY[k], outZ[k]);
+				}
+			}
+		}
+	}
+
+	// Displaces a grid from GeometryGenerator::CreateGrid(width, depth, m, n) into
+	// hills, row by row on the default thread pool.
+	static void ApplyHills(GeometryGenerator::MeshData& grid, float width, float depth, uint32_t m, uint32_t n)
+	{
+		const float halfWidth = 0.5f * width;
+		const float halfDepth = 0.5f * depth;
+		const float dx = width / (n - 1);
+		const float dz = depth / (m - 1);
+
+		ThreadPool::Default().ParallelFor(0, (int)m, 16, [&](int rowBegin, int rowEnd)
+			{
+				vector<float> heights(n);
+				vector<XMFLOAT3> normals(n);
+
+				for (int i = rowBegin; i < rowEnd; ++i)
+				{
+					GetHillsRow(-halfWidth, dx, halfDepth - i * dz, n, heights.data(), normals.data());
+
+					auto row = grid.Vertices.begin() + (size_t)i * n;
+					for (uint32_t j = 0; j < n; ++j)
+					{
+						row[j].Position.y = heights[j];
+						row[j].Normal = normals[j];
+					}
+				}
+			});
+	}
+
+	static GeometryGenerator::MeshData CreateHillsGrid(float width, float depth, uint32_t m, uint32_t n)
+	{
+		GeometryGenerator geoGen;
+		GeometryGenerator::MeshData grid = geoGen.CreateGrid(width, depth, m, n);
+		ApplyHills(grid, width, depth, m, n);
+		return grid;
+	}
+
+	// Bound on GetHillsRowError for worlds up to 8192 across, see SimdMath::SinCos.
+	static constexpr float HillsRowMaxError = 2e-7f;
+
+	// Largest absolute difference between GetHillsRow and the scalar functions over
+	// a width x depth grid, for checking the approximation.
+	static float GetHillsRowError(float width, float depth, uint32_t m, uint32_t n)
+	{
+		const float dx = width / (n - 1);
+		const float dz = depth / (m - 1);
+
+		vector<float> heights(n);
+		vector<XMFLOAT3> normals(n);
+
+		float error = 0.0f;
+		for (uint32_t i = 0; i < m; ++i)
+		{
+			float z = 0.5f * depth - i * dz;
+			GetHillsRow(-0.5f * width, dx, z, n, heights.data(), normals.data());
+
+			for (uint32_t j = 0; j < n; ++j)
+			{
+				float x = -0.5f * width + j * dx;
+				XMFLOAT3 normal = GetHillsNormal(x, z);
+
+				// Heights scale with |x| + |z|, so compare them relative to that.
+				float scale = max(1.0f, fabsf(x) + fabsf(z));
+				error = max(error, fabsf(heights[j] - GetHillsHeight(x, z)) / scale);
+				error = max(error, fabsf(normals[j].x - normal.x));
+				error = max(error, fabsf(normals[j].y - normal.y));
+				error = max(error, fabsf(normals[j].z - normal.z));
+			}
+		}
+
+		return error;
+	}
 };
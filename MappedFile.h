@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Read-only view of a whole file. Pages are only faulted in when touched, so
+// parsing a header does not pull the rest of the file off disk.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	~MappedFile();
+
+	HRESULT Open(const wstring& filename);
+	void Close();
+
+	const uint8_t* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+
+private:
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -0,0 +1,101 @@
+#include "MeshBuilder.h"
+#include <algorithm>
+#include <cfloat>
+
+MeshBuildLayout MeshBuilder::ComputeLayout(const MeshList& meshes)
+{
+	MeshBuildLayout layout;
+	layout.Submeshes.reserve(meshes.size());
+
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+
+	for (auto& mesh : meshes)
+	{
+		MeshBuildSubmesh submesh;
+		submesh.Name = mesh.first;
+		submesh.IndexCount = (uint32_t)mesh.second->Indices32.size();
+		submesh.StartIndexLocation = indexCount;
+		submesh.BaseVertexLocation = (int32_t)vertexCount;
+		layout.Submeshes.push_back(submesh);
+
+		if (mesh.second->Vertices.size() > 0x10000)
+		{
+			layout.Indices32 = true;
+		}
+
+		vertexCount += (uint32_t)mesh.second->Vertices.size();
+		indexCount += submesh.IndexCount;
+	}
+
+	const uint32_t indexSize = layout.Indices32 ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	layout.VertexBufferByteSize = vertexCount * layout.VertexByteStride;
+	layout.IndexBufferOffset = (layout.VertexBufferByteSize + 15) & ~15u;
+	layout.IndexBufferByteSize = indexCount * indexSize;
+	return layout;
+}
+
+MeshBuildLayout MeshBuilder::Build(const MeshList& meshes, MeshStagingBuffer& staging)
+{
+	MeshBuildLayout layout = ComputeLayout(meshes);
+
+	uint8_t* data = staging.Map((uint64_t)layout.IndexBufferOffset + layout.IndexBufferByteSize);
+	PackedMeshVertex* vertices = reinterpret_cast<PackedMeshVertex*>(data);
+	uint8_t* indices = data + layout.IndexBufferOffset;
+
+	for (size_t m = 0; m < meshes.size(); ++m)
+	{
+		const GeometryGenerator::MeshData& mesh = *meshes[m].second;
+		MeshBuildSubmesh& submesh = layout.Submeshes[m];
+
+		XMFLOAT3 vMin(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+		XMFLOAT3 vMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		PackedMeshVertex* dst = vertices + submesh.BaseVertexLocation;
+		for (auto& v : mesh.Vertices)
+		{
+			dst->Pos = v.Position;
+			dst->Normal = v.Normal;
+			dst->TexC = v.TexC;
+			++dst;
+
+			vMin = XMFLOAT3(min(vMin.x, v.Position.x), min(vMin.y, v.Position.y), min(vMin.z, v.Position.z));
+			vMax = XMFLOAT3(max(vMax.x, v.Position.x), max(vMax.y, v.Position.y), max(vMax.z, v.Position.z));
+		}
+
+		if (!mesh.Vertices.empty())
+		{
+			submesh.BoundsMin = vMin;
+			submesh.BoundsMax = vMax;
+		}
+
+		if (layout.Indices32)
+		{
+			copy(mesh.Indices32.begin(), mesh.Indices32.end(),
+				reinterpret_cast<uint32_t*>(indices) + submesh.StartIndexLocation);
+		}
+		else
+		{
+			uint16_t* dstIndex = reinterpret_cast<uint16_t*>(indices) + submesh.StartIndexLocation;
+			for (uint32_t index : mesh.Indices32)
+			{
+				*dstIndex++ = static_cast<uint16_t>(index);
+			}
+		}
+	}
+
+	return layout;
+}
+
+MeshBuildLayout MeshBuilder::Build(const map<string, GeometryGenerator::MeshData>& meshes, MeshStagingBuffer& staging)
+{
+	MeshList list;
+	list.reserve(meshes.size());
+	for (auto& mesh : meshes)
+	{
+		list.emplace_back(mesh.first, &mesh.second);
+	}
+
+	return Build(list, staging);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <map>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace DirectX;
+
+// Vertex as laid out in the GPU vertex buffer; matches Vertex in FrameResource.h.
+struct PackedMeshVertex
+{
+	XMFLOAT3 Pos;
+	XMFLOAT3 Normal;
+	XMFLOAT2 TexC;
+};
+
+struct MeshBuildSubmesh
+{
+	string Name;
+	uint32_t IndexCount = 0;
+	uint32_t StartIndexLocation = 0;
+	int32_t BaseVertexLocation = 0;
+
+	XMFLOAT3 BoundsMin = { 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 BoundsMax = { 0.0f, 0.0f, 0.0f };
+};
+
+// Where the vertex and index data sit in the staging memory.
+struct MeshBuildLayout
+{
+	uint32_t VertexByteStride = sizeof(PackedMeshVertex);
+	uint32_t VertexBufferByteSize = 0;
+	uint32_t IndexBufferOffset = 0;
+	uint32_t IndexBufferByteSize = 0;
+	bool Indices32 = false;
+
+	vector<MeshBuildSubmesh> Submeshes;
+};
+
+// Write-only memory the builder fills, e.g. a mapped upload heap. The mock keeps
+// it in a vector so the bytes can be checked without a device.
+class MeshStagingBuffer
+{
+public:
+	virtual ~MeshStagingBuffer() = default;
+
+	// Called once per build; the memory stays valid until the buffer is destroyed.
+	virtual uint8_t* Map(uint64_t byteSize) = 0;
+};
+
+class MockMeshStagingBuffer : public MeshStagingBuffer
+{
+public:
+	virtual uint8_t* Map(uint64_t byteSize) override
+	{
+		Bytes.assign((size_t)byteSize, 0);
+		++MapCount;
+		return Bytes.data();
+	}
+
+	vector<uint8_t> Bytes;
+	uint32_t MapCount = 0;
+};
+
+// Packs several MeshData into one vertex and one index buffer, writing each vertex
+// and index exactly once, straight into the staging memory. Indices stay local to
+// their submesh (BaseVertexLocation) and are 16 bit unless a submesh has more than
+// 65536 vertices.
+class MeshBuilder
+{
+public:
+	using MeshList = vector<pair<string, const GeometryGenerator::MeshData*>>;
+
+	static MeshBuildLayout Build(const MeshList& meshes, MeshStagingBuffer& staging);
+	static MeshBuildLayout Build(const map<string, GeometryGenerator::MeshData>& meshes, MeshStagingBuffer& staging);
+
+	// Sizes only, without writing anything.
+	static MeshBuildLayout ComputeLayout(const MeshList& meshes);
+};
@@ -2,90 +2,36 @@
 
 #include "D3DUtil.h"
 #include "GeometryGenerator.h"
+#include "D3D12MeshStaging.h"
 #include "FrameResource.h"
+#include "MeshBuilder.h"
 #include <map>
 
 class MeshUtil
 {
 public:
+	// Vertices and indices are written once, into the upload buffer; CPU copies are
+	// only made with keepCpuCopy. With a batcher the copies are recorded by its
+	// Flush instead of on cmdList.
 	static unique_ptr<MeshGeometry> CreateMesh(
 		string name,
-		map<string, GeometryGenerator::MeshData> meshs,
+		const map<string, GeometryGenerator::MeshData>& meshs,
 		ID3D12Device* d3dDevice,
-		ID3D12GraphicsCommandList* cmdList)
+		ID3D12GraphicsCommandList* cmdList,
+		bool keepCpuCopy = false,
+		UploadBatcher* batcher = nullptr)
 	{
-		UINT vertexOffset = 0;
-		UINT indexOffset = 0;
-		UINT totalVertexCount = 0;
-
-		map<string, SubmeshGeometry> submeshs;
-
-		for (auto& meshPair : meshs)
-		{
-			auto& mesh = meshPair.second;
-			SubmeshGeometry submesh;
-			submesh.IndexCount = (UINT)mesh.Indices32.size();
-			submesh.StartIndexLocation = indexOffset;
-			submesh.BaseVertexLocation = vertexOffset;
-
-			submeshs[meshPair.first] = submesh;
-
-			indexOffset += (UINT)mesh.Indices32.size();
-			vertexOffset += (UINT)mesh.Vertices.size();
-		}
-
-		vector<Vertex> vertices(vertexOffset);
-		vector<uint16_t> indices;
-		UINT index = 0;
-
-		for (auto& meshPair : meshs)
-		{
-			auto& mesh = meshPair.second;
-			for (size_t i = 0; i < mesh.Vertices.size(); ++i, ++index)
-			{
-				vertices[index].Pos = mesh.Vertices[i].Position;
-				vertices[index].Normal = mesh.Vertices[i].Normal;
-				vertices[index].TexC = mesh.Vertices[i].TexC;
-			}
-			indices.insert(indices.end(), begin(mesh.GetIndices16()), end(mesh.GetIndices16()));
-		}
-
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
-
-		auto geo = make_unique<MeshGeometry>();
-		geo->Name = name;
-
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		geo->VertexBufferGPU = D3DUtil::CreateDefaultBuffer(d3dDevice,
-			cmdList, vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-		geo->IndexBufferGPU = D3DUtil::CreateDefaultBuffer(d3dDevice,
-			cmdList, indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-		geo->VertexByteStride = sizeof(Vertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
-
-		for (auto& submesh : submeshs)
-		{
-			geo->DrawArgs[submesh.first] = submesh.second;
-		}
-
-		return geo;
+		D3D12MeshStaging staging(d3dDevice, batcher);
+		MeshBuildLayout layout = MeshBuilder::Build(meshs, staging);
+		return staging.CreateGeometry(name, layout, cmdList, keepCpuCopy);
 	}
 
 	static unique_ptr<MeshGeometry> LoadMesh(
 		ID3D12Device* d3dDevice,
 		ID3D12GraphicsCommandList* cmdList,
 		string name,
-		wstring path)
+		wstring path,
+		UploadBatcher* batcher = nullptr)
 	{
 		ifstream fin(path);
 
@@ -104,20 +50,31 @@ public:
 		fin >> ignore >> tcount;
 		fin >> ignore >> ignore >> ignore >> ignore;
 
+		// Parse straight into the upload buffer.
+		MeshBuildLayout layout;
+		layout.Indices32 = true;
+		layout.VertexBufferByteSize = vcount * layout.VertexByteStride;
+		layout.IndexBufferOffset = layout.VertexBufferByteSize;
+		layout.IndexBufferByteSize = 3 * tcount * sizeof(uint32_t);
+
+		D3D12MeshStaging staging(d3dDevice, batcher);
+		uint8_t* data = staging.Map((uint64_t)layout.IndexBufferOffset + layout.IndexBufferByteSize);
+		PackedMeshVertex* vertices = reinterpret_cast<PackedMeshVertex*>(data);
+		uint32_t* indices = reinterpret_cast<uint32_t*>(data + layout.IndexBufferOffset);
+
 		XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
 		XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
 
 		XMVECTOR vMin = XMLoadFloat3(&vMinf3);
 		XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
 
-		vector<Vertex> vertices(vcount);
-
 		for (UINT i = 0; i < vcount; ++i)
 		{
-			fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-			fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+			PackedMeshVertex v;
+			fin >> v.Pos.x >> v.Pos.y >> v.Pos.z;
+			fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
 
-			XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
+			XMVECTOR P = XMLoadFloat3(&v.Pos);
 
 			XMFLOAT3 spherePos;
 			XMStoreFloat3(&spherePos, XMVector3Normalize(P));
@@ -130,59 +87,31 @@ public:
 			float phi = acosf(spherePos.y);
 
 			float u = theta / (2.0f * XM_PI);
-			float v = phi / XM_PI;
+			float tv = phi / XM_PI;
 
-			vertices[i].TexC = { u, v };
+			v.TexC = { u, tv };
+			vertices[i] = v;
 
 			vMin = XMVectorMin(vMin, P);
 			vMax = XMVectorMax(vMax, P);
 		}
 
-		BoundingBox bounds;
-		XMStoreFloat3(&bounds.Center, 0.5f * (vMin + vMax));
-		XMStoreFloat3(&bounds.Extents, 0.5f * (vMax - vMin));
-
 		fin >> ignore >> ignore >> ignore;
 
-		vector<int32_t> indices(3 * tcount);
-		for (UINT i = 0; i < tcount; ++i)
+		for (UINT i = 0; i < 3 * tcount; ++i)
 		{
-			fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
+			fin >> indices[i];
 		}
 
 		fin.close();
 
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(int32_t);
-
-		auto geo = make_unique<MeshGeometry>();
-		geo->Name = name;
-
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		geo->VertexBufferGPU = D3DUtil::CreateDefaultBuffer(d3dDevice,
-			cmdList, vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-		geo->IndexBufferGPU = D3DUtil::CreateDefaultBuffer(d3dDevice,
-			cmdList, indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-		geo->VertexByteStride = sizeof(Vertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R32_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
-
-		SubmeshGeometry submesh;
-		submesh.IndexCount = (UINT)indices.size();
-		submesh.StartIndexLocation = 0;
-		submesh.BaseVertexLocation = 0;
-		submesh.Bounds = bounds;
-
-		geo->DrawArgs[name] = submesh;
+		MeshBuildSubmesh submesh;
+		submesh.Name = name;
+		submesh.IndexCount = 3 * tcount;
+		XMStoreFloat3(&submesh.BoundsMin, vMin);
+		XMStoreFloat3(&submesh.BoundsMax, vMax);
+		layout.Submeshes.push_back(submesh);
 
-		return geo;
+		return staging.CreateGeometry(name, layout, cmdList);
 	}
 };
@@ -0,0 +1,95 @@
+#include "PassGraph.h"
+#include <cassert>
+
+uint32_t PassGraph::AddPass(const string& name, PassQueue queue, const vector<uint32_t>& dependencies)
+{
+	const uint32_t index = (uint32_t)mPasses.size();
+
+	for (uint32_t dependency : dependencies)
+	{
+		assert(dependency < index && "Passes can only depend on earlier passes.");
+	}
+
+	mPasses.push_back({ name, queue, dependencies });
+	mSubmissionsDirty = true;
+	return index;
+}
+
+void PassGraph::Clear()
+{
+	mPasses.clear();
+	mSubmissions.clear();
+	mSubmissionsDirty = true;
+}
+
+const vector<PassSubmission>& PassGraph::Submissions()
+{
+	if (mSubmissionsDirty)
+	{
+		BuildSubmissions();
+		mSubmissionsDirty = false;
+	}
+	return mSubmissions;
+}
+
+void PassGraph::BuildSubmissions()
+{
+	mSubmissions.clear();
+
+	vector<int> submissionOfPass(mPasses.size(), -1);
+
+	for (uint32_t pass = 0; pass < (uint32_t)mPasses.size(); ++pass)
+	{
+		const Pass& p = mPasses[pass];
+
+		if (mSubmissions.empty() || mSubmissions.back().Queue != p.Queue)
+		{
+			PassSubmission submission;
+			submission.Queue = p.Queue;
+			mSubmissions.push_back(submission);
+		}
+
+		const int current = (int)mSubmissions.size() - 1;
+		PassSubmission& submission = mSubmissions.back();
+
+		// Work on the same queue is already ordered. Across queues only the latest
+		// submission matters, since it was itself ordered after the ones before it.
+		for (uint32_t dependency : p.Dependencies)
+		{
+			const int other = submissionOfPass[dependency];
+			if (other != current && mSubmissions[other].Queue != p.Queue && other > submission.WaitFor)
+			{
+				submission.WaitFor = other;
+			}
+		}
+
+		submission.Passes.push_back(pass);
+		submissionOfPass[pass] = current;
+	}
+
+	for (auto& submission : mSubmissions)
+	{
+		if (submission.WaitFor >= 0)
+		{
+			mSubmissions[submission.WaitFor].Signal = true;
+		}
+	}
+}
+
+void PassGraph::Execute(ThreadPool& pool, const function<void(uint32_t)>& record, const function<void(uint32_t)>& submit)
+{
+	const auto& submissions = Submissions();
+
+	pool.ParallelFor(0, (int)mPasses.size(), 1, [&](int begin, int end)
+		{
+			for (int pass = begin; pass < end; ++pass)
+			{
+				record((uint32_t)pass);
+			}
+		});
+
+	for (uint32_t i = 0; i < (uint32_t)submissions.size(); ++i)
+	{
+		submit(i);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum class PassQueue : uint32_t
+{
+	Graphics = 0,
+	Compute,
+	Count
+};
+
+// A run of consecutive passes on one queue, submitted with one ExecuteCommandLists.
+struct PassSubmission
+{
+	PassQueue Queue = PassQueue::Graphics;
+	vector<uint32_t> Passes;
+
+	// Earlier submission on the other queue that has to finish first, or -1.
+	int WaitFor = -1;
+
+	// Some later submission waits for this one, so its queue signals afterwards.
+	bool Signal = false;
+};
+
+// The passes of a frame in submission order. Every pass records into its own command
+// list, so recording can run on all workers at once. Submission keeps declaration
+// order, batches runs of passes on the same queue and only fences where a pass
+// depends on a pass from the other queue.
+class PassGraph
+{
+public:
+	// Dependencies must be earlier passes. Returns the new pass's index.
+	uint32_t AddPass(const string& name, PassQueue queue, const vector<uint32_t>& dependencies = {});
+	void Clear();
+
+	uint32_t PassCount() const { return (uint32_t)mPasses.size(); }
+	const string& PassName(uint32_t pass) const { return mPasses[pass].Name; }
+	PassQueue GetPassQueue(uint32_t pass) const { return mPasses[pass].Queue; }
+
+	const vector<PassSubmission>& Submissions();
+
+	// Calls record(pass) once per pass on the pool, then submit(submission index) for
+	// every submission in order on the calling thread.
+	void Execute(ThreadPool& pool, const function<void(uint32_t)>& record, const function<void(uint32_t)>& submit);
+
+private:
+	void BuildSubmissions();
+
+private:
+	struct Pass
+	{
+		string Name;
+		PassQueue Queue = PassQueue::Graphics;
+		vector<uint32_t> Dependencies;
+	};
+
+	vector<Pass> mPasses;
+
+	vector<PassSubmission> mSubmissions;
+	bool mSubmissionsDirty = true;
+};
@@ -0,0 +1,192 @@
+#include "PipelineStateKey.h"
+#include "ShaderCache.h"
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+	enum class PipelineType : uint32_t
+	{
+		Graphics = 1,
+		Compute = 2
+	};
+
+	class KeyWriter
+	{
+	public:
+		template<typename T>
+		void Value(const T& value)
+		{
+			static_assert(is_arithmetic<T>::value || is_enum<T>::value, "hash fields one by one");
+			mKey = ShaderCache::Hash(&value, sizeof(value), mKey);
+		}
+
+		void Bytes(const void* data, size_t size)
+		{
+			Value((uint64_t)size);
+			mKey = ShaderCache::Hash(data, size, mKey);
+		}
+
+		void String(const char* str)
+		{
+			Bytes(str, str != nullptr ? strlen(str) : 0);
+		}
+
+		uint64_t Key() const { return mKey; }
+
+	private:
+		uint64_t mKey = 14695981039346656037ull;
+	};
+
+	void WriteShader(KeyWriter& w, const D3D12_SHADER_BYTECODE& shader)
+	{
+		w.Bytes(shader.pShaderBytecode, shader.pShaderBytecode != nullptr ? shader.BytecodeLength : 0);
+	}
+
+	void WriteStreamOutput(KeyWriter& w, const D3D12_STREAM_OUTPUT_DESC& so)
+	{
+		w.Value(so.NumEntries);
+		for (UINT i = 0; i < so.NumEntries; ++i)
+		{
+			const auto& e = so.pSODeclaration[i];
+			w.Value(e.Stream);
+			w.String(e.SemanticName);
+			w.Value(e.SemanticIndex);
+			w.Value(e.StartComponent);
+			w.Value(e.ComponentCount);
+			w.Value(e.OutputSlot);
+		}
+
+		w.Value(so.NumStrides);
+		for (UINT i = 0; i < so.NumStrides; ++i)
+		{
+			w.Value(so.pBufferStrides[i]);
+		}
+		w.Value(so.RasterizedStream);
+	}
+
+	void WriteBlend(KeyWriter& w, const D3D12_BLEND_DESC& blend)
+	{
+		w.Value(blend.AlphaToCoverageEnable);
+		w.Value(blend.IndependentBlendEnable);
+		for (const auto& rt : blend.RenderTarget)
+		{
+			w.Value(rt.BlendEnable);
+			w.Value(rt.LogicOpEnable);
+			w.Value(rt.SrcBlend);
+			w.Value(rt.DestBlend);
+			w.Value(rt.BlendOp);
+			w.Value(rt.SrcBlendAlpha);
+			w.Value(rt.DestBlendAlpha);
+			w.Value(rt.BlendOpAlpha);
+			w.Value(rt.LogicOp);
+			w.Value(rt.RenderTargetWriteMask);
+		}
+	}
+
+	void WriteRasterizer(KeyWriter& w, const D3D12_RASTERIZER_DESC& rs)
+	{
+		w.Value(rs.FillMode);
+		w.Value(rs.CullMode);
+		w.Value(rs.FrontCounterClockwise);
+		w.Value(rs.DepthBias);
+		w.Value(rs.DepthBiasClamp);
+		w.Value(rs.SlopeScaledDepthBias);
+		w.Value(rs.DepthClipEnable);
+		w.Value(rs.MultisampleEnable);
+		w.Value(rs.AntialiasedLineEnable);
+		w.Value(rs.ForcedSampleCount);
+		w.Value(rs.ConservativeRaster);
+	}
+
+	void WriteStencilOp(KeyWriter& w, const D3D12_DEPTH_STENCILOP_DESC& op)
+	{
+		w.Value(op.StencilFailOp);
+		w.Value(op.StencilDepthFailOp);
+		w.Value(op.StencilPassOp);
+		w.Value(op.StencilFunc);
+	}
+
+	void WriteDepthStencil(KeyWriter& w, const D3D12_DEPTH_STENCIL_DESC& ds)
+	{
+		w.Value(ds.DepthEnable);
+		w.Value(ds.DepthWriteMask);
+		w.Value(ds.DepthFunc);
+		w.Value(ds.StencilEnable);
+		w.Value(ds.StencilReadMask);
+		w.Value(ds.StencilWriteMask);
+		WriteStencilOp(w, ds.FrontFace);
+		WriteStencilOp(w, ds.BackFace);
+	}
+
+	void WriteInputLayout(KeyWriter& w, const D3D12_INPUT_LAYOUT_DESC& layout)
+	{
+		w.Value(layout.NumElements);
+		for (UINT i = 0; i < layout.NumElements; ++i)
+		{
+			const auto& e = layout.pInputElementDescs[i];
+			w.String(e.SemanticName);
+			w.Value(e.SemanticIndex);
+			w.Value(e.Format);
+			w.Value(e.InputSlot);
+			w.Value(e.AlignedByteOffset);
+			w.Value(e.InputSlotClass);
+			w.Value(e.InstanceDataStepRate);
+		}
+	}
+}
+
+uint64_t PipelineStateKey::Hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey)
+{
+	// CachedPSO is only a hint to the driver and not part of the pipeline.
+	KeyWriter w;
+	w.Value(PipelineType::Graphics);
+	w.Value(rootSignatureKey);
+	WriteShader(w, desc.VS);
+	WriteShader(w, desc.PS);
+	WriteShader(w, desc.DS);
+	WriteShader(w, desc.HS);
+	WriteShader(w, desc.GS);
+	WriteStreamOutput(w, desc.StreamOutput);
+	WriteBlend(w, desc.BlendState);
+	w.Value(desc.SampleMask);
+	WriteRasterizer(w, desc.RasterizerState);
+	WriteDepthStencil(w, desc.DepthStencilState);
+	WriteInputLayout(w, desc.InputLayout);
+	w.Value(desc.IBStripCutValue);
+	w.Value(desc.PrimitiveTopologyType);
+	w.Value(desc.NumRenderTargets);
+	for (UINT i = 0; i < desc.NumRenderTargets && i < 8; ++i)
+	{
+		w.Value(desc.RTVFormats[i]);
+	}
+	w.Value(desc.DSVFormat);
+	w.Value(desc.SampleDesc.Count);
+	w.Value(desc.SampleDesc.Quality);
+	w.Value(desc.NodeMask);
+	w.Value(desc.Flags);
+	return w.Key();
+}
+
+uint64_t PipelineStateKey::Hash(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey)
+{
+	KeyWriter w;
+	w.Value(PipelineType::Compute);
+	w.Value(rootSignatureKey);
+	WriteShader(w, desc.CS);
+	w.Value(desc.NodeMask);
+	w.Value(desc.Flags);
+	return w.Key();
+}
+
+wstring PipelineStateKey::Name(uint64_t key)
+{
+	static const wchar_t Digits[] = L"0123456789abcdef";
+
+	wstring name = L"pso_";
+	for (int shift = 60; shift >= 0; shift -= 4)
+	{
+		name += Digits[(key >> shift) & 0xf];
+	}
+	return name;
+}
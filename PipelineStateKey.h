@@ -0,0 +1,22 @@
+#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Stable keys for pipeline descriptions. Everything the driver sees is hashed by
+// value: shader bytecode and input layouts by content, state structs field by field
+// so struct padding never gets in. Root signatures are identified by a key the
+// caller derives from the serialized blob, since the pointer changes every run.
+// Only needs the d3d12.h declarations, no device.
+class PipelineStateKey
+{
+public:
+	static uint64_t Hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey);
+	static uint64_t Hash(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureKey);
+
+	// Entry name in an ID3D12PipelineLibrary.
+	static wstring Name(uint64_t key);
+};
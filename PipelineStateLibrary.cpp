@@ -0,0 +1,302 @@
+#include "PipelineStateLibrary.h"
+#include "ShaderCache.h"
+#include <cstdio>
+#include <fstream>
+
+PipelineStateLibrary::PipelineStateLibrary(ID3D12Device* device, const string& libraryPath)
+	: mDevice(device), mLibraryPath(libraryPath)
+{
+	OpenLibrary();
+}
+
+PipelineStateLibrary::~PipelineStateLibrary()
+{
+	Save();
+}
+
+void PipelineStateLibrary::OpenLibrary()
+{
+	ComPtr<ID3D12Device1> device1;
+	if (FAILED(mDevice->QueryInterface(IID_PPV_ARGS(&device1))))
+	{
+		return;
+	}
+
+	ifstream fin(mLibraryPath, ios::binary | ios::ate);
+	if (fin)
+	{
+		mLibraryBlob.resize((size_t)fin.tellg());
+		fin.seekg(0);
+		fin.read(reinterpret_cast<char*>(mLibraryBlob.data()), mLibraryBlob.size());
+		if (!fin)
+		{
+			mLibraryBlob.clear();
+		}
+	}
+
+	if (!mLibraryBlob.empty())
+	{
+		// A driver or adapter change, or a damaged file, invalidates the whole blob.
+		if (SUCCEEDED(device1->CreatePipelineLibrary(mLibraryBlob.data(), mLibraryBlob.size(), IID_PPV_ARGS(&mLibrary))))
+		{
+			return;
+		}
+
+		++mLibraryRejected;
+		mLibraryBlob.clear();
+	}
+
+	if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mLibrary))))
+	{
+		mLibrary = nullptr;
+	}
+}
+
+bool PipelineStateLibrary::Save()
+{
+	if (mLibrary == nullptr || !mLibraryDirty)
+	{
+		return false;
+	}
+
+	vector<uint8_t> data(mLibrary->GetSerializedSize());
+	if (FAILED(mLibrary->Serialize(data.data(), data.size())))
+	{
+		return false;
+	}
+
+	// Write aside and rename so a crash never leaves a truncated library behind.
+	const string tempPath = mLibraryPath + ".tmp";
+	{
+		ofstream fout(tempPath, ios::binary | ios::trunc);
+		if (!fout)
+		{
+			return false;
+		}
+		fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!fout)
+		{
+			return false;
+		}
+	}
+
+	remove(mLibraryPath.c_str());
+	if (rename(tempPath.c_str(), mLibraryPath.c_str()) != 0)
+	{
+		return false;
+	}
+
+	mLibraryDirty = false;
+	return true;
+}
+
+void PipelineStateLibrary::RegisterRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* serialized)
+{
+	mRootSignatureKeys[rootSignature] = ShaderCache::Hash(serialized->GetBufferPointer(), serialized->GetBufferSize());
+}
+
+bool PipelineStateLibrary::FindRootSignatureKey(ID3D12RootSignature* rootSignature, uint64_t& key) const
+{
+	auto it = mRootSignatureKeys.find(rootSignature);
+	if (it != mRootSignatureKeys.end())
+	{
+		key = it->second;
+		return true;
+	}
+
+	// Still unique within this run, which is enough to deduplicate.
+	key = (uint64_t)(uintptr_t)rootSignature;
+	return false;
+}
+
+PipelineStateLibrary::Entry* PipelineStateLibrary::AddEntry(const string& name, uint64_t key)
+{
+	uint32_t id = mRegistry.Add(name, key);
+	if (id < (uint32_t)mEntries.size())
+	{
+		return nullptr;
+	}
+
+	mEntries.push_back(make_unique<Entry>());
+	mEntries.back()->Key = key;
+	return mEntries.back().get();
+}
+
+void PipelineStateLibrary::CopyShader(Entry& entry, D3D12_SHADER_BYTECODE& shader)
+{
+	if (shader.pShaderBytecode == nullptr || shader.BytecodeLength == 0)
+	{
+		shader = {};
+		return;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(shader.pShaderBytecode);
+	entry.Shaders.emplace_back(bytes, bytes + shader.BytecodeLength);
+	shader.pShaderBytecode = entry.Shaders.back().data();
+}
+
+uint32_t PipelineStateLibrary::AddGraphics(const string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	uint64_t rootKey;
+	bool persistent = FindRootSignatureKey(desc.pRootSignature, rootKey);
+
+	uint64_t key = PipelineStateKey::Hash(desc, rootKey);
+	Entry* entry = AddEntry(name, key);
+	if (entry == nullptr)
+	{
+		return mRegistry.Find(name);
+	}
+
+	entry->Persistent = persistent;
+
+	auto& copy = entry->GraphicsDesc;
+	copy = desc;
+	copy.CachedPSO = {};
+
+	// Reserved up front so the pointers taken below stay put.
+	entry->Shaders.reserve(5);
+	CopyShader(*entry, copy.VS);
+	CopyShader(*entry, copy.PS);
+	CopyShader(*entry, copy.DS);
+	CopyShader(*entry, copy.HS);
+	CopyShader(*entry, copy.GS);
+
+	entry->SemanticNames.reserve(desc.InputLayout.NumElements + desc.StreamOutput.NumEntries);
+
+	entry->InputElements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + desc.InputLayout.NumElements);
+	for (auto& element : entry->InputElements)
+	{
+		entry->SemanticNames.push_back(element.SemanticName);
+		element.SemanticName = entry->SemanticNames.back().c_str();
+	}
+	copy.InputLayout = { entry->InputElements.data(), (UINT)entry->InputElements.size() };
+
+	entry->StreamOutEntries.assign(desc.StreamOutput.pSODeclaration, desc.StreamOutput.pSODeclaration + desc.StreamOutput.NumEntries);
+	for (auto& soEntry : entry->StreamOutEntries)
+	{
+		if (soEntry.SemanticName != nullptr)
+		{
+			entry->SemanticNames.push_back(soEntry.SemanticName);
+			soEntry.SemanticName = entry->SemanticNames.back().c_str();
+		}
+	}
+	entry->StreamOutStrides.assign(desc.StreamOutput.pBufferStrides, desc.StreamOutput.pBufferStrides + desc.StreamOutput.NumStrides);
+	copy.StreamOutput.pSODeclaration = entry->StreamOutEntries.data();
+	copy.StreamOutput.pBufferStrides = entry->StreamOutStrides.data();
+
+	return mRegistry.Find(name);
+}
+
+uint32_t PipelineStateLibrary::AddCompute(const string& name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+	uint64_t rootKey;
+	bool persistent = FindRootSignatureKey(desc.pRootSignature, rootKey);
+
+	uint64_t key = PipelineStateKey::Hash(desc, rootKey);
+	Entry* entry = AddEntry(name, key);
+	if (entry == nullptr)
+	{
+		return mRegistry.Find(name);
+	}
+
+	entry->IsCompute = true;
+	entry->Persistent = persistent;
+
+	auto& copy = entry->ComputeDesc;
+	copy = desc;
+	copy.CachedPSO = {};
+
+	entry->Shaders.reserve(1);
+	CopyShader(*entry, copy.CS);
+
+	return mRegistry.Find(name);
+}
+
+void PipelineStateLibrary::Create(Entry& entry)
+{
+	// Each entry is created by exactly one thread, and the pipeline library
+	// synchronizes stores internally.
+	ID3D12PipelineLibrary* library = entry.Persistent ? mLibrary.Get() : nullptr;
+	const wstring name = PipelineStateKey::Name(entry.Key);
+
+	ComPtr<ID3D12PipelineState> pipeline;
+	if (library != nullptr)
+	{
+		HRESULT hr = entry.IsCompute
+			? library->LoadComputePipeline(name.c_str(), &entry.ComputeDesc, IID_PPV_ARGS(&pipeline))
+			: library->LoadGraphicsPipeline(name.c_str(), &entry.GraphicsDesc, IID_PPV_ARGS(&pipeline));
+		if (SUCCEEDED(hr))
+		{
+			++mLibraryHits;
+			entry.Pipeline = pipeline;
+			return;
+		}
+	}
+
+	if (entry.IsCompute)
+	{
+		ThrowIfFailed(mDevice->CreateComputePipelineState(&entry.ComputeDesc, IID_PPV_ARGS(&pipeline)));
+	}
+	else
+	{
+		ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&entry.GraphicsDesc, IID_PPV_ARGS(&pipeline)));
+	}
+	++mCreates;
+
+	if (library != nullptr && SUCCEEDED(library->StorePipeline(name.c_str(), pipeline.Get())))
+	{
+		++mLibraryStores;
+		mLibraryDirty = true;
+	}
+
+	entry.Pipeline = pipeline;
+}
+
+void PipelineStateLibrary::CompileAll(ThreadPool& pool)
+{
+	vector<uint32_t> pending = mRegistry.TakePending();
+
+	pool.ParallelFor(0, (int)pending.size(), 1, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				Entry& entry = *mEntries[pending[i]];
+				if (entry.Pipeline == nullptr)
+				{
+					Create(entry);
+				}
+			}
+		});
+}
+
+ID3D12PipelineState* PipelineStateLibrary::Get(uint32_t id)
+{
+	if (id >= (uint32_t)mEntries.size())
+	{
+		return nullptr;
+	}
+
+	Entry& entry = *mEntries[id];
+	if (entry.Pipeline == nullptr)
+	{
+		Create(entry);
+	}
+	return entry.Pipeline.Get();
+}
+
+ID3D12PipelineState* PipelineStateLibrary::Get(const string& name)
+{
+	return Get(mRegistry.Find(name));
+}
+
+PipelineStateStats PipelineStateLibrary::Stats() const
+{
+	PipelineStateStats stats;
+	stats.Requests = mRegistry.Requests();
+	stats.Deduplicated = mRegistry.Deduplicated();
+	stats.LibraryHits = mLibraryHits;
+	stats.Creates = mCreates;
+	stats.LibraryStores = mLibraryStores;
+	stats.LibraryRejected = mLibraryRejected;
+	return stats;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "PipelineStateKey.h"
+#include "PipelineStateRegistry.h"
+#include "ThreadPool.h"
+
+// Owns the app's pipeline state objects. Descriptions are keyed by PipelineStateKey
+// so identical ones are created once, pending pipelines are created in parallel on a
+// ThreadPool, and everything created is stored in an ID3D12PipelineLibrary that is
+// written to libraryPath and loaded on the next run. Without ID3D12Device1, or when
+// the driver rejects the saved library, pipelines are created normally and a fresh
+// library is started.
+class PipelineStateLibrary
+{
+public:
+	PipelineStateLibrary(ID3D12Device* device, const string& libraryPath);
+	PipelineStateLibrary(const PipelineStateLibrary& rhs) = delete;
+	PipelineStateLibrary& operator=(const PipelineStateLibrary& rhs) = delete;
+	~PipelineStateLibrary();
+
+	// Root signatures are keyed by their serialized blob. Pipelines using a root
+	// signature that was never registered still work but are not persisted.
+	void RegisterRootSignature(ID3D12RootSignature* rootSignature, ID3DBlob* serialized);
+
+	// The description is copied, shaders and input layout included. Returns the
+	// entry id; names with matching descriptions share one entry.
+	uint32_t AddGraphics(const string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+	uint32_t AddCompute(const string& name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+
+	// Creates every pipeline added since the last call.
+	void CompileAll(ThreadPool& pool = ThreadPool::Default());
+
+	// Pipelines still pending are created on the spot. nullptr for unknown names.
+	// Read-only, and so safe from pass recording threads, once CompileAll has run.
+	ID3D12PipelineState* Get(uint32_t id);
+	ID3D12PipelineState* Get(const string& name);
+
+	// Writes the library if it gained pipelines since it was loaded or last saved.
+	// Also done on destruction.
+	bool Save();
+
+	PipelineStateStats Stats() const;
+
+private:
+	struct Entry
+	{
+		uint64_t Key = 0;
+		bool IsCompute = false;
+		bool Persistent = false;
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC GraphicsDesc = {};
+		D3D12_COMPUTE_PIPELINE_STATE_DESC ComputeDesc = {};
+
+		// Storage the descs point into.
+		vector<vector<uint8_t>> Shaders;
+		vector<D3D12_INPUT_ELEMENT_DESC> InputElements;
+		vector<D3D12_SO_DECLARATION_ENTRY> StreamOutEntries;
+		vector<UINT> StreamOutStrides;
+		vector<string> SemanticNames;
+
+		ComPtr<ID3D12PipelineState> Pipeline;
+	};
+
+	bool FindRootSignatureKey(ID3D12RootSignature* rootSignature, uint64_t& key) const;
+	Entry* AddEntry(const string& name, uint64_t key);
+	void CopyShader(Entry& entry, D3D12_SHADER_BYTECODE& shader);
+	void Create(Entry& entry);
+
+	void OpenLibrary();
+
+private:
+	ID3D12Device* mDevice = nullptr;
+	string mLibraryPath;
+
+	ComPtr<ID3D12PipelineLibrary> mLibrary;
+	// The library reads from this for as long as it lives.
+	vector<uint8_t> mLibraryBlob;
+	atomic<bool> mLibraryDirty{ false };
+
+	unordered_map<ID3D12RootSignature*, uint64_t> mRootSignatureKeys;
+
+	PipelineStateRegistry mRegistry;
+	vector<unique_ptr<Entry>> mEntries;
+
+	atomic<uint32_t> mLibraryHits{ 0 };
+	atomic<uint32_t> mCreates{ 0 };
+	atomic<uint32_t> mLibraryStores{ 0 };
+	uint32_t mLibraryRejected = 0;
+};
@@ -0,0 +1,42 @@
+#include "PipelineStateRegistry.h"
+
+uint32_t PipelineStateRegistry::Add(const string& name, uint64_t key)
+{
+	++mRequests;
+
+	uint32_t id;
+	auto it = mEntries.find(key);
+	if (it != mEntries.end())
+	{
+		++mDeduplicated;
+		id = it->second;
+	}
+	else
+	{
+		id = (uint32_t)mKeys.size();
+		mKeys.push_back(key);
+		mEntries[key] = id;
+	}
+
+	mNames[name] = id;
+	return id;
+}
+
+uint32_t PipelineStateRegistry::Find(const string& name) const
+{
+	auto it = mNames.find(name);
+	return it != mNames.end() ? it->second : InvalidId;
+}
+
+vector<uint32_t> PipelineStateRegistry::TakePending()
+{
+	vector<uint32_t> pending;
+	pending.reserve(mKeys.size() - mFirstPending);
+	for (uint32_t id = mFirstPending; id < (uint32_t)mKeys.size(); ++id)
+	{
+		pending.push_back(id);
+	}
+
+	mFirstPending = (uint32_t)mKeys.size();
+	return pending;
+}
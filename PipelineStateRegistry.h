@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct PipelineStateStats
+{
+	uint32_t Requests = 0;
+	uint32_t Deduplicated = 0;
+	uint32_t LibraryHits = 0;
+	uint32_t Creates = 0;
+	uint32_t LibraryStores = 0;
+	uint32_t LibraryRejected = 0;
+};
+
+// Names pipelines and folds identical descriptions onto one entry. Keys come from
+// PipelineStateKey; entries are dense ids the owner keeps its pipeline objects under.
+class PipelineStateRegistry
+{
+public:
+	static const uint32_t InvalidId = UINT32_MAX;
+
+	// Entry for key, created if no earlier name used the same key. Adding a name
+	// again with a different description rebinds the name.
+	uint32_t Add(const string& name, uint64_t key);
+
+	// InvalidId for unknown names.
+	uint32_t Find(const string& name) const;
+
+	// 0 for InvalidId and other ids that were never handed out.
+	uint64_t Key(uint32_t id) const { return id < (uint32_t)mKeys.size() ? mKeys[id] : 0; }
+	uint32_t EntryCount() const { return (uint32_t)mKeys.size(); }
+	size_t NameCount() const { return mNames.size(); }
+
+	// Entries created since the last call, in id order.
+	vector<uint32_t> TakePending();
+
+	uint32_t Requests() const { return mRequests; }
+	uint32_t Deduplicated() const { return mDeduplicated; }
+
+private:
+	unordered_map<string, uint32_t> mNames;
+	unordered_map<uint64_t, uint32_t> mEntries;
+	vector<uint64_t> mKeys;
+
+	uint32_t mFirstPending = 0;
+	uint32_t mRequests = 0;
+	uint32_t mDeduplicated = 0;
+};
@@ -0,0 +1,242 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+	// CPU threads get trace lanes after the GPU queues, in the order they first
+	// record something.
+	atomic<uint32_t> gNextCpuLane{ (uint32_t)ProfileTrack::Count - 1 };
+	thread_local uint32_t tCpuLane = 0;
+
+	uint32_t CurrentCpuLane()
+	{
+		if (tCpuLane == 0)
+		{
+			tCpuLane = gNextCpuLane++;
+		}
+		return tCpuLane;
+	}
+
+	const char* TrackName(ProfileTrack track)
+	{
+		switch (track)
+		{
+		case ProfileTrack::GpuGraphics:
+			return "gpu graphics";
+		case ProfileTrack::GpuCompute:
+			return "gpu compute";
+		default:
+			return "cpu";
+		}
+	}
+
+	void WriteJsonString(ostream& out, const string& value)
+	{
+		out << '"';
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out << '\\';
+			}
+			out << c;
+		}
+		out << '"';
+	}
+}
+
+Profiler::Profiler(uint32_t historySize, uint32_t traceCapacity)
+	: mStart(chrono::steady_clock::now()), mHistorySize(max(historySize, 1u)), mTraceCapacity(traceCapacity)
+{
+}
+
+uint32_t Profiler::RegisterScope(const string& name, ProfileTrack track)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	for (uint32_t i = 0; i < (uint32_t)mScopes.size(); ++i)
+	{
+		if (mScopes[i].Name == name && mScopes[i].Track == track)
+		{
+			return i;
+		}
+	}
+
+	Scope scope;
+	scope.Name = name;
+	scope.Track = track;
+	scope.History.reserve(mHistorySize);
+	mScopes.push_back(move(scope));
+	return (uint32_t)mScopes.size() - 1;
+}
+
+uint32_t Profiler::LaneOf(ProfileTrack track)
+{
+	return track == ProfileTrack::Cpu ? CurrentCpuLane() : (uint32_t)track - 1;
+}
+
+void Profiler::AddSample(uint32_t scope, uint64_t frame, double startMs, double durationMs)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	Scope& s = mScopes[scope];
+	++s.Samples;
+	s.LastMs = durationMs;
+	s.MaxMs = max(s.MaxMs, durationMs);
+
+	if (s.History.size() < mHistorySize)
+	{
+		s.History.push_back(durationMs);
+	}
+	else
+	{
+		s.History[s.HistoryNext] = durationMs;
+	}
+	s.HistoryNext = (s.HistoryNext + 1) % mHistorySize;
+
+	if (mTraceCapacity == 0)
+	{
+		return;
+	}
+	if (mTrace.size() == mTraceCapacity)
+	{
+		mTrace.pop_front();
+	}
+
+	ProfileEvent event;
+	event.Scope = scope;
+	event.Frame = frame;
+	event.StartMs = startMs;
+	event.DurationMs = durationMs;
+	event.Lane = LaneOf(s.Track);
+	mTrace.push_back(event);
+}
+
+double Profiler::Now() const
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - mStart).count();
+}
+
+uint32_t Profiler::ScopeCount() const
+{
+	lock_guard<mutex> lock(mMutex);
+	return (uint32_t)mScopes.size();
+}
+
+ProfileScopeStats Profiler::Stats(uint32_t scope) const
+{
+	lock_guard<mutex> lock(mMutex);
+	return StatsLocked(mScopes[scope]);
+}
+
+ProfileScopeStats Profiler::StatsLocked(const Scope& scope) const
+{
+	ProfileScopeStats stats;
+	stats.Name = scope.Name;
+	stats.Track = scope.Track;
+	stats.Samples = scope.Samples;
+	stats.LastMs = scope.LastMs;
+	stats.MaxMs = scope.MaxMs;
+
+	if (scope.History.empty())
+	{
+		return stats;
+	}
+
+	vector<double> sorted = scope.History;
+	sort(sorted.begin(), sorted.end());
+
+	double sum = 0.0;
+	for (double ms : sorted)
+	{
+		sum += ms;
+	}
+
+	auto percentile = [&sorted](double p)
+	{
+		return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+	};
+
+	stats.AverageMs = sum / sorted.size();
+	stats.P50Ms = percentile(0.50);
+	stats.P95Ms = percentile(0.95);
+	stats.P99Ms = percentile(0.99);
+	return stats;
+}
+
+void Profiler::WriteSummary(ostream& out) const
+{
+	lock_guard<mutex> lock(mMutex);
+
+	out << fixed << setprecision(3);
+	out << left << setw(14) << "track" << setw(28) << "scope"
+		<< right << setw(10) << "samples" << setw(10) << "avg" << setw(10) << "p50"
+		<< setw(10) << "p95" << setw(10) << "p99" << setw(10) << "max" << "\n";
+
+	for (uint32_t track = 0; track < (uint32_t)ProfileTrack::Count; ++track)
+	{
+		for (auto& scope : mScopes)
+		{
+			if ((uint32_t)scope.Track != track || scope.Samples == 0)
+			{
+				continue;
+			}
+
+			ProfileScopeStats stats = StatsLocked(scope);
+			out << left << setw(14) << TrackName(stats.Track) << setw(28) << stats.Name
+				<< right << setw(10) << stats.Samples << setw(10) << stats.AverageMs << setw(10) << stats.P50Ms
+				<< setw(10) << stats.P95Ms << setw(10) << stats.P99Ms << setw(10) << stats.MaxMs << "\n";
+		}
+	}
+}
+
+void Profiler::WriteTrace(ostream& out) const
+{
+	lock_guard<mutex> lock(mMutex);
+
+	out << fixed << setprecision(3);
+	out << "{\"traceEvents\":[";
+
+	const char* separator = "\n";
+
+	// Lane names; CPU lanes are numbered by first use.
+	uint32_t lanes = (uint32_t)ProfileTrack::Count - 1;
+	for (auto& event : mTrace)
+	{
+		lanes = max(lanes, event.Lane + 1);
+	}
+	for (uint32_t lane = 0; lane < lanes; ++lane)
+	{
+		string name = lane < (uint32_t)ProfileTrack::Count - 1 ?
+			TrackName((ProfileTrack)(lane + 1)) : "cpu " + to_string(lane - ((uint32_t)ProfileTrack::Count - 1));
+
+		out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << lane << ",\"args\":{\"name\":";
+		WriteJsonString(out, name);
+		out << "}}";
+		separator = ",\n";
+	}
+
+	for (auto& event : mTrace)
+	{
+		out << separator << "{\"name\":";
+		WriteJsonString(out, mScopes[event.Scope].Name);
+		out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.Lane
+			<< ",\"ts\":" << event.StartMs * 1000.0
+			<< ",\"dur\":" << event.DurationMs * 1000.0
+			<< ",\"args\":{\"frame\":" << event.Frame << "}}";
+	}
+
+	out << "\n]}\n";
+}
+
+ProfileScope::ProfileScope(Profiler& profiler, uint32_t scope)
+	: mProfiler(profiler), mScope(scope), mStartMs(profiler.Now())
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+	const double end = mProfiler.Now();
+	mProfiler.AddSample(mScope, mProfiler.CurrentFrame(), mStartMs, end - mStartMs);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum class ProfileTrack : uint32_t
+{
+	Cpu = 0,
+	GpuGraphics,
+	GpuCompute,
+	Count
+};
+
+struct ProfileScopeStats
+{
+	string Name;
+	ProfileTrack Track = ProfileTrack::Cpu;
+	uint64_t Samples = 0;
+	// Over the last HistorySize samples, except Max which is over all of them.
+	double LastMs = 0.0;
+	double AverageMs = 0.0;
+	double P50Ms = 0.0;
+	double P95Ms = 0.0;
+	double P99Ms = 0.0;
+	double MaxMs = 0.0;
+};
+
+struct ProfileEvent
+{
+	uint32_t Scope = 0;
+	uint64_t Frame = 0;
+	// Milliseconds on the profiler's clock, see Now.
+	double StartMs = 0.0;
+	double DurationMs = 0.0;
+	// Row in the trace: one per GPU queue, then one per CPU thread.
+	uint32_t Lane = 0;
+};
+
+// Named timing scopes from the CPU and the GPU with per-scope percentiles and a
+// trace of recent samples in the chrome://tracing format. Thread-safe; CPU scopes
+// are usually recorded through ProfileScope, GPU samples come from GpuProfiler.
+class Profiler
+{
+public:
+	explicit Profiler(uint32_t historySize = 256, uint32_t traceCapacity = 16384);
+	Profiler(const Profiler& rhs) = delete;
+	Profiler& operator=(const Profiler& rhs) = delete;
+
+	// The same name on the same track gives the same id.
+	uint32_t RegisterScope(const string& name, ProfileTrack track);
+
+	// Frame CPU scopes are attributed to.
+	void BeginFrame(uint64_t frame) { mFrame = frame; }
+	uint64_t CurrentFrame() const { return mFrame; }
+
+	void AddSample(uint32_t scope, uint64_t frame, double startMs, double durationMs);
+
+	// Milliseconds since the profiler was created.
+	double Now() const;
+
+	uint32_t ScopeCount() const;
+	ProfileScopeStats Stats(uint32_t scope) const;
+
+	// One line per scope with samples, grouped by track.
+	void WriteSummary(ostream& out) const;
+	void WriteTrace(ostream& out) const;
+
+	static uint32_t LaneOf(ProfileTrack track);
+
+private:
+	struct Scope
+	{
+		string Name;
+		ProfileTrack Track = ProfileTrack::Cpu;
+		uint64_t Samples = 0;
+		double LastMs = 0.0;
+		double MaxMs = 0.0;
+		vector<double> History;
+		uint32_t HistoryNext = 0;
+	};
+
+	ProfileScopeStats StatsLocked(const Scope& scope) const;
+
+private:
+	chrono::steady_clock::time_point mStart;
+	uint32_t mHistorySize = 0;
+	uint32_t mTraceCapacity = 0;
+	atomic<uint64_t> mFrame{ 0 };
+
+	mutable mutex mMutex;
+	vector<Scope> mScopes;
+	deque<ProfileEvent> mTrace;
+};
+
+// Times its own lifetime on the CPU.
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler& profiler, uint32_t scope);
+	ProfileScope(const ProfileScope& rhs) = delete;
+	ProfileScope& operator=(const ProfileScope& rhs) = delete;
+	~ProfileScope();
+
+private:
+	Profiler& mProfiler;
+	uint32_t mScope = 0;
+	double mStartMs = 0.0;
+};
@@ -0,0 +1,128 @@
+#include "QueueTimeline.h"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+
+namespace
+{
+	PassQueue OtherQueue(PassQueue queue)
+	{
+		return queue == PassQueue::Graphics ? PassQueue::Compute : PassQueue::Graphics;
+	}
+}
+
+QueueTimeline::QueueTimeline(uint32_t capacity)
+	: mStart(chrono::steady_clock::now()), mCapacity(max(capacity, 1u))
+{
+}
+
+double QueueTimeline::Now() const
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - mStart).count();
+}
+
+void QueueTimeline::BeginFrame(uint64_t frame)
+{
+	mFrame = frame;
+	mFrameOverlapped = false;
+	++mStats.Frames;
+
+	for (int q = 0; q < (int)PassQueue::Count; ++q)
+	{
+		mPreviousFrameSignal[q] = mLastSignal[q];
+	}
+}
+
+void QueueTimeline::Update(PassQueue queue, uint64_t completedValue)
+{
+	const int q = (int)queue;
+	if (completedValue <= mCompleted[q])
+	{
+		return;
+	}
+	mCompleted[q] = completedValue;
+
+	const double now = Now();
+
+	// Completion is in order per queue: stop at the first event already done.
+	for (auto it = mEvents.rbegin(); it != mEvents.rend(); ++it)
+	{
+		if (it->Queue != queue || it->Signal > completedValue)
+		{
+			continue;
+		}
+		if (it->CompleteMs >= 0.0)
+		{
+			break;
+		}
+		it->CompleteMs = now;
+	}
+}
+
+void QueueTimeline::Submit(PassQueue queue, const string& passes, uint64_t waitValue, uint64_t signalValue)
+{
+	const int q = (int)queue;
+	const int other = (int)OtherQueue(queue);
+
+	assert(signalValue > mLastSignal[q] && "Signal values must increase per queue.");
+
+	QueueTimelineEvent event;
+	event.Frame = mFrame;
+	event.Queue = queue;
+	event.Passes = passes;
+	event.WaitValue = waitValue;
+	event.Signal = signalValue;
+	event.SubmitMs = Now();
+	event.Overlapped = mPreviousFrameSignal[other] > mCompleted[other];
+
+	mLastSignal[q] = signalValue;
+
+	++mStats.Submissions;
+	if (waitValue != 0)
+	{
+		++mStats.CrossQueueWaits;
+	}
+	if (event.Overlapped && queue == PassQueue::Compute && !mFrameOverlapped)
+	{
+		mFrameOverlapped = true;
+		++mStats.OverlappedFrames;
+	}
+
+	if (mEvents.size() == mCapacity)
+	{
+		mEvents.pop_front();
+	}
+	mEvents.push_back(move(event));
+}
+
+void QueueTimeline::Write(ostream& out) const
+{
+	out << fixed << setprecision(3);
+
+	for (auto& event : mEvents)
+	{
+		out << "frame " << event.Frame
+			<< (event.Queue == PassQueue::Compute ? "  compute " : "  graphics")
+			<< "  submit " << event.SubmitMs << " ms";
+
+		if (event.CompleteMs >= 0.0)
+		{
+			out << "  done " << event.CompleteMs << " ms";
+		}
+		else
+		{
+			out << "  pending";
+		}
+
+		out << "  signal " << event.Signal;
+		if (event.WaitValue != 0)
+		{
+			out << "  wait " << event.WaitValue;
+		}
+		if (event.Overlapped)
+		{
+			out << "  overlapped";
+		}
+		out << "  " << event.Passes << "\n";
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "PassGraph.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+struct QueueTimelineEvent
+{
+	uint64_t Frame = 0;
+	PassQueue Queue = PassQueue::Graphics;
+	// Names of the submission's passes, joined with '+'.
+	string Passes;
+
+	// Value of the other queue's fence waited for before starting, 0 for none.
+	uint64_t WaitValue = 0;
+	// Value this queue's fence reaches once the submission has finished.
+	uint64_t Signal = 0;
+
+	// Milliseconds since the timeline was created. Completion is when the CPU first
+	// saw the fence reach Signal, so it lags the GPU by up to a frame; -1 while pending.
+	double SubmitMs = 0.0;
+	double CompleteMs = -1.0;
+
+	// Submitted while the other queue still had an earlier frame's work pending, so
+	// the two can run at the same time.
+	bool Overlapped = false;
+};
+
+struct QueueTimelineStats
+{
+	uint64_t Frames = 0;
+	uint64_t Submissions = 0;
+	uint64_t CrossQueueWaits = 0;
+	// Frames whose compute work was submitted while an earlier frame's graphics
+	// work was still running.
+	uint64_t OverlappedFrames = 0;
+};
+
+// Log of what each queue was given and when it finished, kept for the last
+// Capacity submissions. Fed by D3D12PassRecorder; headless so it can be driven
+// with made-up fence values.
+class QueueTimeline
+{
+public:
+	explicit QueueTimeline(uint32_t capacity = 4096);
+
+	void BeginFrame(uint64_t frame);
+
+	// Marks submissions on queue up to completedValue as done. Fence values per
+	// queue only grow, so call it with the latest value before each frame.
+	void Update(PassQueue queue, uint64_t completedValue);
+
+	// signalValue must be non-zero and increase per queue.
+	void Submit(PassQueue queue, const string& passes, uint64_t waitValue, uint64_t signalValue);
+
+	const deque<QueueTimelineEvent>& Events() const { return mEvents; }
+	const QueueTimelineStats& Stats() const { return mStats; }
+
+	// One line per submission, oldest first.
+	void Write(ostream& out) const;
+
+private:
+	double Now() const;
+
+private:
+	chrono::steady_clock::time_point mStart;
+	uint32_t mCapacity = 0;
+
+	uint64_t mFrame = 0;
+	bool mFrameOverlapped = false;
+
+	uint64_t mCompleted[(int)PassQueue::Count] = {};
+	uint64_t mLastSignal[(int)PassQueue::Count] = {};
+	// mLastSignal as of the end of the previous frame.
+	uint64_t mPreviousFrameSignal[(int)PassQueue::Count] = {};
+
+	deque<QueueTimelineEvent> mEvents;
+	QueueTimelineStats mStats;
+};
@@ -0,0 +1,763 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	const uint32_t ReadOnlyStates = D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ;
+
+	// States a compute command list cannot transition into or out of.
+	const uint32_t GraphicsOnlyStates =
+		D3D12_RESOURCE_STATE_INDEX_BUFFER |
+		D3D12_RESOURCE_STATE_RENDER_TARGET |
+		D3D12_RESOURCE_STATE_DEPTH_WRITE |
+		D3D12_RESOURCE_STATE_DEPTH_READ |
+		D3D12_RESOURCE_STATE_STREAM_OUT |
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+		D3D12_RESOURCE_STATE_RESOLVE_DEST |
+		D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+	void AddUnique(vector<uint32_t>& values, uint32_t value)
+	{
+		if (find(values.begin(), values.end(), value) == values.end())
+		{
+			values.push_back(value);
+		}
+	}
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+bool RenderGraph::IsReadOnlyState(D3D12_RESOURCE_STATES state)
+{
+	return state != D3D12_RESOURCE_STATE_COMMON && (state & ~ReadOnlyStates) == 0;
+}
+
+bool RenderGraph::IsGraphicsOnlyState(D3D12_RESOURCE_STATES state)
+{
+	return (state & GraphicsOnlyStates) != 0;
+}
+
+RenderGraphResource RenderGraph::ImportResource(const string& name, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Initial = initialState;
+	resource.Final = finalState;
+	mResources.push_back(resource);
+	return (RenderGraphResource)mResources.size() - 1;
+}
+
+RenderGraphResource RenderGraph::CreateTransient(const string& name, uint64_t size, uint64_t alignment, uint32_t heapClass)
+{
+	Resource resource;
+	resource.Name = name;
+	resource.Transient = true;
+	resource.Size = size;
+	resource.Alignment = max<uint64_t>(alignment, 1);
+	resource.HeapClass = heapClass;
+	mResources.push_back(resource);
+	return (RenderGraphResource)mResources.size() - 1;
+}
+
+uint32_t RenderGraph::AddPass(const string& name, PassQueue queue, bool sideEffects)
+{
+	Pass pass;
+	pass.Name = name;
+	pass.Queue = queue;
+	pass.SideEffects = sideEffects;
+	mPasses.push_back(pass);
+	return (uint32_t)mPasses.size() - 1;
+}
+
+void RenderGraph::Read(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state)
+{
+	AddAccess(pass, resource, state, false);
+}
+
+void RenderGraph::Write(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state)
+{
+	AddAccess(pass, resource, state, true);
+}
+
+void RenderGraph::AddAccess(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state, bool write)
+{
+	// One access per resource and pass: reads combine their states, a write decides
+	// the state on its own.
+	for (auto& access : mPasses[pass].Accesses)
+	{
+		if (access.Resource != resource)
+		{
+			continue;
+		}
+
+		if (write)
+		{
+			access.State = state;
+			access.Write = true;
+		}
+		else if (!access.Write)
+		{
+			access.State = (D3D12_RESOURCE_STATES)(access.State | state);
+		}
+		return;
+	}
+
+	mPasses[pass].Accesses.push_back({ resource, state, write });
+}
+
+void RenderGraph::DependsOn(uint32_t pass, uint32_t other)
+{
+	assert(other < pass && "Passes can only depend on earlier passes.");
+	AddUnique(mPasses[pass].Dependencies, other);
+}
+
+const RenderGraph::Access* RenderGraph::FindAccess(uint32_t pass, RenderGraphResource resource) const
+{
+	for (auto& access : mPasses[pass].Accesses)
+	{
+		if (access.Resource == resource)
+		{
+			return &access;
+		}
+	}
+	return nullptr;
+}
+
+vector<vector<uint32_t>> RenderGraph::BuildDependencies(const vector<uint32_t>& passes, bool producersOnly) const
+{
+	vector<vector<uint32_t>> dependencies(mPasses.size());
+
+	vector<bool> included(mPasses.size(), false);
+	for (uint32_t pass : passes)
+	{
+		included[pass] = true;
+	}
+
+	vector<int> lastWriter(mResources.size(), -1);
+	vector<vector<uint32_t>> readers(mResources.size());
+	int lastSideEffect = -1;
+
+	for (uint32_t pass : passes)
+	{
+		const Pass& p = mPasses[pass];
+		auto& deps = dependencies[pass];
+
+		for (uint32_t other : p.Dependencies)
+		{
+			if (included[other])
+			{
+				AddUnique(deps, other);
+			}
+		}
+
+		if (p.SideEffects)
+		{
+			if (lastSideEffect >= 0)
+			{
+				AddUnique(deps, (uint32_t)lastSideEffect);
+			}
+			lastSideEffect = (int)pass;
+		}
+
+		for (auto& access : p.Accesses)
+		{
+			const RenderGraphResource r = access.Resource;
+
+			if (lastWriter[r] >= 0)
+			{
+				AddUnique(deps, (uint32_t)lastWriter[r]);
+			}
+
+			if (access.Write)
+			{
+				if (!producersOnly)
+				{
+					for (uint32_t reader : readers[r])
+					{
+						AddUnique(deps, reader);
+					}
+				}
+
+				lastWriter[r] = (int)pass;
+				readers[r].clear();
+			}
+			else
+			{
+				readers[r].push_back(pass);
+			}
+		}
+	}
+
+	return dependencies;
+}
+
+void RenderGraph::Compile()
+{
+	mStats = RenderGraphStats();
+
+	CullPasses();
+	SortPasses();
+	PlaceTransients();
+	DeriveBarriers();
+}
+
+void RenderGraph::CullPasses()
+{
+	vector<uint32_t> all(mPasses.size());
+	for (uint32_t i = 0; i < (uint32_t)all.size(); ++i)
+	{
+		all[i] = i;
+	}
+
+	auto producers = BuildDependencies(all, true);
+
+	vector<bool> needed(mPasses.size(), false);
+	vector<uint32_t> stack;
+
+	for (uint32_t pass = 0; pass < (uint32_t)mPasses.size(); ++pass)
+	{
+		bool root = mPasses[pass].SideEffects;
+		for (auto& access : mPasses[pass].Accesses)
+		{
+			root |= access.Write && !mResources[access.Resource].Transient;
+		}
+
+		if (root)
+		{
+			needed[pass] = true;
+			stack.push_back(pass);
+		}
+	}
+
+	while (!stack.empty())
+	{
+		uint32_t pass = stack.back();
+		stack.pop_back();
+
+		for (uint32_t producer : producers[pass])
+		{
+			if (!needed[producer])
+			{
+				needed[producer] = true;
+				stack.push_back(producer);
+			}
+		}
+	}
+
+	for (uint32_t pass = 0; pass < (uint32_t)mPasses.size(); ++pass)
+	{
+		mPasses[pass].Culled = !needed[pass];
+		mStats.CulledPasses += mPasses[pass].Culled ? 1 : 0;
+	}
+}
+
+void RenderGraph::SortPasses()
+{
+	vector<uint32_t> live;
+	for (uint32_t pass = 0; pass < (uint32_t)mPasses.size(); ++pass)
+	{
+		if (!mPasses[pass].Culled)
+		{
+			live.push_back(pass);
+		}
+	}
+
+	auto dependencies = BuildDependencies(live, false);
+
+	vector<uint32_t> pending(mPasses.size(), 0);
+	vector<vector<uint32_t>> dependents(mPasses.size());
+	for (uint32_t pass : live)
+	{
+		pending[pass] = (uint32_t)dependencies[pass].size();
+		for (uint32_t dependency : dependencies[pass])
+		{
+			dependents[dependency].push_back(pass);
+		}
+	}
+
+	vector<uint32_t> ready;
+	for (uint32_t pass : live)
+	{
+		if (pending[pass] == 0)
+		{
+			ready.push_back(pass);
+		}
+	}
+
+	// Kahn's algorithm. Among ready passes, staying on the queue of the previous pass
+	// saves a submission and a fence; after that declaration order decides, which
+	// also picks the queue the frame starts on.
+	mOrder.clear();
+	PassQueue lastQueue = ready.empty() ? PassQueue::Graphics : mPasses[ready[0]].Queue;
+	while (!ready.empty())
+	{
+		size_t best = 0;
+		for (size_t i = 1; i < ready.size(); ++i)
+		{
+			const bool sameQueue = mPasses[ready[i]].Queue == lastQueue;
+			const bool bestSameQueue = mPasses[ready[best]].Queue == lastQueue;
+			if (sameQueue != bestSameQueue ? sameQueue : ready[i] < ready[best])
+			{
+				best = i;
+			}
+		}
+
+		const uint32_t pass = ready[best];
+		ready.erase(ready.begin() + best);
+
+		mOrder.push_back(pass);
+		lastQueue = mPasses[pass].Queue;
+
+		for (uint32_t dependent : dependents[pass])
+		{
+			if (--pending[dependent] == 0)
+			{
+				ready.push_back(dependent);
+			}
+		}
+	}
+	assert(mOrder.size() == live.size());
+
+	vector<uint32_t> position(mPasses.size(), 0);
+	for (uint32_t i = 0; i < (uint32_t)mOrder.size(); ++i)
+	{
+		position[mOrder[i]] = i;
+	}
+
+	mCompiled.assign(mOrder.size(), RenderGraphCompiledPass());
+	for (uint32_t i = 0; i < (uint32_t)mOrder.size(); ++i)
+	{
+		mCompiled[i].Pass = mOrder[i];
+		for (uint32_t dependency : dependencies[mOrder[i]])
+		{
+			mCompiled[i].Dependencies.push_back(position[dependency]);
+		}
+		sort(mCompiled[i].Dependencies.begin(), mCompiled[i].Dependencies.end());
+	}
+
+	mStats.Passes = (uint32_t)mOrder.size();
+}
+
+void RenderGraph::PlaceTransients()
+{
+	for (auto& resource : mResources)
+	{
+		resource.FirstUse = -1;
+		resource.LastUse = -1;
+		resource.QueueMask = 0;
+		resource.Offset = 0;
+		resource.Aliased = false;
+	}
+
+	for (int i = 0; i < (int)mOrder.size(); ++i)
+	{
+		const Pass& pass = mPasses[mOrder[i]];
+		for (auto& access : pass.Accesses)
+		{
+			Resource& resource = mResources[access.Resource];
+			if (resource.FirstUse < 0)
+			{
+				resource.FirstUse = i;
+			}
+			resource.LastUse = i;
+			resource.QueueMask |= 1u << (uint32_t)pass.Queue;
+		}
+	}
+
+	// Memory is only shared between transients used on one and the same queue: that
+	// queue's own ordering then covers reuse within a frame and across frames.
+	// Transients used on both queues get memory of their own.
+	struct Group
+	{
+		uint32_t HeapClass = 0;
+		uint32_t QueueMask = 0;
+		bool Aliasing = false;
+		vector<RenderGraphResource> Resources;
+	};
+	vector<Group> groups;
+
+	for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+	{
+		const Resource& resource = mResources[r];
+		if (!resource.Transient || resource.FirstUse < 0)
+		{
+			continue;
+		}
+
+		const bool singleQueue = (resource.QueueMask & (resource.QueueMask - 1)) == 0;
+
+		Group* group = nullptr;
+		for (auto& g : groups)
+		{
+			if (singleQueue && g.Aliasing && g.HeapClass == resource.HeapClass && g.QueueMask == resource.QueueMask)
+			{
+				group = &g;
+				break;
+			}
+		}
+
+		if (group == nullptr)
+		{
+			groups.push_back(Group());
+			group = &groups.back();
+			group->HeapClass = resource.HeapClass;
+			group->QueueMask = resource.QueueMask;
+			group->Aliasing = singleQueue;
+		}
+		group->Resources.push_back(r);
+
+		mStats.TransientBytesUnaliased += AlignUp(resource.Size, resource.Alignment);
+	}
+
+	mHeapSizes.clear();
+
+	for (auto& group : groups)
+	{
+		// Largest first, each at the lowest offset free for its whole lifetime.
+		sort(group.Resources.begin(), group.Resources.end(), [&](RenderGraphResource a, RenderGraphResource b)
+			{
+				if (mResources[a].Size != mResources[b].Size)
+				{
+					return mResources[a].Size > mResources[b].Size;
+				}
+				return mResources[a].FirstUse < mResources[b].FirstUse;
+			});
+
+		uint64_t groupAlignment = 1;
+		uint64_t groupSize = 0;
+		vector<RenderGraphResource> placed;
+
+		for (RenderGraphResource r : group.Resources)
+		{
+			Resource& resource = mResources[r];
+			groupAlignment = max(groupAlignment, resource.Alignment);
+
+			vector<pair<uint64_t, uint64_t>> taken;
+			for (RenderGraphResource p : placed)
+			{
+				const Resource& other = mResources[p];
+				if (other.FirstUse <= resource.LastUse && resource.FirstUse <= other.LastUse)
+				{
+					taken.push_back({ other.Offset, other.Offset + other.Size });
+				}
+			}
+			sort(taken.begin(), taken.end());
+
+			uint64_t offset = 0;
+			for (auto& range : taken)
+			{
+				if (AlignUp(offset, resource.Alignment) + resource.Size <= range.first)
+				{
+					break;
+				}
+				offset = max(offset, range.second);
+			}
+
+			resource.Offset = AlignUp(offset, resource.Alignment);
+			groupSize = max(groupSize, resource.Offset + resource.Size);
+			placed.push_back(r);
+		}
+
+		for (size_t i = 0; i < placed.size(); ++i)
+		{
+			for (size_t j = i + 1; j < placed.size(); ++j)
+			{
+				Resource& a = mResources[placed[i]];
+				Resource& b = mResources[placed[j]];
+				if (a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size)
+				{
+					a.Aliased = true;
+					b.Aliased = true;
+				}
+			}
+		}
+
+		// Groups follow one another in their class's heap.
+		if (group.HeapClass >= mHeapSizes.size())
+		{
+			mHeapSizes.resize(group.HeapClass + 1, 0);
+		}
+
+		const uint64_t base = AlignUp(mHeapSizes[group.HeapClass], groupAlignment);
+		for (RenderGraphResource r : placed)
+		{
+			mResources[r].Offset += base;
+		}
+		mHeapSizes[group.HeapClass] = base + groupSize;
+	}
+
+	for (uint64_t size : mHeapSizes)
+	{
+		mStats.TransientBytes += size;
+	}
+}
+
+void RenderGraph::DeriveBarriers()
+{
+	vector<D3D12_RESOURCE_STATES> start(mResources.size());
+	for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+	{
+		const Resource& resource = mResources[r];
+		start[r] = resource.Initial;
+
+		if (resource.Transient && resource.LastUse >= 0)
+		{
+			start[r] = FindAccess(mOrder[resource.LastUse], r)->State;
+
+			mResources[r].Restore = false;
+			if (mPasses[mOrder[resource.FirstUse]].Queue == PassQueue::Compute && IsGraphicsOnlyState(start[r]))
+			{
+				start[r] = D3D12_RESOURCE_STATE_COMMON;
+				mResources[r].Final = start[r];
+				mResources[r].Restore = true;
+			}
+		}
+	}
+
+	vector<vector<uint32_t>> baseDependencies;
+	for (auto& compiled : mCompiled)
+	{
+		baseDependencies.push_back(compiled.Dependencies);
+	}
+
+	// Transients start each frame in the state they ended the last one in. Read
+	// widening can make that differ from the last access, so settle it first.
+	for (int attempt = 0; attempt < 3; ++attempt)
+	{
+		for (size_t i = 0; i < mCompiled.size(); ++i)
+		{
+			mCompiled[i].Dependencies = baseDependencies[i];
+		}
+
+		auto end = DeriveBarriers(start);
+
+		bool settled = true;
+		for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+		{
+			if (mResources[r].Transient && end[r] != start[r])
+			{
+				start[r] = end[r];
+				settled = false;
+			}
+		}
+
+		if (settled)
+		{
+			break;
+		}
+	}
+
+	for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+	{
+		if (mResources[r].Transient)
+		{
+			mResources[r].Initial = start[r];
+		}
+	}
+
+	for (auto& compiled : mCompiled)
+	{
+		sort(compiled.Dependencies.begin(), compiled.Dependencies.end());
+
+		for (auto* barriers : { &compiled.Barriers, &compiled.PostBarriers })
+		{
+			mStats.BarrierBatches += barriers->empty() ? 0 : 1;
+			for (auto& barrier : *barriers)
+			{
+				switch (barrier.Type)
+				{
+				case RenderGraphBarrier::BarrierType::Transition: ++mStats.Transitions; break;
+				case RenderGraphBarrier::BarrierType::Aliasing: ++mStats.AliasingBarriers; break;
+				case RenderGraphBarrier::BarrierType::UnorderedAccess: ++mStats.UAVBarriers; break;
+				}
+			}
+		}
+	}
+}
+
+vector<D3D12_RESOURCE_STATES> RenderGraph::DeriveBarriers(const vector<D3D12_RESOURCE_STATES>& startStates)
+{
+	struct Tracking
+	{
+		D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_COMMON;
+		int LastUse = -1;
+		bool LastWroteUAV = false;
+		// Positions that used the resource in its current state.
+		vector<uint32_t> Users;
+	};
+
+	vector<Tracking> tracking(mResources.size());
+	for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+	{
+		tracking[r].State = startStates[r];
+	}
+
+	for (auto& compiled : mCompiled)
+	{
+		compiled.Barriers.clear();
+		compiled.PostBarriers.clear();
+	}
+
+	auto queueAt = [&](uint32_t position) { return mPasses[mOrder[position]].Queue; };
+
+	// Anyone still using the old state on another queue must be done before issuer
+	// changes it.
+	auto orderAfterUsers = [&](const Tracking& t, uint32_t issuer)
+	{
+		for (uint32_t user : t.Users)
+		{
+			if (user != issuer && queueAt(user) != queueAt(issuer))
+			{
+				AddUnique(mCompiled[issuer].Dependencies, user);
+			}
+		}
+	};
+
+	for (uint32_t pos = 0; pos < (uint32_t)mOrder.size(); ++pos)
+	{
+		const Pass& pass = mPasses[mOrder[pos]];
+		auto& compiled = mCompiled[pos];
+
+		for (auto& access : pass.Accesses)
+		{
+			const Resource& resource = mResources[access.Resource];
+			if (resource.Transient && resource.Aliased && resource.FirstUse == (int)pos)
+			{
+				RenderGraphBarrier barrier;
+				barrier.Type = RenderGraphBarrier::BarrierType::Aliasing;
+				barrier.Resource = access.Resource;
+				compiled.Barriers.push_back(barrier);
+			}
+		}
+
+		for (auto& access : pass.Accesses)
+		{
+			Tracking& t = tracking[access.Resource];
+
+			const bool covered = !access.Write && IsReadOnlyState(t.State) && (t.State & access.State) == access.State;
+
+			D3D12_RESOURCE_STATES desired = access.State;
+			if (!access.Write && IsReadOnlyState(desired))
+			{
+				// Transition once into everything the readers up to the next write need.
+				for (uint32_t k = pos + 1; k < (uint32_t)mOrder.size(); ++k)
+				{
+					const Access* next = FindAccess(mOrder[k], access.Resource);
+					if (next == nullptr)
+					{
+						continue;
+					}
+					if (next->Write || !IsReadOnlyState(next->State))
+					{
+						break;
+					}
+
+					D3D12_RESOURCE_STATES widened = (D3D12_RESOURCE_STATES)(desired | next->State);
+					if (pass.Queue == PassQueue::Compute && IsGraphicsOnlyState(widened))
+					{
+						break;
+					}
+					desired = widened;
+				}
+			}
+
+			if (covered)
+			{
+				// Already readable as needed.
+			}
+			else if (t.State == desired)
+			{
+				if (desired == D3D12_RESOURCE_STATE_UNORDERED_ACCESS && t.LastUse >= 0 &&
+					(t.LastWroteUAV || access.Write) && queueAt(t.LastUse) == pass.Queue)
+				{
+					RenderGraphBarrier barrier;
+					barrier.Type = RenderGraphBarrier::BarrierType::UnorderedAccess;
+					barrier.Resource = access.Resource;
+					compiled.Barriers.push_back(barrier);
+				}
+			}
+			else
+			{
+				RenderGraphBarrier barrier;
+				barrier.Resource = access.Resource;
+				barrier.Before = t.State;
+				barrier.After = desired;
+
+				uint32_t issuer = pos;
+				if (pass.Queue == PassQueue::Compute && (IsGraphicsOnlyState(t.State) || IsGraphicsOnlyState(desired)))
+				{
+					// The compute list cannot leave a graphics-only state; the
+					// previous user on the graphics queue does it for us.
+					assert(!IsGraphicsOnlyState(desired) && "Compute passes cannot use graphics-only states.");
+					assert(t.LastUse >= 0 && queueAt(t.LastUse) == PassQueue::Graphics &&
+						"Resources first used on the compute queue must start in a compute-compatible state.");
+
+					issuer = (uint32_t)t.LastUse;
+					mCompiled[issuer].PostBarriers.push_back(barrier);
+					AddUnique(compiled.Dependencies, issuer);
+				}
+				else
+				{
+					compiled.Barriers.push_back(barrier);
+				}
+
+				orderAfterUsers(t, issuer);
+
+				t.State = desired;
+				t.Users.clear();
+			}
+
+			t.LastUse = (int)pos;
+			t.LastWroteUAV = access.Write && t.State == D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+			t.Users.push_back(pos);
+		}
+	}
+
+	// Imported resources go back to the state their owner expects.
+	for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+	{
+		const Resource& resource = mResources[r];
+		Tracking& t = tracking[r];
+		if ((resource.Transient && !resource.Restore) || t.LastUse < 0 || t.State == resource.Final)
+		{
+			continue;
+		}
+
+		uint32_t issuer = (uint32_t)t.LastUse;
+		if (queueAt(issuer) == PassQueue::Compute && (IsGraphicsOnlyState(t.State) || IsGraphicsOnlyState(resource.Final)))
+		{
+			int graphics = -1;
+			for (uint32_t pos = issuer + 1; pos < (uint32_t)mOrder.size(); ++pos)
+			{
+				if (queueAt(pos) == PassQueue::Graphics)
+				{
+					graphics = (int)pos;
+				}
+			}
+			assert(graphics >= 0 && "No graphics pass left to restore the final state.");
+
+			AddUnique(mCompiled[graphics].Dependencies, issuer);
+			issuer = (uint32_t)graphics;
+		}
+
+		RenderGraphBarrier barrier;
+		barrier.Resource = r;
+		barrier.Before = t.State;
+		barrier.After = resource.Final;
+		mCompiled[issuer].PostBarriers.push_back(barrier);
+
+		orderAfterUsers(t, issuer);
+		t.State = resource.Final;
+	}
+
+	vector<D3D12_RESOURCE_STATES> end(mResources.size());
+	for (RenderGraphResource r = 0; r < (RenderGraphResource)mResources.size(); ++r)
+	{
+		end[r] = tracking[r].State;
+	}
+	return end;
+}
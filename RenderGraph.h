@@ -0,0 +1,183 @@
+#pragma once
+
+#include "PassGraph.h"
+
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef uint32_t RenderGraphResource;
+
+struct RenderGraphBarrier
+{
+	enum class BarrierType
+	{
+		Transition,
+		Aliasing,
+		UnorderedAccess
+	};
+
+	BarrierType Type = BarrierType::Transition;
+	RenderGraphResource Resource = 0;
+	D3D12_RESOURCE_STATES Before = D3D12_RESOURCE_STATE_COMMON;
+	D3D12_RESOURCE_STATES After = D3D12_RESOURCE_STATE_COMMON;
+};
+
+struct RenderGraphCompiledPass
+{
+	// Declaration index of the pass.
+	uint32_t Pass = 0;
+
+	// Positions in the compiled order.
+	vector<uint32_t> Dependencies;
+
+	// Issued as one batch before the pass, in the pass's own command list.
+	vector<RenderGraphBarrier> Barriers;
+
+	// Issued after the pass: transitions the next user's queue cannot do itself,
+	// and imported resources going back to their final state.
+	vector<RenderGraphBarrier> PostBarriers;
+};
+
+struct RenderGraphStats
+{
+	uint32_t Passes = 0;
+	uint32_t CulledPasses = 0;
+	uint32_t Transitions = 0;
+	uint32_t AliasingBarriers = 0;
+	uint32_t UAVBarriers = 0;
+	uint32_t BarrierBatches = 0;
+	uint64_t TransientBytes = 0;
+	uint64_t TransientBytesUnaliased = 0;
+};
+
+// Frame graph compiler. Passes declare the resources they read and write and the
+// state they need them in; Compile then
+//  - culls passes whose results nothing with side effects or no imported resource
+//    ends up using,
+//  - orders the rest topologically, keeping runs on the same queue together,
+//  - derives the transitions, UAV and aliasing barriers, widening read states so
+//    consecutive readers share one transition,
+//  - places transient resources in per-class heaps, overlapping those whose
+//    lifetimes do not.
+// Headless: it only needs the d3d12.h declarations. D3D12RenderGraph runs the result.
+class RenderGraph
+{
+public:
+	// Lives outside the graph. It is expected in initialState when the frame starts
+	// and is left in finalState.
+	RenderGraphResource ImportResource(const string& name, D3D12_RESOURCE_STATES initialState, D3D12_RESOURCE_STATES finalState);
+
+	// Owned by the graph and placed in the heap of heapClass. Contents do not survive
+	// from one frame to the next, and memory may be shared with other transients, so
+	// the first pass using it has to write all of it.
+	RenderGraphResource CreateTransient(const string& name, uint64_t size, uint64_t alignment, uint32_t heapClass);
+
+	// Passes with side effects are never culled and keep their relative order.
+	uint32_t AddPass(const string& name, PassQueue queue, bool sideEffects = false);
+
+	void Read(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state);
+	void Write(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state);
+
+	// Orders pass after other for work the declared resources do not show.
+	void DependsOn(uint32_t pass, uint32_t other);
+
+	void Compile();
+
+	const vector<RenderGraphCompiledPass>& CompiledPasses() const { return mCompiled; }
+	bool IsCulled(uint32_t pass) const { return mPasses[pass].Culled; }
+
+	uint32_t PassCount() const { return (uint32_t)mPasses.size(); }
+	const string& PassName(uint32_t pass) const { return mPasses[pass].Name; }
+	PassQueue GetPassQueue(uint32_t pass) const { return mPasses[pass].Queue; }
+
+	uint32_t ResourceCount() const { return (uint32_t)mResources.size(); }
+	const string& ResourceName(RenderGraphResource resource) const { return mResources[resource].Name; }
+	bool IsTransient(RenderGraphResource resource) const { return mResources[resource].Transient; }
+
+	// Transients only: heap placement, and the state they are created in, which is
+	// the state they end every frame in.
+	uint32_t HeapClass(RenderGraphResource resource) const { return mResources[resource].HeapClass; }
+	uint64_t HeapOffset(RenderGraphResource resource) const { return mResources[resource].Offset; }
+	D3D12_RESOURCE_STATES InitialState(RenderGraphResource resource) const { return mResources[resource].Initial; }
+
+	// Bit (1 << queue) for every queue a pass using the resource runs on.
+	uint32_t QueueMask(RenderGraphResource resource) const { return mResources[resource].QueueMask; }
+
+	uint32_t HeapClassCount() const { return (uint32_t)mHeapSizes.size(); }
+	uint64_t HeapSize(uint32_t heapClass) const { return heapClass < mHeapSizes.size() ? mHeapSizes[heapClass] : 0; }
+
+	const RenderGraphStats& Stats() const { return mStats; }
+
+	static bool IsReadOnlyState(D3D12_RESOURCE_STATES state);
+	static bool IsGraphicsOnlyState(D3D12_RESOURCE_STATES state);
+
+private:
+	struct Resource
+	{
+		string Name;
+		bool Transient = false;
+		D3D12_RESOURCE_STATES Initial = D3D12_RESOURCE_STATE_COMMON;
+		D3D12_RESOURCE_STATES Final = D3D12_RESOURCE_STATE_COMMON;
+
+		uint64_t Size = 0;
+		uint64_t Alignment = 1;
+		uint32_t HeapClass = 0;
+		uint64_t Offset = 0;
+		bool Aliased = false;
+
+		// Transients whose end state the first user's queue cannot leave are put
+		// back to Final at the end of each frame, like imported resources.
+		bool Restore = false;
+
+		// Positions in the compiled order, -1 if unused.
+		int FirstUse = -1;
+		int LastUse = -1;
+		uint32_t QueueMask = 0;
+	};
+
+	struct Access
+	{
+		RenderGraphResource Resource = 0;
+		D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_COMMON;
+		bool Write = false;
+	};
+
+	struct Pass
+	{
+		string Name;
+		PassQueue Queue = PassQueue::Graphics;
+		bool SideEffects = false;
+		vector<Access> Accesses;
+		vector<uint32_t> Dependencies;
+		bool Culled = false;
+	};
+
+	void AddAccess(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state, bool write);
+	const Access* FindAccess(uint32_t pass, RenderGraphResource resource) const;
+
+	// Declaration-order edges between the given passes. producersOnly leaves out
+	// write-after-read edges, which must not keep a reader alive.
+	vector<vector<uint32_t>> BuildDependencies(const vector<uint32_t>& passes, bool producersOnly) const;
+
+	void CullPasses();
+	void SortPasses();
+	void PlaceTransients();
+	void DeriveBarriers();
+
+	// One derivation from the given start states; returns the states the frame ends in.
+	vector<D3D12_RESOURCE_STATES> DeriveBarriers(const vector<D3D12_RESOURCE_STATES>& startStates);
+
+private:
+	vector<Resource> mResources;
+	vector<Pass> mPasses;
+
+	vector<uint32_t> mOrder;
+	vector<RenderGraphCompiledPass> mCompiled;
+	vector<uint64_t> mHeapSizes;
+
+	RenderGraphStats mStats;
+};
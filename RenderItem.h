@@ -5,6 +5,8 @@
 
 struct RenderItem
 {
+	static constexpr UINT InvalidArchetype = UINT_MAX;
+
 	RenderItem() = default;
 	RenderItem(const RenderItem& rhs) = delete;
 
@@ -21,7 +23,10 @@ struct RenderItem
 	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
 	BoundingBox Bounds;
+	// Filled by the app's Build; BaseApp then moves them into its InstanceStorage
+	// as archetype Archetype and leaves this empty.
 	vector<Instance> Instances;
+	UINT Archetype = InvalidArchetype;
 
 	UINT IndexCount = 0;
 	UINT InstanceCount = 0;
@@ -0,0 +1,272 @@
+#include "ShaderCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	const uint32_t EntryMagic = 0x43485344; // "DSHC"
+
+	bool ReadFile(const string& path, string& contents)
+	{
+		ifstream fin(path, ios::binary);
+		if (!fin)
+		{
+			return false;
+		}
+
+		ostringstream oss;
+		oss << fin.rdbuf();
+		contents = oss.str();
+		return true;
+	}
+
+	string DirectoryOf(const string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == string::npos ? string() : path.substr(0, slash + 1);
+	}
+
+	// Quoted #include targets in source order. Angle bracket includes would be
+	// system headers, which the shaders here do not use.
+	vector<string> FindIncludes(const string& source)
+	{
+		vector<string> includes;
+
+		istringstream lines(source);
+		string line;
+		while (getline(lines, line))
+		{
+			size_t pos = line.find_first_not_of(" \t");
+			if (pos == string::npos || line[pos] != '#')
+			{
+				continue;
+			}
+
+			pos = line.find_first_not_of(" \t", pos + 1);
+			if (pos == string::npos || line.compare(pos, 7, "include") != 0)
+			{
+				continue;
+			}
+
+			size_t open = line.find('"', pos + 7);
+			size_t close = open == string::npos ? string::npos : line.find('"', open + 1);
+			if (close != string::npos)
+			{
+				includes.push_back(line.substr(open + 1, close - open - 1));
+			}
+		}
+
+		return includes;
+	}
+}
+
+ShaderCache::ShaderCache(ShaderCompiler* compiler, const string& cacheDirectory)
+	: mCompiler(compiler), mCacheDirectory(cacheDirectory)
+{
+	if (!mCacheDirectory.empty() && mCacheDirectory.back() != '/' && mCacheDirectory.back() != '\\')
+	{
+		mCacheDirectory += '/';
+	}
+}
+
+uint64_t ShaderCache::Hash(const void* data, size_t size, uint64_t seed)
+{
+	// FNV-1a.
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+uint64_t ShaderCache::HashSourceTree(const string& path, vector<string>& visited)
+{
+	// Include guards make repeated includes harmless; hash each file once.
+	for (auto& v : visited)
+	{
+		if (v == path)
+		{
+			return 0;
+		}
+	}
+	visited.push_back(path);
+
+	auto it = mFileHashes.find(path);
+	if (it == mFileHashes.end())
+	{
+		SourceFile file;
+
+		string source;
+		if (ReadFile(path, source))
+		{
+			file.Hash = Hash(source.data(), source.size());
+			file.Includes = FindIncludes(source);
+		}
+		else
+		{
+			// A missing file still contributes, so creating it changes the key.
+			file.Hash = Hash(path.data(), path.size(), 0);
+		}
+
+		it = mFileHashes.emplace(path, move(file)).first;
+	}
+
+	uint64_t hash = it->second.Hash;
+
+	const string directory = DirectoryOf(path);
+	for (auto& include : it->second.Includes)
+	{
+		uint64_t child = HashSourceTree(directory + include, visited);
+		hash = Hash(&child, sizeof(child), hash);
+	}
+
+	return hash;
+}
+
+uint64_t ShaderCache::ComputeKey(const ShaderCompileRequest& request)
+{
+	vector<string> visited;
+	uint64_t key = HashSourceTree(request.Path, visited);
+
+	auto mix = [&key](const string& s)
+		{
+			key = ShaderCache::Hash(s.data(), s.size() + 1, key);
+		};
+
+	for (auto& define : request.Defines)
+	{
+		mix(define.Name);
+		mix(define.Value);
+	}
+	mix(request.EntryPoint);
+	mix(request.Target);
+	mix(mCompiler->Version());
+	key = Hash(&request.Flags, sizeof(request.Flags), key);
+
+	return key;
+}
+
+void ShaderCache::ClearFileHashes()
+{
+	lock_guard<mutex> lock(mMutex);
+	mFileHashes.clear();
+}
+
+string ShaderCache::EntryPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.cso", (unsigned long long)key);
+	return mCacheDirectory + name;
+}
+
+bool ShaderCache::ReadEntry(uint64_t key, vector<uint8_t>& byteCode)
+{
+	string contents;
+	if (mCacheDirectory.empty() || !ReadFile(EntryPath(key), contents))
+	{
+		return false;
+	}
+
+	// magic, key, bytecode size, bytecode hash, bytecode
+	const size_t headerSize = sizeof(uint32_t) + 3 * sizeof(uint64_t);
+	if (contents.size() < headerSize)
+	{
+		++mStats.RejectedEntries;
+		return false;
+	}
+
+	uint32_t magic;
+	uint64_t storedKey, size, hash;
+	const char* p = contents.data();
+	memcpy(&magic, p, sizeof(magic));
+	memcpy(&storedKey, p + 4, sizeof(storedKey));
+	memcpy(&size, p + 12, sizeof(size));
+	memcpy(&hash, p + 20, sizeof(hash));
+
+	if (magic != EntryMagic || storedKey != key || size != contents.size() - headerSize
+		|| Hash(p + headerSize, (size_t)size) != hash)
+	{
+		++mStats.RejectedEntries;
+		return false;
+	}
+
+	byteCode.assign(p + headerSize, p + contents.size());
+	return true;
+}
+
+void ShaderCache::WriteEntry(uint64_t key, const vector<uint8_t>& byteCode)
+{
+	if (mCacheDirectory.empty())
+	{
+		return;
+	}
+
+	uint64_t size = byteCode.size();
+	uint64_t hash = Hash(byteCode.data(), byteCode.size());
+
+	// Write aside and rename so a crash never leaves a truncated entry behind.
+	const string path = EntryPath(key);
+	const string tempPath = path + ".tmp";
+	{
+		ofstream fout(tempPath, ios::binary | ios::trunc);
+		if (!fout)
+		{
+			return;
+		}
+
+		fout.write(reinterpret_cast<const char*>(&EntryMagic), sizeof(EntryMagic));
+		fout.write(reinterpret_cast<const char*>(&key), sizeof(key));
+		fout.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		fout.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+		fout.write(reinterpret_cast<const char*>(byteCode.data()), byteCode.size());
+	}
+
+	remove(path.c_str());
+	rename(tempPath.c_str(), path.c_str());
+}
+
+ShaderByteCode ShaderCache::Get(const ShaderCompileRequest& request, string* errors)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	const uint64_t key = ComputeKey(request);
+
+	auto it = mMemory.find(key);
+	if (it != mMemory.end())
+	{
+		++mStats.MemoryHits;
+		return it->second;
+	}
+
+	auto byteCode = make_shared<vector<uint8_t>>();
+	if (ReadEntry(key, *byteCode))
+	{
+		++mStats.DiskHits;
+	}
+	else
+	{
+		string compileErrors;
+		if (!mCompiler->Compile(request, *byteCode, compileErrors))
+		{
+			++mStats.Failures;
+			if (errors != nullptr)
+			{
+				*errors = compileErrors;
+			}
+			return nullptr;
+		}
+
+		++mStats.Compiles;
+		WriteEntry(key, *byteCode);
+	}
+
+	mMemory[key] = byteCode;
+	return byteCode;
+}
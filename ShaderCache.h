@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct ShaderDefine
+{
+	string Name;
+	string Value;
+};
+
+struct ShaderCompileRequest
+{
+	string Path;
+	vector<ShaderDefine> Defines;
+	string EntryPoint;
+	string Target;
+	uint32_t Flags = 0;
+};
+
+typedef shared_ptr<const vector<uint8_t>> ShaderByteCode;
+
+// Turns a request into bytecode. D3DShaderCompiler wraps D3DCompileFromFile; tests
+// can plug in anything deterministic.
+class ShaderCompiler
+{
+public:
+	virtual ~ShaderCompiler() = default;
+
+	virtual bool Compile(const ShaderCompileRequest& request, vector<uint8_t>& byteCode, string& errors) = 0;
+
+	// Part of the cache key, so a compiler update invalidates old entries.
+	virtual string Version() const = 0;
+};
+
+struct ShaderCacheStats
+{
+	uint32_t MemoryHits = 0;
+	uint32_t DiskHits = 0;
+	uint32_t Compiles = 0;
+	uint32_t Failures = 0;
+	uint32_t RejectedEntries = 0;
+};
+
+// Bytecode cache in front of a ShaderCompiler. The key hashes the contents of the
+// shader and every file it #includes (recursively, quoted includes resolved next
+// to the including file), the defines, entry point, target, flags and compiler
+// version. Entries are written to cacheDirectory/<key>.cso and also kept in memory
+// for the rest of the run. An empty cacheDirectory keeps them in memory only.
+class ShaderCache
+{
+public:
+	ShaderCache(ShaderCompiler* compiler, const string& cacheDirectory);
+	ShaderCache(const ShaderCache& rhs) = delete;
+	ShaderCache& operator=(const ShaderCache& rhs) = delete;
+
+	// nullptr on compile errors, which are then in errors.
+	ShaderByteCode Get(const ShaderCompileRequest& request, string* errors = nullptr);
+
+	// Source files are read and hashed once per run; call this after editing
+	// shaders while the app is running.
+	void ClearFileHashes();
+
+	const ShaderCacheStats& Stats() const { return mStats; }
+
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+private:
+	struct SourceFile
+	{
+		uint64_t Hash = 0;
+		vector<string> Includes;
+	};
+
+	// Both fill mFileHashes; callers hold mMutex.
+	uint64_t ComputeKey(const ShaderCompileRequest& request);
+	uint64_t HashSourceTree(const string& path, vector<string>& visited);
+	string EntryPath(uint64_t key) const;
+
+	bool ReadEntry(uint64_t key, vector<uint8_t>& byteCode);
+	void WriteEntry(uint64_t key, const vector<uint8_t>& byteCode);
+
+private:
+	ShaderCompiler* mCompiler = nullptr;
+	string mCacheDirectory;
+
+	mutex mMutex;
+	unordered_map<string, SourceFile> mFileHashes;
+	unordered_map<uint64_t, ShaderByteCode> mMemory;
+
+	ShaderCacheStats mStats;
+};
@@ -1,3 +1,5 @@
+// Mirrored on the CPU by BezierPatchUtil in BezierPatch.h; keep the two in sync.
+
 struct BezierHullOut
 {
     float3 PosL : POSITION;
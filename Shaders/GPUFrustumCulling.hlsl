@@ -1,4 +1,5 @@
 #define threadBlockSize 128
+#define planeCount 6
 
 struct SceneObjectData
 {
@@ -28,9 +29,9 @@ struct Plane
 cbuffer cbRoot : register(b0)
 {
     uint gCommandCount;
+    uint gObjectCount;
     uint pad0;
     uint pad1;
-    uint pad2;
 }
 
 StructuredBuffer<SceneObjectData> gObjectData : register(t0, space0);
@@ -38,41 +39,76 @@ StructuredBuffer<Plane> gFrustumPlanes : register(t0, space1);
 RWStructuredBuffer<IndirectCommand> gCullingOutputs : register(u0);
 // RWByteAddressBuffer<IndirectCommand> gCullingOutputs : register(u0);
 RWStructuredBuffer<uint> gVisibilityOutputs : register(u1);
+// [0, planeCount) culled by each plane, then instances tested per command.
+RWStructuredBuffer<uint> gCullingStats : register(u2);
 
+groupshared uint gsCulledByPlane[planeCount];
+groupshared uint gsTested;
 
-bool IsBoxInFrustum(float4 posW, float3 size)
+// Index of the first plane the box is fully outside of, planeCount if none.
+uint FirstOutsidePlane(float4 posW, float3 size)
 {
     float3 halfSize = size * 0.5;
 
-    for (int i = 0; i < 6; ++i)
+    for (uint i = 0; i < planeCount; ++i)
     {
         Plane plane = gFrustumPlanes[i];
         float3 signedHalfSize = (plane.normal > 0) ? halfSize : -halfSize;
         float3 boxVertex = posW.xyz + signedHalfSize;
         if (dot(plane.normal, boxVertex) + plane.distance < 0)
         {
-            return false;
+            return i;
         }
     }
-    return true;
+    return planeCount;
 }
 
 [numthreads(threadBlockSize, 1, 1)]
-void CS(uint3 groupId : SV_GroupID, uint3 DTid : SV_DispatchThreadID)
+void CS(uint3 groupId : SV_GroupID, uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 {
+    if (groupIndex < planeCount)
+    {
+        gsCulledByPlane[groupIndex] = 0;
+    }
+    if (groupIndex == 0)
+    {
+        gsTested = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
     // NOTE : Depends on groupId, Indirect Command'd be changed
+    // SV_DispatchThreadID already includes the group offset.
     uint commandIndex = groupId.x;
-    uint index = groupId.x * threadBlockSize + DTid.x;
-    if (commandIndex < gCommandCount)
+    uint index = DTid.x;
+    if (commandIndex < gCommandCount && index < gObjectCount)
     {
         SceneObjectData objData = gObjectData[index];
-        bool isVisible = IsBoxInFrustum(objData.posW, objData.size);
-        if (isVisible)
+        uint plane = FirstOutsidePlane(objData.posW, objData.size);
+        InterlockedAdd(gsTested, 1);
+        if (plane == planeCount)
         {
             uint visibilityIndex;
             InterlockedAdd(gCullingOutputs[commandIndex].InstanceCount, 1, visibilityIndex);
             visibilityIndex += threadBlockSize * groupId.x;
             gVisibilityOutputs[visibilityIndex] = index;
         }
+        else
+        {
+            InterlockedAdd(gsCulledByPlane[plane], 1);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // One global atomic per counter and group.
+    if (commandIndex < gCommandCount)
+    {
+        if (groupIndex < planeCount && gsCulledByPlane[groupIndex] > 0)
+        {
+            InterlockedAdd(gCullingStats[groupIndex], gsCulledByPlane[groupIndex]);
+        }
+        if (groupIndex == 0)
+        {
+            InterlockedAdd(gCullingStats[planeCount + commandIndex], gsTested);
+        }
     }
 }
@@ -10,6 +10,20 @@
 #define NUM_SPOT_LIGHTS 0
 #endif
 
+// Distance based tessellation, mirrored by LandTessellation.h. Overriding
+// LAND_MAX_TESS_FACTOR caps the factor to keep a triangle budget.
+#ifndef LAND_TESS_MIN_DISTANCE
+#define LAND_TESS_MIN_DISTANCE 20.0f
+#endif
+
+#ifndef LAND_TESS_MAX_DISTANCE
+#define LAND_TESS_MAX_DISTANCE 200.0f
+#endif
+
+#ifndef LAND_MAX_TESS_FACTOR
+#define LAND_MAX_TESS_FACTOR 64.0f
+#endif
+
 #include "LightingUtil.hlsl"
 
 Texture2D gDiffuseMap : register(t0);
@@ -98,9 +112,9 @@ PatchTess ConstantHS(InputPatch<VertexOut, 4> patch, uint patchID : SV_Primitive
 
     float d = distance(centerW, gEyePosW);
 
-    const float d0 = 20.0f;
-    const float d1 = 200.0f;
-    float tess = 64.0f * saturate((d1 - d) / (d1 - d0));
+    const float d0 = LAND_TESS_MIN_DISTANCE;
+    const float d1 = LAND_TESS_MAX_DISTANCE;
+    float tess = min(64.0f * saturate((d1 - d) / (d1 - d0)), LAND_MAX_TESS_FACTOR);
 
     pt.EdgeTess[0] = tess;
     pt.EdgeTess[1] = tess;
@@ -0,0 +1,144 @@
+// Compute version of the Waves solver. Each group loads a WaveTileSize^2 tile of
+// the current solution plus a one texel halo into groupshared memory, so every
+// height is read from memory once per group instead of five times.
+// WavesTiledEmulator runs the same algorithm on the CPU.
+
+#define WaveTileSize 16
+
+struct WaveVertex
+{
+    float3 PosL;
+    float3 NormalL;
+    float2 TexC;
+};
+
+cbuffer cbWaves : register(b0)
+{
+    float gK1;
+    float gK2;
+    float gK3;
+    float gSpatialStep;
+    uint gNumRows;
+    uint gNumCols;
+    float gWidth;
+    float gDepth;
+    uint gDisturbRow;
+    uint gDisturbCol;
+    float gDisturbMagnitude;
+    uint gWavesPad0;
+};
+
+// Both solutions stay in UNORDERED_ACCESS, so the current one is bound as a UAV
+// as well and only ever read.
+RWStructuredBuffer<float> gPrevSolution : register(u0);
+RWStructuredBuffer<float> gCurrSolution : register(u1);
+RWStructuredBuffer<WaveVertex> gVertices : register(u2);
+
+groupshared float gTile[WaveTileSize + 2][WaveTileSize + 2];
+
+float LoadHeight(int row, int col)
+{
+    row = clamp(row, 0, (int)gNumRows - 1);
+    col = clamp(col, 0, (int)gNumCols - 1);
+    return gCurrSolution[row * gNumCols + col];
+}
+
+// x is the column, y the row. Threads on the tile edge also fetch the halo next
+// to them; the five point stencil never needs the corners.
+void LoadTile(int2 cell, int2 local)
+{
+    gTile[local.y + 1][local.x + 1] = LoadHeight(cell.y, cell.x);
+
+    if (local.x == 0)
+    {
+        gTile[local.y + 1][0] = LoadHeight(cell.y, cell.x - 1);
+    }
+    if (local.x == WaveTileSize - 1)
+    {
+        gTile[local.y + 1][WaveTileSize + 1] = LoadHeight(cell.y, cell.x + 1);
+    }
+    if (local.y == 0)
+    {
+        gTile[0][local.x + 1] = LoadHeight(cell.y - 1, cell.x);
+    }
+    if (local.y == WaveTileSize - 1)
+    {
+        gTile[WaveTileSize + 1][local.x + 1] = LoadHeight(cell.y + 1, cell.x);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+}
+
+bool IsInterior(int2 cell)
+{
+    return cell.x >= 1 && cell.y >= 1 && cell.x < (int)gNumCols - 1 && cell.y < (int)gNumRows - 1;
+}
+
+[numthreads(WaveTileSize, WaveTileSize, 1)]
+void UpdateCS(int3 groupThreadID : SV_GroupThreadID, int3 dispatchThreadID : SV_DispatchThreadID)
+{
+    LoadTile(dispatchThreadID.xy, groupThreadID.xy);
+
+    if (!IsInterior(dispatchThreadID.xy))
+    {
+        return;
+    }
+
+    int tx = groupThreadID.x + 1;
+    int ty = groupThreadID.y + 1;
+    uint index = dispatchThreadID.y * gNumCols + dispatchThreadID.x;
+
+    // Next step overwrites the previous one in place, like the CPU solver.
+    gPrevSolution[index] =
+        gK1 * gPrevSolution[index] +
+        gK2 * gTile[ty][tx] +
+        gK3 * (gTile[ty + 1][tx] + gTile[ty - 1][tx] + gTile[ty][tx + 1] + gTile[ty][tx - 1]);
+}
+
+[numthreads(WaveTileSize, WaveTileSize, 1)]
+void NormalsCS(int3 groupThreadID : SV_GroupThreadID, int3 dispatchThreadID : SV_DispatchThreadID)
+{
+    LoadTile(dispatchThreadID.xy, groupThreadID.xy);
+
+    int2 cell = dispatchThreadID.xy;
+    if (cell.x >= (int)gNumCols || cell.y >= (int)gNumRows)
+    {
+        return;
+    }
+
+    int tx = groupThreadID.x + 1;
+    int ty = groupThreadID.y + 1;
+
+    float halfWidth = (gNumCols - 1) * gSpatialStep * 0.5f;
+    float halfDepth = (gNumRows - 1) * gSpatialStep * 0.5f;
+
+    WaveVertex v;
+    v.PosL = float3(-halfWidth + cell.x * gSpatialStep, gTile[ty][tx], halfDepth - cell.y * gSpatialStep);
+    v.NormalL = float3(0.0f, 1.0f, 0.0f);
+    v.TexC = float2(0.5f + v.PosL.x / gWidth, 0.5f - v.PosL.z / gDepth);
+
+    if (IsInterior(cell))
+    {
+        float l = gTile[ty][tx - 1];
+        float r = gTile[ty][tx + 1];
+        float t = gTile[ty - 1][tx];
+        float b = gTile[ty + 1][tx];
+
+        v.NormalL = normalize(float3(l - r, 2.0f * gSpatialStep, b - t));
+    }
+
+    gVertices[cell.y * gNumCols + cell.x] = v;
+}
+
+[numthreads(1, 1, 1)]
+void DisturbCS()
+{
+    uint index = gDisturbRow * gNumCols + gDisturbCol;
+    float halfMag = 0.5f * gDisturbMagnitude;
+
+    gCurrSolution[index] += gDisturbMagnitude;
+    gCurrSolution[index + 1] += halfMag;
+    gCurrSolution[index - 1] += halfMag;
+    gCurrSolution[index + gNumCols] += halfMag;
+    gCurrSolution[index - gNumCols] += halfMag;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <emmintrin.h>
+
+// SSE2 helpers shared by the batch geometry paths. SSE2 is part of x64, so
+// these need no runtime dispatch.
+namespace SimdMath
+{
+	inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		// mask ? a : b
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	// sin and cos of four angles. The argument is reduced to [-pi/4, pi/4] with a
+	// three part pi/2 and evaluated with minimax polynomials; the absolute error
+	// stays below 2e-7 for |x| < 8192 and grows slowly past that.
+	inline void SinCos(__m128 x, __m128* s, __m128* c)
+	{
+		const __m128 twoOverPi = _mm_set1_ps(0.636619772367581f);
+		const __m128 pio2a = _mm_set1_ps(1.5703125f);
+		const __m128 pio2b = _mm_set1_ps(4.8375129699707031e-4f);
+		const __m128 pio2c = _mm_set1_ps(7.5497899548918821e-8f);
+
+		__m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, twoOverPi));
+		__m128 qf = _mm_cvtepi32_ps(q);
+
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, pio2a));
+		r = _mm_sub_ps(r, _mm_mul_ps(qf, pio2b));
+		r = _mm_sub_ps(r, _mm_mul_ps(qf, pio2c));
+
+		__m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 sp = _mm_set1_ps(-1.9515295891e-4f);
+		sp = _mm_add_ps(_mm_mul_ps(sp, r2), _mm_set1_ps(8.3321608736e-3f));
+		sp = _mm_add_ps(_mm_mul_ps(sp, r2), _mm_set1_ps(-1.6666654611e-1f));
+		sp = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sp, r2), r), r);
+
+		__m128 cp = _mm_set1_ps(2.443315711809948e-5f);
+		cp = _mm_add_ps(_mm_mul_ps(cp, r2), _mm_set1_ps(-1.388731625493765e-3f));
+		cp = _mm_add_ps(_mm_mul_ps(cp, r2), _mm_set1_ps(4.166664568298827e-2f));
+		cp = _mm_mul_ps(_mm_mul_ps(cp, r2), r2);
+		cp = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), cp);
+
+		// Quadrant q: odd quadrants swap sin and cos, sin flips sign in quadrants
+		// 2 and 3, cos in quadrants 1 and 2.
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+
+		*s = _mm_xor_ps(Select(swap, cp, sp), sinSign);
+		*c = _mm_xor_ps(Select(swap, sp, cp), cosSign);
+	}
+
+	// out = a * b for row-major 4x4 matrices, row vectors as in DirectXMath. out may
+	// alias a or b; none of them need to be aligned.
+	inline void MultiplyMatrix(const float* a, const float* b, float* out)
+	{
+		const __m128 b0 = _mm_loadu_ps(b);
+		const __m128 b1 = _mm_loadu_ps(b + 4);
+		const __m128 b2 = _mm_loadu_ps(b + 8);
+		const __m128 b3 = _mm_loadu_ps(b + 12);
+
+		__m128 rows[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			const float* ai = a + 4 * i;
+			rows[i] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ai[0]), b0), _mm_mul_ps(_mm_set1_ps(ai[1]), b1)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ai[2]), b2), _mm_mul_ps(_mm_set1_ps(ai[3]), b3)));
+		}
+
+		for (int i = 0; i < 4; ++i)
+		{
+			_mm_storeu_ps(out + 4 * i, rows[i]);
+		}
+	}
+}
@@ -0,0 +1,229 @@
+#include "StreamingScheduler.h"
+#include <algorithm>
+
+StreamingScheduler::StreamingScheduler(CopyQueueBackend* backend, uint64_t bytesPerUpdate, uint32_t maxBatchesInFlight)
+	: mBackend(backend), mBytesPerUpdate(bytesPerUpdate), mMaxBatchesInFlight(max(maxBatchesInFlight, 1u))
+{
+}
+
+uint64_t StreamingScheduler::Enqueue(int priority, uint64_t byteSize, shared_ptr<const void> payload, function<void()> onComplete)
+{
+	auto request = make_unique<StreamRequest>();
+	request->Id = mNextId++;
+	request->Priority = priority;
+	request->ByteSize = byteSize;
+	request->Payload = move(payload);
+	request->OnComplete = move(onComplete);
+	request->Sequence = mNextSequence++;
+	request->EnqueueFrame = mFrame;
+
+	uint64_t id = request->Id;
+	mStates[id] = StreamState::Queued;
+	mQueued.push_back(move(request));
+
+	++mStats.RequestsQueued;
+	return id;
+}
+
+bool StreamingScheduler::SetPriority(uint64_t id, int priority)
+{
+	for (auto& request : mQueued)
+	{
+		if (request->Id == id)
+		{
+			request->Priority = priority;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool StreamingScheduler::Cancel(uint64_t id)
+{
+	auto it = find_if(mQueued.begin(), mQueued.end(),
+		[id](const unique_ptr<StreamRequest>& request) { return request->Id == id; });
+
+	if (it == mQueued.end())
+	{
+		return false;
+	}
+
+	mQueued.erase(it);
+	mStates.erase(id);
+	--mStats.RequestsQueued;
+	return true;
+}
+
+void StreamingScheduler::Update()
+{
+	++mFrame;
+
+	RetireCompleted();
+	SubmitQueued();
+}
+
+void StreamingScheduler::RetireCompleted()
+{
+	const uint64_t completed = mBackend->CompletedValue();
+
+	// Fences complete in submission order.
+	while (!mInFlight.empty() && mInFlight.front().Fence <= completed)
+	{
+		Batch batch = move(mInFlight.front());
+		mInFlight.pop_front();
+
+		for (auto& request : batch.Requests)
+		{
+			// GetState reports untracked ids as Complete.
+			mStates.erase(request->Id);
+
+			mStats.BytesCompleted += request->ByteSize;
+			++mStats.RequestsCompleted;
+			--mStats.RequestsInFlight;
+			mStats.MaxLatency = max(mStats.MaxLatency, mFrame - request->EnqueueFrame);
+
+			if (request->OnComplete)
+			{
+				request->OnComplete();
+			}
+		}
+	}
+
+	mStats.BatchesInFlight = (uint32_t)mInFlight.size();
+}
+
+void StreamingScheduler::SubmitQueued()
+{
+	mStats.BytesSubmittedLastUpdate = 0;
+
+	if (mQueued.empty())
+	{
+		return;
+	}
+
+	if (mInFlight.size() >= mMaxBatchesInFlight)
+	{
+		++mStats.BatchLimitedUpdates;
+		return;
+	}
+
+	stable_sort(mQueued.begin(), mQueued.end(),
+		[](const unique_ptr<StreamRequest>& a, const unique_ptr<StreamRequest>& b)
+		{
+			if (a->Priority != b->Priority)
+			{
+				return a->Priority > b->Priority;
+			}
+			return a->Sequence < b->Sequence;
+		});
+
+	// Strict priority order: stop at the first request that does not fit rather
+	// than letting smaller, less important ones overtake it.
+	uint64_t bytes = 0;
+	size_t count = 0;
+	while (count < mQueued.size())
+	{
+		uint64_t size = mQueued[count]->ByteSize;
+		if (count > 0 && bytes + size > mBytesPerUpdate)
+		{
+			break;
+		}
+
+		bytes += size;
+		++count;
+
+		if (bytes >= mBytesPerUpdate)
+		{
+			break;
+		}
+	}
+
+	if (count < mQueued.size())
+	{
+		++mStats.BudgetLimitedUpdates;
+	}
+
+	Batch batch;
+	batch.Requests.reserve(count);
+	vector<const StreamRequest*> requests;
+	requests.reserve(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		requests.push_back(mQueued[i].get());
+		mStates[mQueued[i]->Id] = StreamState::InFlight;
+		batch.Requests.push_back(move(mQueued[i]));
+	}
+	mQueued.erase(mQueued.begin(), mQueued.begin() + count);
+
+	batch.Fence = mBackend->Submit(requests);
+	mInFlight.push_back(move(batch));
+
+	mStats.BytesSubmitted += bytes;
+	mStats.BytesSubmittedLastUpdate = bytes;
+	mStats.RequestsQueued -= (uint32_t)count;
+	mStats.RequestsInFlight += (uint32_t)count;
+	mStats.BatchesInFlight = (uint32_t)mInFlight.size();
+}
+
+void StreamingScheduler::Drain(const function<void()>& waitForBackend)
+{
+	while (!mQueued.empty() || !mInFlight.empty())
+	{
+		Update();
+
+		if (!mInFlight.empty())
+		{
+			waitForBackend();
+		}
+	}
+}
+
+StreamState StreamingScheduler::GetState(uint64_t id) const
+{
+	if (id == 0 || id >= mNextId)
+	{
+		return StreamState::Unknown;
+	}
+
+	auto it = mStates.find(id);
+	return it == mStates.end() ? StreamState::Complete : it->second;
+}
+
+uint64_t SimulatedCopyQueue::Submit(const vector<const StreamRequest*>& batch)
+{
+	PendingBatch pending;
+	pending.Fence = ++mNextFence;
+
+	for (auto request : batch)
+	{
+		pending.RemainingBytes += request->ByteSize;
+		SubmittedIds.push_back(request->Id);
+	}
+
+	mPending.push_back(pending);
+	return pending.Fence;
+}
+
+void SimulatedCopyQueue::Tick()
+{
+	uint64_t budget = mBytesPerTick;
+
+	while (!mPending.empty())
+	{
+		PendingBatch& batch = mPending.front();
+
+		uint64_t done = min(budget, batch.RemainingBytes);
+		batch.RemainingBytes -= done;
+		budget -= done;
+
+		if (batch.RemainingBytes > 0)
+		{
+			break;
+		}
+
+		mCompleted = batch.Fence;
+		mPending.pop_front();
+	}
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct StreamRequest
+{
+	uint64_t Id = 0;
+	// Higher goes first; equal priorities keep submission order.
+	int Priority = 0;
+	uint64_t ByteSize = 0;
+
+	// What to copy; only the backend looks inside.
+	shared_ptr<const void> Payload;
+
+	// Called from StreamingScheduler::Update once the copy has completed on the GPU.
+	function<void()> OnComplete;
+
+	uint64_t Sequence = 0;
+	uint64_t EnqueueFrame = 0;
+};
+
+// The queue the copies run on. The D3D12 implementation records them on a copy
+// queue; SimulatedCopyQueue models one for tests.
+class CopyQueueBackend
+{
+public:
+	virtual ~CopyQueueBackend() = default;
+
+	// Starts the copies of batch and returns the fence value that completes them.
+	// Values increase with every call.
+	virtual uint64_t Submit(const vector<const StreamRequest*>& batch) = 0;
+
+	virtual uint64_t CompletedValue() = 0;
+};
+
+enum class StreamState
+{
+	Unknown,
+	Queued,
+	InFlight,
+	Complete
+};
+
+struct StreamingStats
+{
+	uint64_t BytesSubmitted = 0;
+	uint64_t BytesCompleted = 0;
+	uint64_t BytesSubmittedLastUpdate = 0;
+	uint32_t RequestsQueued = 0;
+	uint32_t RequestsInFlight = 0;
+	uint64_t RequestsCompleted = 0;
+	uint32_t BatchesInFlight = 0;
+	// Updates that left requests queued because of the byte budget or the batch limit.
+	uint64_t BudgetLimitedUpdates = 0;
+	uint64_t BatchLimitedUpdates = 0;
+	// Updates between Enqueue and completion.
+	uint64_t MaxLatency = 0;
+};
+
+// Decides what is copied when: once per frame Update retires completed batches and
+// submits the most important queued requests that fit in the frame's byte budget.
+// A request larger than the budget goes alone in an otherwise empty frame.
+class StreamingScheduler
+{
+public:
+	StreamingScheduler(CopyQueueBackend* backend, uint64_t bytesPerUpdate, uint32_t maxBatchesInFlight = 3);
+	StreamingScheduler(const StreamingScheduler& rhs) = delete;
+	StreamingScheduler& operator=(const StreamingScheduler& rhs) = delete;
+
+	uint64_t Enqueue(int priority, uint64_t byteSize, shared_ptr<const void> payload, function<void()> onComplete = nullptr);
+
+	// Only requests that are still queued can be changed or cancelled.
+	bool SetPriority(uint64_t id, int priority);
+	bool Cancel(uint64_t id);
+
+	void Update();
+
+	// Blocks until everything queued has been submitted and completed; for loading
+	// screens and shutdown.
+	void Drain(const function<void()>& waitForBackend);
+
+	// Only queued and in-flight requests are tracked; any other id Enqueue returned
+	// reads as Complete, cancelled ones included.
+	StreamState GetState(uint64_t id) const;
+	const StreamingStats& Stats() const { return mStats; }
+
+	void SetBytesPerUpdate(uint64_t bytesPerUpdate) { mBytesPerUpdate = bytesPerUpdate; }
+
+private:
+	struct Batch
+	{
+		uint64_t Fence = 0;
+		vector<unique_ptr<StreamRequest>> Requests;
+	};
+
+	void RetireCompleted();
+	void SubmitQueued();
+
+private:
+	CopyQueueBackend* mBackend = nullptr;
+	uint64_t mBytesPerUpdate = 0;
+	uint32_t mMaxBatchesInFlight = 0;
+
+	uint64_t mNextId = 1;
+	uint64_t mNextSequence = 0;
+	uint64_t mFrame = 0;
+
+	vector<unique_ptr<StreamRequest>> mQueued;
+	deque<Batch> mInFlight;
+	// Queued and in-flight requests only, so it does not grow with every upload.
+	unordered_map<uint64_t, StreamState> mStates;
+
+	StreamingStats mStats;
+};
+
+// In-order queue that completes a fixed number of bytes per Tick. Batches finish
+// whole, like a fence signaled after the last copy of a command list.
+class SimulatedCopyQueue : public CopyQueueBackend
+{
+public:
+	explicit SimulatedCopyQueue(uint64_t bytesPerTick) : mBytesPerTick(bytesPerTick) {}
+
+	virtual uint64_t Submit(const vector<const StreamRequest*>& batch) override;
+	virtual uint64_t CompletedValue() override { return mCompleted; }
+
+	void Tick();
+
+	// Submission order of every request seen, for checking priorities.
+	vector<uint64_t> SubmittedIds;
+
+private:
+	struct PendingBatch
+	{
+		uint64_t Fence = 0;
+		uint64_t RemainingBytes = 0;
+	};
+
+	uint64_t mBytesPerTick = 0;
+	uint64_t mNextFence = 0;
+	uint64_t mCompleted = 0;
+	deque<PendingBatch> mPending;
+};
@@ -0,0 +1,490 @@
+#include "Terrain.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	int32_t FloorDiv2(int32_t v)
+	{
+		return (v >= 0) ? v / 2 : -((-v + 1) / 2);
+	}
+
+	TerrainNodeId Parent(const TerrainNodeId& id)
+	{
+		TerrainNodeId parent;
+		parent.X = FloorDiv2(id.X);
+		parent.Z = FloorDiv2(id.Z);
+		parent.Level = id.Level - 1;
+		return parent;
+	}
+}
+
+Terrain::Terrain(const TerrainSettings& settings, TerrainTileGenerator generator)
+	: mSettings(settings), mGenerator(move(generator))
+{
+	for (uint32_t i = 0; i < max(1u, mSettings.WorkerCount); ++i)
+	{
+		mWorkers.emplace_back(&Terrain::WorkerLoop, this);
+	}
+}
+
+Terrain::~Terrain()
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStop = true;
+		mQueue.clear();
+	}
+	mWake.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void Terrain::Update(const XMFLOAT3& eyePos, uint64_t frame)
+{
+	mLoadedTiles.clear();
+	mEvictedTiles.clear();
+
+	CollectFinished();
+	for (auto tile : mLoadedTiles)
+	{
+		const_cast<TerrainTile*>(tile)->LastUsedFrame = frame;
+	}
+
+	// What the camera wants, whether resident or not, drives the requests.
+	vector<TerrainNodeId> desired;
+	Select(eyePos, false, desired);
+	RequestMissing(eyePos, desired);
+
+	// What gets drawn only splits into resident children.
+	vector<TerrainNodeId> resident;
+	Select(eyePos, true, resident);
+
+	vector<TerrainDrawTile> drawTiles;
+	if (BuildDrawTiles(resident, drawTiles))
+	{
+		mDrawTiles = move(drawTiles);
+	}
+	else
+	{
+		++mStats.SelectionStalls;
+	}
+
+	for (auto& drawTile : mDrawTiles)
+	{
+		const_cast<TerrainTile*>(drawTile.Tile)->LastUsedFrame = frame;
+	}
+
+	for (auto& id : desired)
+	{
+		for (TerrainNodeId node = id; ; node = Parent(node))
+		{
+			auto it = mTiles.find(NodeKey(node));
+			if (it != mTiles.end())
+			{
+				it->second->LastUsedFrame = frame;
+			}
+
+			if (node.Level == 0)
+			{
+				break;
+			}
+		}
+	}
+
+	Evict(frame);
+}
+
+TerrainStats Terrain::Stats() const
+{
+	TerrainStats stats = mStats;
+	stats.ResidentTiles = (uint32_t)mTiles.size();
+	stats.DrawTiles = (uint32_t)mDrawTiles.size();
+
+	lock_guard<mutex> lock(mMutex);
+	stats.PendingTiles = (uint32_t)(mQueue.size() + mInFlight.size());
+	return stats;
+}
+
+void Terrain::WaitIdle()
+{
+	unique_lock<mutex> lock(mMutex);
+	mIdle.wait(lock, [this] { return mQueue.empty() && mBusyWorkers == 0; });
+}
+
+uint64_t Terrain::NodeKey(const TerrainNodeId& id)
+{
+	const uint64_t bias = 1ull << 29;
+	const uint64_t mask = (1ull << 30) - 1;
+
+	return ((uint64_t)id.Level << 60) |
+		((((uint64_t)(int64_t)id.X + bias) & mask) << 30) |
+		(((uint64_t)(int64_t)id.Z + bias) & mask);
+}
+
+vector<uint32_t> Terrain::BuildIndices(uint32_t resolution, uint32_t stitchMask)
+{
+	const uint32_t n = resolution;
+
+	// Odd vertices on a stitched edge collapse onto the even vertex before them;
+	// the triangles that touch them either degenerate or stretch along the edge.
+	auto index = [n, stitchMask](uint32_t i, uint32_t j) -> uint32_t
+		{
+			if ((stitchMask & TerrainEdgeMaxZ) && i == 0 && (j & 1))
+			{
+				--j;
+			}
+			if ((stitchMask & TerrainEdgeMinZ) && i == n - 1 && (j & 1))
+			{
+				--j;
+			}
+			if ((stitchMask & TerrainEdgeMinX) && j == 0 && (i & 1))
+			{
+				--i;
+			}
+			if ((stitchMask & TerrainEdgeMaxX) && j == n - 1 && (i & 1))
+			{
+				--i;
+			}
+			return i * n + j;
+		};
+
+	vector<uint32_t> indices;
+	indices.reserve((n - 1) * (n - 1) * 6);
+
+	auto addTriangle = [&indices](uint32_t a, uint32_t b, uint32_t c)
+		{
+			if (a != b && b != c && a != c)
+			{
+				indices.push_back(a);
+				indices.push_back(b);
+				indices.push_back(c);
+			}
+		};
+
+	// Same winding as GeometryGenerator::CreateGrid.
+	for (uint32_t i = 0; i < n - 1; ++i)
+	{
+		for (uint32_t j = 0; j < n - 1; ++j)
+		{
+			addTriangle(index(i, j), index(i, j + 1), index(i + 1, j));
+			addTriangle(index(i + 1, j), index(i, j + 1), index(i + 1, j + 1));
+		}
+	}
+
+	return indices;
+}
+
+TerrainTileGenerator Terrain::MakeRowGenerator(TerrainRowFunction rowFunction)
+{
+	return [rowFunction](TerrainTile& tile, uint32_t resolution)
+		{
+			const float step = tile.Size / (resolution - 1);
+
+			for (uint32_t i = 0; i < resolution; ++i)
+			{
+				float z = tile.MinZ + tile.Size - i * step;
+				rowFunction(tile.MinX, step, z, resolution,
+					tile.Heights.data() + (size_t)i * resolution,
+					tile.Normals.data() + (size_t)i * resolution);
+			}
+		};
+}
+
+float Terrain::NodeSize(uint32_t level) const
+{
+	return ldexpf(mSettings.RootSize, -(int)level);
+}
+
+void Terrain::InitTile(TerrainTile& tile, const TerrainNodeId& id) const
+{
+	tile.Id = id;
+	tile.Key = NodeKey(id);
+	tile.Size = NodeSize(id.Level);
+	tile.MinX = id.X * tile.Size;
+	tile.MinZ = id.Z * tile.Size;
+
+	const size_t vertexCount = (size_t)mSettings.Resolution * mSettings.Resolution;
+	tile.Heights.assign(vertexCount, 0.0f);
+	tile.Normals.assign(vertexCount, XMFLOAT3(0.0f, 1.0f, 0.0f));
+}
+
+bool Terrain::IsResident(const TerrainNodeId& id) const
+{
+	return mTiles.count(NodeKey(id)) != 0;
+}
+
+void Terrain::Select(const XMFLOAT3& eyePos, bool requireResident, vector<TerrainNodeId>& nodes) const
+{
+	const int32_t rootX = (int32_t)floorf(eyePos.x / mSettings.RootSize);
+	const int32_t rootZ = (int32_t)floorf(eyePos.z / mSettings.RootSize);
+
+	for (int dz = -mSettings.LoadRadius; dz <= mSettings.LoadRadius; ++dz)
+	{
+		for (int dx = -mSettings.LoadRadius; dx <= mSettings.LoadRadius; ++dx)
+		{
+			TerrainNodeId root;
+			root.X = rootX + dx;
+			root.Z = rootZ + dz;
+
+			if (requireResident && !IsResident(root))
+			{
+				continue;
+			}
+
+			SelectNode(eyePos, root, requireResident, nodes);
+		}
+	}
+}
+
+void Terrain::SelectNode(const XMFLOAT3& eyePos, const TerrainNodeId& id, bool requireResident, vector<TerrainNodeId>& nodes) const
+{
+	const float size = NodeSize(id.Level);
+	const float cx = (id.X + 0.5f) * size - eyePos.x;
+	const float cz = (id.Z + 0.5f) * size - eyePos.z;
+	const float distance = sqrtf(cx * cx + eyePos.y * eyePos.y + cz * cz);
+
+	TerrainNodeId children[4];
+	for (int c = 0; c < 4; ++c)
+	{
+		children[c].X = id.X * 2 + (c & 1);
+		children[c].Z = id.Z * 2 + (c >> 1);
+		children[c].Level = id.Level + 1;
+	}
+
+	bool split = id.Level < mSettings.MaxLevel && distance < mSettings.SplitDistance * size;
+
+	if (split && requireResident)
+	{
+		for (auto& child : children)
+		{
+			split = split && IsResident(child);
+		}
+	}
+
+	if (!split)
+	{
+		nodes.push_back(id);
+		return;
+	}
+
+	for (auto& child : children)
+	{
+		SelectNode(eyePos, child, requireResident, nodes);
+	}
+}
+
+bool Terrain::BuildDrawTiles(const vector<TerrainNodeId>& nodes, vector<TerrainDrawTile>& drawTiles) const
+{
+	unordered_set<uint64_t> selected;
+	for (auto& id : nodes)
+	{
+		selected.insert(NodeKey(id));
+	}
+
+	const int32_t offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	const uint32_t edges[4] = { TerrainEdgeMinX, TerrainEdgeMaxX, TerrainEdgeMinZ, TerrainEdgeMaxZ };
+
+	drawTiles.clear();
+	drawTiles.reserve(nodes.size());
+
+	for (auto& id : nodes)
+	{
+		auto it = mTiles.find(NodeKey(id));
+		if (it == mTiles.end())
+		{
+			return false;
+		}
+
+		TerrainDrawTile drawTile;
+		drawTile.Tile = it->second.get();
+
+		for (int side = 0; side < 4; ++side)
+		{
+			TerrainNodeId neighbor = id;
+			neighbor.X += offsets[side][0];
+			neighbor.Z += offsets[side][1];
+
+			// A selected parent of the neighbour means one level coarser, which the
+			// stitch handles; any further ancestor would leave a crack.
+			TerrainNodeId ancestor = neighbor;
+			for (uint32_t up = 1; up <= id.Level; ++up)
+			{
+				ancestor = Parent(ancestor);
+				if (selected.count(NodeKey(ancestor)))
+				{
+					if (up > 1)
+					{
+						return false;
+					}
+					drawTile.StitchMask |= edges[side];
+					break;
+				}
+			}
+		}
+
+		drawTiles.push_back(drawTile);
+	}
+
+	return true;
+}
+
+void Terrain::RequestMissing(const XMFLOAT3& eyePos, const vector<TerrainNodeId>& nodes)
+{
+	// Drawing a node needs every ancestor resident as well.
+	unordered_set<uint64_t> seen;
+	vector<TerrainNodeId> missing;
+
+	for (auto& id : nodes)
+	{
+		for (TerrainNodeId node = id; ; node = Parent(node))
+		{
+			uint64_t key = NodeKey(node);
+			if (!seen.insert(key).second)
+			{
+				break;
+			}
+
+			if (!mTiles.count(key))
+			{
+				missing.push_back(node);
+			}
+
+			if (node.Level == 0)
+			{
+				break;
+			}
+		}
+	}
+
+	// Coarse levels first, nearest first within a level.
+	auto distanceSq = [this, &eyePos](const TerrainNodeId& id)
+		{
+			float size = NodeSize(id.Level);
+			float dx = (id.X + 0.5f) * size - eyePos.x;
+			float dz = (id.Z + 0.5f) * size - eyePos.z;
+			return dx * dx + dz * dz;
+		};
+
+	sort(missing.begin(), missing.end(), [&](const TerrainNodeId& a, const TerrainNodeId& b)
+		{
+			if (a.Level != b.Level)
+			{
+				return a.Level < b.Level;
+			}
+			return distanceSq(a) < distanceSq(b);
+		});
+
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		// Requests the camera no longer needs are dropped before they start.
+		mQueue.clear();
+		for (auto& id : missing)
+		{
+			if (!mInFlight.count(NodeKey(id)))
+			{
+				mQueue.push_back(id);
+			}
+		}
+	}
+	mWake.notify_all();
+}
+
+void Terrain::CollectFinished()
+{
+	vector<unique_ptr<TerrainTile>> finished;
+	{
+		lock_guard<mutex> lock(mMutex);
+		finished.swap(mFinished);
+		for (auto& tile : finished)
+		{
+			mInFlight.erase(tile->Key);
+		}
+	}
+
+	for (auto& tile : finished)
+	{
+		if (mTiles.count(tile->Key))
+		{
+			continue;
+		}
+
+		++mStats.TilesGenerated;
+		mLoadedTiles.push_back(tile.get());
+		mTiles[tile->Key] = move(tile);
+	}
+}
+
+void Terrain::Evict(uint64_t frame)
+{
+	if (mTiles.size() <= mSettings.MaxResidentTiles)
+	{
+		return;
+	}
+
+	// Tiles touched this frame, which includes everything drawn, stay.
+	vector<TerrainTile*> candidates;
+	for (auto& e : mTiles)
+	{
+		if (e.second->LastUsedFrame < frame)
+		{
+			candidates.push_back(e.second.get());
+		}
+	}
+
+	sort(candidates.begin(), candidates.end(), [](const TerrainTile* a, const TerrainTile* b)
+		{
+			return a->LastUsedFrame < b->LastUsedFrame;
+		});
+
+	size_t excess = mTiles.size() - mSettings.MaxResidentTiles;
+	for (size_t i = 0; i < candidates.size() && i < excess; ++i)
+	{
+		uint64_t key = candidates[i]->Key;
+		mEvictedTiles.push_back(key);
+		mTiles.erase(key);
+		++mStats.TilesEvicted;
+	}
+}
+
+void Terrain::WorkerLoop()
+{
+	unique_lock<mutex> lock(mMutex);
+	for (;;)
+	{
+		mWake.wait(lock, [this] { return mStop || !mQueue.empty(); });
+		if (mStop)
+		{
+			return;
+		}
+
+		TerrainNodeId id = mQueue.front();
+		mQueue.pop_front();
+		mInFlight.insert(NodeKey(id));
+		++mBusyWorkers;
+
+		lock.unlock();
+
+		auto tile = make_unique<TerrainTile>();
+		InitTile(*tile, id);
+		mGenerator(*tile, mSettings.Resolution);
+
+		auto range = minmax_element(tile->Heights.begin(), tile->Heights.end());
+		tile->MinY = *range.first;
+		tile->MaxY = *range.second;
+
+		lock.lock();
+
+		mFinished.push_back(move(tile));
+		--mBusyWorkers;
+
+		if (mBusyWorkers == 0 && mQueue.empty())
+		{
+			mIdle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace std;
+using namespace DirectX;
+
+struct TerrainSettings
+{
+	// Edge length of a level 0 node. Level l nodes are RootSize / 2^l wide.
+	float RootSize = 2048.0f;
+	uint32_t MaxLevel = 4;
+
+	// Vertices per tile edge; must be 2^k + 1 so coarser edges land on even vertices.
+	uint32_t Resolution = 65;
+
+	// Roots kept around the camera, in roots on each side of the one it is over.
+	int LoadRadius = 2;
+
+	// A node splits while the camera is closer to its centre than SplitDistance
+	// node sizes. Anything above 1.6 keeps neighbouring tiles within one level.
+	float SplitDistance = 2.5f;
+
+	uint32_t MaxResidentTiles = 1024;
+	uint32_t WorkerCount = 2;
+};
+
+struct TerrainNodeId
+{
+	int32_t X = 0;
+	int32_t Z = 0;
+	uint32_t Level = 0;
+};
+
+// Heights and normals of one node, Resolution x Resolution vertices in
+// GeometryGenerator::CreateGrid order: row i at z = MinZ + Size - i * step,
+// column j at x = MinX + j * step.
+struct TerrainTile
+{
+	TerrainNodeId Id;
+	uint64_t Key = 0;
+
+	float MinX = 0.0f;
+	float MinZ = 0.0f;
+	float Size = 0.0f;
+	float MinY = 0.0f;
+	float MaxY = 0.0f;
+
+	vector<float> Heights;
+	vector<XMFLOAT3> Normals;
+
+	uint64_t LastUsedFrame = 0;
+};
+
+// Bits of TerrainDrawTile::StitchMask: the neighbour on that side is one level
+// coarser, so the odd vertices of that edge must not be used.
+enum TerrainEdge : uint32_t
+{
+	TerrainEdgeMinX = 1 << 0,
+	TerrainEdgeMaxX = 1 << 1,
+	TerrainEdgeMinZ = 1 << 2,
+	TerrainEdgeMaxZ = 1 << 3,
+	TerrainEdgeCount = 16,
+};
+
+struct TerrainDrawTile
+{
+	const TerrainTile* Tile = nullptr;
+	uint32_t StitchMask = 0;
+};
+
+struct TerrainStats
+{
+	uint32_t ResidentTiles = 0;
+	uint32_t PendingTiles = 0;
+	uint32_t DrawTiles = 0;
+	uint64_t TilesGenerated = 0;
+	uint64_t TilesEvicted = 0;
+	// Updates that kept the previous selection because no balanced one was resident.
+	uint64_t SelectionStalls = 0;
+};
+
+// Fills tile.Heights and tile.Normals. Called on worker threads.
+typedef function<void(TerrainTile& tile, uint32_t resolution)> TerrainTileGenerator;
+typedef function<void(float x0, float dx, float z, uint32_t count, float* heights, XMFLOAT3* normals)> TerrainRowFunction;
+
+// Quadtree terrain over an unbounded grid of roots. Tiles are generated on worker
+// threads around the camera; the selection that is drawn only ever contains
+// resident tiles whose neighbours differ by at most one level, so the stitch
+// masks close every crack.
+class Terrain
+{
+public:
+	Terrain(const TerrainSettings& settings, TerrainTileGenerator generator);
+	Terrain(const Terrain& rhs) = delete;
+	Terrain& operator=(const Terrain& rhs) = delete;
+	~Terrain();
+
+	void Update(const XMFLOAT3& eyePos, uint64_t frame);
+
+	const vector<TerrainDrawTile>& DrawTiles() const { return mDrawTiles; }
+
+	// Changes made by the last Update, for whoever mirrors tiles on the GPU.
+	const vector<const TerrainTile*>& LoadedTiles() const { return mLoadedTiles; }
+	const vector<uint64_t>& EvictedTiles() const { return mEvictedTiles; }
+
+	const TerrainSettings& Settings() const { return mSettings; }
+	TerrainStats Stats() const;
+
+	// Blocks until nothing is queued or being generated.
+	void WaitIdle();
+
+	static uint64_t NodeKey(const TerrainNodeId& id);
+
+	// Triangle list over a Resolution x Resolution tile with the edges in
+	// stitchMask snapped to every other vertex.
+	static vector<uint32_t> BuildIndices(uint32_t resolution, uint32_t stitchMask);
+
+	static TerrainTileGenerator MakeRowGenerator(TerrainRowFunction rowFunction);
+
+private:
+	float NodeSize(uint32_t level) const;
+	void InitTile(TerrainTile& tile, const TerrainNodeId& id) const;
+	bool IsResident(const TerrainNodeId& id) const;
+
+	void Select(const XMFLOAT3& eyePos, bool requireResident, vector<TerrainNodeId>& nodes) const;
+	void SelectNode(const XMFLOAT3& eyePos, const TerrainNodeId& id, bool requireResident, vector<TerrainNodeId>& nodes) const;
+	bool BuildDrawTiles(const vector<TerrainNodeId>& nodes, vector<TerrainDrawTile>& drawTiles) const;
+
+	void RequestMissing(const XMFLOAT3& eyePos, const vector<TerrainNodeId>& nodes);
+	void CollectFinished();
+	void Evict(uint64_t frame);
+
+	void WorkerLoop();
+
+private:
+	TerrainSettings mSettings;
+	TerrainTileGenerator mGenerator;
+
+	unordered_map<uint64_t, unique_ptr<TerrainTile>> mTiles;
+	unordered_set<uint64_t> mInFlight;
+
+	vector<TerrainDrawTile> mDrawTiles;
+	vector<const TerrainTile*> mLoadedTiles;
+	vector<uint64_t> mEvictedTiles;
+
+	TerrainStats mStats;
+
+	vector<thread> mWorkers;
+	mutable mutex mMutex;
+	condition_variable mWake;
+	condition_variable mIdle;
+	deque<TerrainNodeId> mQueue;
+	vector<unique_ptr<TerrainTile>> mFinished;
+	uint32_t mBusyWorkers = 0;
+	bool mStop = false;
+};
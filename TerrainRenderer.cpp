@@ -0,0 +1,210 @@
+#include "TerrainRenderer.h"
+
+void TerrainRenderer::Build(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const TerrainSettings& settings)
+{
+	mResolution = settings.Resolution;
+
+	vector<uint32_t> indices;
+
+	mIndices = make_unique<MeshGeometry>();
+	mIndices->Name = "terrainIndices";
+
+	for (uint32_t mask = 0; mask < TerrainEdgeCount; ++mask)
+	{
+		auto variant = Terrain::BuildIndices(mResolution, mask);
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = (UINT)variant.size();
+		submesh.StartIndexLocation = (UINT)indices.size();
+		submesh.BaseVertexLocation = 0;
+		mIndices->DrawArgs[to_string(mask)] = submesh;
+
+		indices.insert(indices.end(), variant.begin(), variant.end());
+	}
+
+	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint32_t);
+
+	if (mBatcher != nullptr)
+	{
+		mIndices->IndexBufferGPU = mBatcher->CreateBuffer(indices.data(), ibByteSize);
+	}
+	else
+	{
+		mIndices->IndexBufferGPU = D3DUtil::CreateDefaultBuffer(
+			device,
+			cmdList,
+			indices.data(),
+			ibByteSize,
+			mIndices->IndexBufferUploader);
+	}
+
+	mIndices->IndexFormat = DXGI_FORMAT_R32_UINT;
+	mIndices->IndexBufferByteSize = ibByteSize;
+}
+
+void TerrainRenderer::Update(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const Terrain& terrain,
+	UINT64 fenceValue,
+	UINT64 completedFenceValue)
+{
+	for (auto key : terrain.EvictedTiles())
+	{
+		auto it = mTileBuffers.find(key);
+		if (it == mTileBuffers.end())
+		{
+			continue;
+		}
+
+		// Earlier frames may still draw from it.
+		RetiredBuffer retired;
+		retired.Resource = it->second.VertexBuffer;
+		retired.Fence = fenceValue;
+		mRetired.push_back(retired);
+
+		mTileBuffers.erase(it);
+	}
+
+	for (auto tile : terrain.LoadedTiles())
+	{
+		UploadTile(device, cmdList, *tile, fenceValue);
+	}
+
+	for (auto& e : mTileBuffers)
+	{
+		if (e.second.Uploader != nullptr && e.second.UploadFence <= completedFenceValue)
+		{
+			e.second.Uploader = nullptr;
+		}
+	}
+
+	mRetired.erase(
+		remove_if(mRetired.begin(), mRetired.end(), [completedFenceValue](const RetiredBuffer& r)
+			{
+				return r.Fence <= completedFenceValue;
+			}),
+		mRetired.end());
+
+	mDrawTiles = terrain.DrawTiles();
+}
+
+void TerrainRenderer::Cull(const Camera& camera, FrustumCulling& culler)
+{
+	mTileBounds.clear();
+	mVisibleIndices.clear();
+
+	for (auto& drawTile : mDrawTiles)
+	{
+		auto tile = drawTile.Tile;
+
+		BoundingBox bounds;
+		bounds.Center = XMFLOAT3(
+			tile->MinX + 0.5f * tile->Size,
+			0.5f * (tile->MinY + tile->MaxY),
+			tile->MinZ + 0.5f * tile->Size);
+		bounds.Extents = XMFLOAT3(
+			0.5f * tile->Size,
+			0.5f * (tile->MaxY - tile->MinY),
+			0.5f * tile->Size);
+
+		mTileBounds.push_back(bounds);
+	}
+
+	culler.UpdateCameraFrustum(camera);
+	mCullingCounters.Reset();
+	culler.CullBounds(camera, mTileBounds, mVisibleIndices, &mCullingCounters);
+}
+
+void TerrainRenderer::Draw(ID3D12GraphicsCommandList* cmdList)
+{
+	auto ibv = mIndices->IndexBufferView();
+	cmdList->IASetIndexBuffer(&ibv);
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	const UINT vertexCount = mResolution * mResolution;
+
+	for (UINT index : mVisibleIndices)
+	{
+		auto& drawTile = mDrawTiles[index];
+
+		auto it = mTileBuffers.find(drawTile.Tile->Key);
+		if (it == mTileBuffers.end())
+		{
+			continue;
+		}
+
+		D3D12_VERTEX_BUFFER_VIEW vbv;
+		vbv.BufferLocation = it->second.VertexBuffer->GetGPUVirtualAddress();
+		vbv.StrideInBytes = sizeof(Vertex);
+		vbv.SizeInBytes = vertexCount * sizeof(Vertex);
+		cmdList->IASetVertexBuffers(0, 1, &vbv);
+
+		auto& submesh = mIndices->DrawArgs[to_string(drawTile.StitchMask)];
+		cmdList->DrawIndexedInstanced(submesh.IndexCount, 1, submesh.StartIndexLocation, 0, 0);
+	}
+}
+
+void TerrainRenderer::UploadTile(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const TerrainTile& tile, UINT64 fenceValue)
+{
+	const UINT n = mResolution;
+	const float step = tile.Size / (n - 1);
+	const UINT64 vbByteSize = (UINT64)n * n * sizeof(Vertex);
+
+	vector<Vertex> stagingVertices;
+	UploadAllocation allocation;
+	Vertex* vertices = nullptr;
+
+	if (mBatcher != nullptr)
+	{
+		allocation = mBatcher->Allocate(vbByteSize);
+		vertices = reinterpret_cast<Vertex*>(allocation.CpuAddress);
+	}
+	else
+	{
+		stagingVertices.resize(n * n);
+		vertices = stagingVertices.data();
+	}
+
+	for (UINT i = 0; i < n; ++i)
+	{
+		for (UINT j = 0; j < n; ++j)
+		{
+			UINT k = i * n + j;
+
+			Vertex v;
+			v.Pos = XMFLOAT3(tile.MinX + j * step, tile.Heights[k], tile.MinZ + tile.Size - i * step);
+			v.Normal = tile.Normals[k];
+			v.TexC = XMFLOAT2((float)j / (n - 1), (float)i / (n - 1));
+			vertices[k] = v;
+		}
+	}
+
+	TileBuffer buffer;
+	if (mBatcher != nullptr)
+	{
+		CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
+		ThrowIfFailed(device->CreateCommittedResource(
+			&heapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&resourceDesc,
+			D3D12_RESOURCE_STATE_COMMON,
+			nullptr,
+			IID_PPV_ARGS(buffer.VertexBuffer.GetAddressOf())));
+
+		mBatcher->CopyBuffer(buffer.VertexBuffer.Get(), 0, allocation, 0, vbByteSize);
+	}
+	else
+	{
+		buffer.VertexBuffer = D3DUtil::CreateDefaultBuffer(
+			device,
+			cmdList,
+			vertices,
+			vbByteSize,
+			buffer.Uploader);
+		buffer.UploadFence = fenceValue;
+	}
+
+	mTileBuffers[tile.Key] = buffer;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "D3DUtil.h"
+#include "FrameResource.h"
+#include "FrustumCulling.h"
+#include "Terrain.h"
+#include "UploadBatcher.h"
+
+// GPU side of Terrain: one vertex buffer per resident tile, one shared index
+// buffer holding a variant per stitch mask, and per-frame culling of the drawn
+// tiles' bounds.
+class TerrainRenderer
+{
+public:
+	void Build(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const TerrainSettings& settings);
+
+	// Set before Build. Tile vertices are then written straight into the batcher's upload pages and
+	// copied by its Flush instead of through a committed uploader per tile.
+	void SetUploadBatcher(UploadBatcher* batcher) { mBatcher = batcher; }
+
+	// Uploads tiles the last Terrain::Update loaded and retires evicted ones.
+	// Copies are recorded on cmdList, which signals fenceValue when done.
+	void Update(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const Terrain& terrain,
+		UINT64 fenceValue,
+		UINT64 completedFenceValue);
+
+	// Builds the world bounds of every drawn tile and keeps the visible ones.
+	void Cull(const Camera& camera, FrustumCulling& culler);
+
+	// Caller sets the pipeline state and root parameters.
+	void Draw(ID3D12GraphicsCommandList* cmdList);
+
+	const vector<BoundingBox>& TileBounds() const { return mTileBounds; }
+	UINT VisibleTileCount() const { return (UINT)mVisibleIndices.size(); }
+	// Of the last Cull, in the same form as the GPU culler's.
+	const CullingCounters& TileCullingCounters() const { return mCullingCounters; }
+
+private:
+	struct TileBuffer
+	{
+		ComPtr<ID3D12Resource> VertexBuffer;
+		ComPtr<ID3D12Resource> Uploader;
+		UINT64 UploadFence = 0;
+	};
+
+	struct RetiredBuffer
+	{
+		ComPtr<ID3D12Resource> Resource;
+		UINT64 Fence = 0;
+	};
+
+	void UploadTile(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const TerrainTile& tile, UINT64 fenceValue);
+
+private:
+	UINT mResolution = 0;
+	UploadBatcher* mBatcher = nullptr;
+
+	unique_ptr<MeshGeometry> mIndices;
+	unordered_map<uint64_t, TileBuffer> mTileBuffers;
+	vector<RetiredBuffer> mRetired;
+
+	vector<TerrainDrawTile> mDrawTiles;
+	vector<BoundingBox> mTileBounds;
+	vector<UINT> mVisibleIndices;
+	CullingCounters mCullingCounters;
+};
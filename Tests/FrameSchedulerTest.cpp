@@ -0,0 +1,156 @@
+// Drives FrameScheduler with SimulatedFrameFence playing the GPU: slots rotate,
+// WaitForSlot waits only for the fence of the slot being reused, and frames whose
+// slot the GPU already finished go ahead without waiting. Standalone; it is not
+// part of the app project and needs no device.
+//
+//   cl /std:c++17 /EHsc /I.. FrameSchedulerTest.cpp ../FrameScheduler.cpp
+//   g++ -std=c++17 -I.. FrameSchedulerTest.cpp ../FrameScheduler.cpp
+
+#include "FrameScheduler.h"
+#include "TestUtil.h"
+
+namespace
+{
+	void TestSlotRotation()
+	{
+		SimulatedFrameFence fence;
+		FrameScheduler scheduler(&fence, 3);
+		CHECK(scheduler.FramesInFlight() == 3);
+
+		for (uint32_t frame = 1; frame <= 7; ++frame)
+		{
+			CHECK(scheduler.BeginFrame() == (frame - 1) % 3);
+			CHECK(scheduler.CurrentSlot() == (frame - 1) % 3);
+			CHECK(scheduler.CurrentFrame() == frame);
+			scheduler.WaitForSlot();
+			scheduler.EndFrame(frame);
+			fence.Complete(frame);
+		}
+
+		FrameScheduler single(&fence, 0);
+		CHECK(single.FramesInFlight() == 1);
+		CHECK(single.BeginFrame() == 0 && single.BeginFrame() == 0);
+
+		FrameScheduler clamped(&fence, MaxFramesInFlight + 4);
+		CHECK(clamped.FramesInFlight() == MaxFramesInFlight);
+	}
+
+	void TestWaitsOnReusedSlotOnly()
+	{
+		SimulatedFrameFence fence;
+		FrameScheduler scheduler(&fence, 3);
+
+		// The first three frames get fresh slots, nothing to wait for even though
+		// the GPU has not finished anything.
+		for (uint64_t frame = 1; frame <= 3; ++frame)
+		{
+			scheduler.BeginFrame();
+			CHECK(scheduler.WaitForSlot() == 0.0);
+			scheduler.EndFrame(10 * frame);
+		}
+		CHECK(fence.Waits.empty());
+		CHECK(scheduler.Stats().BlockedFrames == 0);
+
+		// Frame 4 reuses slot 0 and waits for frame 1's fence, not the latest.
+		CHECK(scheduler.BeginFrame() == 0);
+		scheduler.WaitForSlot();
+		CHECK((fence.Waits == vector<uint64_t>{ 10 }));
+		CHECK(fence.CompletedValue() == 10);
+		CHECK(scheduler.Stats().BlockedFrames == 1);
+		scheduler.EndFrame(40);
+
+		// The GPU finished frame 2 exactly; frame 5 goes ahead.
+		fence.Complete(20);
+		CHECK(scheduler.BeginFrame() == 1);
+		CHECK(scheduler.WaitForSlot() == 0.0);
+		CHECK(fence.Waits.size() == 1);
+		scheduler.EndFrame(50);
+
+		// Frame 6 waits on slot 2's fence only.
+		CHECK(scheduler.BeginFrame() == 2);
+		scheduler.WaitForSlot();
+		CHECK((fence.Waits == vector<uint64_t>{ 10, 30 }));
+		scheduler.EndFrame(60);
+
+		CHECK(scheduler.Stats().Frames == 6);
+		CHECK(scheduler.Stats().BlockedFrames == 2);
+		CHECK(scheduler.Stats().TotalBlockedMs >= scheduler.Stats().MaxBlockedMs);
+
+		scheduler.WaitForIdle();
+		CHECK(fence.Waits.back() == 60 && fence.CompletedValue() == 60);
+	}
+
+	void TestCompletedAheadDoesNotWait()
+	{
+		SimulatedFrameFence fence;
+		FrameScheduler scheduler(&fence, 2);
+
+		// A GPU that keeps up never makes the CPU wait, whatever the slot.
+		for (uint64_t frame = 1; frame <= 20; ++frame)
+		{
+			scheduler.BeginFrame();
+			CHECK(scheduler.WaitForSlot() == 0.0);
+			scheduler.EndFrame(frame);
+
+			// Fence values may run ahead of the frame count, e.g. with extra signals.
+			fence.Complete(frame + 5);
+		}
+		CHECK(fence.Waits.empty());
+		CHECK(scheduler.Stats().BlockedFrames == 0);
+		CHECK(scheduler.Stats().TotalBlockedMs == 0.0);
+		CHECK(scheduler.Stats().P99BlockedMs == 0.0);
+
+		scheduler.WaitForIdle();
+		CHECK(fence.Waits.empty());
+	}
+
+	void TestGpuOneFrameBehind()
+	{
+		SimulatedFrameFence fence;
+		FrameScheduler scheduler(&fence, 2);
+
+		// The GPU finishes each frame one frame late, so with two slots every
+		// reused slot is already done.
+		for (uint64_t frame = 1; frame <= 10; ++frame)
+		{
+			scheduler.BeginFrame();
+			scheduler.WaitForSlot();
+			scheduler.EndFrame(frame);
+			if (frame > 1)
+			{
+				fence.Complete(frame - 1);
+			}
+		}
+		CHECK(fence.Waits.empty());
+
+		// Two frames late: every reused slot has to wait for exactly its own frame.
+		SimulatedFrameFence slowFence;
+		FrameScheduler slow(&slowFence, 2);
+		vector<uint64_t> expected;
+		for (uint64_t frame = 1; frame <= 10; ++frame)
+		{
+			slow.BeginFrame();
+			slow.WaitForSlot();
+			slow.EndFrame(frame);
+			if (frame > 2)
+			{
+				expected.push_back(frame - 2);
+			}
+			if (frame > 3)
+			{
+				slowFence.Complete(frame - 3);
+			}
+		}
+		CHECK(slowFence.Waits == expected);
+		CHECK(slow.Stats().BlockedFrames == expected.size());
+	}
+}
+
+int main()
+{
+	TestSlotRotation();
+	TestWaitsOnReusedSlotOnly();
+	TestCompletedAheadDoesNotWait();
+	TestGpuOneFrameBehind();
+	return TestResult();
+}
@@ -0,0 +1,143 @@
+// Checks GpuProfiler's query layout and the conversion of synthetic timestamps into
+// Profiler samples. Standalone; it is not part of the app project and needs no
+// device.
+//
+//   cl /std:c++17 /EHsc /I.. GpuProfilerTest.cpp ../GpuProfiler.cpp ../Profiler.cpp
+//   g++ -std=c++17 -pthread -I.. GpuProfilerTest.cpp ../GpuProfiler.cpp ../Profiler.cpp
+
+#include "GpuProfiler.h"
+#include "TestUtil.h"
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+	bool Near(double a, double b)
+	{
+		return fabs(a - b) < 1e-6;
+	}
+
+	void TestQueryLayout()
+	{
+		Profiler profiler;
+		GpuProfiler gpu(&profiler, 3, 4);
+
+		auto culling = gpu.AddScope("culling", PassQueue::Compute);
+		auto opaque = gpu.AddScope("opaque", PassQueue::Graphics);
+		auto executeIndirect = gpu.AddScope("executeIndirect", PassQueue::Graphics);
+
+		CHECK(gpu.AddScope("opaque", PassQueue::Graphics) == opaque);
+		CHECK(gpu.AddScope("opaque", PassQueue::Compute) != opaque);
+		CHECK(gpu.ScopeQueue(culling) == PassQueue::Compute);
+
+		CHECK(gpu.QueriesPerSlot() == 8);
+		CHECK(gpu.HeapQueryCount() == 24);
+		CHECK(gpu.QueryCount(PassQueue::Graphics) == 4);
+		CHECK(gpu.QueryCount(PassQueue::Compute) == 4);
+
+		// Scopes are numbered per queue, two queries each, in the slot's range.
+		CHECK(gpu.BeginQuery(0, culling) == 0);
+		CHECK(gpu.BeginQuery(0, opaque) == 0);
+		CHECK(gpu.BeginQuery(1, executeIndirect) == 10);
+		CHECK(gpu.EndQuery(1, executeIndirect) == 11);
+		CHECK(gpu.FirstQuery(2) == 16);
+	}
+
+	void TestResolve()
+	{
+		Profiler profiler;
+		GpuProfiler gpu(&profiler, 2, 4);
+
+		auto culling = gpu.AddScope("culling", PassQueue::Compute);
+		auto opaque = gpu.AddScope("opaque", PassQueue::Graphics);
+		auto executeIndirect = gpu.AddScope("executeIndirect", PassQueue::Graphics);
+
+		const uint32_t opaqueStats = profiler.RegisterScope("opaque", ProfileTrack::GpuGraphics);
+		const uint32_t executeIndirectStats = profiler.RegisterScope("executeIndirect", ProfileTrack::GpuGraphics);
+		const uint32_t cullingStats = profiler.RegisterScope("culling", ProfileTrack::GpuCompute);
+
+		// Nothing is resolved before the queue is calibrated.
+		const uint64_t early[4] = { 0, 100, 0, 0 };
+		gpu.BeginFrame(0, 0);
+		gpu.MarkWritten(0, opaque);
+		gpu.Resolve(0, PassQueue::Graphics, early);
+		CHECK(profiler.Stats(opaqueStats).Samples == 0);
+
+		// One tick is a microsecond; timestamp 5000000 is at 100 ms on the CPU clock.
+		gpu.SetCalibration(PassQueue::Graphics, 1000000, 5000000, 100.0);
+		gpu.SetCalibration(PassQueue::Compute, 1000000, 5000000, 100.0);
+
+		for (uint64_t frame = 1; frame <= 10; ++frame)
+		{
+			const uint32_t slot = frame % 2;
+			gpu.BeginFrame(slot, frame);
+			CHECK(gpu.HasResults(slot));
+
+			gpu.MarkWritten(slot, culling);
+			gpu.MarkWritten(slot, opaque);
+			// Frame 5 skips ExecuteIndirect; its stale queries must not count.
+			if (frame != 5)
+			{
+				gpu.MarkWritten(slot, executeIndirect);
+			}
+
+			const uint64_t base = 5000000 + frame * 16000;
+			const uint64_t graphics[4] = { base + 2000, base + 2000 + frame * 1000, base + 2500, base + 4500 };
+			const uint64_t compute[2] = { base, base + 1500 };
+
+			gpu.Resolve(slot, PassQueue::Graphics, graphics);
+			gpu.Resolve(slot, PassQueue::Compute, compute);
+		}
+
+		const ProfileScopeStats opaqueResult = profiler.Stats(opaqueStats);
+		CHECK(opaqueResult.Samples == 10);
+		CHECK(Near(opaqueResult.LastMs, 10.0));
+		CHECK(Near(opaqueResult.MaxMs, 10.0));
+		CHECK(Near(opaqueResult.AverageMs, 5.5));
+		CHECK(Near(opaqueResult.P50Ms, 6.0));
+
+		const ProfileScopeStats executeIndirectResult = profiler.Stats(executeIndirectStats);
+		CHECK(executeIndirectResult.Samples == 9);
+		CHECK(Near(executeIndirectResult.AverageMs, 2.0));
+
+		CHECK(profiler.Stats(cullingStats).Samples == 10);
+		CHECK(Near(profiler.Stats(cullingStats).AverageMs, 1.5));
+
+		// The queue's frame spans from the first begin to the last end.
+		const ProfileScopeStats total = profiler.Stats(gpu.TotalScope(PassQueue::Graphics));
+		CHECK(total.Samples == 10);
+		CHECK(Near(total.LastMs, 10.0));
+		CHECK(Near(profiler.Stats(gpu.TotalScope(PassQueue::Compute)).LastMs, 1.5));
+
+		// Samples are placed on the CPU clock through the calibration.
+		ostringstream trace;
+		profiler.WriteTrace(trace);
+		CHECK(trace.str().find("\"name\":\"opaque\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":262000.000,\"dur\":10000.000") != string::npos);
+		CHECK(trace.str().find("\"name\":\"culling\",\"ph\":\"X\",\"pid\":0,\"tid\":1,\"ts\":260000.000") != string::npos);
+	}
+
+	void TestInvertedTimestamps()
+	{
+		Profiler profiler;
+		GpuProfiler gpu(&profiler, 1, 4);
+		auto opaque = gpu.AddScope("opaque", PassQueue::Graphics);
+		gpu.SetCalibration(PassQueue::Graphics, 1000000, 0, 0.0);
+
+		// An end before its begin is a torn or unwritten pair and is dropped.
+		const uint64_t timestamps[2] = { 5000, 4000 };
+		gpu.BeginFrame(0, 1);
+		gpu.MarkWritten(0, opaque);
+		gpu.Resolve(0, PassQueue::Graphics, timestamps);
+
+		CHECK(profiler.Stats(profiler.RegisterScope("opaque", ProfileTrack::GpuGraphics)).Samples == 0);
+		CHECK(profiler.Stats(gpu.TotalScope(PassQueue::Graphics)).Samples == 0);
+	}
+}
+
+int main()
+{
+	TestQueryLayout();
+	TestResolve();
+	TestInvertedTimestamps();
+	return TestResult();
+}
@@ -0,0 +1,175 @@
+// Runs LandTessellationAnalyzer over a camera path across a MakeGridPatches grid,
+// prints the report and checks that the cap from FindMaxTessFactor keeps every
+// frame within the triangle budget. Also checks the quad domain triangle counts
+// and the grid guards. Standalone; it is not part of the app project and needs
+// no device.
+//
+//   cl /std:c++17 /EHsc /I.. LandTessellationTest.cpp ../LandTessellation.cpp
+//   g++ -std=c++17 -I.. -I<DirectXMath>/Inc -I<sal.h directory> LandTessellationTest.cpp ../LandTessellation.cpp
+
+#include "LandTessellation.h"
+#include "TestUtil.h"
+#include <cmath>
+
+namespace
+{
+	const float GridSize = 160.0f;
+	const uint32_t GridVertices = 33;
+
+	XMFLOAT4X4 Identity()
+	{
+		return XMFLOAT4X4(
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	QuadPatchTess UniformTess(float factor)
+	{
+		QuadPatchTess tess;
+		for (auto& edge : tess.EdgeTess)
+		{
+			edge = factor;
+		}
+		tess.InsideTess[0] = factor;
+		tess.InsideTess[1] = factor;
+		return tess;
+	}
+
+	// A low pass over the grid that starts and ends past MaxDistance.
+	vector<XMFLOAT3> MakeEyePath()
+	{
+		vector<XMFLOAT3> path;
+		for (int i = 0; i <= 60; ++i)
+		{
+			const float t = i / 60.0f;
+			path.push_back(XMFLOAT3(-300.0f + 600.0f * t, 5.0f + 20.0f * t, 10.0f));
+		}
+		return path;
+	}
+
+	void TestGridPatches()
+	{
+		CHECK(LandTessellationAnalyzer::MakeGridPatches(GridSize, GridSize, 0, 0).empty());
+		CHECK(LandTessellationAnalyzer::MakeGridPatches(GridSize, GridSize, 1, 5).empty());
+		CHECK(LandTessellationAnalyzer::MakeGridPatches(GridSize, GridSize, 5, 1).empty());
+
+		auto patches = LandTessellationAnalyzer::MakeGridPatches(80.0f, 40.0f, 3, 5);
+		CHECK(patches.size() == 8);
+		CHECK(patches.front()[0].x == -40.0f && patches.front()[0].z == 20.0f);
+		CHECK(patches.back()[3].x == 40.0f && patches.back()[3].z == -20.0f);
+		CHECK(patches.front()[1].x - patches.front()[0].x == 20.0f);
+		CHECK(patches.front()[0].z - patches.front()[2].z == 20.0f);
+	}
+
+	void TestTriangleCounts()
+	{
+		// A uniform factor n splits the quad into n x n cells of two triangles.
+		for (uint32_t n = 1; n <= 64; ++n)
+		{
+			CHECK(CountQuadDomainTriangles(UniformTess((float)n)) == 2 * n * n);
+		}
+
+		// Integer partitioning rounds up.
+		CHECK(CountQuadDomainTriangles(UniformTess(2.5f)) == 18);
+		CHECK(CountQuadDomainTriangles(UniformTess(0.0f)) == 0);
+
+		QuadPatchTess oneEdgeCulled = UniformTess(8.0f);
+		oneEdgeCulled.EdgeTess[2] = 0.0f;
+		CHECK(CountQuadDomainTriangles(oneEdgeCulled) == 0);
+
+		// Outer edges of 1 around an interior of 4: 2*2*2 interior plus 4 strips of 1 + 2.
+		QuadPatchTess coarseEdges = UniformTess(4.0f);
+		for (auto& edge : coarseEdges.EdgeTess)
+		{
+			edge = 1.0f;
+		}
+		CHECK(CountQuadDomainTriangles(coarseEdges) == 20);
+	}
+
+	void TestPatchTess()
+	{
+		LandPatch patch = { XMFLOAT3(-1, 0, 1), XMFLOAT3(1, 0, 1), XMFLOAT3(-1, 0, -1), XMFLOAT3(1, 0, -1) };
+		const XMFLOAT4X4 world = Identity();
+		LandTessellationParams params;
+
+		CHECK(ComputeLandPatchTess(patch, world, XMFLOAT3(0, 5, 0), params).EdgeTess[0] == 64.0f);
+		CHECK(ComputeLandPatchTess(patch, world, XMFLOAT3(0, 300, 0), params).EdgeTess[0] == 0.0f);
+
+		// Halfway between MinDistance and MaxDistance.
+		const QuadPatchTess mid = ComputeLandPatchTess(patch, world, XMFLOAT3(0, 110, 0), params);
+		CHECK(fabsf(mid.EdgeTess[0] - 32.0f) < 1e-4f && mid.InsideTess[1] == mid.EdgeTess[0]);
+
+		// The world translation moves the patch center.
+		XMFLOAT4X4 moved = world;
+		moved._42 = 105.0f;
+		CHECK(fabsf(ComputeLandPatchTess(patch, moved, XMFLOAT3(0, 215, 0), params).EdgeTess[3] - 32.0f) < 1e-4f);
+
+		params.MaxTessFactor = 13.0f;
+		CHECK(ComputeLandPatchTess(patch, world, XMFLOAT3(0, 5, 0), params).EdgeTess[0] == 13.0f);
+	}
+
+	void TestBudgetAlongPath()
+	{
+		LandTessellationAnalyzer analyzer(
+			LandTessellationAnalyzer::MakeGridPatches(GridSize, GridSize, GridVertices, GridVertices), Identity());
+		const vector<XMFLOAT3> path = MakeEyePath();
+		LandTessellationParams params;
+
+		const LandTessellationReport uncapped = analyzer.AnalyzePath(path, params);
+		printf("uncapped: %s", LandTessellationAnalyzer::FormatReport(uncapped).c_str());
+		CHECK(uncapped.Frames.size() == path.size());
+		CHECK(uncapped.MinTriangles <= uncapped.AverageTriangles && uncapped.AverageTriangles <= uncapped.MaxTriangles);
+		// The path starts past MaxDistance, where every patch is culled.
+		CHECK(uncapped.MinTriangles == 0);
+		CHECK(uncapped.Frames.front().CulledPatches == (GridVertices - 1) * (GridVertices - 1));
+
+		const uint64_t budgets[] = { uncapped.MaxTriangles / 2, uncapped.MaxTriangles / 10, uncapped.MaxTriangles / 100 };
+		for (uint64_t budget : budgets)
+		{
+			const float cap = analyzer.FindMaxTessFactor(path, budget, params);
+			CHECK(cap >= 1.0f && cap < params.MaxTessFactor);
+			CHECK(cap == floorf(cap));
+
+			LandTessellationParams capped = params;
+			capped.MaxTessFactor = cap;
+			const LandTessellationReport report = analyzer.AnalyzePath(path, capped);
+			printf("budget %llu: LAND_MAX_TESS_FACTOR %s, max %llu\n", (unsigned long long)budget,
+				LandTessellationAnalyzer::MaxTessFactorDefine(cap).c_str(), (unsigned long long)report.MaxTriangles);
+
+			for (auto& frame : report.Frames)
+			{
+				CHECK(frame.Triangles <= budget);
+				CHECK(frame.MaxTessFactor <= cap);
+			}
+
+			// The cap is the largest that fits.
+			capped.MaxTessFactor = cap + 1.0f;
+			CHECK(analyzer.AnalyzePath(path, capped).MaxTriangles > budget);
+		}
+
+		CHECK(analyzer.FindMaxTessFactor(path, uncapped.MaxTriangles, params) == params.MaxTessFactor);
+
+		// Even a cap of 1 draws two triangles per visible patch.
+		CHECK(analyzer.FindMaxTessFactor(path, 1, params) == 0.0f);
+
+		params.MaxTessFactor = 16.0f;
+		CHECK(analyzer.FindMaxTessFactor(path, uncapped.MaxTriangles, params) == 16.0f);
+	}
+
+	void TestMaxTessFactorDefine()
+	{
+		CHECK(LandTessellationAnalyzer::MaxTessFactorDefine(13.0f) == "13.0f");
+	}
+}
+
+int main()
+{
+	TestGridPatches();
+	TestTriangleCounts();
+	TestPatchTess();
+	TestBudgetAlongPath();
+	TestMaxTessFactorDefine();
+	return TestResult();
+}
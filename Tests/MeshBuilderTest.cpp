@@ -0,0 +1,110 @@
+// Checks MeshBuilder against a plain copy of the meshes through MockMeshStagingBuffer.
+// Standalone; it is not part of the app project and needs no device.
+//
+//   cl /std:c++17 /EHsc /I.. MeshBuilderTest.cpp ../MeshBuilder.cpp ../GeometryGenerator.cpp ../ThreadPool.cpp
+//   g++ -std=c++17 -pthread -I.. -I<DirectXMath>/Inc -I<sal.h directory> MeshBuilderTest.cpp ../MeshBuilder.cpp ../GeometryGenerator.cpp ../ThreadPool.cpp
+
+#include "MeshBuilder.h"
+#include "TestUtil.h"
+#include <cstring>
+
+namespace
+{
+	void TestPacking()
+	{
+		GeometryGenerator geoGen;
+		map<string, GeometryGenerator::MeshData> meshes;
+		meshes["box"] = geoGen.CreateBox(1.0f, 2.0f, 3.0f, 2);
+		meshes["geosphere"] = geoGen.CreateGeosphere(1.0f, 3);
+		meshes["grid"] = geoGen.CreateGrid(5.0f, 5.0f, 10, 10);
+
+		MockMeshStagingBuffer staging;
+		MeshBuildLayout layout = MeshBuilder::Build(meshes, staging);
+
+		vector<PackedMeshVertex> vertices;
+		vector<uint16_t> indices;
+		for (auto& mesh : meshes)
+		{
+			for (auto& v : mesh.second.Vertices)
+			{
+				vertices.push_back({ v.Position, v.Normal, v.TexC });
+			}
+			auto& indices16 = mesh.second.GetIndices16();
+			indices.insert(indices.end(), indices16.begin(), indices16.end());
+		}
+
+		CHECK(staging.MapCount == 1);
+		CHECK(!layout.Indices32);
+		CHECK(layout.IndexBufferOffset % 16 == 0);
+		CHECK(layout.Submeshes.size() == meshes.size());
+
+		CHECK(layout.VertexBufferByteSize == vertices.size() * sizeof(PackedMeshVertex));
+		CHECK(layout.IndexBufferByteSize == indices.size() * sizeof(uint16_t));
+		CHECK(staging.Bytes.size() >= (size_t)layout.IndexBufferOffset + layout.IndexBufferByteSize);
+
+		if (staging.Bytes.size() >= (size_t)layout.IndexBufferOffset + layout.IndexBufferByteSize)
+		{
+			CHECK(memcmp(staging.Bytes.data(), vertices.data(), layout.VertexBufferByteSize) == 0);
+			CHECK(memcmp(staging.Bytes.data() + layout.IndexBufferOffset, indices.data(), layout.IndexBufferByteSize) == 0);
+		}
+
+		// Submeshes follow the map's order, each starting where the previous ended.
+		uint32_t baseVertex = 0;
+		uint32_t startIndex = 0;
+		size_t m = 0;
+		for (auto& mesh : meshes)
+		{
+			const MeshBuildSubmesh& submesh = layout.Submeshes[m++];
+			CHECK(submesh.Name == mesh.first);
+			CHECK(submesh.BaseVertexLocation == (int32_t)baseVertex);
+			CHECK(submesh.StartIndexLocation == startIndex);
+			CHECK(submesh.IndexCount == mesh.second.Indices32.size());
+
+			baseVertex += (uint32_t)mesh.second.Vertices.size();
+			startIndex += submesh.IndexCount;
+		}
+
+		const MeshBuildSubmesh& box = layout.Submeshes[0];
+		CHECK(box.BoundsMin.x == -0.5f && box.BoundsMin.y == -1.0f && box.BoundsMin.z == -1.5f);
+		CHECK(box.BoundsMax.x == 0.5f && box.BoundsMax.y == 1.0f && box.BoundsMax.z == 1.5f);
+	}
+
+	void TestIndices32()
+	{
+		// 300x300 vertices do not fit 16 bit indices.
+		GeometryGenerator geoGen;
+		GeometryGenerator::MeshData grid = geoGen.CreateGrid(10.0f, 10.0f, 300, 300);
+
+		MockMeshStagingBuffer staging;
+		MeshBuildLayout layout = MeshBuilder::Build(MeshBuilder::MeshList{ { "grid", &grid } }, staging);
+
+		CHECK(layout.Indices32);
+		CHECK(layout.IndexBufferByteSize == grid.Indices32.size() * sizeof(uint32_t));
+		CHECK(memcmp(staging.Bytes.data() + layout.IndexBufferOffset, grid.Indices32.data(), layout.IndexBufferByteSize) == 0);
+	}
+
+	void TestComputeLayout()
+	{
+		GeometryGenerator geoGen;
+		GeometryGenerator::MeshData box = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 0);
+		GeometryGenerator::MeshData sphere = geoGen.CreateSphere(1.0f, 8, 8);
+		MeshBuilder::MeshList meshes = { { "box", &box }, { "sphere", &sphere } };
+
+		MockMeshStagingBuffer staging;
+		MeshBuildLayout built = MeshBuilder::Build(meshes, staging);
+		MeshBuildLayout computed = MeshBuilder::ComputeLayout(meshes);
+
+		CHECK(computed.VertexBufferByteSize == built.VertexBufferByteSize);
+		CHECK(computed.IndexBufferOffset == built.IndexBufferOffset);
+		CHECK(computed.IndexBufferByteSize == built.IndexBufferByteSize);
+		CHECK(computed.Submeshes.size() == built.Submeshes.size());
+	}
+}
+
+int main()
+{
+	TestPacking();
+	TestIndices32();
+	TestComputeLayout();
+	return TestResult();
+}
@@ -0,0 +1,248 @@
+// Checks that PipelineStateKey hashes pipeline descriptions by value, so equal
+// descriptions built separately get one key and any single field change gets
+// another, and that PipelineStateRegistry folds equal keys onto one id and
+// handles InvalidId. Standalone; it is not part of the app project and needs no
+// device, only the d3d12.h declarations (on Linux those of DirectX-Headers).
+//
+//   cl /std:c++17 /EHsc /I.. PipelineStateKeyTest.cpp ../PipelineStateKey.cpp ../PipelineStateRegistry.cpp ../ShaderCache.cpp
+//   g++ -std=c++17 -I.. -I<DirectX-Headers>/include/directx -I<DirectX-Headers>/include/wsl/stubs PipelineStateKeyTest.cpp ../PipelineStateKey.cpp ../PipelineStateRegistry.cpp ../ShaderCache.cpp
+
+#include "PipelineStateKey.h"
+#include "PipelineStateRegistry.h"
+#include "TestUtil.h"
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <set>
+
+namespace
+{
+	const uint64_t RootSignatureKey = 0x1234;
+
+	// Everything a description points to, owned per instance so two equal
+	// descriptions share no pointers.
+	struct GraphicsPipeline
+	{
+		GraphicsPipeline()
+		{
+			VS = { 'v', 's', 0, 1, 2, 3 };
+			PS = { 'p', 's', 4, 5, 6, 7, 8 };
+			Semantics[0] = "POSITION";
+			Semantics[1] = "TEXCOORD";
+			Strides[0] = 32;
+
+			// Garbage in padding and in unused slots must not reach the key.
+			memset(&Desc, 0xcd, sizeof(Desc));
+
+			Desc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(this);
+			Desc.VS = { VS.data(), VS.size() };
+			Desc.PS = { PS.data(), PS.size() };
+			Desc.DS = { nullptr, 0 };
+			Desc.HS = { nullptr, 123 };
+			Desc.GS = { nullptr, 0 };
+
+			SODeclaration = { 0, Semantics[0].c_str(), 0, 0, 3, 0 };
+			Desc.StreamOutput.pSODeclaration = &SODeclaration;
+			Desc.StreamOutput.NumEntries = 1;
+			Desc.StreamOutput.pBufferStrides = Strides;
+			Desc.StreamOutput.NumStrides = 1;
+			Desc.StreamOutput.RasterizedStream = 0;
+
+			Desc.BlendState.AlphaToCoverageEnable = FALSE;
+			Desc.BlendState.IndependentBlendEnable = FALSE;
+			for (auto& rt : Desc.BlendState.RenderTarget)
+			{
+				rt.BlendEnable = FALSE;
+				rt.LogicOpEnable = FALSE;
+				rt.SrcBlend = D3D12_BLEND_ONE;
+				rt.DestBlend = D3D12_BLEND_ONE;
+				rt.BlendOp = D3D12_BLEND_OP_ADD;
+				rt.SrcBlendAlpha = D3D12_BLEND_ONE;
+				rt.DestBlendAlpha = D3D12_BLEND_ONE;
+				rt.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+				rt.LogicOp = D3D12_LOGIC_OP_NOOP;
+				rt.RenderTargetWriteMask = 0xf;
+			}
+			Desc.SampleMask = UINT_MAX;
+
+			Desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+			Desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+			Desc.RasterizerState.FrontCounterClockwise = FALSE;
+			Desc.RasterizerState.DepthBias = 0;
+			Desc.RasterizerState.DepthBiasClamp = 0.0f;
+			Desc.RasterizerState.SlopeScaledDepthBias = 0.0f;
+			Desc.RasterizerState.DepthClipEnable = TRUE;
+			Desc.RasterizerState.MultisampleEnable = FALSE;
+			Desc.RasterizerState.AntialiasedLineEnable = FALSE;
+			Desc.RasterizerState.ForcedSampleCount = 0;
+			Desc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+			Desc.DepthStencilState.DepthEnable = TRUE;
+			Desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+			Desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+			Desc.DepthStencilState.StencilEnable = FALSE;
+			Desc.DepthStencilState.StencilReadMask = 0xff;
+			Desc.DepthStencilState.StencilWriteMask = 0xff;
+			Desc.DepthStencilState.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+			Desc.DepthStencilState.BackFace = Desc.DepthStencilState.FrontFace;
+
+			InputLayout[0] = { Semantics[0].c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+			InputLayout[1] = { Semantics[1].c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+			Desc.InputLayout = { InputLayout, 2 };
+
+			Desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+			Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			Desc.NumRenderTargets = 1;
+			Desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+			Desc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+			Desc.SampleDesc = { 1, 0 };
+			Desc.NodeMask = 0;
+			Desc.CachedPSO = { this, sizeof(*this) };
+			Desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+		}
+
+		GraphicsPipeline(const GraphicsPipeline& rhs) = delete;
+		GraphicsPipeline& operator=(const GraphicsPipeline& rhs) = delete;
+
+		uint64_t Key() const
+		{
+			return PipelineStateKey::Hash(Desc, RootSignatureKey);
+		}
+
+		vector<uint8_t> VS;
+		vector<uint8_t> PS;
+		string Semantics[2];
+		UINT Strides[1];
+		D3D12_SO_DECLARATION_ENTRY SODeclaration;
+		D3D12_INPUT_ELEMENT_DESC InputLayout[2];
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc;
+	};
+
+	void TestEqualDescriptions()
+	{
+		GraphicsPipeline a;
+		GraphicsPipeline b;
+		CHECK(a.Desc.VS.pShaderBytecode != b.Desc.VS.pShaderBytecode);
+		CHECK(a.Key() == b.Key());
+
+		// Formats past NumRenderTargets are not part of the pipeline.
+		b.Desc.RTVFormats[5] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		CHECK(a.Key() == b.Key());
+
+		CHECK(PipelineStateKey::Hash(a.Desc, RootSignatureKey + 1) != a.Key());
+
+		CHECK(PipelineStateKey::Name(0x0123456789abcdefull) == L"pso_0123456789abcdef");
+		CHECK(PipelineStateKey::Name(1) == L"pso_0000000000000001");
+	}
+
+	void TestSingleFieldChanges()
+	{
+		GraphicsPipeline base;
+		set<uint64_t> keys = { base.Key() };
+
+		const function<void(GraphicsPipeline&)> changes[] =
+		{
+			[](GraphicsPipeline& p) { p.VS.back() ^= 1; },
+			[](GraphicsPipeline& p) { p.Desc.PS.BytecodeLength -= 1; },
+			[](GraphicsPipeline& p) { p.Desc.PS = { nullptr, 0 }; },
+			[](GraphicsPipeline& p) { p.Desc.DS = p.Desc.PS; },
+			[](GraphicsPipeline& p) { p.Desc.StreamOutput.NumEntries = 0; },
+			[](GraphicsPipeline& p) { p.SODeclaration.SemanticName = p.Semantics[1].c_str(); },
+			[](GraphicsPipeline& p) { p.Strides[0] = 16; },
+			[](GraphicsPipeline& p) { p.Desc.BlendState.RenderTarget[7].BlendEnable = TRUE; },
+			[](GraphicsPipeline& p) { p.Desc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0x7; },
+			[](GraphicsPipeline& p) { p.Desc.SampleMask = 1; },
+			[](GraphicsPipeline& p) { p.Desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME; },
+			[](GraphicsPipeline& p) { p.Desc.RasterizerState.SlopeScaledDepthBias = 1.0f; },
+			[](GraphicsPipeline& p) { p.Desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS; },
+			[](GraphicsPipeline& p) { p.Desc.DepthStencilState.BackFace.StencilFunc = D3D12_COMPARISON_FUNC_LESS; },
+			[](GraphicsPipeline& p) { p.Semantics[1] = "NORMAL"; p.InputLayout[1].SemanticName = p.Semantics[1].c_str(); },
+			[](GraphicsPipeline& p) { p.InputLayout[1].AlignedByteOffset = 16; },
+			[](GraphicsPipeline& p) { p.Desc.InputLayout.NumElements = 1; },
+			[](GraphicsPipeline& p) { p.Desc.NumRenderTargets = 2; p.Desc.RTVFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM; },
+			[](GraphicsPipeline& p) { p.Desc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN; },
+			[](GraphicsPipeline& p) { p.Desc.DSVFormat = DXGI_FORMAT_UNKNOWN; },
+			[](GraphicsPipeline& p) { p.Desc.SampleDesc.Count = 4; },
+			[](GraphicsPipeline& p) { p.Desc.NodeMask = 1; },
+		};
+
+		for (auto& change : changes)
+		{
+			GraphicsPipeline p;
+			change(p);
+			CHECK(keys.insert(p.Key()).second);
+		}
+	}
+
+	void TestCompute()
+	{
+		const uint8_t shader[] = { 'c', 's', 1, 2, 3 };
+		const uint8_t copy[] = { 'c', 's', 1, 2, 3 };
+
+		D3D12_COMPUTE_PIPELINE_STATE_DESC a = {};
+		a.CS = { shader, sizeof(shader) };
+		D3D12_COMPUTE_PIPELINE_STATE_DESC b = a;
+		b.CS.pShaderBytecode = copy;
+		b.CachedPSO = { shader, sizeof(shader) };
+		CHECK(PipelineStateKey::Hash(a, RootSignatureKey) == PipelineStateKey::Hash(b, RootSignatureKey));
+
+		b.CS.BytecodeLength = 4;
+		CHECK(PipelineStateKey::Hash(a, RootSignatureKey) != PipelineStateKey::Hash(b, RootSignatureKey));
+
+		// A compute and a graphics pipeline with nothing set do not collide.
+		D3D12_COMPUTE_PIPELINE_STATE_DESC emptyCompute = {};
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC emptyGraphics = {};
+		CHECK(PipelineStateKey::Hash(emptyCompute, 0) != PipelineStateKey::Hash(emptyGraphics, 0));
+	}
+
+	void TestRegistry()
+	{
+		GraphicsPipeline opaque;
+		GraphicsPipeline opaqueAgain;
+		GraphicsPipeline wireframe;
+		wireframe.Desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
+
+		PipelineStateRegistry registry;
+		CHECK(registry.Find("opaque") == PipelineStateRegistry::InvalidId);
+		CHECK(registry.Key(PipelineStateRegistry::InvalidId) == 0);
+		CHECK(registry.Key(0) == 0);
+		CHECK(registry.TakePending().empty());
+
+		const uint32_t opaqueId = registry.Add("opaque", opaque.Key());
+		const uint32_t sameId = registry.Add("opaqueCopy", opaqueAgain.Key());
+		const uint32_t wireframeId = registry.Add("wireframe", wireframe.Key());
+		CHECK(opaqueId == 0 && sameId == opaqueId && wireframeId == 1);
+		CHECK(registry.EntryCount() == 2 && registry.NameCount() == 3);
+		CHECK(registry.Requests() == 3 && registry.Deduplicated() == 1);
+		CHECK(registry.Key(opaqueId) == opaque.Key() && registry.Key(wireframeId) == wireframe.Key());
+
+		CHECK(registry.Find("opaqueCopy") == opaqueId);
+		CHECK(registry.Find("missing") == PipelineStateRegistry::InvalidId);
+		CHECK(registry.Key(PipelineStateRegistry::InvalidId) == 0);
+		CHECK(registry.Key(registry.EntryCount()) == 0);
+
+		CHECK((registry.TakePending() == vector<uint32_t>{ 0, 1 }));
+		CHECK(registry.TakePending().empty());
+
+		// Adding a known description again creates nothing.
+		CHECK(registry.Add("wireframe", wireframe.Key()) == wireframeId);
+		CHECK(registry.TakePending().empty());
+
+		// Rebinding a name to a new description leaves the other names alone.
+		GraphicsPipeline msaa;
+		msaa.Desc.SampleDesc.Count = 4;
+		const uint32_t msaaId = registry.Add("opaque", msaa.Key());
+		CHECK(msaaId == 2 && registry.Find("opaque") == msaaId);
+		CHECK(registry.Find("opaqueCopy") == opaqueId);
+		CHECK((registry.TakePending() == vector<uint32_t>{ 2 }));
+	}
+}
+
+int main()
+{
+	TestEqualDescriptions();
+	TestSingleFieldChanges();
+	TestCompute();
+	TestRegistry();
+	return TestResult();
+}
@@ -0,0 +1,236 @@
+// Checks the RenderGraph compiler: culling, ordering, barrier derivation and
+// transient placement. Standalone; it is not part of the app project and needs no
+// device, only the d3d12.h declarations (on Linux those of DirectX-Headers).
+//
+//   cl /std:c++17 /EHsc /I.. RenderGraphTest.cpp ../RenderGraph.cpp
+//   g++ -std=c++17 -I.. -I<DirectX-Headers>/include/directx -I<DirectX-Headers>/include/wsl/stubs RenderGraphTest.cpp ../RenderGraph.cpp
+
+#include "RenderGraph.h"
+#include "TestUtil.h"
+#include <algorithm>
+
+namespace
+{
+	typedef RenderGraphBarrier::BarrierType BarrierType;
+
+	int PositionOf(const RenderGraph& graph, uint32_t pass)
+	{
+		const auto& compiled = graph.CompiledPasses();
+		for (size_t i = 0; i < compiled.size(); ++i)
+		{
+			if (compiled[i].Pass == pass)
+			{
+				return (int)i;
+			}
+		}
+		return -1;
+	}
+
+	const RenderGraphCompiledPass& Compiled(const RenderGraph& graph, uint32_t pass)
+	{
+		return graph.CompiledPasses()[PositionOf(graph, pass)];
+	}
+
+	bool HasTransition(const vector<RenderGraphBarrier>& barriers, RenderGraphResource resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+	{
+		for (auto& barrier : barriers)
+		{
+			if (barrier.Type == BarrierType::Transition && barrier.Resource == resource && barrier.Before == before && barrier.After == after)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool HasBarrier(const vector<RenderGraphBarrier>& barriers, BarrierType type, RenderGraphResource resource)
+	{
+		for (auto& barrier : barriers)
+		{
+			if (barrier.Type == type && barrier.Resource == resource)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WaitsFor(const RenderGraph& graph, uint32_t pass, uint32_t other)
+	{
+		const auto& dependencies = Compiled(graph, pass).Dependencies;
+		return find(dependencies.begin(), dependencies.end(), (uint32_t)PositionOf(graph, other)) != dependencies.end();
+	}
+
+	// The app's frame: culling on the compute queue feeding ExecuteIndirect.
+	void TestCullingFrame()
+	{
+		RenderGraph graph;
+		auto backBuffer = graph.ImportResource("backBuffer", D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+		auto depth = graph.ImportResource("depth", D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		auto args = graph.ImportResource("indirectArgs", D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		auto visibility = graph.ImportResource("visibility", D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+		auto upload = graph.AddPass("upload", PassQueue::Graphics, true);
+		auto clear = graph.AddPass("clear", PassQueue::Graphics);
+		graph.Write(clear, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		graph.Write(clear, depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		auto reset = graph.AddPass("reset", PassQueue::Compute);
+		graph.Write(reset, args, D3D12_RESOURCE_STATE_COPY_DEST);
+		auto culling = graph.AddPass("culling", PassQueue::Compute);
+		graph.Write(culling, args, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		graph.Write(culling, visibility, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		auto opaque = graph.AddPass("opaque", PassQueue::Graphics);
+		graph.DependsOn(opaque, upload);
+		graph.Read(opaque, args, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		graph.Read(opaque, visibility, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		graph.Write(opaque, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		graph.Write(opaque, depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+		graph.Compile();
+
+		CHECK(graph.Stats().Passes == 5);
+		CHECK(graph.Stats().CulledPasses == 0);
+
+		CHECK(PositionOf(graph, reset) < PositionOf(graph, culling));
+		CHECK(PositionOf(graph, culling) < PositionOf(graph, opaque));
+		CHECK(WaitsFor(graph, opaque, culling));
+		CHECK(WaitsFor(graph, opaque, upload));
+		CHECK(WaitsFor(graph, culling, reset));
+
+		CHECK(HasTransition(Compiled(graph, reset).Barriers, args, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST));
+		CHECK(HasTransition(Compiled(graph, culling).Barriers, args, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		CHECK(HasTransition(Compiled(graph, culling).Barriers, visibility, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		CHECK(HasTransition(Compiled(graph, opaque).Barriers, args, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT));
+		CHECK(HasTransition(Compiled(graph, opaque).Barriers, visibility, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+		CHECK(HasTransition(Compiled(graph, clear).Barriers, backBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+		CHECK(HasTransition(Compiled(graph, opaque).PostBarriers, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+
+		// Depth stays in DEPTH_WRITE and needs nothing.
+		CHECK(graph.Stats().Transitions == 7);
+		CHECK(graph.Stats().UAVBarriers == 0);
+	}
+
+	void TestTransients()
+	{
+		RenderGraph graph;
+		auto backBuffer = graph.ImportResource("backBuffer", D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+		auto t1 = graph.CreateTransient("t1", 1000, 256, 0);
+		auto t2 = graph.CreateTransient("t2", 800, 256, 0);
+		auto t3 = graph.CreateTransient("t3", 1000, 256, 0);
+		auto unused = graph.CreateTransient("unused", 4096, 256, 0);
+		auto buffer = graph.CreateTransient("buffer", 512, 256, 1);
+
+		auto p1 = graph.AddPass("p1", PassQueue::Graphics);
+		graph.Write(p1, t1, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		auto p2 = graph.AddPass("p2", PassQueue::Graphics);
+		graph.Read(p2, t1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Write(p2, t2, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		auto dead = graph.AddPass("dead", PassQueue::Graphics);
+		graph.Read(dead, t1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Write(dead, unused, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		auto cs1 = graph.AddPass("cs1", PassQueue::Compute);
+		graph.Write(cs1, buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		auto cs2 = graph.AddPass("cs2", PassQueue::Compute);
+		graph.Write(cs2, buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		auto p3 = graph.AddPass("p3", PassQueue::Graphics);
+		graph.Read(p3, t2, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Read(p3, buffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		graph.Write(p3, t3, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		auto p4 = graph.AddPass("p4", PassQueue::Graphics);
+		graph.Read(p4, t3, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Read(p4, buffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Write(p4, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+		graph.Compile();
+
+		// Only the unused transient consumes dead's output.
+		CHECK(graph.IsCulled(dead));
+		CHECK(PositionOf(graph, dead) == -1);
+		CHECK(graph.Stats().CulledPasses == 1);
+
+		// t1 is dead before t3 is born, so they share memory; t2 overlaps both.
+		CHECK(graph.HeapOffset(t1) == graph.HeapOffset(t3));
+		CHECK(graph.HeapOffset(t2) >= graph.HeapOffset(t1) + 1000);
+		CHECK(graph.HeapOffset(t2) % 256 == 0);
+		CHECK(graph.HeapSize(0) == 1024 + 800);
+		CHECK(graph.HeapSize(1) == 512);
+		CHECK(graph.Stats().TransientBytes < graph.Stats().TransientBytesUnaliased);
+
+		CHECK(HasBarrier(Compiled(graph, p1).Barriers, BarrierType::Aliasing, t1));
+		CHECK(HasBarrier(Compiled(graph, p3).Barriers, BarrierType::Aliasing, t3));
+		CHECK(!HasBarrier(Compiled(graph, p2).Barriers, BarrierType::Aliasing, t2));
+		CHECK(graph.Stats().AliasingBarriers == 2);
+
+		// Back-to-back UAV writes on one queue.
+		CHECK(HasBarrier(Compiled(graph, cs2).Barriers, BarrierType::UnorderedAccess, buffer));
+		CHECK(graph.Stats().UAVBarriers == 1);
+
+		// Transients start the frame as they ended the last one...
+		CHECK(graph.InitialState(t1) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		CHECK(HasTransition(Compiled(graph, p1).Barriers, t1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
+		// ...unless the compute queue, which uses them first, could not leave that state.
+		CHECK(graph.InitialState(buffer) == D3D12_RESOURCE_STATE_COMMON);
+		CHECK(HasTransition(Compiled(graph, p4).PostBarriers, buffer,
+			(D3D12_RESOURCE_STATES)(D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE), D3D12_RESOURCE_STATE_COMMON));
+
+		CHECK(graph.QueueMask(buffer) == ((1u << (uint32_t)PassQueue::Graphics) | (1u << (uint32_t)PassQueue::Compute)));
+		CHECK(WaitsFor(graph, p3, cs2));
+	}
+
+	void TestReadWidening()
+	{
+		RenderGraph graph;
+		auto args = graph.ImportResource("args", D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+		auto build = graph.AddPass("build", PassQueue::Compute);
+		graph.Write(build, args, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		auto first = graph.AddPass("first", PassQueue::Graphics, true);
+		graph.Read(first, args, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		auto second = graph.AddPass("second", PassQueue::Graphics, true);
+		graph.Read(second, args, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+		graph.Compile();
+
+		// One transition into both read states serves both readers.
+		const auto readable = (D3D12_RESOURCE_STATES)(D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		CHECK(HasTransition(Compiled(graph, first).Barriers, args, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, readable));
+		CHECK(Compiled(graph, second).Barriers.empty());
+		CHECK(HasTransition(Compiled(graph, second).PostBarriers, args, readable, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		CHECK(graph.Stats().Transitions == 2);
+	}
+
+	void TestGraphicsOnlyStateOnCompute()
+	{
+		RenderGraph graph;
+		auto texture = graph.ImportResource("texture", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		auto backBuffer = graph.ImportResource("backBuffer", D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+
+		auto draw = graph.AddPass("draw", PassQueue::Graphics);
+		graph.Read(draw, texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Write(draw, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		auto blur = graph.AddPass("blur", PassQueue::Compute);
+		graph.Write(blur, texture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		auto compose = graph.AddPass("compose", PassQueue::Graphics);
+		graph.Read(compose, texture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		graph.Write(compose, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+		graph.Compile();
+
+		// The compute list cannot leave PIXEL_SHADER_RESOURCE, so the graphics pass
+		// before it does the transition and the compute pass waits for it.
+		CHECK(HasTransition(Compiled(graph, draw).PostBarriers, texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+		CHECK(Compiled(graph, blur).Barriers.empty());
+		CHECK(WaitsFor(graph, blur, draw));
+		CHECK(WaitsFor(graph, compose, blur));
+		CHECK(HasTransition(Compiled(graph, compose).PostBarriers, texture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	}
+}
+
+int main()
+{
+	TestCullingFrame();
+	TestTransients();
+	TestReadWidening();
+	TestGraphicsOnlyStateOnCompute();
+	return TestResult();
+}
@@ -0,0 +1,310 @@
+// Drives ShaderCache with a fake compiler over shader files in a scratch
+// directory: hits and misses keyed on defines, entry point, target, flags and
+// compiler version, invalidation when an included file changes, and recompiles
+// when a cache entry is corrupt or truncated. Standalone; it is not part of the
+// app project and needs no device.
+//
+//   cl /std:c++17 /EHsc /I.. ShaderCacheTest.cpp ../ShaderCache.cpp
+//   g++ -std=c++17 -I.. ShaderCacheTest.cpp ../ShaderCache.cpp
+
+#include "ShaderCache.h"
+#include "TestUtil.h"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Bytecode is the request spelled out, so a wrong entry is easy to spot.
+	// Sources containing "error" fail to compile.
+	class FakeCompiler : public ShaderCompiler
+	{
+	public:
+		bool Compile(const ShaderCompileRequest& request, vector<uint8_t>& byteCode, string& errors) override
+		{
+			++Calls;
+
+			ifstream fin(request.Path, ios::binary);
+			string source((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+			if (source.find("error") != string::npos)
+			{
+				errors = request.Path + ": error";
+				return false;
+			}
+
+			string text = request.Path + "|" + request.EntryPoint + "|" + request.Target;
+			for (auto& define : request.Defines)
+			{
+				text += "|" + define.Name + "=" + define.Value;
+			}
+			byteCode.assign(text.begin(), text.end());
+			return true;
+		}
+
+		string Version() const override
+		{
+			return VersionString;
+		}
+
+		int Calls = 0;
+		string VersionString = "fake 1";
+	};
+
+	struct ScratchDirectory
+	{
+		ScratchDirectory()
+		{
+			Path = (fs::temp_directory_path() / "ShaderCacheTest").string();
+			fs::remove_all(Path);
+			fs::create_directories(Path + "/cache");
+			fs::create_directories(Path + "/shaders/inc");
+		}
+
+		~ScratchDirectory()
+		{
+			fs::remove_all(Path);
+		}
+
+		string Shader(const string& name) const
+		{
+			return Path + "/shaders/" + name;
+		}
+
+		string Cache() const
+		{
+			return Path + "/cache";
+		}
+
+		vector<string> Entries() const
+		{
+			vector<string> entries;
+			for (auto& entry : fs::directory_iterator(Cache()))
+			{
+				entries.push_back(entry.path().string());
+			}
+			return entries;
+		}
+
+		string Path;
+	};
+
+	void WriteText(const string& path, const string& text)
+	{
+		ofstream fout(path, ios::binary | ios::trunc);
+		fout << text;
+	}
+
+	string ReadBytes(const string& path)
+	{
+		ifstream fin(path, ios::binary);
+		return string((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+	}
+
+	void WriteShaders(const ScratchDirectory& dir)
+	{
+		WriteText(dir.Shader("Default.hlsl"), "#include \"inc/Common.hlsl\"\nfloat4 PS() : SV_Target { return 0; }\n");
+		WriteText(dir.Shader("inc/Common.hlsl"), "#include \"Lighting.hlsl\"\n#define COMMON 1\n");
+		WriteText(dir.Shader("inc/Lighting.hlsl"), "#include \"Common.hlsl\"\nfloat3 Light() { return 1; }\n");
+	}
+
+	ShaderCompileRequest MakeRequest(const ScratchDirectory& dir)
+	{
+		ShaderCompileRequest request;
+		request.Path = dir.Shader("Default.hlsl");
+		request.Defines = { { "FOG", "1" }, { "ALPHA_TEST", "1" } };
+		request.EntryPoint = "PS";
+		request.Target = "ps_5_1";
+		return request;
+	}
+
+	void TestKeys()
+	{
+		ScratchDirectory dir;
+		WriteShaders(dir);
+		FakeCompiler compiler;
+		ShaderCache cache(&compiler, dir.Cache());
+
+		const ShaderCompileRequest request = MakeRequest(dir);
+		ShaderByteCode first = cache.Get(request);
+		CHECK(first != nullptr && compiler.Calls == 1);
+		CHECK(cache.Get(request) == first);
+		CHECK(cache.Stats().MemoryHits == 1 && cache.Stats().Compiles == 1);
+
+		// Every part of the request is part of the key.
+		vector<ShaderCompileRequest> variants(7, request);
+		variants[0].Defines[0].Value = "0";
+		variants[1].Defines[1].Name = "ALPHA_CLIP";
+		variants[2].Defines.pop_back();
+		swap(variants[3].Defines[0], variants[3].Defines[1]);
+		variants[4].EntryPoint = "PSMain";
+		variants[5].Target = "ps_5_0";
+		variants[6].Flags = 1;
+
+		for (auto& variant : variants)
+		{
+			const int calls = compiler.Calls;
+			ShaderByteCode byteCode = cache.Get(variant);
+			CHECK(byteCode != nullptr && byteCode != first);
+			CHECK(compiler.Calls == calls + 1);
+		}
+		CHECK(dir.Entries().size() == 1 + variants.size());
+
+		// A define split differently across name and value is a different request.
+		ShaderCompileRequest shifted = request;
+		shifted.Defines[0] = { "FOG1", "" };
+		const int calls = compiler.Calls;
+		cache.Get(shifted);
+		CHECK(compiler.Calls == calls + 1);
+
+		// A second cache over the same directory hits on disk without compiling.
+		FakeCompiler other;
+		ShaderCache reopened(&other, dir.Cache());
+		ShaderByteCode fromDisk = reopened.Get(request);
+		CHECK(fromDisk != nullptr && *fromDisk == *first);
+		CHECK(other.Calls == 0 && reopened.Stats().DiskHits == 1);
+
+		// Unless its compiler is a different version.
+		other.VersionString = "fake 2";
+		ShaderCache upgraded(&other, dir.Cache());
+		CHECK(upgraded.Get(request) != nullptr && other.Calls == 1);
+	}
+
+	void TestIncludeInvalidation()
+	{
+		ScratchDirectory dir;
+		WriteShaders(dir);
+		FakeCompiler compiler;
+		ShaderCache cache(&compiler, dir.Cache());
+
+		const ShaderCompileRequest request = MakeRequest(dir);
+		CHECK(cache.Get(request) != nullptr && compiler.Calls == 1);
+
+		// Lighting.hlsl is included through Common.hlsl, which it includes back.
+		WriteText(dir.Shader("inc/Lighting.hlsl"), "#include \"Common.hlsl\"\nfloat3 Light() { return 0.5; }\n");
+
+		// Source hashes are kept for the run until cleared.
+		cache.Get(request);
+		CHECK(compiler.Calls == 1 && cache.Stats().MemoryHits == 1);
+
+		cache.ClearFileHashes();
+		CHECK(cache.Get(request) != nullptr && compiler.Calls == 2);
+
+		// A new run sees the change too, and the old entry again once it is undone.
+		FakeCompiler other;
+		ShaderCache reopened(&other, dir.Cache());
+		reopened.Get(request);
+		CHECK(other.Calls == 0 && reopened.Stats().DiskHits == 1);
+
+		WriteText(dir.Shader("inc/Lighting.hlsl"), "#include \"Common.hlsl\"\nfloat3 Light() { return 1; }\n");
+		reopened.ClearFileHashes();
+		reopened.Get(request);
+		CHECK(other.Calls == 0 && reopened.Stats().DiskHits == 2);
+
+		// Adding an include that does not exist yet, then creating it.
+		WriteText(dir.Shader("inc/Common.hlsl"), "#include \"Lighting.hlsl\"\n#include \"Shadows.hlsl\"\n");
+		reopened.ClearFileHashes();
+		reopened.Get(request);
+		CHECK(other.Calls == 1);
+
+		WriteText(dir.Shader("inc/Shadows.hlsl"), "float Shadow() { return 1; }\n");
+		reopened.ClearFileHashes();
+		reopened.Get(request);
+		CHECK(other.Calls == 2);
+	}
+
+	void TestBadEntries()
+	{
+		ScratchDirectory dir;
+		WriteShaders(dir);
+		const ShaderCompileRequest request = MakeRequest(dir);
+
+		FakeCompiler compiler;
+		ShaderByteCode expected;
+		{
+			ShaderCache cache(&compiler, dir.Cache());
+			expected = cache.Get(request);
+		}
+		CHECK(expected != nullptr && dir.Entries().size() == 1);
+
+		const string entry = dir.Entries()[0];
+		const string good = ReadBytes(entry);
+
+		string flipped = good;
+		flipped.back() ^= 0x20;
+		string badMagic = good;
+		badMagic[0] ^= 0x01;
+
+		const string damaged[] =
+		{
+			flipped,
+			badMagic,
+			good.substr(0, good.size() - 1),
+			good.substr(0, 20),
+			good + "x",
+			string(),
+		};
+
+		for (auto& contents : damaged)
+		{
+			WriteText(entry, contents);
+
+			FakeCompiler other;
+			ShaderCache cache(&other, dir.Cache());
+			ShaderByteCode byteCode = cache.Get(request);
+			CHECK(byteCode != nullptr && *byteCode == *expected);
+			CHECK(other.Calls == 1);
+			CHECK(cache.Stats().RejectedEntries == 1 && cache.Stats().DiskHits == 0);
+
+			// The recompile replaced the entry.
+			CHECK(ReadBytes(entry) == good);
+		}
+		CHECK(dir.Entries().size() == 1);
+	}
+
+	void TestCompileFailures()
+	{
+		ScratchDirectory dir;
+		WriteShaders(dir);
+		WriteText(dir.Shader("Broken.hlsl"), "#include \"inc/Common.hlsl\"\nerror\n");
+
+		FakeCompiler compiler;
+		ShaderCache cache(&compiler, dir.Cache());
+
+		ShaderCompileRequest request = MakeRequest(dir);
+		request.Path = dir.Shader("Broken.hlsl");
+
+		string errors;
+		CHECK(cache.Get(request, &errors) == nullptr);
+		CHECK(errors == request.Path + ": error");
+		CHECK(cache.Stats().Failures == 1);
+
+		// Failures are not cached.
+		CHECK(cache.Get(request) == nullptr && compiler.Calls == 2);
+		CHECK(dir.Entries().empty());
+	}
+
+	void TestMemoryOnly()
+	{
+		ScratchDirectory dir;
+		WriteShaders(dir);
+		FakeCompiler compiler;
+		ShaderCache cache(&compiler, "");
+
+		const ShaderCompileRequest request = MakeRequest(dir);
+		ShaderByteCode byteCode = cache.Get(request);
+		CHECK(byteCode != nullptr && cache.Get(request) == byteCode);
+		CHECK(compiler.Calls == 1 && cache.Stats().MemoryHits == 1);
+		CHECK(dir.Entries().empty());
+	}
+}
+
+int main()
+{
+	TestKeys();
+	TestIncludeInvalidation();
+	TestBadEntries();
+	TestCompileFailures();
+	TestMemoryOnly();
+	return TestResult();
+}
@@ -0,0 +1,133 @@
+// Checks StreamingScheduler's budgets, priorities and completion tracking against
+// SimulatedCopyQueue. Standalone; it is not part of the app project and needs no
+// device.
+//
+//   cl /std:c++17 /EHsc /I.. StreamingSchedulerTest.cpp ../StreamingScheduler.cpp
+//   g++ -std=c++17 -I.. StreamingSchedulerTest.cpp ../StreamingScheduler.cpp
+
+#include "StreamingScheduler.h"
+#include "TestUtil.h"
+
+namespace
+{
+	const uint64_t MB = 1024 * 1024;
+
+	void TestPriorityOrder()
+	{
+		SimulatedCopyQueue queue(64 * MB);
+		StreamingScheduler scheduler(&queue, 64 * MB);
+
+		uint64_t low = scheduler.Enqueue(0, MB, nullptr);
+		uint64_t high = scheduler.Enqueue(5, MB, nullptr);
+		uint64_t lowSecond = scheduler.Enqueue(0, MB, nullptr);
+		uint64_t raised = scheduler.Enqueue(0, MB, nullptr);
+		uint64_t cancelled = scheduler.Enqueue(9, MB, nullptr);
+
+		CHECK(scheduler.SetPriority(raised, 7));
+		CHECK(scheduler.Cancel(cancelled));
+		CHECK(!scheduler.Cancel(cancelled));
+
+		scheduler.Update();
+
+		// Highest priority first, submission order within a priority.
+		const vector<uint64_t> expected = { raised, high, low, lowSecond };
+		CHECK(queue.SubmittedIds == expected);
+		CHECK(!scheduler.SetPriority(low, 3));
+	}
+
+	void TestBudgets()
+	{
+		SimulatedCopyQueue queue(3 * MB);
+		StreamingScheduler scheduler(&queue, 4 * MB, 2);
+
+		for (int i = 0; i < 20; ++i)
+		{
+			scheduler.Enqueue(0, MB, nullptr);
+		}
+
+		uint32_t updates = 0;
+		while (scheduler.Stats().RequestsCompleted < 20 && updates < 100)
+		{
+			scheduler.Update();
+			queue.Tick();
+			++updates;
+
+			CHECK(scheduler.Stats().BytesSubmittedLastUpdate <= 4 * MB);
+			CHECK(scheduler.Stats().BatchesInFlight <= 2);
+		}
+
+		CHECK(scheduler.Stats().RequestsCompleted == 20);
+		CHECK(scheduler.Stats().BytesCompleted == 20 * MB);
+		CHECK(scheduler.Stats().BudgetLimitedUpdates > 0);
+		CHECK(scheduler.Stats().RequestsQueued == 0);
+		CHECK(scheduler.Stats().RequestsInFlight == 0);
+	}
+
+	void TestOversizedRequest()
+	{
+		// Larger than the budget: it goes alone instead of stalling.
+		SimulatedCopyQueue queue(64 * MB);
+		StreamingScheduler scheduler(&queue, 4 * MB);
+
+		uint64_t big = scheduler.Enqueue(1, 16 * MB, nullptr);
+		uint64_t small = scheduler.Enqueue(0, MB, nullptr);
+
+		scheduler.Update();
+		CHECK(scheduler.Stats().BytesSubmittedLastUpdate == 16 * MB);
+		CHECK(scheduler.GetState(big) == StreamState::InFlight);
+		CHECK(scheduler.GetState(small) == StreamState::Queued);
+
+		queue.Tick();
+		scheduler.Update();
+		CHECK(scheduler.GetState(big) == StreamState::Complete);
+		CHECK(scheduler.GetState(small) == StreamState::InFlight);
+	}
+
+	void TestCompletion()
+	{
+		SimulatedCopyQueue queue(MB);
+		StreamingScheduler scheduler(&queue, 8 * MB);
+
+		int completed = 0;
+		uint64_t first = scheduler.Enqueue(0, MB, nullptr, [&] { ++completed; });
+		uint64_t second = scheduler.Enqueue(0, MB, nullptr, [&] { ++completed; });
+
+		CHECK(scheduler.GetState(first) == StreamState::Queued);
+		CHECK(scheduler.GetState(second + 1) == StreamState::Unknown);
+		CHECK(scheduler.GetState(0) == StreamState::Unknown);
+
+		scheduler.Update();
+		CHECK(scheduler.GetState(first) == StreamState::InFlight);
+
+		// Both share a batch, which completes whole after the second tick.
+		queue.Tick();
+		scheduler.Update();
+		CHECK(completed == 0);
+
+		queue.Tick();
+		scheduler.Update();
+		CHECK(completed == 2);
+		CHECK(scheduler.GetState(first) == StreamState::Complete);
+		CHECK(scheduler.GetState(second) == StreamState::Complete);
+		CHECK(scheduler.Stats().MaxLatency == 3);
+
+		int drained = 0;
+		for (int i = 0; i < 10; ++i)
+		{
+			scheduler.Enqueue(i, 2 * MB, nullptr, [&] { ++drained; });
+		}
+		scheduler.Drain([&] { queue.Tick(); });
+		CHECK(drained == 10);
+		CHECK(scheduler.Stats().RequestsQueued == 0);
+		CHECK(scheduler.Stats().BatchesInFlight == 0);
+	}
+}
+
+int main()
+{
+	TestPriorityOrder();
+	TestBudgets();
+	TestOversizedRequest();
+	TestCompletion();
+	return TestResult();
+}
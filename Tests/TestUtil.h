@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+
+// Shared by the standalone tests. CHECK reports a failed expression and keeps
+// going; main returns TestResult(), which is 1 if any check failed.
+inline int& TestFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(expr) ((expr) ? (void)0 : (void)(printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expr), ++TestFailures()))
+
+inline int TestResult()
+{
+	if (TestFailures() > 0)
+	{
+		printf("%d checks failed\n", TestFailures());
+		return 1;
+	}
+	printf("passed\n");
+	return 0;
+}
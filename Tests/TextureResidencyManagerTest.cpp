@@ -0,0 +1,259 @@
+// Checks TextureResidencyManager's LRU eviction, its protection of textures used
+// in the frame being updated and re-residency, over TextureStreamer and a fake
+// upload backend. Standalone; it is not part of the app project and needs no
+// device, only the d3d12.h declarations (on Linux those of DirectX-Headers).
+//
+//   cl /std:c++17 /EHsc /I.. TextureResidencyManagerTest.cpp ../TextureResidencyManager.cpp ../TextureStreamer.cpp ../DDSTextureLayout.cpp
+//   g++ -std=c++17 -I.. -I<DirectX-Headers>/include/directx -I<DirectX-Headers>/include/wsl/stubs TextureResidencyManagerTest.cpp ../TextureResidencyManager.cpp ../TextureStreamer.cpp ../DDSTextureLayout.cpp
+
+#include "TextureResidencyManager.h"
+#include "TestUtil.h"
+
+namespace
+{
+	// Counts re-creations; the streamer tracks the resident range itself.
+	class FakeUploadBackend : public TextureUploadBackend
+	{
+	public:
+		void SetResidentMips(const StreamingTexture&, uint32_t) override
+		{
+			++Calls;
+		}
+
+		void Release(const StreamingTexture&) override
+		{
+		}
+
+		int Calls = 0;
+	};
+
+	// 1024x1024 R8G8B8A8 with a full chain: mips 3 and coarser form the mip tail.
+	const uint32_t TextureSize = 1024;
+	const uint32_t TextureMips = 11;
+	const uint32_t TailMip = 3;
+
+	uint64_t MipBytes(uint32_t mip)
+	{
+		return (uint64_t)(TextureSize >> mip) * (TextureSize >> mip) * 4;
+	}
+
+	uint64_t ChainBytes()
+	{
+		uint64_t bytes = 0;
+		for (uint32_t mip = 0; mip < TextureMips; ++mip)
+		{
+			bytes += MipBytes(mip);
+		}
+		return bytes;
+	}
+
+	shared_ptr<vector<uint8_t>> MakeTextureFile()
+	{
+		const size_t headerBytes = sizeof(uint32_t) + sizeof(DDS_HEADER);
+		auto file = make_shared<vector<uint8_t>>(headerBytes + ChainBytes(), 0);
+		*reinterpret_cast<uint32_t*>(file->data()) = DDS_MAGIC;
+
+		auto header = reinterpret_cast<DDS_HEADER*>(file->data() + sizeof(uint32_t));
+		header->size = sizeof(DDS_HEADER);
+		header->flags = DDS_WIDTH | DDS_HEIGHT;
+		header->width = TextureSize;
+		header->height = TextureSize;
+		header->mipMapCount = TextureMips;
+		header->ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header->ddspf.flags = DDS_RGB;
+		header->ddspf.RGBBitCount = 32;
+		header->ddspf.RBitMask = 0x000000ff;
+		header->ddspf.GBitMask = 0x0000ff00;
+		header->ddspf.BBitMask = 0x00ff0000;
+		header->ddspf.ABitMask = 0xff000000;
+		return file;
+	}
+
+	struct Fixture
+	{
+		Fixture()
+			: Streamer(&Backend, 1ull << 30, 1ull << 30), Residency(&Streamer, 1ull << 30)
+		{
+			const char* names[] = { "a", "b", "c" };
+			for (const char* name : names)
+			{
+				auto file = MakeTextureFile();
+				Textures.push_back(Streamer.AddTexture(name, file->data(), file->size(), file));
+			}
+		}
+
+		// Streams every texture to mip 0, one mip per frame.
+		void StreamAll(uint64_t& frame)
+		{
+			for (uint32_t i = 0; i < TailMip; ++i, ++frame)
+			{
+				for (auto texture : Textures)
+				{
+					Residency.MarkUsed(texture, 0, frame);
+				}
+				Residency.Update(frame);
+			}
+		}
+
+		FakeUploadBackend Backend;
+		TextureStreamer Streamer;
+		TextureResidencyManager Residency;
+		vector<StreamingTexture*> Textures;
+	};
+
+	void TestLruEviction()
+	{
+		Fixture f;
+		uint64_t frame = 1;
+		f.StreamAll(frame);
+		for (auto texture : f.Textures)
+		{
+			CHECK(texture->ResidentMip == 0);
+		}
+		const uint64_t full = 3 * ChainBytes();
+		CHECK(f.Streamer.Stats().ResidentBytes == full);
+
+		// b was used longest ago, then c, then a.
+		f.Residency.MarkUsed(f.Textures[1], 0, 8);
+		f.Residency.MarkUsed(f.Textures[2], 0, 9);
+		f.Residency.MarkUsed(f.Textures[0], 0, 10);
+
+		f.Residency.SetBudget(full - MipBytes(0));
+		f.Residency.Update(11);
+		CHECK(f.Textures[1]->ResidentMip == 1);
+		CHECK(f.Textures[0]->ResidentMip == 0 && f.Textures[2]->ResidentMip == 0);
+		CHECK(f.Residency.Stats().Evictions == 1);
+		CHECK(f.Residency.Stats().BytesEvicted == MipBytes(0));
+		CHECK(f.Streamer.Stats().ResidentBytes <= f.Residency.GetBudget());
+
+		// b's remaining streamable mips go before c is touched.
+		f.Residency.SetBudget(full - 2 * MipBytes(0));
+		f.Residency.Update(12);
+		CHECK(f.Textures[1]->ResidentMip == TailMip);
+		CHECK(f.Textures[2]->ResidentMip == 1 && f.Textures[0]->ResidentMip == 0);
+		CHECK(f.Streamer.Stats().ResidentBytes <= f.Residency.GetBudget());
+
+		// Several mips of one texture go in a single re-creation.
+		const int calls = f.Backend.Calls;
+		f.Residency.SetBudget(3 * (ChainBytes() - MipBytes(0) - MipBytes(1) - MipBytes(2)));
+		f.Residency.Update(13);
+		CHECK(f.Textures[0]->ResidentMip == TailMip && f.Textures[2]->ResidentMip == TailMip);
+		CHECK(f.Backend.Calls == calls + 2);
+	}
+
+	void TestUsedThisFrameIsProtected()
+	{
+		Fixture f;
+		uint64_t frame = 1;
+		f.StreamAll(frame);
+
+		for (auto texture : f.Textures)
+		{
+			f.Residency.MarkUsed(texture, 0, 20);
+		}
+
+		// Over budget, but everything was used in the frame being updated.
+		f.Residency.SetBudget(ChainBytes());
+		f.Residency.Update(20);
+		for (auto texture : f.Textures)
+		{
+			CHECK(texture->ResidentMip == 0);
+		}
+		CHECK(f.Residency.Stats().Evictions == 0);
+
+		// Only the texture that was not used again is evicted next frame, down to its tail.
+		f.Residency.MarkUsed(f.Textures[0], 0, 21);
+		f.Residency.MarkUsed(f.Textures[2], 0, 21);
+		f.Residency.Update(21);
+		CHECK(f.Textures[1]->ResidentMip == TailMip);
+		CHECK(f.Textures[0]->ResidentMip == 0 && f.Textures[2]->ResidentMip == 0);
+	}
+
+	void TestReResidency()
+	{
+		Fixture f;
+		uint64_t frame = 1;
+		f.StreamAll(frame);
+
+		f.Residency.MarkUsed(f.Textures[0], 0, 30);
+		f.Residency.MarkUsed(f.Textures[2], 0, 30);
+		f.Residency.SetBudget(3 * ChainBytes() - MipBytes(0));
+		f.Residency.Update(31);
+		CHECK(f.Textures[1]->ResidentMip == 1);
+
+		// Not brought back until the renderer asks again.
+		f.Residency.SetBudget(1ull << 30);
+		f.Residency.Update(32);
+		CHECK(f.Textures[1]->ResidentMip == 1);
+
+		const uint64_t misses = f.Residency.Stats().Misses;
+		const uint64_t hits = f.Residency.Stats().Hits;
+		const uint64_t streamed = f.Residency.Stats().BytesStreamed;
+
+		f.Residency.MarkUsed(f.Textures[1], 0, 33);
+		f.Residency.MarkUsed(f.Textures[0], 0, 33);
+		CHECK(f.Residency.Stats().Misses == misses + 1);
+		CHECK(f.Residency.Stats().Hits == hits + 1);
+
+		f.Residency.Update(33);
+		CHECK(f.Textures[1]->ResidentMip == 0);
+		CHECK(f.Residency.Stats().BytesStreamed == streamed + MipBytes(0));
+		CHECK(f.Residency.Stats().StreamedBytes == 3 * ChainBytes());
+	}
+
+	void TestFinestRequestOfFrame()
+	{
+		Fixture f;
+		StreamingTexture* texture = f.Textures[0];
+
+		f.Residency.MarkUsed(texture, 2, 5);
+		f.Residency.MarkUsed(texture, 0, 5);
+		f.Residency.MarkUsed(texture, 1, 5);
+		CHECK(texture->RequestedMip == 0);
+
+		// A new frame starts over.
+		f.Residency.MarkUsed(texture, 2, 6);
+		CHECK(texture->RequestedMip == 2);
+	}
+
+	void TestStaticTextures()
+	{
+		Fixture f;
+
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		desc.Width = 256;
+		desc.Height = 256;
+		desc.DepthOrArraySize = 6;
+		desc.MipLevels = 2;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+		const uint64_t bytes = 6 * (256 * 256 * 4 + 128 * 128 * 4);
+		CHECK(TextureResidencyManager::CalcTextureBytes(desc) == bytes);
+
+		// Static textures are fully resident and shrink what streaming may use.
+		f.Residency.SetBudget(bytes + ChainBytes());
+		f.Residency.TrackStaticTexture("sky", desc);
+		CHECK(f.Residency.Stats().StaticBytes == bytes);
+		CHECK(f.Streamer.GetResidencyBudget() == ChainBytes());
+
+		f.Residency.MarkUsed("sky", 7);
+		f.Residency.MarkUsed("missing", 7);
+		CHECK(f.Residency.GetLastUsedFrame("sky") == 7);
+		CHECK(f.Residency.Stats().Hits == 1);
+
+		f.Residency.UntrackStaticTexture("sky");
+		CHECK(f.Residency.Stats().StaticBytes == 0);
+		CHECK(f.Streamer.GetResidencyBudget() == bytes + ChainBytes());
+	}
+}
+
+int main()
+{
+	TestLruEviction();
+	TestUsedThisFrameIsProtected();
+	TestReResidency();
+	TestFinestRequestOfFrame();
+	TestStaticTextures();
+	return TestResult();
+}
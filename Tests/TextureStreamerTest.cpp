@@ -0,0 +1,429 @@
+// Checks the DDS layout parser against hand-built headers and drives TextureStreamer
+// through a fake upload backend. Standalone; it is not part of the app project and
+// needs no device, only the d3d12.h declarations (on Linux those of DirectX-Headers).
+//
+//   cl /std:c++17 /EHsc /I.. TextureStreamerTest.cpp ../TextureStreamer.cpp ../DDSTextureLayout.cpp
+//   g++ -std=c++17 -I.. -I<DirectX-Headers>/include/directx -I<DirectX-Headers>/include/wsl/stubs TextureStreamerTest.cpp ../TextureStreamer.cpp ../DDSTextureLayout.cpp
+
+#include "TextureStreamer.h"
+#include "TestUtil.h"
+#include <cstring>
+
+namespace
+{
+	const size_t DdsHeaderBytes = sizeof(uint32_t) + sizeof(DDS_HEADER);
+
+	DDS_HEADER* Header(vector<uint8_t>& file)
+	{
+		return reinterpret_cast<DDS_HEADER*>(file.data() + sizeof(uint32_t));
+	}
+
+	DDS_HEADER_DXT10* Dx10Header(vector<uint8_t>& file)
+	{
+		return reinterpret_cast<DDS_HEADER_DXT10*>(file.data() + DdsHeaderBytes);
+	}
+
+	// Legacy header describing R8G8B8A8_UNORM, followed by dataBytes of zeros.
+	vector<uint8_t> MakeRgbaDds(uint32_t width, uint32_t height, uint32_t mipCount, size_t dataBytes)
+	{
+		vector<uint8_t> file(DdsHeaderBytes + dataBytes, 0);
+		*reinterpret_cast<uint32_t*>(file.data()) = DDS_MAGIC;
+
+		DDS_HEADER* header = Header(file);
+		header->size = sizeof(DDS_HEADER);
+		header->flags = DDS_WIDTH | DDS_HEIGHT;
+		header->width = width;
+		header->height = height;
+		header->mipMapCount = mipCount;
+		header->ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header->ddspf.flags = DDS_RGB;
+		header->ddspf.RGBBitCount = 32;
+		header->ddspf.RBitMask = 0x000000ff;
+		header->ddspf.GBitMask = 0x0000ff00;
+		header->ddspf.BBitMask = 0x00ff0000;
+		header->ddspf.ABitMask = 0xff000000;
+		return file;
+	}
+
+	// "DX10" header, followed by dataBytes of zeros.
+	vector<uint8_t> MakeDx10Dds(DXGI_FORMAT format, uint32_t dimension, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t arraySize, size_t dataBytes)
+	{
+		vector<uint8_t> file = MakeRgbaDds(width, height, mipCount, sizeof(DDS_HEADER_DXT10) + dataBytes);
+
+		DDS_HEADER* header = Header(file);
+		header->ddspf.flags = DDS_FOURCC;
+		header->ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		DDS_HEADER_DXT10* dx10 = Dx10Header(file);
+		dx10->dxgiFormat = format;
+		dx10->resourceDimension = dimension;
+		dx10->arraySize = arraySize;
+		return file;
+	}
+
+	size_t RgbaChainBytes(uint32_t width, uint32_t height, uint32_t mipCount)
+	{
+		size_t bytes = 0;
+		for (uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			bytes += (size_t)max(width >> mip, 1u) * max(height >> mip, 1u) * 4;
+		}
+		return bytes;
+	}
+
+	void TestMipSizing()
+	{
+		auto file = MakeRgbaDds(256, 64, 9, RgbaChainBytes(256, 64, 9));
+
+		DDSTextureLayout layout;
+		CHECK(GetDDSTextureLayout(file.data(), file.size(), layout) == S_OK);
+		CHECK(layout.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+		CHECK(layout.Format == DXGI_FORMAT_R8G8B8A8_UNORM);
+		CHECK(layout.MipCount == 9 && layout.ArraySize == 1 && layout.Depth == 1);
+		CHECK(layout.HeaderSize == DdsHeaderBytes);
+		CHECK(layout.Subresources.size() == 9);
+
+		size_t offset = DdsHeaderBytes;
+		for (uint32_t mip = 0; mip < 9; ++mip)
+		{
+			const auto& sub = layout.Subresource(mip);
+			CHECK(sub.Width == max(256u >> mip, 1u));
+			CHECK(sub.Height == max(64u >> mip, 1u));
+			CHECK(sub.RowBytes == sub.Width * 4);
+			CHECK(sub.NumRows == sub.Height);
+			CHECK(sub.NumBytes == sub.RowBytes * sub.NumRows);
+			CHECK(sub.Offset == offset);
+			offset += sub.NumBytes;
+		}
+		CHECK(offset == file.size());
+		CHECK(layout.MipRangeBytes(0) == file.size() - DdsHeaderBytes);
+		CHECK(layout.MipRangeBytes(8) == 4);
+	}
+
+	void TestArraySizing()
+	{
+		// BC1: 8 bytes per 4x4 block, at least one block per mip.
+		const size_t sliceBytes = 16 * 8 + 4 * 8 + 8 + 8;
+		auto file = MakeDx10Dds(DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 16, 16, 4, 3, 3 * sliceBytes);
+
+		DDSTextureLayout layout;
+		CHECK(GetDDSTextureLayout(file.data(), file.size(), layout) == S_OK);
+		CHECK(layout.HeaderSize == DdsHeaderBytes + sizeof(DDS_HEADER_DXT10));
+		CHECK(layout.ArraySize == 3 && layout.MipCount == 4 && !layout.IsCubeMap);
+
+		// Slices are stored one whole mip chain after another.
+		for (uint32_t slice = 0; slice < 3; ++slice)
+		{
+			CHECK(layout.Subresource(0, slice).Offset == layout.HeaderSize + slice * sliceBytes);
+			CHECK(layout.Subresource(3, slice).NumBytes == 8);
+			CHECK(&layout.Subresource(1, slice) == &layout.Subresources[1 + slice * 4]);
+		}
+		CHECK(layout.Subresource(0, 1).RowBytes == 4 * 8 && layout.Subresource(0, 1).NumRows == 4);
+		CHECK(layout.MipRangeBytes(2) == 3 * 16);
+	}
+
+	void TestCubeSizing()
+	{
+		const size_t faceBytes = RgbaChainBytes(8, 8, 4);
+
+		auto legacy = MakeRgbaDds(8, 8, 4, 6 * faceBytes);
+		Header(legacy)->caps2 = DDS_CUBEMAP_ALLFACES;
+
+		DDSTextureLayout layout;
+		CHECK(GetDDSTextureLayout(legacy.data(), legacy.size(), layout) == S_OK);
+		CHECK(layout.IsCubeMap && layout.ArraySize == 6);
+		CHECK(layout.Subresource(0, 5).Offset == DdsHeaderBytes + 5 * faceBytes);
+
+		Header(legacy)->caps2 = DDS_CUBEMAP_POSITIVEX;
+		CHECK(GetDDSTextureLayout(legacy.data(), legacy.size(), layout) == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+
+		// A cube array counts faces, not cubes.
+		auto array = MakeDx10Dds(DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 8, 8, 4, 2, 12 * faceBytes);
+		Dx10Header(array)->miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+		CHECK(GetDDSTextureLayout(array.data(), array.size(), layout) == S_OK);
+		CHECK(layout.IsCubeMap && layout.ArraySize == 12);
+		CHECK(layout.Subresources.size() == 48);
+	}
+
+	void TestTruncated()
+	{
+		auto file = MakeRgbaDds(64, 64, 7, RgbaChainBytes(64, 64, 7));
+
+		DDSTextureLayout layout;
+		CHECK(GetDDSTextureLayout(file.data(), file.size() - 1, layout) == HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+		CHECK(layout.Subresources.empty() && layout.MipCount == 0);
+
+		CHECK(GetDDSTextureLayout(file.data(), DdsHeaderBytes - 1, layout) == E_FAIL);
+		CHECK(GetDDSTextureLayout(nullptr, file.size(), layout) == E_POINTER);
+
+		auto dx10 = MakeDx10Dds(DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 4, 4, 1, 1, 64);
+		CHECK(GetDDSTextureLayout(dx10.data(), DdsHeaderBytes + sizeof(DDS_HEADER_DXT10) - 1, layout) == E_FAIL);
+
+		file[0] = 'X';
+		CHECK(GetDDSTextureLayout(file.data(), file.size(), layout) == E_FAIL);
+	}
+
+	void TestSizeGuards()
+	{
+		const HRESULT notSupported = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+		const HRESULT invalid = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+		DDSTextureLayout layout;
+
+		auto wide = MakeRgbaDds(D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION + 1, 1, 1, 64);
+		CHECK(GetDDSTextureLayout(wide.data(), wide.size(), layout) == notSupported);
+
+		auto mips = MakeRgbaDds(4, 4, D3D12_REQ_MIP_LEVELS + 1, 64);
+		CHECK(GetDDSTextureLayout(mips.data(), mips.size(), layout) == notSupported);
+
+		// 0x40000000 cubes would wrap to a small face count if scaled before the check.
+		auto cubes = MakeDx10Dds(DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 4, 4, 1, 0x40000000, 64);
+		Dx10Header(cubes)->miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+		CHECK(GetDDSTextureLayout(cubes.data(), cubes.size(), layout) == notSupported);
+
+		// Largest allowed volume; its size fits in size_t but not in the file.
+		const uint32_t maxVolume = D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION;
+		auto volume = MakeDx10Dds(DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE3D, maxVolume, maxVolume, 1, 1, 64);
+		Header(volume)->flags |= DDS_HEADER_FLAGS_VOLUME;
+		Header(volume)->depth = maxVolume;
+		CHECK(GetDDSTextureLayout(volume.data(), volume.size(), layout) == HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+
+		Header(volume)->depth = 0;
+		CHECK(GetDDSTextureLayout(volume.data(), volume.size(), layout) == invalid);
+
+		auto legacyVolume = MakeRgbaDds(4, 4, 1, 64);
+		Header(legacyVolume)->flags |= DDS_HEADER_FLAGS_VOLUME;
+		CHECK(GetDDSTextureLayout(legacyVolume.data(), legacyVolume.size(), layout) == invalid);
+		Header(legacyVolume)->depth = 1;
+		CHECK(GetDDSTextureLayout(legacyVolume.data(), legacyVolume.size(), layout) == S_OK);
+		CHECK(layout.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D);
+
+		auto empty = MakeRgbaDds(0, 4, 1, 64);
+		CHECK(GetDDSTextureLayout(empty.data(), empty.size(), layout) == invalid);
+		Header(empty)->width = 4;
+		Header(empty)->height = 0;
+		CHECK(GetDDSTextureLayout(empty.data(), empty.size(), layout) == invalid);
+
+		auto noSlices = MakeDx10Dds(DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 4, 4, 1, 0, 64);
+		CHECK(GetDDSTextureLayout(noSlices.data(), noSlices.size(), layout) == invalid);
+	}
+
+	// Remembers what the streamer asked for instead of recording copies.
+	class FakeUploadBackend : public TextureUploadBackend
+	{
+	public:
+		struct Call
+		{
+			string Name;
+			uint32_t FromMip;
+			uint32_t ToMip;
+		};
+
+		void SetResidentMips(const StreamingTexture& texture, uint32_t firstMip) override
+		{
+			Calls.push_back({ texture.Name, texture.ResidentMip, firstMip });
+		}
+
+		void Release(const StreamingTexture& texture) override
+		{
+			Released.push_back(texture.Name);
+		}
+
+		vector<Call> Calls;
+		vector<string> Released;
+	};
+
+	// 1024x1024 with a full chain: mips 3 and coarser form the mip tail.
+	const uint32_t TextureSize = 1024;
+	const uint32_t TextureMips = 11;
+	const uint32_t TailMip = 3;
+
+	uint64_t MipBytes(uint32_t mip)
+	{
+		return (uint64_t)(TextureSize >> mip) * (TextureSize >> mip) * 4;
+	}
+
+	uint64_t TailBytes()
+	{
+		return RgbaChainBytes(TextureSize, TextureSize, TextureMips) - MipBytes(0) - MipBytes(1) - MipBytes(2);
+	}
+
+	shared_ptr<vector<uint8_t>> MakeTextureFile()
+	{
+		return make_shared<vector<uint8_t>>(MakeRgbaDds(TextureSize, TextureSize, TextureMips, RgbaChainBytes(TextureSize, TextureSize, TextureMips)));
+	}
+
+	StreamingTexture* Add(TextureStreamer& streamer, const string& name, const shared_ptr<vector<uint8_t>>& file)
+	{
+		return streamer.AddTexture(name, file->data(), file->size(), file);
+	}
+
+	void TestAddLoadsMipTail()
+	{
+		FakeUploadBackend backend;
+		TextureStreamer streamer(&backend, 1ull << 30, 1ull << 30);
+
+		auto texture = Add(streamer, "a", MakeTextureFile());
+		CHECK(texture != nullptr);
+		CHECK(TextureStreamer::MipTailStart(texture->Layout) == TailMip);
+		CHECK(texture->ResidentMip == TailMip && texture->RequestedMip == TailMip);
+		CHECK(texture->ResidentBytes == TailBytes());
+		CHECK(streamer.Stats().ResidentBytes == TailBytes());
+		CHECK(backend.Calls.size() == 1 && backend.Calls[0].FromMip == TextureMips && backend.Calls[0].ToMip == TailMip);
+		CHECK(streamer.GetTexture("a") == texture);
+
+		// Nothing requested beyond the tail.
+		streamer.Update();
+		CHECK(backend.Calls.size() == 1);
+		CHECK(streamer.PendingUploadBytes() == 0);
+
+		auto volume = make_shared<vector<uint8_t>>(MakeRgbaDds(4, 4, 1, 64));
+		Header(*volume)->flags |= DDS_HEADER_FLAGS_VOLUME;
+		Header(*volume)->depth = 1;
+		CHECK(Add(streamer, "volume", volume) == nullptr);
+
+		auto truncated = make_shared<vector<uint8_t>>(MakeRgbaDds(TextureSize, TextureSize, TextureMips, 64));
+		CHECK(Add(streamer, "truncated", truncated) == nullptr);
+		CHECK(backend.Calls.size() == 1 && streamer.GetTexture("volume") == nullptr);
+	}
+
+	void TestStreamsOneMipPerUpdate()
+	{
+		FakeUploadBackend backend;
+		TextureStreamer streamer(&backend, 1ull << 30, 1ull << 30);
+		auto texture = Add(streamer, "a", MakeTextureFile());
+
+		streamer.RequestMip(texture, 0, 1);
+		CHECK(streamer.PendingUploadBytes() == MipBytes(2));
+
+		for (uint32_t expected = TailMip - 1; expected != ~0u; --expected)
+		{
+			const uint32_t version = texture->ResidencyVersion;
+			streamer.Update();
+			CHECK(texture->ResidentMip == expected);
+			CHECK(texture->ResidencyVersion == version + 1);
+			CHECK(streamer.Stats().BytesStreamedLastUpdate == MipBytes(expected));
+		}
+
+		CHECK(streamer.Stats().MipsStreamed == TextureMips);
+		CHECK(streamer.Stats().BytesStreamed == RgbaChainBytes(TextureSize, TextureSize, TextureMips));
+		CHECK(streamer.Stats().PendingRequests == 0);
+
+		// Requests finer than the tail are clamped, coarser ones to the tail.
+		streamer.RequestMip(texture, 9, 2);
+		CHECK(texture->RequestedMip == TailMip && texture->LastRequestedFrame == 2);
+	}
+
+	void TestUploadBudget()
+	{
+		FakeUploadBackend backend;
+		TextureStreamer streamer(&backend, 1ull << 30, MipBytes(2));
+		auto older = Add(streamer, "older", MakeTextureFile());
+		auto newer = Add(streamer, "newer", MakeTextureFile());
+		backend.Calls.clear();
+
+		streamer.RequestMip(older, 2, 1);
+		streamer.RequestMip(newer, 2, 2);
+
+		// One mip fits per update; the most recently requested texture goes first.
+		streamer.Update();
+		CHECK(backend.Calls.size() == 1 && backend.Calls[0].Name == "newer");
+		CHECK(streamer.Stats().PendingRequests == 1);
+
+		streamer.Update();
+		CHECK(backend.Calls.size() == 2 && backend.Calls[1].Name == "older");
+		CHECK(streamer.Stats().PendingRequests == 0);
+
+		// A mip larger than the per-update budget still goes through on its own.
+		streamer.SetUploadBytesPerUpdate(1);
+		streamer.RequestMip(older, 0, 3);
+		streamer.Update();
+		CHECK(older->ResidentMip == 1);
+		streamer.Update();
+		CHECK(older->ResidentMip == 0);
+	}
+
+	void TestResidencyBudget()
+	{
+		FakeUploadBackend backend;
+		TextureStreamer streamer(&backend, TailBytes() + MipBytes(2), 1ull << 30);
+		auto texture = Add(streamer, "a", MakeTextureFile());
+
+		streamer.RequestMip(texture, 0, 1);
+		streamer.Update();
+		CHECK(texture->ResidentMip == 2);
+
+		streamer.Update();
+		CHECK(texture->ResidentMip == 2);
+		CHECK(streamer.Stats().BudgetRejections == 1);
+		CHECK(streamer.Stats().PendingRequests == 1);
+
+		streamer.SetResidencyBudget(1ull << 30);
+		streamer.Update();
+		CHECK(texture->ResidentMip == 1);
+	}
+
+	void TestEvictAndRemove()
+	{
+		FakeUploadBackend backend;
+		TextureStreamer streamer(&backend, 1ull << 30, 1ull << 30);
+		auto texture = Add(streamer, "a", MakeTextureFile());
+		Add(streamer, "b", MakeTextureFile());
+
+		streamer.RequestMip(texture, 0, 1);
+		for (int i = 0; i < 3; ++i)
+		{
+			streamer.Update();
+		}
+		CHECK(texture->ResidentMip == 0);
+		backend.Calls.clear();
+
+		// Evicting several mips is one backend call; the tail stays.
+		streamer.EvictMips(texture, 8);
+		CHECK(backend.Calls.size() == 1 && backend.Calls[0].FromMip == 0 && backend.Calls[0].ToMip == TailMip);
+		CHECK(texture->ResidentMip == TailMip && texture->ResidentBytes == TailBytes());
+		CHECK(streamer.Stats().MipsEvicted == TailMip);
+
+		// Evicted mips are not streamed back until asked for again.
+		streamer.Update();
+		CHECK(texture->ResidentMip == TailMip);
+		streamer.EvictMips(texture, 1);
+		CHECK(backend.Calls.size() == 1);
+
+		streamer.RemoveTexture("a");
+		CHECK(backend.Released.size() == 1 && backend.Released[0] == "a");
+		CHECK(streamer.GetTexture("a") == nullptr);
+		CHECK(streamer.Stats().ResidentBytes == TailBytes());
+
+		// Adding under a used name replaces the old texture.
+		Add(streamer, "b", MakeTextureFile());
+		CHECK(backend.Released.size() == 2 && backend.Released[1] == "b");
+		CHECK(streamer.Stats().ResidentBytes == TailBytes());
+	}
+
+	void TestDestructorReleases()
+	{
+		FakeUploadBackend backend;
+		{
+			TextureStreamer streamer(&backend, 1ull << 30, 1ull << 30);
+			Add(streamer, "a", MakeTextureFile());
+			Add(streamer, "b", MakeTextureFile());
+		}
+		CHECK(backend.Released.size() == 2);
+	}
+}
+
+int main()
+{
+	TestMipSizing();
+	TestArraySizing();
+	TestCubeSizing();
+	TestTruncated();
+	TestSizeGuards();
+	TestAddLoadsMipTail();
+	TestStreamsOneMipPerUpdate();
+	TestUploadBudget();
+	TestResidencyBudget();
+	TestEvictAndRemove();
+	TestDestructorReleases();
+	return TestResult();
+}
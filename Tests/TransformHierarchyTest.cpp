@@ -0,0 +1,253 @@
+// Removes subtrees from the middle of a TransformHierarchy and checks that the
+// compaction keeps surviving handles, parents and world matrices, that freed
+// handles are reused, and that Update only recomputes dirty subtrees. World
+// matrices are compared with a plain scalar product walked up the parents.
+// Standalone; it is not part of the app project and needs no device.
+//
+//   cl /std:c++17 /EHsc /I.. TransformHierarchyTest.cpp ../TransformHierarchy.cpp
+//   g++ -std=c++17 -I.. -I<DirectXMath>/Inc -I<sal.h directory> TransformHierarchyTest.cpp ../TransformHierarchy.cpp
+
+#include "TransformHierarchy.h"
+#include "TestUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+	const float Tolerance = 1e-5f;
+
+	// Scale, a rotation about y by a quarter turn when turned is set, then a translation.
+	XMFLOAT4X4 MakeLocal(float scale, bool turned, float x, float y, float z)
+	{
+		const float c = turned ? 0.0f : scale;
+		const float s = turned ? scale : 0.0f;
+		return XMFLOAT4X4(
+			c, 0.0f, -s, 0.0f,
+			0.0f, scale, 0.0f, 0.0f,
+			s, 0.0f, c, 0.0f,
+			x, y, z, 1.0f);
+	}
+
+	XMFLOAT4X4 Multiply(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		XMFLOAT4X4 out;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < 4; ++k)
+				{
+					sum += (&a._11)[i * 4 + k] * (&b._11)[k * 4 + j];
+				}
+				(&out._11)[i * 4 + j] = sum;
+			}
+		}
+		return out;
+	}
+
+	// The hierarchy plus a plain record of what was added, to check it against.
+	struct Scene
+	{
+		TransformNode Add(TransformNode parent, const XMFLOAT4X4& local)
+		{
+			TransformNode node = Transforms.Add(parent, local);
+			Parents[node] = parent;
+			Locals[node] = local;
+			return node;
+		}
+
+		void SetLocal(TransformNode node, const XMFLOAT4X4& local)
+		{
+			Transforms.SetLocal(node, local);
+			Locals[node] = local;
+		}
+
+		void Remove(TransformNode node)
+		{
+			Transforms.Remove(node);
+
+			// Drop node and everything under it from the record.
+			bool erased = true;
+			Parents.erase(node);
+			Locals.erase(node);
+			while (erased)
+			{
+				erased = false;
+				for (auto it = Parents.begin(); it != Parents.end(); ++it)
+				{
+					if (it->second != TransformHierarchy::InvalidNode && Parents.count(it->second) == 0)
+					{
+						Locals.erase(it->first);
+						Parents.erase(it);
+						erased = true;
+						break;
+					}
+				}
+			}
+		}
+
+		XMFLOAT4X4 ExpectedWorld(TransformNode node) const
+		{
+			const TransformNode parent = Parents.at(node);
+			if (parent == TransformHierarchy::InvalidNode)
+			{
+				return Locals.at(node);
+			}
+			return Multiply(Locals.at(node), ExpectedWorld(parent));
+		}
+
+		// Every recorded node is valid with the recorded parent, local and world.
+		bool Matches() const
+		{
+			if (Transforms.Size() != Parents.size())
+			{
+				return false;
+			}
+
+			for (auto& [node, parent] : Parents)
+			{
+				if (!Transforms.IsValid(node) || Transforms.Parent(node) != parent)
+				{
+					return false;
+				}
+
+				const XMFLOAT4X4 expected = ExpectedWorld(node);
+				for (int i = 0; i < 16; ++i)
+				{
+					if (fabsf((&Transforms.World(node)._11)[i] - (&expected._11)[i]) > Tolerance
+						|| (&Transforms.Local(node)._11)[i] != (&Locals.at(node)._11)[i])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		TransformHierarchy Transforms;
+		unordered_map<TransformNode, TransformNode> Parents;
+		unordered_map<TransformNode, XMFLOAT4X4> Locals;
+	};
+
+	bool ChangedIs(const TransformHierarchy& transforms, const vector<TransformNode>& expected)
+	{
+		return transforms.Changed() == expected;
+	}
+
+	void TestRemoveMidHierarchy()
+	{
+		const TransformNode None = TransformHierarchy::InvalidNode;
+
+		// Added interleaved so the subtree under b is spread out between survivors:
+		//
+		//   a - b - c - d      h - i
+		//     |   - e
+		//     - f - g
+		Scene scene;
+		const TransformNode a = scene.Add(None, MakeLocal(1.0f, false, 1, 0, 0));
+		const TransformNode b = scene.Add(a, MakeLocal(2.0f, true, 0, 1, 0));
+		const TransformNode f = scene.Add(a, MakeLocal(1.0f, true, 5, 0, 0));
+		const TransformNode c = scene.Add(b, MakeLocal(0.5f, false, 0, 0, 1));
+		const TransformNode h = scene.Add(None, MakeLocal(1.0f, false, 10, 0, 0));
+		const TransformNode g = scene.Add(f, MakeLocal(3.0f, false, 0, 0, 7));
+		const TransformNode e = scene.Add(b, MakeLocal(1.0f, true, 0, 3, 0));
+		const TransformNode d = scene.Add(c, MakeLocal(1.0f, false, 2, 0, 0));
+		const TransformNode i = scene.Add(h, MakeLocal(1.0f, true, 0, 0, -4));
+
+		CHECK(scene.Transforms.Update() == 9);
+		CHECK(scene.Matches());
+		CHECK(scene.Transforms.Update() == 0);
+
+		// g is dirty and stays; c is dirty and goes with b.
+		scene.SetLocal(g, MakeLocal(1.0f, false, 0, 6, 0));
+		scene.SetLocal(c, MakeLocal(4.0f, false, 0, 0, 0));
+		scene.Remove(b);
+
+		for (TransformNode removed : { b, c, d, e })
+		{
+			CHECK(!scene.Transforms.IsValid(removed));
+		}
+		CHECK(scene.Transforms.Size() == 5);
+		CHECK(scene.Transforms.Parent(g) == f && scene.Transforms.Parent(f) == a);
+		CHECK(scene.Transforms.Parent(i) == h && scene.Transforms.Parent(h) == None);
+
+		// Only g was dirty among the survivors.
+		CHECK(scene.Transforms.Update() == 1);
+		CHECK(ChangedIs(scene.Transforms, { g }));
+		CHECK(scene.Matches());
+
+		// A change to f carries down to g and nowhere else, parents first.
+		scene.SetLocal(f, MakeLocal(2.0f, false, -5, 0, 0));
+		scene.Transforms.Update();
+		CHECK(ChangedIs(scene.Transforms, { f, g }));
+		CHECK(scene.Matches());
+
+		// Freed handles are reused, most recently freed first.
+		const TransformNode j = scene.Add(h, MakeLocal(1.0f, false, 0, 2, 0));
+		const TransformNode k = scene.Add(j, MakeLocal(0.5f, true, 1, 1, 1));
+		CHECK(j == d && k == e);
+		CHECK(scene.Transforms.IsValid(j) && scene.Transforms.Parent(k) == j);
+		scene.Transforms.Update();
+		CHECK(ChangedIs(scene.Transforms, { j, k }));
+		CHECK(scene.Matches());
+
+		// i is dirty and slides down when a goes; h's other children are untouched.
+		scene.SetLocal(i, MakeLocal(1.0f, false, 0, 0, 4));
+		scene.Remove(a);
+		CHECK(!scene.Transforms.IsValid(a) && !scene.Transforms.IsValid(f) && !scene.Transforms.IsValid(g));
+		CHECK(scene.Transforms.Size() == 4);
+		scene.Transforms.Update();
+		CHECK(ChangedIs(scene.Transforms, { i }));
+		CHECK(scene.Matches());
+
+		// The five handles still free are used up before a new one is made.
+		vector<TransformNode> added;
+		for (int n = 0; n < 6; ++n)
+		{
+			added.push_back(scene.Add(k, MakeLocal(1.0f, n % 2 == 0, (float)n, 0, 0)));
+		}
+		vector<TransformNode> reused(added.begin(), added.begin() + 5);
+		sort(reused.begin(), reused.end());
+		vector<TransformNode> freed = { a, b, c, f, g };
+		sort(freed.begin(), freed.end());
+		CHECK(reused == freed);
+		CHECK(added[5] == 9);
+		scene.Transforms.Update();
+		CHECK(scene.Matches());
+	}
+
+	void TestRemoveLeafAndRoot()
+	{
+		const TransformNode None = TransformHierarchy::InvalidNode;
+
+		Scene scene;
+		const TransformNode root = scene.Add(None, MakeLocal(1.0f, false, 0, 1, 0));
+		const TransformNode child = scene.Add(root, MakeLocal(1.0f, true, 1, 0, 0));
+		const TransformNode leaf = scene.Add(child, MakeLocal(2.0f, false, 0, 0, 1));
+		scene.Transforms.Update();
+
+		// Removing the only dirty node leaves nothing to update.
+		scene.SetLocal(leaf, MakeLocal(1.0f, false, 0, 0, 0));
+		scene.Remove(leaf);
+		CHECK(scene.Transforms.Update() == 0);
+		CHECK(scene.Matches());
+
+		scene.Remove(root);
+		CHECK(scene.Transforms.Size() == 0 && !scene.Transforms.IsValid(child));
+		CHECK(scene.Transforms.Update() == 0);
+
+		const TransformNode again = scene.Add(None, MakeLocal(1.0f, false, 3, 0, 0));
+		CHECK(again == root || again == child || again == leaf);
+		CHECK(scene.Transforms.Update() == 1);
+		CHECK(scene.Matches());
+	}
+}
+
+int main()
+{
+	TestRemoveMidHierarchy();
+	TestRemoveLeafAndRoot();
+	return TestResult();
+}
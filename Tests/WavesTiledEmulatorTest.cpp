@@ -0,0 +1,154 @@
+// Steps Waves and WavesTiledEmulator side by side, with disturbances, and checks
+// heights, normals and tangents against each other on the AVX2 and the scalar
+// kernels. The grid is not a multiple of the tile size, so partial tiles and
+// their halos are covered. Standalone; it is not part of the app project and
+// needs no device.
+//
+// The emulator evaluates the scalar kernels' expressions in the same order, so with
+// FP contraction off the two agree exactly; ScalarTolerance only leaves room for a
+// compiler that fuses multiply-adds in one of them. The AVX2 stencil adds the four
+// neighbours pairwise, which rounds differently; over the StepCount steps and
+// disturbances below the difference stays well under AVX2Tolerance.
+//
+//   cl /std:c++17 /EHsc /fp:precise /I.. WavesTiledEmulatorTest.cpp ../WavesTiledEmulator.cpp ../Waves.cpp ../WaveKernels.cpp ../ThreadPool.cpp
+//   g++ -std=c++17 -O2 -ffp-contract=off -pthread -I.. -I<DirectXMath>/Inc -I<sal.h directory> WavesTiledEmulatorTest.cpp ../WavesTiledEmulator.cpp ../Waves.cpp ../WaveKernels.cpp ../ThreadPool.cpp
+
+#include "WavesTiledEmulator.h"
+#include "WaveKernels.h"
+#include "TestUtil.h"
+#include <cmath>
+
+namespace
+{
+	const int Rows = 70;
+	const int Cols = 45;
+	const float SpatialStep = 0.8f;
+	const float TimeStep = 0.03f;
+	const float Speed = 3.25f;
+	const float Damping = 0.2f;
+
+	const int StepCount = 200;
+	const float ScalarTolerance = 1e-6f;
+	const float AVX2Tolerance = 1e-4f;
+
+	struct SurfaceError
+	{
+		float Height = 0.0f;
+		float Normal = 0.0f;
+		float Tangent = 0.0f;
+	};
+
+	// Normals and tangents are only written for interior vertices.
+	SurfaceError CompareSurfaces(const WaveSurface& a, const WaveSurface& b)
+	{
+		SurfaceError error;
+		for (int row = 0; row < Rows; ++row)
+		{
+			for (int col = 0; col < Cols; ++col)
+			{
+				const int i = row * Cols + col;
+				error.Height = max(error.Height, fabsf(a.Height[i] - b.Height[i]));
+
+				if (row == 0 || col == 0 || row == Rows - 1 || col == Cols - 1)
+				{
+					continue;
+				}
+
+				error.Normal = max(error.Normal, fabsf(a.NormalX[i] - b.NormalX[i]));
+				error.Normal = max(error.Normal, fabsf(a.NormalY[i] - b.NormalY[i]));
+				error.Normal = max(error.Normal, fabsf(a.NormalZ[i] - b.NormalZ[i]));
+				error.Tangent = max(error.Tangent, fabsf(a.TangentX[i] - b.TangentX[i]));
+				error.Tangent = max(error.Tangent, fabsf(a.TangentY[i] - b.TangentY[i]));
+			}
+		}
+		return error;
+	}
+
+	void TestConstants()
+	{
+		Waves waves(Rows, Cols, SpatialStep, TimeStep, Speed, Damping);
+		const WaveConstants constants = MakeWaveConstants(Rows, Cols, SpatialStep, TimeStep, Speed, Damping);
+
+		CHECK(constants.NumRows == (uint32_t)Rows && constants.NumCols == (uint32_t)Cols);
+		CHECK(constants.Width == waves.Width() && constants.Depth == waves.Depth());
+		CHECK(constants.SpatialStep == waves.SpatialStep());
+	}
+
+	void TestSideBySide(bool scalar)
+	{
+		WaveKernels::ForceScalar(scalar);
+		const float tolerance = scalar ? ScalarTolerance : AVX2Tolerance;
+
+		ThreadPool pool(4);
+		Waves waves(Rows, Cols, SpatialStep, TimeStep, Speed, Damping);
+		waves.SetThreadPool(&pool);
+		// Small row tiles so several tasks meet inside one emulated tile.
+		waves.SetGrainSize(5);
+		WavesTiledEmulator emulator(Rows, Cols, SpatialStep, TimeStep, Speed, Damping);
+
+		WaveSurface expected;
+		WaveSurface actual;
+		SurfaceError worst;
+		float largestHeight = 0.0f;
+
+		for (int step = 0; step < StepCount; ++step)
+		{
+			// Disturbances at tile corners and edges as well as inside tiles.
+			if (step % 25 == 0)
+			{
+				const int row = 2 + (step * 7) % (Rows - 4);
+				const int col = 2 + (step * 13) % (Cols - 4);
+				const float magnitude = (step % 50 == 0) ? 0.3f : -0.2f;
+				waves.Disturb(row, col, magnitude);
+				emulator.Disturb(row, col, magnitude);
+			}
+			if (step == 10)
+			{
+				waves.Disturb(WaveTileSize, WaveTileSize - 1, 0.4f);
+				emulator.Disturb(WaveTileSize, WaveTileSize - 1, 0.4f);
+			}
+
+			waves.Step(1);
+			emulator.Step(1);
+
+			CHECK(emulator.MaxHeightError(waves) <= tolerance);
+
+			if (step % 10 == 9)
+			{
+				waves.BuildSurface(expected);
+				emulator.BuildSurface(actual);
+
+				const SurfaceError error = CompareSurfaces(expected, actual);
+				worst.Height = max(worst.Height, error.Height);
+				worst.Normal = max(worst.Normal, error.Normal);
+				worst.Tangent = max(worst.Tangent, error.Tangent);
+
+				for (float h : expected.Height)
+				{
+					largestHeight = max(largestHeight, fabsf(h));
+				}
+			}
+		}
+
+		printf("%s: largest height %g, max error height %g, normal %g, tangent %g\n", scalar ? "scalar" : "avx2", largestHeight, worst.Height, worst.Normal, worst.Tangent);
+		CHECK(worst.Height <= tolerance);
+		CHECK(worst.Normal <= tolerance);
+		CHECK(worst.Tangent <= tolerance);
+
+		// The comparison is only meaningful if the waves are still moving.
+		CHECK(largestHeight > 0.01f);
+
+		WaveKernels::ForceScalar(false);
+	}
+}
+
+int main()
+{
+	TestConstants();
+	if (WaveKernels::HasAVX2())
+	{
+		TestSideBySide(false);
+	}
+	TestSideBySide(true);
+	return TestResult();
+}
@@ -0,0 +1,179 @@
+#include "TextureResidencyManager.h"
+#include <algorithm>
+
+TextureResidencyManager::TextureResidencyManager(TextureStreamer* streamer, uint64_t budget)
+	: mStreamer(streamer), mBudget(budget)
+{
+	mStreamer->SetResidencyBudget(StreamingBudget());
+}
+
+TextureResidencyManager::~TextureResidencyManager()
+{
+}
+
+void TextureResidencyManager::TrackStaticTexture(const string& name, const D3D12_RESOURCE_DESC& desc)
+{
+	UntrackStaticTexture(name);
+
+	StaticTexture texture;
+	texture.Bytes = CalcTextureBytes(desc);
+	mStaticTextures[name] = texture;
+
+	mStats.StaticBytes += texture.Bytes;
+	mStreamer->SetResidencyBudget(StreamingBudget());
+}
+
+void TextureResidencyManager::UntrackStaticTexture(const string& name)
+{
+	auto it = mStaticTextures.find(name);
+	if (it == mStaticTextures.end())
+	{
+		return;
+	}
+
+	mStats.StaticBytes -= it->second.Bytes;
+	mStaticTextures.erase(it);
+	mStreamer->SetResidencyBudget(StreamingBudget());
+}
+
+void TextureResidencyManager::MarkUsed(const string& staticName, uint64_t frame)
+{
+	auto it = mStaticTextures.find(staticName);
+	if (it == mStaticTextures.end())
+	{
+		return;
+	}
+
+	it->second.LastUsedFrame = frame;
+	++mStats.Hits;
+}
+
+void TextureResidencyManager::MarkUsed(StreamingTexture* texture, uint32_t desiredMip, uint64_t frame)
+{
+	if (texture->ResidentMip <= desiredMip)
+	{
+		++mStats.Hits;
+	}
+	else
+	{
+		++mStats.Misses;
+	}
+
+	// Several draws can reference the same texture; keep the finest request of the frame.
+	if (texture->LastRequestedFrame == frame)
+	{
+		desiredMip = min(desiredMip, texture->RequestedMip);
+	}
+
+	mStreamer->RequestMip(texture, desiredMip, frame);
+}
+
+void TextureResidencyManager::Update(uint64_t frame)
+{
+	const uint64_t budget = StreamingBudget();
+	const uint64_t pending = mStreamer->PendingUploadBytes();
+	const uint64_t resident = mStreamer->Stats().ResidentBytes;
+
+	if (resident + pending > budget)
+	{
+		EvictUntil((pending < budget) ? budget - pending : 0, frame);
+	}
+
+	const uint64_t streamedBefore = mStreamer->Stats().BytesStreamed;
+	mStreamer->Update();
+
+	mStats.BytesStreamed += mStreamer->Stats().BytesStreamed - streamedBefore;
+	mStats.StreamedBytes = mStreamer->Stats().ResidentBytes;
+}
+
+void TextureResidencyManager::SetBudget(uint64_t bytes)
+{
+	mBudget = bytes;
+	mStreamer->SetResidencyBudget(StreamingBudget());
+}
+
+uint64_t TextureResidencyManager::GetLastUsedFrame(const string& staticName) const
+{
+	auto it = mStaticTextures.find(staticName);
+	return (it == mStaticTextures.end()) ? 0 : it->second.LastUsedFrame;
+}
+
+uint64_t TextureResidencyManager::CalcTextureBytes(const D3D12_RESOURCE_DESC& desc)
+{
+	const uint64_t arraySize = (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) ? 1 : desc.DepthOrArraySize;
+	const UINT mipLevels = (desc.MipLevels == 0) ? 1 : desc.MipLevels;
+
+	uint64_t bytes = 0;
+	size_t w = (size_t)desc.Width;
+	size_t h = desc.Height;
+	size_t d = (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D) ? desc.DepthOrArraySize : 1;
+
+	for (UINT mip = 0; mip < mipLevels; ++mip)
+	{
+		size_t numBytes = 0;
+		GetSurfaceInfo(w, h, desc.Format, &numBytes, nullptr, nullptr);
+		bytes += (uint64_t)numBytes * d;
+
+		w = max<size_t>(w >> 1, 1);
+		h = max<size_t>(h >> 1, 1);
+		d = max<size_t>(d >> 1, 1);
+	}
+
+	return bytes * arraySize;
+}
+
+uint64_t TextureResidencyManager::StreamingBudget() const
+{
+	return (mStats.StaticBytes < mBudget) ? mBudget - mStats.StaticBytes : 0;
+}
+
+void TextureResidencyManager::EvictUntil(uint64_t targetBytes, uint64_t frame)
+{
+	vector<StreamingTexture*> candidates;
+	mStreamer->ForEachTexture([&](StreamingTexture* texture)
+		{
+			// Textures used this frame are never evicted, nor is the mip tail.
+			if (texture->LastRequestedFrame < frame &&
+				texture->ResidentMip < TextureStreamer::MipTailStart(texture->Layout))
+			{
+				candidates.push_back(texture);
+			}
+		});
+
+	sort(candidates.begin(), candidates.end(), [](const StreamingTexture* a, const StreamingTexture* b)
+		{
+			if (a->LastRequestedFrame != b->LastRequestedFrame)
+			{
+				return a->LastRequestedFrame < b->LastRequestedFrame;
+			}
+			return a->ResidentBytes > b->ResidentBytes;
+		});
+
+	for (auto texture : candidates)
+	{
+		const uint32_t tailStart = TextureStreamer::MipTailStart(texture->Layout);
+
+		// Every eviction re-creates the texture, so find how many mips have to go
+		// first and drop them in one call.
+		uint64_t resident = mStreamer->Stats().ResidentBytes;
+		uint32_t firstMip = texture->ResidentMip;
+		while (resident > targetBytes && firstMip < tailStart)
+		{
+			resident -= TextureStreamer::MipBytes(texture->Layout, firstMip);
+			++firstMip;
+		}
+
+		if (firstMip > texture->ResidentMip)
+		{
+			const uint64_t before = texture->ResidentBytes;
+			mStats.Evictions += firstMip - texture->ResidentMip;
+			mStreamer->EvictMips(texture, firstMip);
+			mStats.BytesEvicted += before - texture->ResidentBytes;
+		}
+
+		if (mStreamer->Stats().ResidentBytes <= targetBytes)
+		{
+			break;
+		}
+	}
+}
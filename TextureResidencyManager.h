@@ -0,0 +1,65 @@
+#pragma once
+
+#include "TextureStreamer.h"
+
+struct TextureResidencyStats
+{
+	// A use is a hit when the mip the renderer wanted was already resident.
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+	uint64_t Evictions = 0;
+	uint64_t BytesEvicted = 0;
+	uint64_t BytesStreamed = 0;
+
+	uint64_t StaticBytes = 0;
+	uint64_t StreamedBytes = 0;
+};
+
+// Keeps static and streamed textures under one memory budget. Static textures are
+// fully resident and only counted; streamed textures lose their finest mips in
+// least-recently-used order whenever pending uploads would exceed the budget.
+class TextureResidencyManager
+{
+public:
+	TextureResidencyManager(TextureStreamer* streamer, uint64_t budget);
+	TextureResidencyManager(const TextureResidencyManager& rhs) = delete;
+	TextureResidencyManager& operator=(const TextureResidencyManager& rhs) = delete;
+	~TextureResidencyManager();
+
+	void TrackStaticTexture(const string& name, const D3D12_RESOURCE_DESC& desc);
+	void UntrackStaticTexture(const string& name);
+
+	// Called from the render path for every texture a draw references.
+	void MarkUsed(const string& staticName, uint64_t frame);
+	void MarkUsed(StreamingTexture* texture, uint32_t desiredMip, uint64_t frame);
+
+	// Evicts as needed, then lets the streamer upload within what is left.
+	void Update(uint64_t frame);
+
+	uint64_t GetBudget() const { return mBudget; }
+	void SetBudget(uint64_t bytes);
+
+	uint64_t GetLastUsedFrame(const string& staticName) const;
+
+	const TextureResidencyStats& Stats() const { return mStats; }
+
+	static uint64_t CalcTextureBytes(const D3D12_RESOURCE_DESC& desc);
+
+private:
+	struct StaticTexture
+	{
+		uint64_t Bytes = 0;
+		uint64_t LastUsedFrame = 0;
+	};
+
+	uint64_t StreamingBudget() const;
+	void EvictUntil(uint64_t targetBytes, uint64_t frame);
+
+private:
+	TextureStreamer* mStreamer = nullptr;
+	uint64_t mBudget = 0;
+
+	unordered_map<string, StaticTexture> mStaticTextures;
+
+	TextureResidencyStats mStats;
+};
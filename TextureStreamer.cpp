@@ -0,0 +1,226 @@
+#include "TextureStreamer.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include "MappedFile.h"
+#endif
+
+TextureStreamer::TextureStreamer(TextureUploadBackend* backend, uint64_t residencyBudget, uint64_t uploadBytesPerUpdate)
+	: mBackend(backend), mResidencyBudget(residencyBudget), mUploadBytesPerUpdate(uploadBytesPerUpdate)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	for (auto& e : mTextures)
+	{
+		mBackend->Release(*e.second);
+	}
+}
+
+StreamingTexture* TextureStreamer::AddTexture(
+	const string& name,
+	const uint8_t* data,
+	size_t dataSize,
+	shared_ptr<const void> storage)
+{
+	auto texture = make_unique<StreamingTexture>();
+	texture->Name = name;
+	texture->Data = data;
+	texture->DataSize = dataSize;
+	texture->Storage = move(storage);
+
+	if (FAILED(GetDDSTextureLayout(data, dataSize, texture->Layout)))
+	{
+		return nullptr;
+	}
+
+	// Only plain 2D textures (and arrays/cubes of them) can be re-created with fewer mips.
+	if (texture->Layout.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D)
+	{
+		return nullptr;
+	}
+
+	texture->ResidentMip = texture->Layout.MipCount;
+	texture->RequestedMip = MipTailStart(texture->Layout);
+
+	RemoveTexture(name);
+
+	SetResidentMips(*texture, texture->RequestedMip);
+
+	auto result = texture.get();
+	mTextures[name] = move(texture);
+	return result;
+}
+
+#ifdef _WIN32
+StreamingTexture* TextureStreamer::LoadTexture(const string& name, const wstring& filename)
+{
+	auto file = make_shared<MappedFile>();
+	if (FAILED(file->Open(filename)))
+	{
+		return nullptr;
+	}
+
+	return AddTexture(name, file->Data(), file->Size(), file);
+}
+#endif
+
+void TextureStreamer::RemoveTexture(const string& name)
+{
+	auto it = mTextures.find(name);
+	if (it == mTextures.end())
+	{
+		return;
+	}
+
+	mStats.ResidentBytes -= it->second->ResidentBytes;
+	mBackend->Release(*it->second);
+	mTextures.erase(it);
+}
+
+StreamingTexture* TextureStreamer::GetTexture(const string& name)
+{
+	auto it = mTextures.find(name);
+	return (it == mTextures.end()) ? nullptr : it->second.get();
+}
+
+void TextureStreamer::RequestMip(StreamingTexture* texture, uint32_t mip, uint64_t frame)
+{
+	texture->RequestedMip = min(mip, MipTailStart(texture->Layout));
+	texture->LastRequestedFrame = frame;
+}
+
+void TextureStreamer::EvictMips(StreamingTexture* texture, uint32_t firstMip)
+{
+	firstMip = min(firstMip, MipTailStart(texture->Layout));
+	if (firstMip <= texture->ResidentMip)
+	{
+		return;
+	}
+
+	mStats.MipsEvicted += firstMip - texture->ResidentMip;
+	SetResidentMips(*texture, firstMip);
+
+	// Do not stream the evicted mips straight back in; the renderer has to ask again.
+	texture->RequestedMip = max(texture->RequestedMip, firstMip);
+}
+
+uint64_t TextureStreamer::PendingUploadBytes() const
+{
+	uint64_t bytes = 0;
+	for (auto& e : mTextures)
+	{
+		if (e.second->ResidentMip > e.second->RequestedMip)
+		{
+			bytes += MipBytes(e.second->Layout, e.second->ResidentMip - 1);
+		}
+	}
+	return bytes;
+}
+
+void TextureStreamer::Update()
+{
+	vector<StreamingTexture*> pending;
+	for (auto& e : mTextures)
+	{
+		if (e.second->ResidentMip > e.second->RequestedMip)
+		{
+			pending.push_back(e.second.get());
+		}
+	}
+
+	// Coarse mips first so every texture gets sharper before any one gets its top
+	// mip, then the most recently requested textures.
+	sort(pending.begin(), pending.end(), [](const StreamingTexture* a, const StreamingTexture* b)
+		{
+			if (a->ResidentMip != b->ResidentMip)
+			{
+				return a->ResidentMip > b->ResidentMip;
+			}
+			return a->LastRequestedFrame > b->LastRequestedFrame;
+		});
+
+	uint64_t uploaded = 0;
+	uint32_t remaining = 0;
+
+	for (auto texture : pending)
+	{
+		uint32_t nextMip = texture->ResidentMip - 1;
+		uint64_t bytes = MipBytes(texture->Layout, nextMip);
+
+		// Always let one mip through so a mip larger than the per-update budget
+		// does not stall forever.
+		if (uploaded > 0 && uploaded + bytes > mUploadBytesPerUpdate)
+		{
+			++remaining;
+			continue;
+		}
+
+		if (mStats.ResidentBytes + bytes > mResidencyBudget)
+		{
+			++mStats.BudgetRejections;
+			++remaining;
+			continue;
+		}
+
+		SetResidentMips(*texture, nextMip);
+		uploaded += bytes;
+
+		if (texture->ResidentMip > texture->RequestedMip)
+		{
+			++remaining;
+		}
+	}
+
+	mStats.BytesStreamedLastUpdate = uploaded;
+	mStats.PendingRequests = remaining;
+}
+
+uint32_t TextureStreamer::MipTailStart(const DDSTextureLayout& layout)
+{
+	for (uint32_t mip = 0; mip < layout.MipCount; ++mip)
+	{
+		const auto& sub = layout.Subresource(mip);
+		if (max(sub.Width, sub.Height) <= MipTailDimension)
+		{
+			return mip;
+		}
+	}
+	return layout.MipCount - 1;
+}
+
+uint64_t TextureStreamer::MipBytes(const DDSTextureLayout& layout, uint32_t mip)
+{
+	uint64_t bytes = 0;
+	for (uint32_t item = 0; item < layout.ArraySize; ++item)
+	{
+		bytes += layout.Subresource(mip, item).NumBytes;
+	}
+	return bytes;
+}
+
+void TextureStreamer::SetResidentMips(StreamingTexture& texture, uint32_t firstMip)
+{
+	if (firstMip == texture.ResidentMip)
+	{
+		return;
+	}
+
+	uint64_t oldBytes = texture.ResidentBytes;
+	uint64_t newBytes = texture.Layout.MipRangeBytes(firstMip);
+
+	mBackend->SetResidentMips(texture, firstMip);
+
+	if (firstMip < texture.ResidentMip)
+	{
+		mStats.BytesStreamed += newBytes - oldBytes;
+		mStats.MipsStreamed += texture.ResidentMip - firstMip;
+	}
+
+	mStats.ResidentBytes = mStats.ResidentBytes - oldBytes + newBytes;
+
+	texture.ResidentMip = firstMip;
+	texture.ResidentBytes = newBytes;
+	++texture.ResidencyVersion;
+}
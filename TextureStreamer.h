@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DDSTextureLayout.h"
+
+using namespace std;
+using namespace DirectX;
+
+struct StreamingTexture
+{
+	string Name;
+
+	// Bytes of the whole DDS file. Storage keeps them alive (a MappedFile for
+	// file-backed textures, any buffer for in-memory sources).
+	const uint8_t* Data = nullptr;
+	size_t DataSize = 0;
+	shared_ptr<const void> Storage;
+
+	DDSTextureLayout Layout;
+
+	// Most detailed resident mip; Layout.MipCount means nothing is resident.
+	uint32_t ResidentMip = 0;
+	// Most detailed mip the renderer asked for.
+	uint32_t RequestedMip = 0;
+	// Bumped whenever the resident range changes so views can be rebuilt.
+	uint32_t ResidencyVersion = 0;
+
+	uint64_t ResidentBytes = 0;
+	uint64_t LastRequestedFrame = 0;
+};
+
+// Where streamed mips end up. The D3D12 implementation records copies on a command
+// list; a mock can simply remember the calls.
+class TextureUploadBackend
+{
+public:
+	virtual ~TextureUploadBackend() = default;
+
+	// Changes the resident range of texture from [texture.ResidentMip, MipCount) to
+	// [firstMip, MipCount). Mips that stay resident are kept, newly resident mips are
+	// read from texture.Data.
+	virtual void SetResidentMips(const StreamingTexture& texture, uint32_t firstMip) = 0;
+
+	virtual void Release(const StreamingTexture& texture) = 0;
+};
+
+struct TextureStreamingStats
+{
+	uint64_t ResidentBytes = 0;
+	uint64_t BytesStreamed = 0;
+	uint64_t BytesStreamedLastUpdate = 0;
+	uint32_t MipsStreamed = 0;
+	uint32_t MipsEvicted = 0;
+	uint32_t PendingRequests = 0;
+	uint32_t BudgetRejections = 0;
+};
+
+class TextureStreamer
+{
+public:
+	TextureStreamer(TextureUploadBackend* backend, uint64_t residencyBudget, uint64_t uploadBytesPerUpdate);
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+	~TextureStreamer();
+
+	// Parses the DDS header and makes the mip tail resident right away. Returns
+	// nullptr if the data is not a DDS file this path understands.
+	StreamingTexture* AddTexture(
+		const string& name,
+		const uint8_t* data,
+		size_t dataSize,
+		shared_ptr<const void> storage);
+
+#ifdef _WIN32
+	StreamingTexture* LoadTexture(const string& name, const wstring& filename);
+#endif
+
+	void RemoveTexture(const string& name);
+	StreamingTexture* GetTexture(const string& name);
+
+	void RequestMip(StreamingTexture* texture, uint32_t mip, uint64_t frame);
+
+	// Drops mips finer than firstMip; the mip tail always stays resident.
+	void EvictMips(StreamingTexture* texture, uint32_t firstMip);
+
+	// Bytes the next Update would like to upload, ignoring the budgets.
+	uint64_t PendingUploadBytes() const;
+
+	template<typename Fn>
+	void ForEachTexture(Fn fn)
+	{
+		for (auto& e : mTextures)
+		{
+			fn(e.second.get());
+		}
+	}
+
+	// Streams at most one mip per texture, coarsest first, within the upload and
+	// residency budgets.
+	void Update();
+
+	uint64_t GetResidencyBudget() const { return mResidencyBudget; }
+	void SetResidencyBudget(uint64_t bytes) { mResidencyBudget = bytes; }
+	void SetUploadBytesPerUpdate(uint64_t bytes) { mUploadBytesPerUpdate = bytes; }
+
+	const TextureStreamingStats& Stats() const { return mStats; }
+
+	static uint32_t MipTailStart(const DDSTextureLayout& layout);
+	static uint64_t MipBytes(const DDSTextureLayout& layout, uint32_t mip);
+
+public:
+	// Mips whose largest dimension is at most this are loaded with the texture.
+	static constexpr uint32_t MipTailDimension = 128;
+
+private:
+	void SetResidentMips(StreamingTexture& texture, uint32_t firstMip);
+
+private:
+	TextureUploadBackend* mBackend = nullptr;
+
+	uint64_t mResidencyBudget = 0;
+	uint64_t mUploadBytesPerUpdate = 0;
+
+	unordered_map<string, unique_ptr<StreamingTexture>> mTextures;
+
+	TextureStreamingStats mStats;
+};
@@ -0,0 +1,181 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+	thread_local bool tInsideParallelFor = false;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount, bool pinThreads)
+{
+	if (threadCount == 0)
+	{
+		threadCount = max(1u, thread::hardware_concurrency());
+	}
+
+	if (pinThreads)
+	{
+		PinCurrentThread(0);
+	}
+
+	for (unsigned i = 1; i < threadCount; ++i)
+	{
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i, pinThreads);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWake.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(int begin, int end, int grain, const function<void(int, int)>& body)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+
+	grain = max(1, grain);
+
+	if (mWorkers.empty() || end - begin <= grain || tInsideParallelFor)
+	{
+		for (int i = begin; i < end; i += grain)
+		{
+			body(i, min(end, i + grain));
+		}
+		return;
+	}
+
+	lock_guard<mutex> dispatch(mDispatchMutex);
+
+	{
+		lock_guard<mutex> lock(mMutex);
+		mBody = &body;
+		mNext = begin;
+		mEnd = end;
+		mGrain = grain;
+		mError = nullptr;
+		mBusyWorkers = (unsigned)mWorkers.size();
+		++mGeneration;
+	}
+	mWake.notify_all();
+
+	RunChunks();
+
+	// Every worker has to finish this generation before the job fields can change.
+	exception_ptr error;
+	{
+		unique_lock<mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return mBusyWorkers == 0; });
+		mBody = nullptr;
+		error = mError;
+	}
+
+	if (error)
+	{
+		rethrow_exception(error);
+	}
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::WorkerLoop(unsigned index, bool pin)
+{
+	if (pin)
+	{
+		PinCurrentThread(index);
+	}
+
+	uint64_t seenGeneration = 0;
+
+	unique_lock<mutex> lock(mMutex);
+	for (;;)
+	{
+		mWake.wait(lock, [&] { return mStop || mGeneration != seenGeneration; });
+		if (mStop)
+		{
+			return;
+		}
+
+		seenGeneration = mGeneration;
+
+		lock.unlock();
+		RunChunks();
+		lock.lock();
+
+		if (--mBusyWorkers == 0)
+		{
+			mDone.notify_one();
+		}
+	}
+}
+
+void ThreadPool::RunChunks()
+{
+	tInsideParallelFor = true;
+
+	for (;;)
+	{
+		int chunkBegin = mNext.fetch_add(mGrain);
+		if (chunkBegin >= mEnd)
+		{
+			break;
+		}
+
+		try
+		{
+			(*mBody)(chunkBegin, min(mEnd, chunkBegin + mGrain));
+		}
+		catch (...)
+		{
+			lock_guard<mutex> lock(mMutex);
+			if (!mError)
+			{
+				mError = current_exception();
+			}
+			// Skip whatever is left.
+			mNext = mEnd;
+		}
+	}
+
+	tInsideParallelFor = false;
+}
+
+void ThreadPool::PinCurrentThread(unsigned core)
+{
+	const unsigned coreCount = max(1u, thread::hardware_concurrency());
+	core %= coreCount;
+
+#ifdef _WIN32
+	if (core < sizeof(DWORD_PTR) * 8)
+	{
+		SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+	}
+#else
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Fixed set of worker threads for data-parallel loops. The calling thread joins in
+// on every ParallelFor, so a pool of N threads has N - 1 workers.
+class ThreadPool
+{
+public:
+	// threadCount == 0 uses every hardware thread. With pinThreads each worker is
+	// bound to its own core, the caller keeps core 0.
+	explicit ThreadPool(unsigned threadCount = 0, bool pinThreads = false);
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+	~ThreadPool();
+
+	unsigned ThreadCount() const { return (unsigned)mWorkers.size() + 1; }
+
+	// Calls body(chunkBegin, chunkEnd) over [begin, end) in chunks of at most grain
+	// indices and returns once all of them are done. The first exception thrown by
+	// body is rethrown here. Calls from inside a body run serially.
+	void ParallelFor(int begin, int end, int grain, const function<void(int, int)>& body);
+
+	static ThreadPool& Default();
+
+private:
+	void WorkerLoop(unsigned index, bool pin);
+	void RunChunks();
+
+	static void PinCurrentThread(unsigned core);
+
+private:
+	vector<thread> mWorkers;
+
+	// One ParallelFor at a time; the job fields below belong to it.
+	mutex mDispatchMutex;
+
+	mutex mMutex;
+	condition_variable mWake;
+	condition_variable mDone;
+	uint64_t mGeneration = 0;
+	unsigned mBusyWorkers = 0;
+	bool mStop = false;
+
+	const function<void(int, int)>* mBody = nullptr;
+	atomic<int> mNext{ 0 };
+	int mEnd = 0;
+	int mGrain = 1;
+	exception_ptr mError;
+};
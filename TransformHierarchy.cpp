@@ -0,0 +1,134 @@
+#include "TransformHierarchy.h"
+#include "SimdMath.h"
+
+#include <algorithm>
+
+TransformNode TransformHierarchy::Add(TransformNode parent, const XMFLOAT4X4& local)
+{
+	// Appending keeps parents first: the parent already has a slot.
+	const uint32_t slot = (uint32_t)mNodes.size();
+
+	TransformNode node;
+	if (!mFreeNodes.empty())
+	{
+		node = mFreeNodes.back();
+		mFreeNodes.pop_back();
+		mSlots[node] = slot;
+	}
+	else
+	{
+		node = (TransformNode)mSlots.size();
+		mSlots.push_back(slot);
+	}
+
+	mParentSlots.push_back(parent == InvalidNode ? InvalidSlot : mSlots[parent]);
+	mLocal.push_back(local);
+	mWorld.push_back(local);
+	mDirty.push_back(1);
+	mNodes.push_back(node);
+
+	mFirstDirty = min(mFirstDirty, slot);
+	return node;
+}
+
+void TransformHierarchy::Remove(TransformNode node)
+{
+	const uint32_t root = mSlots[node];
+	const uint32_t count = (uint32_t)mNodes.size();
+
+	// Descendants come after root, so one pass finds the subtree. Survivors slide
+	// down over the removed slots, keeping their order.
+	vector<uint32_t> newSlots(count - root, InvalidSlot);
+	uint32_t write = root;
+
+	for (uint32_t slot = root; slot < count; ++slot)
+	{
+		const uint32_t parent = mParentSlots[slot];
+		const bool removed = slot == root || (parent >= root && parent != InvalidSlot && newSlots[parent - root] == InvalidSlot);
+
+		if (removed)
+		{
+			mSlots[mNodes[slot]] = InvalidSlot;
+			mFreeNodes.push_back(mNodes[slot]);
+			continue;
+		}
+
+		newSlots[slot - root] = write;
+		mParentSlots[write] = (parent != InvalidSlot && parent >= root) ? newSlots[parent - root] : parent;
+		mLocal[write] = mLocal[slot];
+		mWorld[write] = mWorld[slot];
+		mDirty[write] = mDirty[slot];
+		mNodes[write] = mNodes[slot];
+		mSlots[mNodes[write]] = write;
+		++write;
+	}
+
+	mParentSlots.resize(write);
+	mLocal.resize(write);
+	mWorld.resize(write);
+	mDirty.resize(write);
+	mNodes.resize(write);
+
+	if (mFirstDirty != InvalidSlot && mFirstDirty > root)
+	{
+		mFirstDirty = root;
+	}
+	if (mFirstDirty >= write)
+	{
+		mFirstDirty = InvalidSlot;
+	}
+}
+
+void TransformHierarchy::SetLocal(TransformNode node, const XMFLOAT4X4& local)
+{
+	const uint32_t slot = mSlots[node];
+	mLocal[slot] = local;
+	mDirty[slot] = 1;
+	mFirstDirty = min(mFirstDirty, slot);
+}
+
+TransformNode TransformHierarchy::Parent(TransformNode node) const
+{
+	const uint32_t parent = mParentSlots[mSlots[node]];
+	return parent == InvalidSlot ? InvalidNode : mNodes[parent];
+}
+
+uint32_t TransformHierarchy::Update()
+{
+	mChanged.clear();
+
+	const uint32_t count = (uint32_t)mNodes.size();
+	for (uint32_t slot = mFirstDirty; slot < count; ++slot)
+	{
+		// A parent recomputed earlier in this pass is still marked, which carries
+		// the change down its subtree.
+		const uint32_t parent = mParentSlots[slot];
+		if (parent != InvalidSlot && mDirty[parent])
+		{
+			mDirty[slot] = 1;
+		}
+
+		if (!mDirty[slot])
+		{
+			continue;
+		}
+
+		if (parent == InvalidSlot)
+		{
+			mWorld[slot] = mLocal[slot];
+		}
+		else
+		{
+			SimdMath::MultiplyMatrix(&mLocal[slot]._11, &mWorld[parent]._11, &mWorld[slot]._11);
+		}
+		mChanged.push_back(mNodes[slot]);
+	}
+
+	for (TransformNode node : mChanged)
+	{
+		mDirty[mSlots[node]] = 0;
+	}
+
+	mFirstDirty = InvalidSlot;
+	return (uint32_t)mChanged.size();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace std;
+using namespace DirectX;
+
+typedef uint32_t TransformNode;
+
+// Parent-child transforms, world = local * parent world. Nodes are kept in flat
+// arrays, one per component, in an order where every parent comes before its
+// children, so one forward pass over the arrays updates the whole hierarchy.
+// SetLocal only marks the node; Update recomputes the world matrices of marked
+// nodes and their subtrees and leaves everything else alone.
+class TransformHierarchy
+{
+public:
+	static constexpr TransformNode InvalidNode = UINT32_MAX;
+
+	// parent is InvalidNode for a root. Handles stay valid until the node is removed.
+	TransformNode Add(TransformNode parent, const XMFLOAT4X4& local);
+
+	// Removes node and its whole subtree.
+	void Remove(TransformNode node);
+
+	void SetLocal(TransformNode node, const XMFLOAT4X4& local);
+
+	const XMFLOAT4X4& Local(TransformNode node) const { return mLocal[mSlots[node]]; }
+	// As of the last Update.
+	const XMFLOAT4X4& World(TransformNode node) const { return mWorld[mSlots[node]]; }
+	TransformNode Parent(TransformNode node) const;
+
+	bool IsValid(TransformNode node) const { return node < mSlots.size() && mSlots[node] != InvalidSlot; }
+	uint32_t Size() const { return (uint32_t)mNodes.size(); }
+
+	// Returns the number of world matrices recomputed.
+	uint32_t Update();
+
+	// Nodes whose world matrix Update recomputed, parents first.
+	const vector<TransformNode>& Changed() const { return mChanged; }
+
+private:
+	static constexpr uint32_t InvalidSlot = UINT32_MAX;
+
+	// Per slot, in parent-first order.
+	vector<uint32_t> mParentSlots;
+	vector<XMFLOAT4X4> mLocal;
+	vector<XMFLOAT4X4> mWorld;
+	vector<uint8_t> mDirty;
+	vector<TransformNode> mNodes;
+
+	// Slot of each handle; InvalidSlot for removed ones, which are reused.
+	vector<uint32_t> mSlots;
+	vector<TransformNode> mFreeNodes;
+
+	// Update starts here; slots before it are clean.
+	uint32_t mFirstDirty = InvalidSlot;
+
+	vector<TransformNode> mChanged;
+};
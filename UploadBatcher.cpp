@@ -0,0 +1,335 @@
+#include "UploadBatcher.h"
+
+UploadBatcher::UploadBatcher(ID3D12Device* device, UINT64 pageSize)
+	: md3dDevice(device), mPageSize(pageSize)
+{
+	ThrowIfFailed(md3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+}
+
+UploadBatcher::~UploadBatcher()
+{
+	// Pages still in flight are read by the GPU; wait for them before releasing.
+	if (mFence != nullptr && mFence->GetCompletedValue() < mFenceValue)
+	{
+		HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+		ThrowIfFailed(mFence->SetEventOnCompletion(mFenceValue, eventHandle));
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+}
+
+unique_ptr<UploadBatcher::Page> UploadBatcher::CreatePage(UINT64 size)
+{
+	auto page = make_unique<Page>();
+	page->Size = size;
+
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(page->Resource.GetAddressOf())));
+
+	// Upload heaps may stay mapped for their whole life.
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(page->Resource->Map(0, &readRange, reinterpret_cast<void**>(&page->CpuAddress)));
+
+	++mStats.PagesCreated;
+	return page;
+}
+
+UploadAllocation UploadBatcher::Allocate(UINT64 byteSize, UINT64 alignment)
+{
+	byteSize = max<UINT64>(byteSize, 1);
+
+	auto alignUp = [alignment](UINT64 v) { return (v + alignment - 1) / alignment * alignment; };
+
+	if (byteSize > mPageSize)
+	{
+		auto page = CreatePage(alignUp(byteSize));
+		page->Used = page->Size;
+
+		UploadAllocation allocation;
+		allocation.CpuAddress = page->CpuAddress;
+		allocation.Resource = page->Resource.Get();
+		allocation.Offset = 0;
+		allocation.Size = byteSize;
+
+		mFilledPages.push_back(move(page));
+		mStats.BytesStaged += byteSize;
+		return allocation;
+	}
+
+	if (mCurrentPage != nullptr && alignUp(mCurrentPage->Used) + byteSize > mCurrentPage->Size)
+	{
+		mFilledPages.push_back(move(mCurrentPage));
+	}
+
+	if (mCurrentPage == nullptr)
+	{
+		if (mFreePages.empty())
+		{
+			Recycle();
+		}
+
+		if (!mFreePages.empty())
+		{
+			mCurrentPage = move(mFreePages.back());
+			mFreePages.pop_back();
+		}
+		else
+		{
+			mCurrentPage = CreatePage(mPageSize);
+		}
+	}
+
+	UINT64 offset = alignUp(mCurrentPage->Used);
+	mCurrentPage->Used = offset + byteSize;
+
+	UploadAllocation allocation;
+	allocation.CpuAddress = mCurrentPage->CpuAddress + offset;
+	allocation.Resource = mCurrentPage->Resource.Get();
+	allocation.Offset = offset;
+	allocation.Size = byteSize;
+
+	mStats.BytesStaged += byteSize;
+	return allocation;
+}
+
+void UploadBatcher::AddTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	// Several copies into one resource share a single pair of barriers.
+	for (auto& t : mTransitions)
+	{
+		if (t.Resource == resource)
+		{
+			t.After = after;
+			return;
+		}
+	}
+
+	PendingTransition t;
+	t.Resource = resource;
+	t.Before = before;
+	t.After = after;
+	mTransitions.push_back(t);
+}
+
+void UploadBatcher::CopyBuffer(
+	ID3D12Resource* dest,
+	UINT64 destOffset,
+	const UploadAllocation& src,
+	UINT64 srcOffset,
+	UINT64 byteSize,
+	D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter)
+{
+	PendingCopy copy;
+	copy.Dest = dest;
+	copy.Source = src.Resource;
+	copy.DestOffset = destOffset;
+	copy.SourceOffset = src.Offset + srcOffset;
+	copy.ByteSize = byteSize;
+	mCopies.push_back(copy);
+
+	AddTransition(dest, stateBefore, stateAfter);
+}
+
+void UploadBatcher::UploadBuffer(
+	ID3D12Resource* dest,
+	UINT64 destOffset,
+	const void* data,
+	UINT64 byteSize,
+	D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter)
+{
+	UploadAllocation allocation = Allocate(byteSize);
+	memcpy(allocation.CpuAddress, data, (size_t)byteSize);
+
+	CopyBuffer(dest, destOffset, allocation, 0, byteSize, stateBefore, stateAfter);
+}
+
+ComPtr<ID3D12Resource> UploadBatcher::CreateBuffer(const void* data, UINT64 byteSize, D3D12_RESOURCE_STATES stateAfter)
+{
+	ComPtr<ID3D12Resource> buffer;
+
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(buffer.GetAddressOf())));
+
+	UploadBuffer(buffer.Get(), 0, data, byteSize, D3D12_RESOURCE_STATE_COMMON, stateAfter);
+	return buffer;
+}
+
+void UploadBatcher::UploadTexture(
+	ID3D12Resource* dest,
+	UINT firstSubresource,
+	UINT numSubresources,
+	const D3D12_SUBRESOURCE_DATA* data,
+	D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter)
+{
+	vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+	vector<UINT> numRows(numSubresources);
+	vector<UINT64> rowSizes(numSubresources);
+	UINT64 totalBytes = 0;
+
+	D3D12_RESOURCE_DESC desc = dest->GetDesc();
+	md3dDevice->GetCopyableFootprints(&desc, firstSubresource, numSubresources, 0,
+		layouts.data(), numRows.data(), rowSizes.data(), &totalBytes);
+
+	UploadAllocation allocation = Allocate(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	for (UINT i = 0; i < numSubresources; ++i)
+	{
+		const auto& footprint = layouts[i].Footprint;
+		uint8_t* dstSlice = allocation.CpuAddress + layouts[i].Offset;
+		const uint8_t* srcSlice = static_cast<const uint8_t*>(data[i].pData);
+
+		for (UINT z = 0; z < footprint.Depth; ++z)
+		{
+			for (UINT y = 0; y < numRows[i]; ++y)
+			{
+				memcpy(dstSlice + (UINT64)footprint.RowPitch * (z * numRows[i] + y),
+					srcSlice + data[i].SlicePitch * z + data[i].RowPitch * y,
+					(size_t)rowSizes[i]);
+			}
+		}
+
+		PendingCopy copy;
+		copy.Dest = dest;
+		copy.Source = allocation.Resource;
+		copy.Texture = true;
+		copy.Subresource = firstSubresource + i;
+		copy.Footprint = layouts[i];
+		copy.Footprint.Offset += allocation.Offset;
+		mCopies.push_back(copy);
+	}
+
+	AddTransition(dest, stateBefore, stateAfter);
+}
+
+void UploadBatcher::Flush(ID3D12GraphicsCommandList* cmdList)
+{
+	if (!mCopies.empty())
+	{
+		vector<D3D12_RESOURCE_BARRIER> barriers;
+		barriers.reserve(mTransitions.size());
+
+		for (auto& t : mTransitions)
+		{
+			if (t.Before != t.After && t.Before != D3D12_RESOURCE_STATE_COPY_DEST)
+			{
+				barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(t.Resource, t.Before, D3D12_RESOURCE_STATE_COPY_DEST));
+			}
+		}
+
+		if (!barriers.empty())
+		{
+			cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+			mStats.BarriersRecorded += barriers.size();
+		}
+
+		for (auto& copy : mCopies)
+		{
+			if (copy.Texture)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(copy.Dest.Get(), copy.Subresource);
+				CD3DX12_TEXTURE_COPY_LOCATION src(copy.Source, copy.Footprint);
+				cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+			else
+			{
+				cmdList->CopyBufferRegion(copy.Dest.Get(), copy.DestOffset, copy.Source, copy.SourceOffset, copy.ByteSize);
+			}
+		}
+		mStats.CopiesRecorded += mCopies.size();
+
+		barriers.clear();
+		for (auto& t : mTransitions)
+		{
+			if (t.Before != t.After && t.After != D3D12_RESOURCE_STATE_COPY_DEST)
+			{
+				barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(t.Resource, D3D12_RESOURCE_STATE_COPY_DEST, t.After));
+			}
+		}
+
+		if (!barriers.empty())
+		{
+			cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+			mStats.BarriersRecorded += barriers.size();
+		}
+
+		mCopies.clear();
+		mTransitions.clear();
+	}
+
+	// Everything allocated so far belongs to this batch; later allocations start
+	// on a new page.
+	for (auto& page : mFilledPages)
+	{
+		mFlushedPages.push_back(move(page));
+	}
+	mFilledPages.clear();
+
+	if (mCurrentPage != nullptr)
+	{
+		mFlushedPages.push_back(move(mCurrentPage));
+	}
+}
+
+UINT64 UploadBatcher::Signal(ID3D12CommandQueue* queue)
+{
+	if (mFlushedPages.empty())
+	{
+		return mFenceValue;
+	}
+
+	ThrowIfFailed(queue->Signal(mFence.Get(), ++mFenceValue));
+
+	for (auto& page : mFlushedPages)
+	{
+		page->Fence = mFenceValue;
+		mInFlightPages.push_back(move(page));
+	}
+	mFlushedPages.clear();
+
+	++mStats.BatchesSignaled;
+	return mFenceValue;
+}
+
+void UploadBatcher::Recycle()
+{
+	const UINT64 completed = mFence->GetCompletedValue();
+
+	auto it = partition(mInFlightPages.begin(), mInFlightPages.end(),
+		[completed](const unique_ptr<Page>& page)
+		{
+			return page->Fence > completed;
+		});
+
+	for (auto done = it; done != mInFlightPages.end(); ++done)
+	{
+		// Oversized pages are one-offs.
+		if ((*done)->Size != mPageSize)
+		{
+			continue;
+		}
+
+		(*done)->Used = 0;
+		(*done)->Fence = 0;
+		mFreePages.push_back(move(*done));
+		++mStats.PagesRecycled;
+	}
+
+	mInFlightPages.erase(it, mInFlightPages.end());
+}
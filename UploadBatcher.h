@@ -0,0 +1,150 @@
+#pragma once
+
+#include "D3DUtil.h"
+
+// Upload heap memory handed out by UploadBatcher::Allocate. It stays valid until
+// the batch it belongs to has been signaled and completed.
+struct UploadAllocation
+{
+	uint8_t* CpuAddress = nullptr;
+	ID3D12Resource* Resource = nullptr;
+	UINT64 Offset = 0;
+	UINT64 Size = 0;
+};
+
+struct UploadBatcherStats
+{
+	UINT64 BytesStaged = 0;
+	UINT64 CopiesRecorded = 0;
+	UINT64 BarriersRecorded = 0;
+	UINT PagesCreated = 0;
+	UINT PagesRecycled = 0;
+	UINT BatchesSignaled = 0;
+};
+
+// Replaces a committed upload resource per D3DUtil::CreateDefaultBuffer call.
+// Uploads are sub-allocated from shared upload heap pages and recorded together by
+// Flush: one barrier call into COPY_DEST, all copies, one barrier call into the
+// final states. Signal puts a fence behind the batch and its pages go back to the
+// free list once that fence completes.
+//
+// Per batch: queue uploads, Flush on a command list, execute it, then Signal on
+// the same queue. Passing the same state before and after skips the barriers and
+// relies on implicit promotion to COPY_DEST and decay back to COMMON, which is
+// what the copy queue needs.
+class UploadBatcher
+{
+public:
+	UploadBatcher(ID3D12Device* device, UINT64 pageSize = 8ull * 1024 * 1024);
+	UploadBatcher(const UploadBatcher& rhs) = delete;
+	UploadBatcher& operator=(const UploadBatcher& rhs) = delete;
+	~UploadBatcher();
+
+	// Allocations larger than the page size get a page of their own that is
+	// released instead of pooled.
+	UploadAllocation Allocate(UINT64 byteSize, UINT64 alignment = 16);
+
+	// Copies byteSize bytes at src.Offset + srcOffset into dest.
+	void CopyBuffer(
+		ID3D12Resource* dest,
+		UINT64 destOffset,
+		const UploadAllocation& src,
+		UINT64 srcOffset,
+		UINT64 byteSize,
+		D3D12_RESOURCE_STATES stateBefore = D3D12_RESOURCE_STATE_COMMON,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	void UploadBuffer(
+		ID3D12Resource* dest,
+		UINT64 destOffset,
+		const void* data,
+		UINT64 byteSize,
+		D3D12_RESOURCE_STATES stateBefore = D3D12_RESOURCE_STATE_COMMON,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// Drop-in for D3DUtil::CreateDefaultBuffer without the per-call uploader.
+	ComPtr<ID3D12Resource> CreateBuffer(
+		const void* data,
+		UINT64 byteSize,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	void UploadTexture(
+		ID3D12Resource* dest,
+		UINT firstSubresource,
+		UINT numSubresources,
+		const D3D12_SUBRESOURCE_DATA* data,
+		D3D12_RESOURCE_STATES stateBefore = D3D12_RESOURCE_STATE_COMMON,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	bool HasPendingCopies() const { return !mCopies.empty(); }
+
+	// Records every upload queued since the last Flush on cmdList.
+	void Flush(ID3D12GraphicsCommandList* cmdList);
+
+	// Call once the flushed command list has been submitted to queue. Returns the
+	// fence value that retires the batch.
+	UINT64 Signal(ID3D12CommandQueue* queue);
+
+	// Moves pages of completed batches back to the free list. Allocate does this
+	// on its own when it runs out of pages.
+	void Recycle();
+
+	UINT64 CompletedFenceValue() const { return mFence->GetCompletedValue(); }
+	ID3D12Fence* Fence() const { return mFence.Get(); }
+
+	const UploadBatcherStats& Stats() const { return mStats; }
+
+private:
+	struct Page
+	{
+		ComPtr<ID3D12Resource> Resource;
+		uint8_t* CpuAddress = nullptr;
+		UINT64 Size = 0;
+		UINT64 Used = 0;
+		UINT64 Fence = 0;
+	};
+
+	struct PendingCopy
+	{
+		ComPtr<ID3D12Resource> Dest;
+		ID3D12Resource* Source = nullptr;
+		bool Texture = false;
+
+		UINT64 DestOffset = 0;
+		UINT64 SourceOffset = 0;
+		UINT64 ByteSize = 0;
+
+		UINT Subresource = 0;
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint = {};
+	};
+
+	struct PendingTransition
+	{
+		ID3D12Resource* Resource = nullptr;
+		D3D12_RESOURCE_STATES Before = D3D12_RESOURCE_STATE_COMMON;
+		D3D12_RESOURCE_STATES After = D3D12_RESOURCE_STATE_COMMON;
+	};
+
+	unique_ptr<Page> CreatePage(UINT64 size);
+	void AddTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+	UINT64 mPageSize = 0;
+
+	ComPtr<ID3D12Fence> mFence;
+	UINT64 mFenceValue = 0;
+
+	// Pages are either free, being filled (current plus full ones), flushed and
+	// waiting for Signal, or in flight behind a fence.
+	unique_ptr<Page> mCurrentPage;
+	vector<unique_ptr<Page>> mFilledPages;
+	vector<unique_ptr<Page>> mFlushedPages;
+	vector<unique_ptr<Page>> mInFlightPages;
+	vector<unique_ptr<Page>> mFreePages;
+
+	vector<PendingCopy> mCopies;
+	vector<PendingTransition> mTransitions;
+
+	UploadBatcherStats mStats;
+};
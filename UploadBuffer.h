@@ -53,6 +53,14 @@ public:
 		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
 	}
 
+	// Copies count consecutive elements at once; structured buffers only, constant
+	// buffer elements are padded.
+	void CopyData(int firstElement, const T* data, UINT count)
+	{
+		assert(!mIsConstantBuffer);
+		memcpy(&mMappedData[firstElement * mElementByteSize], data, sizeof(T) * count);
+	}
+
 private:
 	ComPtr<ID3D12Resource> mUploadBuffer;
 	BYTE* mMappedData = nullptr;
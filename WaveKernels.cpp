@@ -0,0 +1,221 @@
+#include "WaveKernels.h"
+#include <cmath>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define WAVE_AVX2_TARGET
+#else
+#define WAVE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+	bool gForceScalar = false;
+
+	bool DetectAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool UseAVX2()
+	{
+		return WaveKernels::HasAVX2() && !gForceScalar;
+	}
+
+	void StencilRowScalar(
+		const float* prev, const float* curr, float* next,
+		int numCols, int begin, int end, float k1, float k2, float k3)
+	{
+		const float* up = curr - numCols;
+		const float* down = curr + numCols;
+
+		for (int j = begin; j < end; ++j)
+		{
+			next[j] = k1 * prev[j] + k2 * curr[j] +
+				k3 * (down[j] + up[j] + curr[j + 1] + curr[j - 1]);
+		}
+	}
+
+	void NormalRowScalar(
+		const float* h, int numCols, int begin, int end, float spatialStep,
+		float* nx, float* ny, float* nz, float* tx, float* ty)
+	{
+		const float twoDx = 2.0f * spatialStep;
+
+		for (int j = begin; j < end; ++j)
+		{
+			float l = h[j - 1];
+			float r = h[j + 1];
+			float t = h[j - numCols];
+			float b = h[j + numCols];
+
+			float x = l - r;
+			float z = b - t;
+			float invLen = 1.0f / sqrtf(x * x + twoDx * twoDx + z * z);
+			nx[j] = x * invLen;
+			ny[j] = twoDx * invLen;
+			nz[j] = z * invLen;
+
+			float y = r - l;
+			float invTanLen = 1.0f / sqrtf(twoDx * twoDx + y * y);
+			tx[j] = twoDx * invTanLen;
+			ty[j] = y * invTanLen;
+		}
+	}
+
+	WAVE_AVX2_TARGET
+	void StencilRowAVX2(
+		const float* prev, const float* curr, float* next,
+		int numCols, int begin, int end, float k1, float k2, float k3)
+	{
+		const float* up = curr - numCols;
+		const float* down = curr + numCols;
+
+		const __m256 vk1 = _mm256_set1_ps(k1);
+		const __m256 vk2 = _mm256_set1_ps(k2);
+		const __m256 vk3 = _mm256_set1_ps(k3);
+
+		int j = begin;
+		for (; j + 8 <= end; j += 8)
+		{
+			__m256 sum = _mm256_add_ps(
+				_mm256_add_ps(_mm256_loadu_ps(down + j), _mm256_loadu_ps(up + j)),
+				_mm256_add_ps(_mm256_loadu_ps(curr + j + 1), _mm256_loadu_ps(curr + j - 1)));
+
+			__m256 v = _mm256_mul_ps(vk1, _mm256_loadu_ps(prev + j));
+			v = _mm256_add_ps(v, _mm256_mul_ps(vk2, _mm256_loadu_ps(curr + j)));
+			v = _mm256_add_ps(v, _mm256_mul_ps(vk3, sum));
+
+			_mm256_storeu_ps(next + j, v);
+		}
+
+		StencilRowScalar(prev, curr, next, numCols, j, end, k1, k2, k3);
+	}
+
+	WAVE_AVX2_TARGET
+	void NormalRowAVX2(
+		const float* h, int numCols, int begin, int end, float spatialStep,
+		float* nx, float* ny, float* nz, float* tx, float* ty)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 twoDx = _mm256_set1_ps(2.0f * spatialStep);
+		const __m256 twoDxSq = _mm256_mul_ps(twoDx, twoDx);
+
+		int j = begin;
+		for (; j + 8 <= end; j += 8)
+		{
+			__m256 l = _mm256_loadu_ps(h + j - 1);
+			__m256 r = _mm256_loadu_ps(h + j + 1);
+			__m256 t = _mm256_loadu_ps(h + j - numCols);
+			__m256 b = _mm256_loadu_ps(h + j + numCols);
+
+			__m256 x = _mm256_sub_ps(l, r);
+			__m256 z = _mm256_sub_ps(b, t);
+			__m256 lenSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), twoDxSq), _mm256_mul_ps(z, z));
+			__m256 invLen = _mm256_div_ps(one, _mm256_sqrt_ps(lenSq));
+
+			_mm256_storeu_ps(nx + j, _mm256_mul_ps(x, invLen));
+			_mm256_storeu_ps(ny + j, _mm256_mul_ps(twoDx, invLen));
+			_mm256_storeu_ps(nz + j, _mm256_mul_ps(z, invLen));
+
+			// The tangent's slope is -x, so its length only needs x * x.
+			__m256 invTanLen = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(twoDxSq, _mm256_mul_ps(x, x))));
+
+			_mm256_storeu_ps(tx + j, _mm256_mul_ps(twoDx, invTanLen));
+			_mm256_storeu_ps(ty + j, _mm256_mul_ps(_mm256_sub_ps(r, l), invTanLen));
+		}
+
+		NormalRowScalar(h, numCols, j, end, spatialStep, nx, ny, nz, tx, ty);
+	}
+}
+
+void WaveKernels::Stencil(
+	const float* prev,
+	const float* curr,
+	float* next,
+	int numCols,
+	int rowBegin,
+	int rowEnd,
+	float k1,
+	float k2,
+	float k3)
+{
+	const bool avx2 = UseAVX2();
+
+	for (int i = rowBegin; i < rowEnd; ++i)
+	{
+		const size_t row = (size_t)i * numCols;
+
+		if (avx2)
+		{
+			StencilRowAVX2(prev + row, curr + row, next + row, numCols, 1, numCols - 1, k1, k2, k3);
+		}
+		else
+		{
+			StencilRowScalar(prev + row, curr + row, next + row, numCols, 1, numCols - 1, k1, k2, k3);
+		}
+	}
+}
+
+void WaveKernels::NormalsAndTangents(
+	const float* heights,
+	int numCols,
+	int rowBegin,
+	int rowEnd,
+	float spatialStep,
+	float* normalX,
+	float* normalY,
+	float* normalZ,
+	float* tangentX,
+	float* tangentY)
+{
+	const bool avx2 = UseAVX2();
+
+	for (int i = rowBegin; i < rowEnd; ++i)
+	{
+		const size_t row = (size_t)i * numCols;
+
+		if (avx2)
+		{
+			NormalRowAVX2(heights + row, numCols, 1, numCols - 1, spatialStep,
+				normalX + row, normalY + row, normalZ + row, tangentX + row, tangentY + row);
+		}
+		else
+		{
+			NormalRowScalar(heights + row, numCols, 1, numCols - 1, spatialStep,
+				normalX + row, normalY + row, normalZ + row, tangentX + row, tangentY + row);
+		}
+	}
+}
+
+bool WaveKernels::HasAVX2()
+{
+	static const bool hasAVX2 = DetectAVX2();
+	return hasAVX2;
+}
+
+void WaveKernels::ForceScalar(bool scalar)
+{
+	gForceScalar = scalar;
+}
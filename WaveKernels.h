@@ -0,0 +1,38 @@
+#pragma once
+
+// Row kernels for the Waves height field. Heights are stored as a plain
+// numRows x numCols float array; only interior rows/columns are written.
+// Every kernel picks an AVX2 path at runtime and falls back to scalar code.
+
+namespace WaveKernels
+{
+	// next = k1 * prev + k2 * curr + k3 * (sum of the four neighbours in curr).
+	// next may alias prev, which is how Waves uses it.
+	void Stencil(
+		const float* prev,
+		const float* curr,
+		float* next,
+		int numCols,
+		int rowBegin,
+		int rowEnd,
+		float k1,
+		float k2,
+		float k3);
+
+	// Normalized central-difference normals and x tangents. The tangent has no z
+	// component, so only its x and y are written.
+	void NormalsAndTangents(
+		const float* heights,
+		int numCols,
+		int rowBegin,
+		int rowEnd,
+		float spatialStep,
+		float* normalX,
+		float* normalY,
+		float* normalZ,
+		float* tangentX,
+		float* tangentY);
+
+	bool HasAVX2();
+	void ForceScalar(bool scalar);
+}
@@ -1,5 +1,5 @@
 #include "Waves.h"
-#include <ppl.h>
+#include "WaveKernels.h"
 #include <algorithm>
 #include <vector>
 #include <cassert>
@@ -24,81 +24,114 @@ Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
 	mK2 = (4.0f - 8.0f * e) / d;
 	mK3 = (2.0f * e) / d;
 
-	mPrevSolution.resize(m * n);
-	mCurrSolution.resize(m * n);
-	mNormals.resize(m * n);
-	mTangentX.resize(m * n);
+	mPrevSolution.assign(m * n, 0.0f);
+	mCurrSolution.assign(m * n, 0.0f);
 
-	float halfWidth = (n - 1) * dx * 0.5f;
-	float halfDepth = (m - 1) * dx * 0.5f;
+	mSurface.Resize(m * n);
+}
 
-	for (int i = 0; i < m; ++i)
-	{
-		float z = halfDepth - i * dx;
-		for (int j = 0; j < n; ++j)
-		{
-			float x = -halfWidth + j * dx;
+Waves::~Waves()
+{
+}
 
-			mPrevSolution[i * n + j] = XMFLOAT3(x, 0.0f, z);
-			mCurrSolution[i * n + j] = XMFLOAT3(x, 0.0f, z);
-			mNormals[i * n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			mTangentX[i * n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-		}
-	}
+void WaveSurface::Resize(int vertexCount)
+{
+	// Boundary vertices are never written by the solver and keep a flat frame.
+	Height.assign(vertexCount, 0.0f);
+	NormalX.assign(vertexCount, 0.0f);
+	NormalY.assign(vertexCount, 1.0f);
+	NormalZ.assign(vertexCount, 0.0f);
+	TangentX.assign(vertexCount, 1.0f);
+	TangentY.assign(vertexCount, 0.0f);
 }
 
-Waves::~Waves()
+XMFLOAT3 Waves::Position(int i) const
+{
+	return GridPosition(i, mCurrSolution[i]);
+}
+
+XMFLOAT3 Waves::GridPosition(int i, float height) const
 {
+	float halfWidth = (mNumCols - 1) * mSpatialStep * 0.5f;
+	float halfDepth = (mNumRows - 1) * mSpatialStep * 0.5f;
+
+	int row = i / mNumCols;
+	int col = i - row * mNumCols;
+
+	return XMFLOAT3(-halfWidth + col * mSpatialStep, height, halfDepth - row * mSpatialStep);
 }
 
 void Waves::Update(float dt)
 {
-	static float t = 0;
+	mAccumulatedTime += dt;
+
+	if (mAccumulatedTime >= mTimeStep)
+	{
+		Step(1);
+		BuildSurface(mSurface);
 
-	t += dt;
+		mAccumulatedTime = 0.0f;
+	}
+}
+
+void Waves::Step(int count)
+{
+	ThreadPool& pool = mThreadPool ? *mThreadPool : ThreadPool::Default();
 
-	if (t >= mTimeStep)
+	for (int step = 0; step < count; ++step)
 	{
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
+		pool.ParallelFor(1, mNumRows - 1, mGrainRows, [this](int rowBegin, int rowEnd)
 			{
-				for (int j = 1; j < mNumCols - 1; ++j)
-				{
-					mPrevSolution[i * mNumCols + j].y =
-						mK1 * mPrevSolution[i * mNumCols + j].y +
-						mK2 * mCurrSolution[i * mNumCols + j].y +
-						mK3 * (mCurrSolution[(i + 1) * mNumCols + j].y +
-							mCurrSolution[(i - 1) * mNumCols + j].y +
-							mCurrSolution[i * mNumCols + j + 1].y +
-							mCurrSolution[i * mNumCols + j - 1].y);
-				}
+				WaveKernels::Stencil(
+					mPrevSolution.data(),
+					mCurrSolution.data(),
+					mPrevSolution.data(),
+					mNumCols,
+					rowBegin,
+					rowEnd,
+					mK1,
+					mK2,
+					mK3);
 			});
 
 		std::swap(mPrevSolution, mCurrSolution);
+	}
+}
+
+void Waves::BuildSurface(WaveSurface& surface) const
+{
+	if ((int)surface.Height.size() != mVertexCount)
+	{
+		surface.Resize(mVertexCount);
+	}
+
+	ThreadPool& pool = mThreadPool ? *mThreadPool : ThreadPool::Default();
+
+	pool.ParallelFor(0, mNumRows, mGrainRows, [this, &surface](int rowBegin, int rowEnd)
+		{
+			copy(
+				mCurrSolution.begin() + (size_t)rowBegin * mNumCols,
+				mCurrSolution.begin() + (size_t)rowEnd * mNumCols,
+				surface.Height.begin() + (size_t)rowBegin * mNumCols);
 
-		t = 0.0f;
+			rowBegin = max(rowBegin, 1);
+			rowEnd = min(rowEnd, mNumRows - 1);
 
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
+			if (rowBegin < rowEnd)
 			{
-				for (int j = 1; j < mNumCols - 1; ++j)
-				{
-					float l = mCurrSolution[i * mNumCols + j - 1].y;
-					float r = mCurrSolution[i * mNumCols + j + 1].y;
-					float t = mCurrSolution[(i - 1) * mNumCols + j].y;
-					float b = mCurrSolution[(i + 1) * mNumCols + j].y;
-
-					mNormals[i * mNumCols + j].x = -r + l;
-					mNormals[i * mNumCols + j].y = 2.0f * mSpatialStep;
-					mNormals[i * mNumCols + j].z = b - t;
-
-					XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&mNormals[i * mNumCols + j]));
-					XMStoreFloat3(&mNormals[i * mNumCols + j], n);
-
-					mTangentX[i * mNumCols + j] = XMFLOAT3(2.0f * mSpatialStep, r - l, 0.0f);
-					XMVECTOR tan = XMVector3Normalize(XMLoadFloat3(&mTangentX[i * mNumCols + j]));
-					XMStoreFloat3(&mTangentX[i * mNumCols + j], tan);
-				}
-			});
-	}
+				WaveKernels::NormalsAndTangents(
+					mCurrSolution.data(),
+					mNumCols,
+					rowBegin,
+					rowEnd,
+					mSpatialStep,
+					surface.NormalX.data(),
+					surface.NormalY.data(),
+					surface.NormalZ.data(),
+					surface.TangentX.data(),
+					surface.TangentY.data());
+			}
+		});
 }
 
 void Waves::Disturb(int i, int j, float magnitude)
@@ -108,9 +141,9 @@ void Waves::Disturb(int i, int j, float magnitude)
 
 	float halfMag = 0.5f * magnitude;
 
-	mCurrSolution[i * mNumCols + j].y += magnitude;
-	mCurrSolution[i * mNumCols + j + 1].y += halfMag;
-	mCurrSolution[i * mNumCols + j - 1].y += halfMag;
-	mCurrSolution[(i + 1) * mNumCols + j].y += halfMag;
-	mCurrSolution[(i - 1) * mNumCols + j].y += halfMag;
-}
\ No newline at end of file
+	mCurrSolution[i * mNumCols + j] += magnitude;
+	mCurrSolution[i * mNumCols + j + 1] += halfMag;
+	mCurrSolution[i * mNumCols + j - 1] += halfMag;
+	mCurrSolution[(i + 1) * mNumCols + j] += halfMag;
+	mCurrSolution[(i - 1) * mNumCols + j] += halfMag;
+}
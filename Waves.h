@@ -1,11 +1,31 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <DirectXMath.h>
+#include "ThreadPool.h"
 
 using namespace std;
 using namespace DirectX;
 
+// Default rows per task in the solver passes. 32 rows of a 1024 wide grid keep the three
+// height rows a stencil row touches, and the rows next to them, in L1/L2.
+const int WaveRowTile = 32;
+
+// Heights, normals and x tangents of one solver step, one float per vertex and
+// component. The tangent has no z component.
+struct WaveSurface
+{
+	vector<float> Height;
+	vector<float> NormalX;
+	vector<float> NormalY;
+	vector<float> NormalZ;
+	vector<float> TangentX;
+	vector<float> TangentY;
+
+	void Resize(int vertexCount);
+};
+
 class Waves
 {
 public:
@@ -20,14 +40,33 @@ public:
 	int TriangleCount() const { return mTriangleCount; }
 	float Width() const { return mNumCols * mSpatialStep; }
 	float Depth() const { return mNumRows * mSpatialStep; }
+	float TimeStep() const { return mTimeStep; }
+	float SpatialStep() const { return mSpatialStep; }
+
+	XMFLOAT3 Position(int i) const;
+	XMFLOAT3 Normal(int i) const { return XMFLOAT3(mSurface.NormalX[i], mSurface.NormalY[i], mSurface.NormalZ[i]); }
+	XMFLOAT3 TangentX(int i) const { return XMFLOAT3(mSurface.TangentX[i], mSurface.TangentY[i], 0.0f); }
 
-	const XMFLOAT3& Position(int i) const { return mCurrSolution[i]; }
-	const XMFLOAT3& Normal(int i) const { return mNormals[i]; }
-	const XMFLOAT3& TangentX(int i) const { return mTangentX[i]; }
+	// Grid position of vertex i with the given height.
+	XMFLOAT3 GridPosition(int i, float height) const;
 
+	// Height field in row-major order, one float per vertex.
+	const float* Heights() const { return mCurrSolution.data(); }
+
+	// Steps at most once when enough time has accumulated and refreshes the
+	// surface returned by Position/Normal/TangentX.
 	void Update(float dt);
 	void Disturb(int i, int j, float magnitude);
 
+	// Advances the solution by count fixed time steps without touching the surface.
+	void Step(int count);
+	// Writes heights, normals and tangents of the current solution to surface.
+	void BuildSurface(WaveSurface& surface) const;
+
+	void SetThreadPool(ThreadPool* pool) { mThreadPool = pool; }
+	void SetGrainSize(int rows) { mGrainRows = max(1, rows); }
+	int GetGrainSize() const { return mGrainRows; }
+
 private:
 	int mNumRows = 0;
 	int mNumCols = 0;
@@ -42,8 +81,15 @@ private:
 	float mTimeStep = 0.0f;
 	float mSpatialStep = 0.0f;
 
-	vector<XMFLOAT3> mPrevSolution;
-	vector<XMFLOAT3> mCurrSolution;
-	vector<XMFLOAT3> mNormals;
-	vector<XMFLOAT3> mTangentX;
+	// Time since the last step, per instance so simulations stay independent.
+	float mAccumulatedTime = 0.0f;
+
+	ThreadPool* mThreadPool = nullptr;
+	int mGrainRows = WaveRowTile;
+
+	// Only the heights change; x and z follow from the grid.
+	vector<float> mPrevSolution;
+	vector<float> mCurrSolution;
+
+	WaveSurface mSurface;
 };
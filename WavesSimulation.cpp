@@ -0,0 +1,152 @@
+#include "WavesSimulation.h"
+#include <cmath>
+
+WavesSimulation::WavesSimulation(Waves* waves, int maxSubstepsPerFrame, bool async)
+	: mWaves(waves), mMaxSubsteps(max(1, maxSubstepsPerFrame)), mAsync(async)
+{
+	mWaves->BuildSurface(mSurfaces[0]);
+	mWaves->BuildSurface(mSurfaces[1]);
+
+	if (mAsync)
+	{
+		// Half the hardware threads, the worker included; the rest stay with the renderer.
+		mThreadPool = make_unique<ThreadPool>(max(1u, thread::hardware_concurrency() / 2));
+		mWaves->SetThreadPool(mThreadPool.get());
+		mWorker = thread(&WavesSimulation::WorkerLoop, this);
+	}
+}
+
+WavesSimulation::~WavesSimulation()
+{
+	if (mAsync)
+	{
+		{
+			lock_guard<mutex> lock(mMutex);
+			mStop = true;
+		}
+		mWake.notify_one();
+		mWorker.join();
+		mWaves->SetThreadPool(nullptr);
+	}
+}
+
+const WaveSurface& WavesSimulation::Advance(float dt)
+{
+	Wait();
+
+	const float timeStep = mWaves->TimeStep();
+	mAccumulatedTime += dt;
+
+	int substeps = (int)floorf(mAccumulatedTime / timeStep);
+	mAccumulatedTime -= substeps * timeStep;
+
+	if (substeps > mMaxSubsteps)
+	{
+		mDroppedSteps += substeps - mMaxSubsteps;
+		substeps = mMaxSubsteps;
+	}
+
+	mLastSubsteps = substeps;
+
+	if (substeps > 0)
+	{
+		Kick(substeps);
+	}
+
+	return mSurfaces[mFront];
+}
+
+void WavesSimulation::Flush()
+{
+	Wait();
+}
+
+void WavesSimulation::Disturb(int i, int j, float magnitude)
+{
+	Disturbance d;
+	d.Row = i;
+	d.Col = j;
+	d.Magnitude = magnitude;
+	mDisturbances.push_back(d);
+}
+
+void WavesSimulation::Kick(int substeps)
+{
+	mStepCount += substeps;
+
+	if (!mAsync)
+	{
+		swap(mPendingDisturbances, mDisturbances);
+		Run(substeps, mSurfaces[1 - mFront]);
+		mFront = 1 - mFront;
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(mMutex);
+		swap(mPendingDisturbances, mDisturbances);
+		mPendingSubsteps = substeps;
+		mBusy = true;
+	}
+	mWake.notify_one();
+
+	mInFlight = true;
+}
+
+void WavesSimulation::Wait()
+{
+	if (!mAsync)
+	{
+		return;
+	}
+
+	if (!mInFlight)
+	{
+		return;
+	}
+
+	{
+		unique_lock<mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return !mBusy; });
+	}
+
+	// The worker filled the back surface; publish it.
+	mFront = 1 - mFront;
+	mInFlight = false;
+}
+
+void WavesSimulation::Run(int substeps, WaveSurface& target)
+{
+	for (auto& d : mPendingDisturbances)
+	{
+		mWaves->Disturb(d.Row, d.Col, d.Magnitude);
+	}
+	mPendingDisturbances.clear();
+
+	mWaves->Step(substeps);
+	mWaves->BuildSurface(target);
+}
+
+void WavesSimulation::WorkerLoop()
+{
+	unique_lock<mutex> lock(mMutex);
+	for (;;)
+	{
+		mWake.wait(lock, [this] { return mStop || mPendingSubsteps > 0; });
+		if (mStop)
+		{
+			return;
+		}
+
+		int substeps = mPendingSubsteps;
+		mPendingSubsteps = 0;
+		WaveSurface& target = mSurfaces[1 - mFront];
+
+		lock.unlock();
+		Run(substeps, target);
+		lock.lock();
+
+		mBusy = false;
+		mDone.notify_one();
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Waves.h"
+
+// Runs Waves at its fixed time step, decoupled from the frame rate. Every Advance
+// turns the elapsed frame time into a whole number of substeps (any remainder
+// carries over) and, in async mode, runs them on a worker thread while the
+// renderer consumes the surface produced by the previous Advance. Results are
+// double-buffered: the worker fills one WaveSurface while the other is read, and
+// the two are swapped by index. The worker steps Waves on a ThreadPool of its own;
+// sharing ThreadPool::Default() would make the render thread's parallel loops
+// queue behind wave steps.
+class WavesSimulation
+{
+public:
+	WavesSimulation(Waves* waves, int maxSubstepsPerFrame = 4, bool async = true);
+	WavesSimulation(const WavesSimulation& rhs) = delete;
+	WavesSimulation& operator=(const WavesSimulation& rhs) = delete;
+	~WavesSimulation();
+
+	// Render thread, once per frame. Returns the newest finished surface, which
+	// stays valid until the next Advance.
+	const WaveSurface& Advance(float dt);
+
+	// Waits for the step in flight, so Current() is the newest state.
+	void Flush();
+
+	const WaveSurface& Current() const { return mSurfaces[mFront]; }
+
+	// Disturbances are applied before the next batch of substeps.
+	void Disturb(int i, int j, float magnitude);
+
+	uint64_t StepCount() const { return mStepCount; }
+	int LastSubsteps() const { return mLastSubsteps; }
+	// Whole steps of simulation time dropped because a frame needed more than
+	// maxSubstepsPerFrame.
+	uint64_t DroppedSteps() const { return mDroppedSteps; }
+
+private:
+	struct Disturbance
+	{
+		int Row = 0;
+		int Col = 0;
+		float Magnitude = 0.0f;
+	};
+
+	void Kick(int substeps);
+	void Wait();
+	void Run(int substeps, WaveSurface& target);
+	void WorkerLoop();
+
+private:
+	Waves* mWaves = nullptr;
+	int mMaxSubsteps = 4;
+	bool mAsync = true;
+
+	WaveSurface mSurfaces[2];
+	int mFront = 0;
+
+	float mAccumulatedTime = 0.0f;
+	uint64_t mStepCount = 0;
+	uint64_t mDroppedSteps = 0;
+	int mLastSubsteps = 0;
+
+	vector<Disturbance> mDisturbances;
+
+	// Render thread only: a kicked batch has not been published yet.
+	bool mInFlight = false;
+
+	unique_ptr<ThreadPool> mThreadPool;
+	thread mWorker;
+	mutex mMutex;
+	condition_variable mWake;
+	condition_variable mDone;
+	int mPendingSubsteps = 0;
+	vector<Disturbance> mPendingDisturbances;
+	bool mBusy = false;
+	bool mStop = false;
+};
@@ -0,0 +1,204 @@
+#include "WavesTiledEmulator.h"
+#include <algorithm>
+#include <cmath>
+
+WaveConstants MakeWaveConstants(int m, int n, float dx, float dt, float speed, float damping)
+{
+	// Same coefficients as Waves.
+	float d = damping * dt + 2.0f;
+	float e = (speed * speed) * (dt * dt) / (dx * dx);
+
+	WaveConstants constants;
+	constants.K1 = (damping * dt - 2.0f) / d;
+	constants.K2 = (4.0f - 8.0f * e) / d;
+	constants.K3 = (2.0f * e) / d;
+	constants.SpatialStep = dx;
+	constants.NumRows = (uint32_t)m;
+	constants.NumCols = (uint32_t)n;
+	constants.Width = n * dx;
+	constants.Depth = m * dx;
+	return constants;
+}
+
+WavesTiledEmulator::WavesTiledEmulator(int m, int n, float dx, float dt, float speed, float damping)
+{
+	mConstants = MakeWaveConstants(m, n, dx, dt, speed, damping);
+
+	mPrevSolution.assign(m * n, 0.0f);
+	mCurrSolution.assign(m * n, 0.0f);
+}
+
+WavesTiledEmulator::~WavesTiledEmulator()
+{
+}
+
+float WavesTiledEmulator::LoadHeight(int row, int col) const
+{
+	row = min(max(row, 0), (int)mConstants.NumRows - 1);
+	col = min(max(col, 0), (int)mConstants.NumCols - 1);
+	return mCurrSolution[row * mConstants.NumCols + col];
+}
+
+void WavesTiledEmulator::LoadTile(int groupRow, int groupCol, Tile& tile) const
+{
+	// Every emulated thread does its loads before any of them computes, which is
+	// what GroupMemoryBarrierWithGroupSync guarantees on the GPU.
+	for (int ly = 0; ly < WaveTileSize; ++ly)
+	{
+		for (int lx = 0; lx < WaveTileSize; ++lx)
+		{
+			int row = groupRow * WaveTileSize + ly;
+			int col = groupCol * WaveTileSize + lx;
+
+			tile[ly + 1][lx + 1] = LoadHeight(row, col);
+
+			if (lx == 0)
+			{
+				tile[ly + 1][0] = LoadHeight(row, col - 1);
+			}
+			if (lx == WaveTileSize - 1)
+			{
+				tile[ly + 1][WaveTileSize + 1] = LoadHeight(row, col + 1);
+			}
+			if (ly == 0)
+			{
+				tile[0][lx + 1] = LoadHeight(row - 1, col);
+			}
+			if (ly == WaveTileSize - 1)
+			{
+				tile[WaveTileSize + 1][lx + 1] = LoadHeight(row + 1, col);
+			}
+		}
+	}
+}
+
+bool WavesTiledEmulator::IsInterior(int row, int col) const
+{
+	return col >= 1 && row >= 1 && col < (int)mConstants.NumCols - 1 && row < (int)mConstants.NumRows - 1;
+}
+
+void WavesTiledEmulator::Step(int count)
+{
+	Tile tile;
+
+	for (int step = 0; step < count; ++step)
+	{
+		for (int gy = 0; gy < GroupCountY(); ++gy)
+		{
+			for (int gx = 0; gx < GroupCountX(); ++gx)
+			{
+				LoadTile(gy, gx, tile);
+
+				for (int ly = 0; ly < WaveTileSize; ++ly)
+				{
+					for (int lx = 0; lx < WaveTileSize; ++lx)
+					{
+						int row = gy * WaveTileSize + ly;
+						int col = gx * WaveTileSize + lx;
+						if (!IsInterior(row, col))
+						{
+							continue;
+						}
+
+						int tx = lx + 1;
+						int ty = ly + 1;
+						size_t index = (size_t)row * mConstants.NumCols + col;
+
+						mPrevSolution[index] =
+							mConstants.K1 * mPrevSolution[index] +
+							mConstants.K2 * tile[ty][tx] +
+							mConstants.K3 * (tile[ty + 1][tx] + tile[ty - 1][tx] + tile[ty][tx + 1] + tile[ty][tx - 1]);
+					}
+				}
+			}
+		}
+
+		swap(mPrevSolution, mCurrSolution);
+	}
+}
+
+void WavesTiledEmulator::Disturb(int i, int j, float magnitude)
+{
+	const int n = (int)mConstants.NumCols;
+	float halfMag = 0.5f * magnitude;
+
+	mCurrSolution[i * n + j] += magnitude;
+	mCurrSolution[i * n + j + 1] += halfMag;
+	mCurrSolution[i * n + j - 1] += halfMag;
+	mCurrSolution[(i + 1) * n + j] += halfMag;
+	mCurrSolution[(i - 1) * n + j] += halfMag;
+}
+
+void WavesTiledEmulator::BuildSurface(WaveSurface& surface) const
+{
+	const int vertexCount = (int)(mConstants.NumRows * mConstants.NumCols);
+	if ((int)surface.Height.size() != vertexCount)
+	{
+		surface.Resize(vertexCount);
+	}
+
+	const float twoDx = 2.0f * mConstants.SpatialStep;
+	Tile tile;
+
+	for (int gy = 0; gy < GroupCountY(); ++gy)
+	{
+		for (int gx = 0; gx < GroupCountX(); ++gx)
+		{
+			LoadTile(gy, gx, tile);
+
+			for (int ly = 0; ly < WaveTileSize; ++ly)
+			{
+				for (int lx = 0; lx < WaveTileSize; ++lx)
+				{
+					int row = gy * WaveTileSize + ly;
+					int col = gx * WaveTileSize + lx;
+					if (row >= (int)mConstants.NumRows || col >= (int)mConstants.NumCols)
+					{
+						continue;
+					}
+
+					int tx = lx + 1;
+					int ty = ly + 1;
+					size_t index = (size_t)row * mConstants.NumCols + col;
+
+					surface.Height[index] = tile[ty][tx];
+
+					if (!IsInterior(row, col))
+					{
+						continue;
+					}
+
+					float l = tile[ty][tx - 1];
+					float r = tile[ty][tx + 1];
+					float t = tile[ty - 1][tx];
+					float b = tile[ty + 1][tx];
+
+					float x = l - r;
+					float z = b - t;
+					float invLen = 1.0f / sqrtf(x * x + twoDx * twoDx + z * z);
+					surface.NormalX[index] = x * invLen;
+					surface.NormalY[index] = twoDx * invLen;
+					surface.NormalZ[index] = z * invLen;
+
+					float y = r - l;
+					float invTanLen = 1.0f / sqrtf(twoDx * twoDx + y * y);
+					surface.TangentX[index] = twoDx * invTanLen;
+					surface.TangentY[index] = y * invTanLen;
+				}
+			}
+		}
+	}
+}
+
+float WavesTiledEmulator::MaxHeightError(const Waves& reference) const
+{
+	float error = 0.0f;
+
+	const float* heights = reference.Heights();
+	for (size_t i = 0; i < mCurrSolution.size(); ++i)
+	{
+		error = max(error, fabsf(heights[i] - mCurrSolution[i]));
+	}
+
+	return error;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Waves.h"
+
+// Must match WaveTileSize in Shaders/Waves.hlsl.
+const int WaveTileSize = 16;
+
+// Mirrors cbWaves in Shaders/Waves.hlsl.
+struct WaveConstants
+{
+	float K1 = 0.0f;
+	float K2 = 0.0f;
+	float K3 = 0.0f;
+	float SpatialStep = 0.0f;
+	uint32_t NumRows = 0;
+	uint32_t NumCols = 0;
+	float Width = 0.0f;
+	float Depth = 0.0f;
+	uint32_t DisturbRow = 0;
+	uint32_t DisturbCol = 0;
+	float DisturbMagnitude = 0.0f;
+	uint32_t Pad0 = 0;
+};
+
+WaveConstants MakeWaveConstants(int m, int n, float dx, float dt, float speed, float damping);
+
+// Runs the groupshared tile algorithm of Shaders/Waves.hlsl on the CPU, one
+// emulated thread group at a time, so the GPU path can be checked against Waves
+// without a device.
+class WavesTiledEmulator
+{
+public:
+	WavesTiledEmulator(int m, int n, float dx, float dt, float speed, float damping);
+	WavesTiledEmulator(const WavesTiledEmulator& rhs) = delete;
+	WavesTiledEmulator& operator=(const WavesTiledEmulator& rhs) = delete;
+	~WavesTiledEmulator();
+
+	const WaveConstants& Constants() const { return mConstants; }
+	const float* Heights() const { return mCurrSolution.data(); }
+
+	// UpdateCS followed by the buffer swap, count times.
+	void Step(int count);
+	// DisturbCS.
+	void Disturb(int i, int j, float magnitude);
+	// NormalsCS, written to a WaveSurface instead of vertices.
+	void BuildSurface(WaveSurface& surface) const;
+
+	// Largest absolute height difference against the CPU solver.
+	float MaxHeightError(const Waves& reference) const;
+
+private:
+	typedef float Tile[WaveTileSize + 2][WaveTileSize + 2];
+
+	float LoadHeight(int row, int col) const;
+	void LoadTile(int groupRow, int groupCol, Tile& tile) const;
+	bool IsInterior(int row, int col) const;
+
+	int GroupCountX() const { return ((int)mConstants.NumCols + WaveTileSize - 1) / WaveTileSize; }
+	int GroupCountY() const { return ((int)mConstants.NumRows + WaveTileSize - 1) / WaveTileSize; }
+
+private:
+	WaveConstants mConstants;
+
+	vector<float> mPrevSolution;
+	vector<float> mCurrSolution;
+};